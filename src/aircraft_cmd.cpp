@@ -1522,7 +1522,7 @@ void AircraftLeaveHangar(Aircraft *v, Direction exit_dir)
 static void AircraftEventHandler_EnterTerminal(Aircraft *v, const AirportFTAClass *apc)
 {
 	AircraftEntersTerminal(v);
-	v->state = apc->layout[v->pos].heading;
+	v->state = apc->GetPosition(v->pos)->heading;
 }
 
 /**
@@ -1533,7 +1533,7 @@ static void AircraftEventHandler_EnterTerminal(Aircraft *v, const AirportFTAClas
 static void AircraftEventHandler_EnterHangar(Aircraft *v, const AirportFTAClass *apc)
 {
 	VehicleEnterDepot(v);
-	v->state = apc->layout[v->pos].heading;
+	v->state = apc->GetPosition(v->pos)->heading;
 }
 
 /**
@@ -1573,7 +1573,7 @@ static void AircraftEventHandler_InHangar(Aircraft *v, const AirportFTAClass *ap
 	}
 
 	/* if the block of the next position is busy, stay put */
-	if (AirportHasBlock(v, &apc->layout[v->pos], apc)) return;
+	if (AirportHasBlock(v, apc->GetPosition(v->pos), apc)) return;
 
 	/* We are already at the target airport, we need to find a terminal */
 	if (v->current_order.GetDestination() == v->targetairport) {
@@ -1616,7 +1616,7 @@ static void AircraftEventHandler_AtTerminal(Aircraft *v, const AirportFTAClass *
 	if (v->current_order.IsType(OT_NOTHING)) return;
 
 	/* if the block of the next position is busy, stay put */
-	if (AirportHasBlock(v, &apc->layout[v->pos], apc)) return;
+	if (AirportHasBlock(v, apc->GetPosition(v->pos), apc)) return;
 
 	/* airport-road is free. We either have to go to another airport, or to the hangar
 	 * ---> start moving */
@@ -1697,8 +1697,8 @@ static void AircraftEventHandler_Flying(Aircraft *v, const AirportFTAClass *apc)
 		 * if it is an airplane, look for LANDING, for helicopter HELILANDING
 		 * it is possible to choose from multiple landing runways, so loop until a free one is found */
 		byte landingtype = (v->subtype == AIR_HELICOPTER) ? HELILANDING : LANDING;
-		const AirportFTA *current = apc->layout[v->pos].next;
-		while (current != nullptr) {
+		const AirportFTA *end = apc->GetTransitionsEnd(v->pos);
+		for (const AirportFTA *current = apc->GetPosition(v->pos) + 1; current != end; current++) {
 			if (current->heading == landingtype) {
 				/* save speed before, since if AirportHasBlock is false, it resets them to 0
 				 * we don't want that for plane in air
@@ -1712,17 +1712,16 @@ static void AircraftEventHandler_Flying(Aircraft *v, const AirportFTAClass *apc)
 					 * if there are multiple runways, plane won't know which one it took (because
 					 * they all have heading LANDING). And also occupy that block! */
 					v->pos = current->next_position;
-					SETBITS(st->airport.flags, apc->layout[v->pos].block);
+					SETBITS(st->airport.flags, apc->GetPosition(v->pos)->block);
 					return;
 				}
 				v->cur_speed = tcur_speed;
 				v->subspeed = tsubspeed;
 			}
-			current = current->next;
 		}
 	}
 	v->state = FLYING;
-	v->pos = apc->layout[v->pos].next_position;
+	v->pos = apc->GetPosition(v->pos)->next_position;
 }
 
 static void AircraftEventHandler_Landing(Aircraft *v, const AirportFTAClass *apc)
@@ -1747,7 +1746,7 @@ static void AircraftEventHandler_HeliLanding(Aircraft *v, const AirportFTAClass
 static void AircraftEventHandler_EndLanding(Aircraft *v, const AirportFTAClass *apc)
 {
 	/* next block busy, don't do a thing, just wait */
-	if (AirportHasBlock(v, &apc->layout[v->pos], apc)) return;
+	if (AirportHasBlock(v, apc->GetPosition(v->pos), apc)) return;
 
 	/* if going to terminal (OT_GOTO_STATION) choose one
 	 * 1. in case all terminals are busy AirportFindFreeTerminal() returns false or
@@ -1763,7 +1762,7 @@ static void AircraftEventHandler_EndLanding(Aircraft *v, const AirportFTAClass *
 static void AircraftEventHandler_HeliEndLanding(Aircraft *v, const AirportFTAClass *apc)
 {
 	/*  next block busy, don't do a thing, just wait */
-	if (AirportHasBlock(v, &apc->layout[v->pos], apc)) return;
+	if (AirportHasBlock(v, apc->GetPosition(v->pos), apc)) return;
 
 	/* if going to helipad (OT_GOTO_STATION) choose one. If airport doesn't have helipads, choose terminal
 	 * 1. in case all terminals/helipads are busy (AirportFindFreeHelipad() returns false) or
@@ -1813,10 +1812,11 @@ static AircraftStateHandler * const _aircraft_state_handlers[] = {
 static void AirportClearBlock(const Aircraft *v, const AirportFTAClass *apc)
 {
 	/* we have left the previous block, and entered the new one. Free the previous block */
-	if (apc->layout[v->previous_pos].block != apc->layout[v->pos].block) {
+	const uint64 previous_block = apc->GetPosition(v->previous_pos)->block;
+	if (previous_block != apc->GetPosition(v->pos)->block) {
 		Station *st = Station::Get(v->targetairport);
 
-		CLRBITS(st->airport.flags, apc->layout[v->previous_pos].block);
+		CLRBITS(st->airport.flags, previous_block);
 	}
 }
 
@@ -1840,7 +1840,8 @@ static bool AirportMove(Aircraft *v, const AirportFTAClass *apc)
 		assert(v->pos < apc->nofelements);
 	}
 
-	const AirportFTA *current = &apc->layout[v->pos];
+	const AirportFTA *current = apc->GetPosition(v->pos);
+	const AirportFTA *end = apc->GetTransitionsEnd(v->pos);
 	/* we have arrived in an important state (eg terminal, hangar, etc.) */
 	if (current->heading == v->state) {
 		byte prev_pos = v->pos; // location could be changed in state, so save it before-hand
@@ -1854,7 +1855,7 @@ static bool AirportMove(Aircraft *v, const AirportFTAClass *apc)
 	v->previous_pos = v->pos; // save previous location
 
 	/* there is only one choice to move to */
-	if (current->next == nullptr) {
+	if (current + 1 == end) {
 		if (AirportSetBlocks(v, current, apc)) {
 			v->pos = current->next_position;
 			UpdateAircraftCache(v);
@@ -1864,7 +1865,7 @@ static bool AirportMove(Aircraft *v, const AirportFTAClass *apc)
 
 	/* there are more choices to choose from, choose the one that
 	 * matches our heading */
-	do {
+	for (; current != end; current++) {
 		if (v->state == current->heading || current->heading == TO_ALL) {
 			if (AirportSetBlocks(v, current, apc)) {
 				v->pos = current->next_position;
@@ -1872,34 +1873,28 @@ static bool AirportMove(Aircraft *v, const AirportFTAClass *apc)
 			} // move to next position
 			return false;
 		}
-		current = current->next;
-	} while (current != nullptr);
+	}
 
 	DEBUG(misc, 0, "[Ap] cannot move further on Airport! (pos %d state %d) for vehicle %d", v->pos, v->state, v->index);
 	NOT_REACHED();
 }
 
-/** returns true if the road ahead is busy, eg. you must wait before proceeding. */
+/**
+ * Check whether the road ahead is busy, eg. you must wait before proceeding.
+ * @param v Aircraft that wants to proceed.
+ * @param current_pos Transition of the current position of the aircraft to take.
+ * @param apc Airport of the aircraft.
+ * @return True iff the aircraft has to wait.
+ */
 static bool AirportHasBlock(Aircraft *v, const AirportFTA *current_pos, const AirportFTAClass *apc)
 {
-	const AirportFTA *reference = &apc->layout[v->pos];
-	const AirportFTA *next = &apc->layout[current_pos->next_position];
-
 	/* same block, then of course we can move */
-	if (apc->layout[current_pos->position].block != next->block) {
-		const Station *st = Station::Get(v->targetairport);
-		uint64 airport_flags = next->block;
-
-		/* check additional possible extra blocks */
-		if (current_pos != reference && current_pos->block != NOTHING_block) {
-			airport_flags |= current_pos->block;
-		}
+	if (current_pos->wait_blocks == 0) return false;
 
-		if (st->airport.flags & airport_flags) {
-			v->cur_speed = 0;
-			v->subspeed = 0;
-			return true;
-		}
+	if (Station::Get(v->targetairport)->airport.flags & current_pos->wait_blocks) {
+		v->cur_speed = 0;
+		v->subspeed = 0;
+		return true;
 	}
 	return false;
 }
@@ -1907,45 +1902,23 @@ static bool AirportHasBlock(Aircraft *v, const AirportFTA *current_pos, const Ai
 /**
  * "reserve" a block for the plane
  * @param v airplane that requires the operation
- * @param current_pos of the vehicle in the list of blocks
+ * @param current_pos transition of the current position of the vehicle to take
  * @param apc airport on which block is requested to be set
  * @returns true on success. Eg, next block was free and we have occupied it
  */
 static bool AirportSetBlocks(Aircraft *v, const AirportFTA *current_pos, const AirportFTAClass *apc)
 {
-	const AirportFTA *next = &apc->layout[current_pos->next_position];
-	const AirportFTA *reference = &apc->layout[v->pos];
-
 	/* if the next position is in another block, check it and wait until it is free */
-	if ((apc->layout[current_pos->position].block & next->block) != next->block) {
-		uint64 airport_flags = next->block;
-		/* search for all all elements in the list with the same state, and blocks != N
-		 * this means more blocks should be checked/set */
-		const AirportFTA *current = current_pos;
-		if (current == reference) current = current->next;
-		while (current != nullptr) {
-			if (current->heading == current_pos->heading && current->block != 0) {
-				airport_flags |= current->block;
-				break;
-			}
-			current = current->next;
-		}
+	if (current_pos->reserve_blocks == 0) return true;
 
-		/* if the block to be checked is in the next position, then exclude that from
-		 * checking, because it has been set by the airplane before */
-		if (current_pos->block == next->block) airport_flags ^= next->block;
-
-		Station *st = Station::Get(v->targetairport);
-		if (st->airport.flags & airport_flags) {
-			v->cur_speed = 0;
-			v->subspeed = 0;
-			return false;
-		}
-
-		if (next->block != NOTHING_block) {
-			SETBITS(st->airport.flags, airport_flags); // occupy next block
-		}
+	Station *st = Station::Get(v->targetairport);
+	if (st->airport.flags & current_pos->reserve_blocks) {
+		v->cur_speed = 0;
+		v->subspeed = 0;
+		return false;
 	}
+
+	SETBITS(st->airport.flags, current_pos->occupy_blocks); // occupy next block
 	return true;
 }
 
@@ -1976,37 +1949,21 @@ static const MovementTerminalMapping _airport_terminal_mapping[] = {
 /**
  * Find a free terminal or helipad, and if available, assign it.
  * @param v Aircraft looking for a free terminal or helipad.
- * @param i First terminal to examine.
- * @param last_terminal Terminal number to stop examining.
+ * @param terminals Terminals and helipads to examine, as bitset of their numbers. The lowest free number is assigned.
  * @return A terminal or helipad has been found, and has been assigned to the aircraft.
  */
-static bool FreeTerminal(Aircraft *v, byte i, byte last_terminal)
+static bool FreeTerminal(Aircraft *v, uint16 terminals)
 {
-	assert(last_terminal <= lengthof(_airport_terminal_mapping));
 	Station *st = Station::Get(v->targetairport);
-	for (; i < last_terminal; i++) {
-		if ((st->airport.flags & _airport_terminal_mapping[i].airport_flag) == 0) {
-			/* TERMINAL# HELIPAD# */
-			v->state = _airport_terminal_mapping[i].state; // start moving to that terminal/helipad
-			SETBITS(st->airport.flags, _airport_terminal_mapping[i].airport_flag); // occupy terminal/helipad
-			return true;
-		}
-	}
-	return false;
-}
-
-/**
- * Get the number of terminals at the airport.
- * @param apc Airport description.
- * @return Number of terminals.
- */
-static uint GetNumTerminals(const AirportFTAClass *apc)
-{
-	uint num = 0;
-
-	for (uint i = apc->terminals[0]; i > 0; i--) num += apc->terminals[i];
-
-	return num;
+	uint16 free = terminals & ~GetOccupiedTerminals(st->airport.flags);
+	if (free == 0) return false;
+
+	uint i = FindFirstBit(free);
+	assert(i < lengthof(_airport_terminal_mapping));
+	/* TERMINAL# HELIPAD# */
+	v->state = _airport_terminal_mapping[i].state; // start moving to that terminal/helipad
+	SETBITS(st->airport.flags, _airport_terminal_mapping[i].airport_flag); // occupy terminal/helipad
+	return true;
 }
 
 /**
@@ -2027,39 +1984,30 @@ static bool AirportFindFreeTerminal(Aircraft *v, const AirportFTAClass *apc)
 	 * possible groups are checked (in this case group 1, since that is after group 0). If that
 	 * fails, then attempt fails and plane waits
 	 */
-	if (apc->terminals[0] > 1) {
+	if (apc->terminals != nullptr && apc->terminals[0] > 1) {
 		const Station *st = Station::Get(v->targetairport);
-		const AirportFTA *temp = apc->layout[v->pos].next;
+		const AirportFTA *end = apc->GetTransitionsEnd(v->pos);
 
-		while (temp != nullptr) {
+		for (const AirportFTA *temp = apc->GetPosition(v->pos) + 1; temp != end; temp++) {
 			if (temp->heading == TERMGROUP) {
 				if (!(st->airport.flags & temp->block)) {
 					/* read which group do we want to go to?
 					 * (the first free group) */
 					uint target_group = temp->next_position + 1;
+					assert(target_group < lengthof(apc->terminal_group_masks));
 
-					/* at what terminal does the group start?
-					 * that means, sum up all terminals of
-					 * groups with lower number */
-					uint group_start = 0;
-					for (uint i = 1; i < target_group; i++) {
-						group_start += apc->terminals[i];
-					}
-
-					uint group_end = group_start + apc->terminals[target_group];
-					if (FreeTerminal(v, group_start, group_end)) return true;
+					if (FreeTerminal(v, apc->terminal_group_masks[target_group])) return true;
 				}
 			} else {
 				/* once the heading isn't 255, we've exhausted the possible blocks.
 				 * So we cannot move */
 				return false;
 			}
-			temp = temp->next;
 		}
 	}
 
 	/* if there is only 1 terminalgroup, all terminals are checked (starting from 0 to max) */
-	return FreeTerminal(v, 0, GetNumTerminals(apc));
+	return FreeTerminal(v, apc->terminal_mask);
 }
 
 /**
@@ -2075,7 +2023,7 @@ static bool AirportFindFreeHelipad(Aircraft *v, const AirportFTAClass *apc)
 
 	/* only 1 helicoptergroup, check all helipads
 	 * The blocks for helipads start after the last terminal (MAX_TERMINALS) */
-	return FreeTerminal(v, MAX_TERMINALS, apc->num_helipads + MAX_TERMINALS);
+	return FreeTerminal(v, apc->helipad_mask);
 }
 
 /**
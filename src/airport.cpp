@@ -66,7 +66,8 @@ AIRPORT_GENERIC(dummy, nullptr, 0, AirportFTAClass::ALL, 0)
 
 
 static uint16 AirportGetNofElements(const AirportFTAbuildup *apFA);
-static AirportFTA *AirportBuildAutomata(uint nofelements, const AirportFTAbuildup *apFA);
+static AirportFTA *AirportBuildAutomata(uint nofelements, const AirportFTAbuildup *apFA, uint16 **first_transition);
+static void AirportPrecomputeBlocks(AirportFTA *layout, const uint16 *first_transition, uint nofelements);
 
 
 /**
@@ -126,20 +127,28 @@ AirportFTAClass::AirportFTAClass(
 	delta_z(delta_z_)
 {
 	/* Build the state machine itself */
-	this->layout = AirportBuildAutomata(this->nofelements, apFA);
+	this->layout = AirportBuildAutomata(this->nofelements, apFA, &this->first_transition);
+	AirportPrecomputeBlocks(this->layout, this->first_transition, this->nofelements);
+
+	/* Terminals are numbered in order of their groups, helipads start after the last possible terminal. */
+	MemSetT(this->terminal_group_masks, 0, lengthof(this->terminal_group_masks));
+	uint num_terminals = 0;
+	if (this->terminals != nullptr) {
+		assert(this->terminals[0] <= MAX_TERMINALS);
+		for (uint group = 1; group <= this->terminals[0]; group++) {
+			this->terminal_group_masks[group] = (uint16)(((1U << this->terminals[group]) - 1) << num_terminals);
+			num_terminals += this->terminals[group];
+		}
+	}
+	assert(num_terminals <= MAX_TERMINALS && this->num_helipads <= MAX_HELIPADS);
+	this->terminal_mask = (uint16)((1U << num_terminals) - 1);
+	this->helipad_mask = (uint16)(((1U << this->num_helipads) - 1) << MAX_TERMINALS);
 }
 
 AirportFTAClass::~AirportFTAClass()
 {
-	for (uint i = 0; i < nofelements; i++) {
-		AirportFTA *current = layout[i].next;
-		while (current != nullptr) {
-			AirportFTA *next = current->next;
-			free(current);
-			current = next;
-		}
-	}
 	free(layout);
+	free(first_transition);
 }
 
 /**
@@ -166,39 +175,88 @@ static uint16 AirportGetNofElements(const AirportFTAbuildup *apFA)
  * Construct the FTA given a description.
  * @param nofelements The number of elements in the FTA.
  * @param apFA The description of the FTA.
- * @return The FTA describing the airport.
+ * @param[out] first_transition Index of the first transition of each element, followed by the number of transitions.
+ * @return The transitions of the FTA describing the airport.
  */
-static AirportFTA *AirportBuildAutomata(uint nofelements, const AirportFTAbuildup *apFA)
+static AirportFTA *AirportBuildAutomata(uint nofelements, const AirportFTAbuildup *apFA, uint16 **first_transition)
 {
-	AirportFTA *FAutomata = MallocT<AirportFTA>(nofelements);
+	uint num_transitions = 0;
+	while (apFA[num_transitions].position != MAX_ELEMENTS) num_transitions++;
+
+	AirportFTA *FAutomata = MallocT<AirportFTA>(num_transitions);
+	uint16 *first = MallocT<uint16>(nofelements + 1);
 	uint16 internalcounter = 0;
 
 	for (uint i = 0; i < nofelements; i++) {
-		AirportFTA *current = &FAutomata[i];
-		current->position      = apFA[internalcounter].position;
-		current->heading       = apFA[internalcounter].heading;
-		current->block         = apFA[internalcounter].block;
-		current->next_position = apFA[internalcounter].next;
-
-		/* outgoing nodes from the same position, create linked list */
-		while (current->position == apFA[internalcounter + 1].position) {
-			AirportFTA *newNode = MallocT<AirportFTA>(1);
-
-			newNode->position      = apFA[internalcounter + 1].position;
-			newNode->heading       = apFA[internalcounter + 1].heading;
-			newNode->block         = apFA[internalcounter + 1].block;
-			newNode->next_position = apFA[internalcounter + 1].next;
-			/* create link */
-			current->next = newNode;
-			current = current->next;
+		first[i] = internalcounter;
+
+		/* outgoing nodes from the same position are consecutive */
+		do {
+			AirportFTA *current = &FAutomata[internalcounter];
+			current->position      = apFA[internalcounter].position;
+			current->heading       = apFA[internalcounter].heading;
+			current->block         = apFA[internalcounter].block;
+			current->next_position = apFA[internalcounter].next;
 			internalcounter++;
-		}
-		current->next = nullptr;
-		internalcounter++;
+		} while (apFA[internalcounter].position == apFA[internalcounter - 1].position);
 	}
+	first[nofelements] = internalcounter;
+	assert(internalcounter == num_transitions);
+
+	*first_transition = first;
 	return FAutomata;
 }
 
+/**
+ * Determine the blocks each transition of the FTA has to check and reserve, so that moving
+ * an aircraft only needs to compare them with the blocks of the airport.
+ * @param layout The transitions of the FTA.
+ * @param first_transition Index of the first transition of each element.
+ * @param nofelements The number of elements in the FTA.
+ */
+static void AirportPrecomputeBlocks(AirportFTA *layout, const uint16 *first_transition, uint nofelements)
+{
+	for (uint i = 0; i < nofelements; i++) {
+		const AirportFTA *position = &layout[first_transition[i]];
+		const AirportFTA *end = &layout[first_transition[i + 1]];
+
+		for (AirportFTA *current = &layout[first_transition[i]]; current != end; current++) {
+			current->wait_blocks = 0;
+			current->reserve_blocks = 0;
+			current->occupy_blocks = 0;
+
+			/* Skip transitions whose next position is not a position of this airport; there is no block to look up for them. */
+			if (current->next_position >= nofelements) continue;
+			const AirportFTA *next = &layout[first_transition[current->next_position]];
+
+			/* Same block, then of course we can move. Otherwise also check the extra block of another movement choice. */
+			if (position->block != next->block) {
+				current->wait_blocks = next->block;
+				if (current != position && current->block != NOTHING_block) current->wait_blocks |= current->block;
+			}
+
+			/* If the next position is in another block, check it and the first other block of a
+			 * movement choice with the same heading, and occupy them. */
+			if ((position->block & next->block) != next->block) {
+				uint64 airport_flags = next->block;
+				for (const AirportFTA *other = (current == position ? current + 1 : current); other != end; other++) {
+					if (other->heading == current->heading && other->block != 0) {
+						airport_flags |= other->block;
+						break;
+					}
+				}
+
+				/* if the block to be checked is in the next position, then exclude that from
+				 * checking, because it has been set by the airplane before */
+				if (current->block == next->block) airport_flags ^= next->block;
+
+				current->reserve_blocks = airport_flags;
+				if (next->block != NOTHING_block) current->occupy_blocks = airport_flags;
+			}
+		}
+	}
+}
+
 /**
  * Get the finite state machine of an airport type.
  * @param airport_type %Airport type to query FTA from. @see AirportTypes
@@ -225,8 +283,8 @@ byte GetVehiclePosOnBuild(TileIndex hangar_tile)
 	 * of all depots, it is simple */
 	for (uint i = 0;; i++) {
 		if (st->airport.GetHangarTile(i) == hangar_tile) {
-			assert(apc->layout[i].heading == HANGAR);
-			return apc->layout[i].position;
+			assert(apc->GetPosition(i)->heading == HANGAR);
+			return apc->GetPosition(i)->position;
 		}
 	}
 	NOT_REACHED();
@@ -10,6 +10,7 @@
 #ifndef AIRPORT_H
 #define AIRPORT_H
 
+#include "core/bitmath_func.hpp"
 #include "direction_type.h"
 #include "tile_type.h"
 
@@ -137,6 +138,30 @@ struct AirportMovingData {
 
 AirportMovingData RotateAirportMovingData(const AirportMovingData *orig, Direction rotation, uint num_tiles_x, uint num_tiles_y);
 
+/** Internal structure used in openttd - Finite sTate mAchine --> FTA */
+struct AirportFTA {
+	uint64 block;            ///< 64 bit blocks (st->airport.flags), should be enough for the most complex airports
+	uint64 wait_blocks;      ///< Blocks which have to be free to take this transition without reserving them, see AirportHasBlock.
+	uint64 reserve_blocks;   ///< Blocks which have to be free to take this transition and reserve it, see AirportSetBlocks.
+	uint64 occupy_blocks;    ///< Blocks occupied when taking this transition and reserving it.
+	byte position;           ///< the position that an airplane is at
+	byte next_position;      ///< next position from this position
+	byte heading;            ///< heading (current orders), guiding an airplane to its target on an airport
+};
+
+/**
+ * Get the terminals and helipads of an airport which are occupied.
+ * Terminals are numbered TERM1-TERM8, followed by HELIPAD1-HELIPAD3.
+ * @param airport_flags Blocks of the airport (st->airport.flags).
+ * @return Bitset of the numbers of the occupied terminals and helipads.
+ */
+static inline uint16 GetOccupiedTerminals(uint64 airport_flags)
+{
+	assert_compile(TERM1_block == 1ULL << 0 && TERM6_block == 1ULL << 5 && TERM7_block == 1ULL << 22 && TERM8_block == 1ULL << 23);
+	assert_compile(HELIPAD1_block == 1ULL << 6 && HELIPAD2_block == 1ULL << 7 && HELIPAD3_block == 1ULL << 24);
+	return (uint16)(GB(airport_flags, 0, 6) | GB(airport_flags, 22, 2) << 6 | GB(airport_flags, 6, 2) << 8 | GB(airport_flags, 24, 1) << 10);
+}
+
 struct AirportFTAbuildup;
 
 /** Finite sTate mAchine (FTA) of an airport. */
@@ -173,8 +198,35 @@ public:
 		return &moving_data[position];
 	}
 
+	/**
+	 * Get the state machine element of a position, i.e. the first of its transitions.
+	 * The other transitions of the position directly follow it, up to #GetTransitionsEnd.
+	 * @param position Position to get the element of.
+	 * @return The element.
+	 */
+	const AirportFTA *GetPosition(byte position) const
+	{
+		assert(position < nofelements);
+		return &layout[first_transition[position]];
+	}
+
+	/**
+	 * Get the end of the transitions of a position.
+	 * @param position Position to get the end of the transitions of.
+	 * @return Pointer just beyond the last transition of the position.
+	 */
+	const AirportFTA *GetTransitionsEnd(byte position) const
+	{
+		assert(position < nofelements);
+		return &layout[first_transition[position + 1]];
+	}
+
 	const AirportMovingData *moving_data; ///< Movement data.
-	struct AirportFTA *layout;            ///< state machine for airport
+	AirportFTA *layout;                   ///< State machine for airport; all transitions of all positions, ordered by position.
+	uint16 *first_transition;             ///< Index in #layout of the first transition of each position, followed by the total number of transitions.
+	uint16 terminal_mask;                 ///< Terminals of the airport, as bitset of terminal numbers. See #GetOccupiedTerminals.
+	uint16 helipad_mask;                  ///< Helipads of the airport, as bitset of terminal numbers. See #GetOccupiedTerminals.
+	uint16 terminal_group_masks[MAX_TERMINALS + 1]; ///< Terminals of each terminal group (1 is the first group), as bitset of terminal numbers.
 	const byte *terminals;                ///< %Array with the number of terminal groups, followed by the number of terminals in each group.
 	const byte num_helipads;              ///< Number of helipads on this airport. When 0 helicopters will go to normal terminals.
 	Flags flags;                          ///< Flags for this airport type.
@@ -186,15 +238,6 @@ public:
 DECLARE_ENUM_AS_BIT_SET(AirportFTAClass::Flags)
 
 
-/** Internal structure used in openttd - Finite sTate mAchine --> FTA */
-struct AirportFTA {
-	AirportFTA *next;        ///< possible extra movement choices from this position
-	uint64 block;            ///< 64 bit blocks (st->airport.flags), should be enough for the most complex airports
-	byte position;           ///< the position that an airplane is at
-	byte next_position;      ///< next position from this position
-	byte heading;            ///< heading (current orders), guiding an airplane to its target on an airport
-};
-
 const AirportFTAClass *GetAirport(const byte airport_type);
 byte GetVehiclePosOnBuild(TileIndex hangar_tile);
 
@@ -5,19 +5,188 @@
  * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
  */
 
-/** @file animated_tile.cpp Everything related to animated tiles. */
+/**
+ * @file animated_tile.cpp Everything related to animated tiles.
+ *
+ * The animated tiles are animated in the order in which they were added. Most NewGRF animations only
+ * advance on ticks which are a multiple of 2^speed, and do nothing on the other ticks. To avoid visiting
+ * those tiles on every tick, the tiles are kept in buckets by their animation speed, each in the order in
+ * which they were added. A tick merges the buckets which are due by that order, so the tiles are animated
+ * in the same order as when visiting all tiles. A tile may be in a bucket of a lower speed than its
+ * animation, but never of a higher one, as it would then miss ticks on which it is animated.
+ */
 
 #include "stdafx.h"
 #include "core/alloc_func.hpp"
+#include "core/bitmath_func.hpp"
 #include "core/smallvec_type.hpp"
 #include "tile_cmd.h"
 #include "viewport_func.h"
 #include "framerate_type.h"
+#include "animated_tile_func.h"
+#include "date_func.h"
+#include "house.h"
+#include "industrytype.h"
+#include "industry_map.h"
+#include "newgrf_airporttiles.h"
+#include "newgrf_object.h"
+#include "newgrf_station.h"
+#include "station_map.h"
+#include "town_map.h"
+
+#include <unordered_map>
 
 #include "safeguards.h"
 
-/** The table/list with animated tiles. */
-std::vector<TileIndex> _animated_tiles;
+static const uint ANIMATED_TILE_BUCKETS = 17; ///< Number of animation speed buckets, for the speeds 0 to 16.
+
+/** An animated tile in a bucket. */
+struct AnimatedTileEntry {
+	uint64 order;   ///< Position in the animation order; tiles added later have a higher order.
+	TileIndex tile; ///< The tile, or #INVALID_TILE if it was removed.
+};
+
+/** Location of an animated tile in the buckets. */
+struct AnimatedTileLocation {
+	uint64 order;   ///< Position in the animation order, to find the tile within its bucket.
+	uint8 bucket;   ///< Bucket of the tile.
+};
+
+/** Animated tiles by the animation speed of their bucket, each bucket sorted by the animation order. */
+static std::vector<AnimatedTileEntry> _animated_tile_buckets[ANIMATED_TILE_BUCKETS];
+static uint32 _animated_tile_bucket_removed[ANIMATED_TILE_BUCKETS]; ///< Number of removed entries in each bucket.
+static std::unordered_map<TileIndex, AnimatedTileLocation> _animated_tile_index; ///< Location of each animated tile.
+static uint64 _animated_tile_next_order = 0;     ///< Order of the next added tile.
+static bool _animated_tile_speeds_valid = true;  ///< Whether the tiles are in the buckets of their speed; otherwise all are in bucket 0.
+static bool _animating_tiles = false;            ///< Whether #AnimateAnimatedTiles is iterating the buckets.
+static std::vector<TileIndex> _animated_tile_speed_updates; ///< Tiles to move to the bucket of their speed after iterating.
+
+/**
+ * Get the bucket for the animation speed of a NewGRF animation.
+ * @param spec The specification of the animated tile, may be nullptr.
+ * @param speed_callback Callback mask bit of the animation speed callback.
+ * @return The speed, or 0 if the animation may change on any tick.
+ */
+template <typename Tspec>
+static uint8 GetNewGRFAnimationSpeedBucket(const Tspec *spec, uint speed_callback)
+{
+	if (spec == nullptr || HasBit(spec->callback_mask, speed_callback)) return 0;
+	return min<uint>(spec->animation.speed, ANIMATED_TILE_BUCKETS - 1);
+}
+
+/**
+ * Get the bucket of an animated tile, i.e.\ the largest n such that the tile only animates on ticks which are a multiple of 2^n.
+ * @param tile The tile.
+ * @return The bucket.
+ */
+static uint8 GetAnimatedTileBucket(TileIndex tile)
+{
+	switch (GetTileType(tile)) {
+		case MP_HOUSE: {
+			const HouseID house = GetHouseType(tile);
+			/* The original lifts only move every 4 ticks, see AnimateTile_Town. */
+			if (house < NEW_HOUSE_OFFSET) return 2;
+			return GetNewGRFAnimationSpeedBucket(HouseSpec::Get(house), CBM_HOUSE_ANIMATION_SPEED);
+		}
+
+		case MP_INDUSTRY: {
+			const IndustryTileSpec *its = GetIndustryTileSpec(GetIndustryGfx(tile));
+			/* The original industry animations have their own timings. */
+			if (its->animation.status == ANIM_STATUS_NO_ANIMATION) return 0;
+			return GetNewGRFAnimationSpeedBucket(its, CBM_INDT_ANIM_SPEED);
+		}
+
+		case MP_STATION:
+			if (HasStationRail(tile)) return GetNewGRFAnimationSpeedBucket(GetStationSpec(tile), CBM_STATION_ANIMATION_SPEED);
+			if (IsAirport(tile)) return GetNewGRFAnimationSpeedBucket(AirportTileSpec::GetByTile(tile), CBM_AIRT_ANIM_SPEED);
+			return 0;
+
+		case MP_OBJECT:
+			return GetNewGRFAnimationSpeedBucket(ObjectSpec::GetByTile(tile), CBM_OBJ_ANIMATION_SPEED);
+
+		default:
+			return 0;
+	}
+}
+
+/**
+ * Find the entry of an animated tile in its bucket.
+ * @param location The location of the tile.
+ * @return The entry.
+ */
+static AnimatedTileEntry &FindAnimatedTileEntry(const AnimatedTileLocation &location)
+{
+	std::vector<AnimatedTileEntry> &bucket = _animated_tile_buckets[location.bucket];
+	auto iter = std::lower_bound(bucket.begin(), bucket.end(), location.order, [](const AnimatedTileEntry &entry, uint64 order) {
+		return entry.order < order;
+	});
+	assert(iter != bucket.end() && iter->order == location.order);
+	return *iter;
+}
+
+/**
+ * Insert an animated tile into a bucket, keeping the bucket sorted by animation order.
+ * @param bucket The bucket.
+ * @param order Animation order of the tile.
+ * @param tile The tile.
+ */
+static void InsertAnimatedTileEntry(uint8 bucket, uint64 order, TileIndex tile)
+{
+	std::vector<AnimatedTileEntry> &entries = _animated_tile_buckets[bucket];
+	if (entries.empty() || entries.back().order < order) {
+		entries.push_back({ order, tile });
+		return;
+	}
+
+	auto iter = std::lower_bound(entries.begin(), entries.end(), order, [](const AnimatedTileEntry &entry, uint64 order) {
+		return entry.order < order;
+	});
+	if (iter != entries.end() && iter->order == order) {
+		/* The tile moved back to a bucket it was removed from, and the removed entry was not yet dropped. */
+		assert(iter->tile == INVALID_TILE);
+		iter->tile = tile;
+		_animated_tile_bucket_removed[bucket]--;
+	} else {
+		entries.insert(iter, { order, tile });
+	}
+}
+
+/**
+ * Drop the removed entries of a bucket, if they take up a large part of it.
+ * Not allowed while iterating the buckets.
+ * @param bucket The bucket.
+ */
+static void CompactAnimatedTileBucket(uint8 bucket)
+{
+	std::vector<AnimatedTileEntry> &entries = _animated_tile_buckets[bucket];
+	if (_animated_tile_bucket_removed[bucket] < 64 || _animated_tile_bucket_removed[bucket] * 2 < entries.size()) return;
+
+	entries.erase(std::remove_if(entries.begin(), entries.end(), [](const AnimatedTileEntry &entry) {
+		return entry.tile == INVALID_TILE;
+	}), entries.end());
+	_animated_tile_bucket_removed[bucket] = 0;
+}
+
+/**
+ * Move an animated tile to the bucket of its current animation speed.
+ * @param tile The tile.
+ */
+static void MoveAnimatedTileToSpeedBucket(TileIndex tile)
+{
+	auto iter = _animated_tile_index.find(tile);
+	if (iter == _animated_tile_index.end()) return;
+
+	AnimatedTileLocation &location = iter->second;
+	const uint8 bucket = GetAnimatedTileBucket(tile);
+	if (bucket == location.bucket) return;
+
+	FindAnimatedTileEntry(location).tile = INVALID_TILE;
+	_animated_tile_bucket_removed[location.bucket]++;
+	CompactAnimatedTileBucket(location.bucket);
+
+	location.bucket = bucket;
+	InsertAnimatedTileEntry(bucket, location.order, tile);
+}
 
 /**
  * Removes the given tile from the animated tile table.
@@ -25,23 +194,127 @@ std::vector<TileIndex> _animated_tiles;
  */
 void DeleteAnimatedTile(TileIndex tile)
 {
-	auto to_remove = std::find(_animated_tiles.begin(), _animated_tiles.end(), tile);
-	if (to_remove != _animated_tiles.end()) {
-		/* The order of the remaining elements must stay the same, otherwise the animation loop may miss a tile. */
-		_animated_tiles.erase(to_remove);
-		MarkTileDirtyByTile(tile, ZOOM_LVL_DRAW_MAP);
-	}
+	auto iter = _animated_tile_index.find(tile);
+	if (iter == _animated_tile_index.end()) return;
+
+	const uint8 bucket = iter->second.bucket;
+	FindAnimatedTileEntry(iter->second).tile = INVALID_TILE;
+	_animated_tile_index.erase(iter);
+	_animated_tile_bucket_removed[bucket]++;
+	if (!_animating_tiles) CompactAnimatedTileBucket(bucket);
+
+	MarkTileDirtyByTile(tile, ZOOM_LVL_DRAW_MAP);
 }
 
 /**
  * Add the given tile to the animated tile table (if it does not exist
  * on that table yet). Also increases the size of the table if necessary.
+ * If the tile already exists, it is moved to the bucket of its current animation speed.
  * @param tile the tile to make animated
  */
 void AddAnimatedTile(TileIndex tile)
 {
 	MarkTileDirtyByTile(tile, ZOOM_LVL_DRAW_MAP);
-	include(_animated_tiles, tile);
+
+	if (_animated_tile_index.count(tile) != 0) {
+		UpdateAnimatedTileSpeed(tile);
+		return;
+	}
+
+	const uint8 bucket = _animated_tile_speeds_valid ? GetAnimatedTileBucket(tile) : 0;
+	const uint64 order = _animated_tile_next_order++;
+	_animated_tile_index[tile] = { order, bucket };
+	_animated_tile_buckets[bucket].push_back({ order, tile });
+}
+
+/**
+ * Update the animation speed of an animated tile after the specification of the tile changed,
+ * without removing the tile from the map. Does nothing if the tile is not animated.
+ * @param tile The tile.
+ */
+void UpdateAnimatedTileSpeed(TileIndex tile)
+{
+	if (!_animated_tile_speeds_valid) return;
+
+	if (_animating_tiles) {
+		_animated_tile_speed_updates.push_back(tile);
+	} else {
+		MoveAnimatedTileToSpeedBucket(tile);
+	}
+}
+
+/**
+ * Update the animation speeds of all animated tiles, after the NewGRF specifications were (re)loaded.
+ * The buckets are rebuilt on the next animation tick.
+ */
+void InvalidateAnimatedTileSpeeds()
+{
+	_animated_tile_speeds_valid = false;
+}
+
+/**
+ * Get all animated tiles, in the order in which they are animated.
+ * @return The animated tiles.
+ */
+std::vector<TileIndex> GetAnimatedTiles()
+{
+	std::vector<AnimatedTileEntry> entries;
+	entries.reserve(_animated_tile_index.size());
+	for (const std::vector<AnimatedTileEntry> &bucket : _animated_tile_buckets) {
+		for (const AnimatedTileEntry &entry : bucket) {
+			if (entry.tile != INVALID_TILE) entries.push_back(entry);
+		}
+	}
+	std::sort(entries.begin(), entries.end(), [](const AnimatedTileEntry &a, const AnimatedTileEntry &b) {
+		return a.order < b.order;
+	});
+
+	std::vector<TileIndex> tiles;
+	tiles.reserve(entries.size());
+	for (const AnimatedTileEntry &entry : entries) tiles.push_back(entry.tile);
+	return tiles;
+}
+
+/**
+ * Replace the animated tiles, when loading a game. Duplicate tiles are dropped.
+ * The animation speeds are determined on the next animation tick, as the map and NewGRFs may not be loaded yet.
+ * @param tiles The animated tiles, in the order in which they are animated.
+ */
+void SetAnimatedTiles(const std::vector<TileIndex> &tiles)
+{
+	InitializeAnimatedTiles();
+	_animated_tile_speeds_valid = false;
+
+	std::vector<AnimatedTileEntry> &bucket = _animated_tile_buckets[0];
+	bucket.reserve(tiles.size());
+	for (TileIndex tile : tiles) {
+		if (!_animated_tile_index.insert({ tile, { _animated_tile_next_order, 0 } }).second) continue;
+		bucket.push_back({ _animated_tile_next_order, tile });
+		_animated_tile_next_order++;
+	}
+}
+
+/** Put all animated tiles into the bucket of their speed. */
+static void RebuildAnimatedTileBuckets()
+{
+	std::vector<AnimatedTileEntry> entries;
+	for (uint8 bucket = 0; bucket < ANIMATED_TILE_BUCKETS; bucket++) {
+		for (const AnimatedTileEntry &entry : _animated_tile_buckets[bucket]) {
+			if (entry.tile != INVALID_TILE) entries.push_back(entry);
+		}
+		_animated_tile_buckets[bucket].clear();
+		_animated_tile_bucket_removed[bucket] = 0;
+	}
+	std::sort(entries.begin(), entries.end(), [](const AnimatedTileEntry &a, const AnimatedTileEntry &b) {
+		return a.order < b.order;
+	});
+
+	for (const AnimatedTileEntry &entry : entries) {
+		const uint8 bucket = GetAnimatedTileBucket(entry.tile);
+		_animated_tile_index[entry.tile].bucket = bucket;
+		_animated_tile_buckets[bucket].push_back(entry);
+	}
+	_animated_tile_speeds_valid = true;
 }
 
 /**
@@ -56,9 +329,32 @@ void AnimateAnimatedTiles()
 
 	PerformanceAccumulator framerate(PFE_GL_LANDSCAPE);
 
-	const TileIndex *ti = _animated_tiles.data();
-	while (ti < _animated_tiles.data() + _animated_tiles.size()) {
-		const TileIndex curr = *ti;
+	if (!_animated_tile_speeds_valid) RebuildAnimatedTileBuckets();
+
+	/* The buckets of the speeds n for which the tick counter is a multiple of 2^n are due. */
+	const uint last_due = (_scaled_tick_counter == 0) ? ANIMATED_TILE_BUCKETS - 1 : min<uint>(FindFirstBit(_scaled_tick_counter), ANIMATED_TILE_BUCKETS - 1);
+	size_t positions[ANIMATED_TILE_BUCKETS] = {};
+
+	_animating_tiles = true;
+	for (;;) {
+		/* Pick the due tile with the lowest order. Tiles added or removed while animating
+		 * are added or removed from the buckets right away, so they are taken into account. */
+		uint next_bucket = ANIMATED_TILE_BUCKETS;
+		uint64 next_order = 0;
+		for (uint bucket = 0; bucket <= last_due; bucket++) {
+			const std::vector<AnimatedTileEntry> &entries = _animated_tile_buckets[bucket];
+			size_t &pos = positions[bucket];
+			while (pos < entries.size() && entries[pos].tile == INVALID_TILE) pos++;
+			if (pos < entries.size() && (next_bucket == ANIMATED_TILE_BUCKETS || entries[pos].order < next_order)) {
+				next_bucket = bucket;
+				next_order = entries[pos].order;
+			}
+		}
+		if (next_bucket == ANIMATED_TILE_BUCKETS) break;
+
+		const TileIndex curr = _animated_tile_buckets[next_bucket][positions[next_bucket]].tile;
+		positions[next_bucket]++;
+
 		switch (GetTileType(curr)) {
 			case MP_HOUSE:
 				AnimateTile_Town(curr);
@@ -79,18 +375,16 @@ void AnimateAnimatedTiles()
 			default:
 				NOT_REACHED();
 		}
+	}
+	_animating_tiles = false;
 
-		/* During the AnimateTile call, DeleteAnimatedTile could have been called,
-		 * deleting an element we've already processed and pushing the rest one
-		 * slot to the left. We can detect this by checking whether the index
-		 * in the current slot has changed - if it has, an element has been deleted,
-		 * and we should process the current slot again instead of going forward.
-		 * NOTE: this will still break if more than one animated tile is being
-		 *       deleted during the same AnimateTile call, but no code seems to
-		 *       be doing this anyway.
-		 */
-		if (*ti == curr) ++ti;
+	for (uint8 bucket = 0; bucket <= last_due; bucket++) {
+		CompactAnimatedTileBucket(bucket);
+	}
+	for (TileIndex tile : _animated_tile_speed_updates) {
+		MoveAnimatedTileToSpeedBucket(tile);
 	}
+	_animated_tile_speed_updates.clear();
 }
 
 /**
@@ -98,5 +392,12 @@ void AnimateAnimatedTiles()
  */
 void InitializeAnimatedTiles()
 {
-	_animated_tiles.clear();
+	for (uint8 bucket = 0; bucket < ANIMATED_TILE_BUCKETS; bucket++) {
+		_animated_tile_buckets[bucket].clear();
+		_animated_tile_bucket_removed[bucket] = 0;
+	}
+	_animated_tile_index.clear();
+	_animated_tile_next_order = 0;
+	_animated_tile_speeds_valid = true;
+	_animated_tile_speed_updates.clear();
 }
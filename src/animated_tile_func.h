@@ -11,10 +11,15 @@
 #define ANIMATED_TILE_FUNC_H
 
 #include "tile_type.h"
+#include <vector>
 
 void AddAnimatedTile(TileIndex tile);
 void DeleteAnimatedTile(TileIndex tile);
+void UpdateAnimatedTileSpeed(TileIndex tile);
+void InvalidateAnimatedTileSpeeds();
 void AnimateAnimatedTiles();
 void InitializeAnimatedTiles();
+std::vector<TileIndex> GetAnimatedTiles();
+void SetAnimatedTiles(const std::vector<TileIndex> &tiles);
 
 #endif /* ANIMATED_TILE_FUNC_H */
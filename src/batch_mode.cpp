@@ -0,0 +1,307 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file batch_mode.cpp Headless processing of savegames and scenarios from the command line. */
+
+#include "stdafx.h"
+#include "batch_mode.h"
+#include "debug.h"
+#include "openttd.h"
+#include "progress.h"
+#include "screenshot.h"
+#include "string_func.h"
+#include "saveload/saveload.h"
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#if defined(UNIX) && !defined(__EMSCRIPTEN__)
+#	include <errno.h>
+#	include <sys/types.h>
+#	include <sys/wait.h>
+#	include <unistd.h>
+#endif
+
+#include "safeguards.h"
+
+extern void StateGameLoop();
+extern void CheckCaches(bool force_check, std::function<void(const char *)> log);
+
+/** Types of batch operations. */
+enum BatchOperationType {
+	BOT_TICKS,                ///< Run a number of game ticks.
+	BOT_CHECK_CACHES,         ///< Check the caches against their recalculated values.
+	BOT_SCREENSHOT_MINIMAP,   ///< Make a minimap screenshot of the whole map.
+	BOT_SCREENSHOT_HEIGHTMAP, ///< Make a heightmap screenshot of the whole map.
+	BOT_FORMAT,               ///< Select the format and compression level of subsequent saves.
+	BOT_SAVE,                 ///< Save the game.
+};
+
+/** A single operation of the batch mode. */
+struct BatchOperation {
+	BatchOperationType type; ///< Type of the operation.
+	uint ticks;              ///< Number of ticks to run, for #BOT_TICKS.
+	std::string argument;    ///< File name or format of the operation, may contain "%f".
+};
+
+static std::vector<BatchOperation> _batch_operations; ///< Operations to run once the game has been started.
+static int _batch_exit_code = 0;                      ///< Exit code of the batch mode.
+
+/**
+ * Parse a comma separated list of batch operations, and append them to the operations to run.
+ * @param operations The operations, as given on the command line.
+ * @return True iff all operations are valid.
+ */
+bool ParseBatchOperations(const char *operations)
+{
+	std::string list(operations);
+	size_t start = 0;
+	while (start <= list.size()) {
+		size_t end = list.find(',', start);
+		if (end == std::string::npos) end = list.size();
+		std::string item = list.substr(start, end - start);
+		start = end + 1;
+
+		size_t eq = item.find('=');
+		std::string key = item.substr(0, eq);
+		std::string value = eq == std::string::npos ? std::string() : item.substr(eq + 1);
+		bool has_value = eq != std::string::npos;
+
+		BatchOperation op;
+		op.ticks = 0;
+		if (key == "ticks" && has_value) {
+			char *tail;
+			unsigned long ticks = strtoul(value.c_str(), &tail, 10);
+			if (*tail != '\0' || ticks == 0 || ticks > UINT32_MAX) {
+				DEBUG(misc, 0, "[batch] Invalid number of ticks '%s'", value.c_str());
+				return false;
+			}
+			op.type = BOT_TICKS;
+			op.ticks = (uint)ticks;
+		} else if (key == "checkcaches" && !has_value) {
+			op.type = BOT_CHECK_CACHES;
+		} else if (key == "screenshot" && has_value) {
+			size_t colon = value.find(':');
+			std::string type = value.substr(0, colon);
+			if (type == "minimap") {
+				op.type = BOT_SCREENSHOT_MINIMAP;
+			} else if (type == "heightmap") {
+				op.type = BOT_SCREENSHOT_HEIGHTMAP;
+			} else {
+				DEBUG(misc, 0, "[batch] Unknown screenshot type '%s'", type.c_str());
+				return false;
+			}
+			if (colon != std::string::npos) op.argument = value.substr(colon + 1);
+		} else if (key == "format" && has_value && !value.empty() && value.size() < lengthof(_savegame_format)) {
+			op.type = BOT_FORMAT;
+			op.argument = value;
+		} else if (key == "save" && has_value && !value.empty()) {
+			op.type = BOT_SAVE;
+			op.argument = value;
+		} else {
+			DEBUG(misc, 0, "[batch] Invalid operation '%s'", item.c_str());
+			return false;
+		}
+		_batch_operations.push_back(op);
+	}
+	return true;
+}
+
+/**
+ * Append saving the game to the operations to run.
+ * @param file File to save to, relative to the working directory.
+ */
+void AddBatchSaveOperation(const char *file)
+{
+	BatchOperation op;
+	op.type = BOT_SAVE;
+	op.ticks = 0;
+	op.argument = file;
+	_batch_operations.push_back(op);
+}
+
+/**
+ * Check whether any batch operations have been given on the command line.
+ * @return True iff there are operations to run.
+ */
+bool HasBatchOperations()
+{
+	return !_batch_operations.empty();
+}
+
+/**
+ * Get the exit code of the batch mode.
+ * @return 0 when all operations succeeded, 1 otherwise.
+ */
+int GetBatchExitCode()
+{
+	return _batch_exit_code;
+}
+
+/**
+ * Replace "%f" in an argument of an operation by the name of the loaded file, without directory and extension.
+ * @param argument The argument.
+ * @return The expanded argument.
+ */
+static std::string ExpandBatchArgument(const std::string &argument)
+{
+	std::string name(_file_to_saveload.name);
+	size_t sep = name.find_last_of("/" PATHSEP);
+	if (sep != std::string::npos) name.erase(0, sep + 1);
+	size_t dot = name.rfind('.');
+	if (dot != std::string::npos) name.erase(dot);
+	if (name.empty()) name = "game";
+
+	std::string result = argument;
+	for (size_t pos = result.find("%f"); pos != std::string::npos; pos = result.find("%f", pos + name.size())) {
+		result.replace(pos, 2, name);
+	}
+	return result;
+}
+
+/**
+ * Run a single batch operation.
+ * @param op The operation.
+ * @return True iff the operation succeeded.
+ */
+static bool RunBatchOperation(const BatchOperation &op)
+{
+	switch (op.type) {
+		case BOT_TICKS: {
+			DEBUG(misc, 0, "[batch] Running %u ticks", op.ticks);
+			/* Savegames are usually paused while loading, or by the player. */
+			PauseMode pause_mode = _pause_mode;
+			_pause_mode = PM_UNPAUSED;
+			for (uint i = 0; i < op.ticks; i++) StateGameLoop();
+			_pause_mode = pause_mode;
+			return true;
+		}
+
+		case BOT_CHECK_CACHES: {
+			uint errors = 0;
+			CheckCaches(true, [&errors](const char *) { errors++; });
+			DEBUG(misc, 0, "[batch] Cache check found %u errors", errors);
+			return errors == 0;
+		}
+
+		case BOT_SCREENSHOT_MINIMAP:
+		case BOT_SCREENSHOT_HEIGHTMAP: {
+			std::string name = ExpandBatchArgument(op.argument);
+			const char *file = name.empty() ? nullptr : name.c_str();
+			bool ok = op.type == BOT_SCREENSHOT_MINIMAP ? MakeMinimapWorldScreenshot(file) : MakeScreenshot(SC_HEIGHTMAP, file);
+			DEBUG(misc, 0, "[batch] %s screenshot '%s'", ok ? "Made" : "Failed to make", _full_screenshot_name);
+			return ok;
+		}
+
+		case BOT_FORMAT:
+			strecpy(_savegame_format, op.argument.c_str(), lastof(_savegame_format));
+			return true;
+
+		case BOT_SAVE: {
+			std::string file = ExpandBatchArgument(op.argument);
+			DEBUG(sl, 0, "Saving to '%s'", file.c_str());
+			if (SaveOrLoad(file.c_str(), SLO_SAVE, DFT_GAME_FILE, NO_DIRECTORY, false) != SL_OK) {
+				DEBUG(sl, 0, "Saving to '%s' failed: %s", file.c_str(), GetSaveLoadErrorString() + 3);
+				return false;
+			}
+			return true;
+		}
+
+		default: NOT_REACHED();
+	}
+}
+
+/**
+ * Run the batch operations as soon as the game given on the command line has been started, and quit afterwards.
+ * All operations are run, even when an earlier one failed; any failure results in a non-zero exit code.
+ * @return True iff the operations have been run and the game is quitting.
+ */
+bool ProcessBatchOperations()
+{
+	if (_batch_operations.empty() || _switch_mode != SM_NONE || HasModalProgress()) return false;
+
+	if (_game_mode != GM_NORMAL && _game_mode != GM_EDITOR) {
+		/* Loading failed, and we went back to the main menu. */
+		DEBUG(misc, 0, "[batch] No game has been started, nothing to process");
+		_batch_exit_code = 1;
+	} else {
+		for (const BatchOperation &op : _batch_operations) {
+			if (!RunBatchOperation(op)) _batch_exit_code = 1;
+		}
+	}
+
+	_batch_operations.clear();
+	_exit_game = true;
+	return true;
+}
+
+/**
+ * Process several files by running a copy of this program per file, with the same options.
+ * @param program Path of this program, as it was started.
+ * @param options Command line options, excluding the program and the files.
+ * @param option_count Number of options.
+ * @param files Files to process.
+ * @param file_count Number of files.
+ * @param jobs Maximum number of files processed at the same time, at least 1.
+ * @return Exit code; 0 when all files have been processed successfully.
+ */
+int RunBatchWorkers(const char *program, char **options, int option_count, char **files, int file_count, uint jobs)
+{
+#if defined(UNIX) && !defined(__EMSCRIPTEN__)
+	std::vector<char *> args;
+	args.push_back(const_cast<char *>(program));
+	args.insert(args.end(), options, options + option_count);
+	const size_t file_arg = args.size();
+	args.push_back(nullptr);
+	args.push_back(nullptr);
+
+	std::map<pid_t, int> running; ///< Running workers, with the index of their file.
+	int next = 0;
+	int failed = 0;
+	while (next < file_count || !running.empty()) {
+		if (next < file_count && running.size() < jobs) {
+			args[file_arg] = files[next];
+			pid_t pid = fork();
+			if (pid == 0) {
+				execvp(program, args.data());
+				fprintf(stderr, "[batch] Could not start '%s': %s\n", program, strerror(errno));
+				_exit(127);
+			}
+			if (pid < 0) {
+				DEBUG(misc, 0, "[batch] %s: could not start a worker: %s", files[next], strerror(errno));
+				failed++;
+			} else {
+				running[pid] = next;
+			}
+			next++;
+			continue;
+		}
+
+		int status;
+		pid_t pid = waitpid(-1, &status, 0);
+		if (pid < 0) {
+			if (errno == EINTR) continue;
+			break;
+		}
+
+		auto it = running.find(pid);
+		if (it == running.end()) continue;
+		bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+		DEBUG(misc, 0, "[batch] %s: %s", files[it->second], ok ? "done" : "failed");
+		if (!ok) failed++;
+		running.erase(it);
+	}
+
+	DEBUG(misc, 0, "[batch] Processed %d files, %d failed", file_count, failed);
+	return failed == 0 ? 0 : 1;
+#else
+	usererror("Processing more than one file at once is not supported on this platform");
+	NOT_REACHED();
+#endif
+}
@@ -0,0 +1,20 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file batch_mode.h Headless processing of savegames and scenarios from the command line. */
+
+#ifndef BATCH_MODE_H
+#define BATCH_MODE_H
+
+bool ParseBatchOperations(const char *operations);
+void AddBatchSaveOperation(const char *file);
+bool HasBatchOperations();
+bool ProcessBatchOperations();
+int GetBatchExitCode();
+int RunBatchWorkers(const char *program, char **options, int option_count, char **files, int file_count, uint jobs);
+
+#endif /* BATCH_MODE_H */
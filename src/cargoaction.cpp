@@ -207,6 +207,7 @@ bool StationCargoReroute::operator()(CargoPacket *cp)
 	 * this might insert the packet between range.first and range.second (which might be end())
 	 * This is why we check for GetKey above to avoid infinite loops. */
 	this->destination->packets.Insert(next, cp_new);
+	this->destination->AddToSourceCounts(next, cp_new->SourceStation(), cp_new->Count());
 	return cp_new == cp;
 }
 
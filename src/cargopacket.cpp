@@ -9,6 +9,7 @@
 
 #include "stdafx.h"
 #include "station_base.h"
+#include "vehicle_base.h"
 #include "core/pool_func.hpp"
 #include "core/random_func.hpp"
 #include "economy_base.h"
@@ -18,6 +19,7 @@
 #include "core/backup_type.hpp"
 #include "string_func.h"
 #include "strings_func.h"
+#include "worker_thread.h"
 #include "3rdparty/cpp-btree/btree_map.h"
 
 #include <vector>
@@ -286,6 +288,9 @@ void CargoPacket::PayDeferredPayments()
 	for (CargoPacket *cp : CargoPacket::Iterate()) {
 		if (cp->source == sid) cp->source = INVALID_STATION;
 	}
+	for (Station *st : Station::Iterate()) {
+		for (CargoID c = 0; c < NUM_CARGO; c++) st->goods[c].cargo.InvalidateSource(sid);
+	}
 }
 
 /* static */ bool CargoPacket::ValidateDeferredCargoPayments()
@@ -868,6 +873,84 @@ uint VehicleCargoList::Reroute(uint max_move, VehicleCargoList *dest, StationID
  *
  */
 
+/**
+ * Find the entry for the given next hop and source station in the sorted list of source counts.
+ * @param next Next hop of the cargo.
+ * @param source Source station of the cargo.
+ * @return Iterator to the matching entry or to the position where it should be inserted.
+ */
+StationCargoSourceCountList::iterator StationCargoList::FindSourceCount(StationID next, StationID source)
+{
+	return std::lower_bound(this->source_counts.begin(), this->source_counts.end(), std::make_pair(next, source),
+			[](const StationCargoSourceCount &entry, const std::pair<StationID, StationID> &key) {
+				return std::make_pair(entry.next, entry.source) < key;
+			});
+}
+
+/**
+ * Add some cargo to the amount cached for a next hop and source station.
+ * @param next Next hop of the cargo.
+ * @param source Source station of the cargo.
+ * @param count Amount of cargo to add.
+ */
+void StationCargoList::AddToSourceCounts(StationID next, StationID source, uint count)
+{
+	if (count == 0) return;
+	StationCargoSourceCountList::iterator it = this->FindSourceCount(next, source);
+	if (it != this->source_counts.end() && it->next == next && it->source == source) {
+		it->count += count;
+	} else {
+		this->source_counts.insert(it, { next, source, count });
+	}
+}
+
+/**
+ * Remove some cargo from the amount cached for a next hop and source station.
+ * Entries which drop to zero are removed, so that the list only holds cargo actually waiting.
+ * @param next Next hop of the cargo.
+ * @param source Source station of the cargo.
+ * @param count Amount of cargo to remove.
+ */
+void StationCargoList::RemoveFromSourceCounts(StationID next, StationID source, uint count)
+{
+	if (count == 0) return;
+	StationCargoSourceCountList::iterator it = this->FindSourceCount(next, source);
+	assert(it != this->source_counts.end() && it->next == next && it->source == source && it->count >= count);
+	it->count -= count;
+	if (it->count == 0) this->source_counts.erase(it);
+}
+
+/** Rebuild the amounts of cargo per next hop and source station from the packets. */
+void StationCargoList::RebuildSourceCounts()
+{
+	this->source_counts.clear();
+	for (ConstIterator it(this->packets.begin()); it != this->packets.end(); it++) {
+		this->AddToSourceCounts(it.GetKey(), (*it)->source, (*it)->count);
+	}
+}
+
+/** Invalidates the cached data and rebuilds it. */
+void StationCargoList::InvalidateCache()
+{
+	this->Parent::InvalidateCache();
+	this->RebuildSourceCounts();
+}
+
+/**
+ * Update the cached source counts after the packets of a station have been invalidated.
+ * @param source Station that has been removed.
+ * @see CargoPacket::InvalidateAllFrom(StationID)
+ */
+void StationCargoList::InvalidateSource(StationID source)
+{
+	for (const StationCargoSourceCount &entry : this->source_counts) {
+		if (entry.source == source) {
+			this->RebuildSourceCounts();
+			return;
+		}
+	}
+}
+
 /**
  * Appends the given cargo packet to the range of packets with the same next station
  * @warning After appending this packet may not exist anymore!
@@ -880,6 +963,7 @@ void StationCargoList::Append(CargoPacket *cp, StationID next)
 {
 	assert(cp != nullptr);
 	this->AddToCache(cp);
+	this->AddToSourceCounts(next, cp->source, cp->count);
 
 	StationCargoPacketMap::List &list = this->packets[next];
 	for (StationCargoPacketMap::List::reverse_iterator it(list.rbegin());
@@ -910,9 +994,14 @@ bool StationCargoList::ShiftCargo(Taction &action, StationID next)
 	for (Iterator it(range.first); it != range.second && it.GetKey() == next;) {
 		if (action.MaxMove() == 0) return false;
 		CargoPacket *cp = *it;
+		/* The action may delete the packet, so remember what it was. */
+		const StationID source = cp->source;
+		const uint count = cp->count;
 		if (action(cp)) {
+			this->RemoveFromSourceCounts(next, source, count);
 			it = this->packets.erase(it);
 		} else {
+			this->RemoveFromSourceCounts(next, source, count - cp->count);
 			return false;
 		}
 	}
@@ -976,6 +1065,7 @@ uint StationCargoList::Truncate(uint max_move, StationCargoAmountMap *cargo_per_
 			if (cp->count > diff) {
 				if (diff > 0) {
 					this->RemoveFromCache(cp, diff);
+					this->RemoveFromSourceCounts(it.GetKey(), cp->source, diff);
 					cp->Reduce(diff);
 					moved += diff;
 				}
@@ -987,6 +1077,7 @@ uint StationCargoList::Truncate(uint max_move, StationCargoAmountMap *cargo_per_
 					++it;
 				}
 			} else {
+				this->RemoveFromSourceCounts(it.GetKey(), cp->source, cp->count);
 				it = this->packets.erase(it);
 				if (do_count && loop > 0) {
 					(*cargo_per_source)[cp->source] -= cp->count;
@@ -1051,6 +1142,44 @@ uint StationCargoList::Reroute(uint max_move, StationCargoList *dest, StationID
 	return this->ShiftCargo(StationCargoReroute(this, dest, max_move, avoid, avoid2, ge), avoid, false);
 }
 
+/**
+ * Estimate the memory allocated by a list of cargo packets.
+ * This assumes the list allocates blocks of 512 bytes, plus an array of at least 8 pointers to them.
+ * @param packets List to estimate.
+ * @return Number of bytes.
+ */
+static size_t EstimateCargoPacketListMemoryUsage(const CargoPacketList &packets)
+{
+	const size_t blocks = packets.size() * sizeof(CargoPacket *) / 512 + 1;
+	return blocks * 512 + max<size_t>(8, blocks + 2) * sizeof(CargoPacket **);
+}
+
+/**
+ * Estimate the memory allocated by the cargo packet lists of all vehicles and stations.
+ * The cargo packets themselves are accounted to their pool.
+ * @return Number of bytes.
+ */
+size_t GetCargoPacketListMemoryUsage()
+{
+	auto sum = [](size_t &total, const size_t &partial) { total += partial; };
+
+	size_t bytes = ParallelPoolReduce<Vehicle>((size_t)0, [](size_t &total, const Vehicle *v) {
+		total += EstimateCargoPacketListMemoryUsage(*v->cargo.Packets());
+	}, sum);
+
+	bytes += ParallelPoolReduce<Station>((size_t)0, [](size_t &total, const Station *st) {
+		for (CargoID c = 0; c < NUM_CARGO; c++) {
+			const StationCargoPacketMap *packets = st->goods[c].cargo.Packets();
+			for (StationCargoPacketMap::ConstMapIterator it(packets->begin()); it != packets->end(); ++it) {
+				/* Tree node of the map, with its links, plus the list itself. */
+				total += sizeof(*it) + 4 * sizeof(void *) + EstimateCargoPacketListMemoryUsage(it->second);
+			}
+		}
+	}, sum);
+
+	return bytes;
+}
+
 /*
  * We have to instantiate everything we want to be usable.
  */
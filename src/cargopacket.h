@@ -19,13 +19,14 @@
 #include "company_type.h"
 #include "core/multimap.hpp"
 #include <deque>
+#include <vector>
 
 /** Unique identifier for a single cargo packet. */
 typedef uint32 CargoPacketID;
 struct CargoPacket;
 
 /** Type of the pool for cargo packets for a little over 16 million packets. */
-typedef Pool<CargoPacket, CargoPacketID, 1024, 0xFFF000, PT_NORMAL, true, false> CargoPacketPool;
+typedef Pool<CargoPacket, CargoPacketID, 1024, 0xFFF000, PT_NORMAL, false> CargoPacketPool;
 /** The actual pool with cargo packets. */
 extern CargoPacketPool _cargopacket_pool;
 
@@ -39,6 +40,7 @@ typedef uint32 TileOrStationID;
 
 void ClearCargoPacketDeferredPayments();
 void ChangeOwnershipOfCargoPacketDeferredPayments(Owner old_owner, Owner new_owner);
+size_t GetCargoPacketListMemoryUsage();
 
 /**
  * Container for cargo from the same location and time.
@@ -479,6 +481,16 @@ public:
 typedef MultiMap<StationID, CargoPacket *, CargoPacketList> StationCargoPacketMap;
 typedef std::map<StationID, uint> StationCargoAmountMap;
 
+/** Amount of cargo in a station cargo list with the same next hop and source station. */
+struct StationCargoSourceCount {
+	StationID next;   ///< Next hop of the cargo.
+	StationID source; ///< Station the cargo came from first.
+	uint count;       ///< Amount of cargo.
+};
+
+/** Flat list of cargo amounts, sorted by next hop and source station. */
+typedef std::vector<StationCargoSourceCount> StationCargoSourceCountList;
+
 /**
  * CargoList that is used for stations.
  */
@@ -489,6 +501,13 @@ protected:
 
 	uint reserved_count; ///< Amount of cargo being reserved for loading.
 
+	StationCargoSourceCountList source_counts; ///< Amounts of available cargo per next hop and source station.
+
+	StationCargoSourceCountList::iterator FindSourceCount(StationID next, StationID source);
+	void AddToSourceCounts(StationID next, StationID source, uint count);
+	void RemoveFromSourceCounts(StationID next, StationID source, uint count);
+	void RebuildSourceCounts();
+
 public:
 	/** The super class ought to know what it's doing. */
 	friend class CargoList<StationCargoList, StationCargoPacketMap>;
@@ -513,6 +532,21 @@ public:
 
 	void Append(CargoPacket *cp, StationID next);
 
+	void InvalidateCache();
+
+	void InvalidateSource(StationID source);
+
+	/**
+	 * Returns the amounts of available cargo per next hop and source station.
+	 * This is kept up to date with the packets, so it can be used instead of
+	 * iterating over all of them.
+	 * @return Cargo amounts, sorted by next hop and source station.
+	 */
+	inline const StationCargoSourceCountList &SourceCounts() const
+	{
+		return this->source_counts;
+	}
+
 	/**
 	 * Check for cargo headed for a specific station.
 	 * @param next Station the cargo is headed for.
@@ -591,7 +625,8 @@ public:
 		return cp1->source_xy    == cp2->source_xy &&
 				cp1->days_in_transit == cp2->days_in_transit &&
 				cp1->source_type     == cp2->source_type &&
-				cp1->source_id       == cp2->source_id;
+				cp1->source_id       == cp2->source_id &&
+				cp1->source          == cp2->source;
 	}
 };
 
@@ -47,7 +47,16 @@
 #include "town.h"
 #include "industry.h"
 #include "string_func_extra.h"
+#include "cargopacket.h"
+#include "order_base.h"
+#include "object_base.h"
+#include "core/kdtree.hpp"
+#include "worker_thread.h"
+#include "memory_usage.h"
+#include "sampling_profiler.h"
 #include <time.h>
+#include <chrono>
+#include <random>
 
 #include "safeguards.h"
 
@@ -1408,6 +1417,90 @@ DEF_CONSOLE_CMD(ConGetSysDate)
 	return true;
 }
 
+DEF_CONSOLE_CMD(ConMemoryUsage)
+{
+	if (argc == 0) {
+		IConsoleHelp("Show the current and peak memory usage of the larger subsystems. Usage: 'memory_usage [pools]'");
+		IConsoleHelp("  'pools' also shows the usage of each pool.");
+		return true;
+	}
+
+	if (argc > 2) return false;
+	const bool show_pools = (argc == 2 && strcmp(argv[1], "pools") == 0);
+	if (argc == 2 && !show_pools) return false;
+
+	UpdateEstimatedMemoryUsage();
+
+	size_t total = 0;
+	for (MemoryUsageCategory category = MUC_BEGIN; category < MUC_END; category++) {
+		const size_t current = _memory_usage[category].current.load(std::memory_order_relaxed);
+		const size_t peak = _memory_usage[category].peak.load(std::memory_order_relaxed);
+		total += current;
+		IConsolePrintF(CC_DEFAULT, "%-14s current: %10.2f MiB, peak: %10.2f MiB", GetMemoryUsageCategoryName(category), current / 1048576.0, peak / 1048576.0);
+	}
+	IConsolePrintF(CC_INFO, "%-14s current: %10.2f MiB", "total", total / 1048576.0);
+
+	if (show_pools) {
+		for (const PoolBase *pool : *PoolBase::GetPools()) {
+			if (pool->memory_peak == 0) continue;
+			IConsolePrintF(CC_DEFAULT, "  pool %-24s current: %10.2f MiB, peak: %10.2f MiB", pool->GetName(), pool->memory_usage / 1048576.0, pool->memory_peak / 1048576.0);
+		}
+	}
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConProfiler)
+{
+	if (argc == 0) {
+		IConsoleHelp("Sample the call stacks of the game loop, to find what it spends its time on. Usage: 'profiler start [<frequency>] | stop | status | dump <file>'");
+		IConsoleHelp("  'start' samples <frequency> times per second of CPU time used, by default 100.");
+		IConsoleHelp("  'dump' writes the stacks sampled since the last dump as folded stacks, for use by flame graph tools.");
+		return true;
+	}
+
+	if (argc < 2 || argc > 3) return false;
+
+	if (!IsSamplingProfilerSupported()) {
+		IConsoleError("The sampling profiler is not supported on this platform.");
+		return true;
+	}
+
+	if (strcmp(argv[1], "start") == 0) {
+		uint32 frequency = 100;
+		if (argc == 3 && !GetArgumentInteger(&frequency, argv[2])) return false;
+		if (!StartSamplingProfiler(frequency)) {
+			IConsoleError("Could not start the sampling profiler.");
+			return true;
+		}
+		IConsolePrintF(CC_DEFAULT, "Sampling profiler running at %u Hz.", GetSamplingProfilerStatus().frequency);
+	} else if (strcmp(argv[1], "stop") == 0) {
+		if (argc != 2) return false;
+		StopSamplingProfiler();
+		IConsolePrint(CC_DEFAULT, "Sampling profiler stopped.");
+	} else if (strcmp(argv[1], "status") == 0) {
+		if (argc != 2) return false;
+		const SamplingProfilerStatus status = GetSamplingProfilerStatus();
+		if (status.running) {
+			IConsolePrintF(CC_DEFAULT, "Sampling profiler running at %u Hz.", status.frequency);
+		} else {
+			IConsolePrint(CC_DEFAULT, "Sampling profiler not running.");
+		}
+		IConsolePrintF(CC_DEFAULT, "Since the last dump: " OTTD_PRINTF64U " samples, " OTTD_PRINTF64U " dropped, " PRINTF_SIZE " distinct stacks.",
+				status.samples, status.dropped, status.stacks);
+	} else if (strcmp(argv[1], "dump") == 0) {
+		if (argc != 3) return false;
+		const uint64 samples = GetSamplingProfilerStatus().samples;
+		if (!DumpSamplingProfile(argv[2])) {
+			IConsolePrintF(CC_ERROR, "Could not write '%s'.", argv[2]);
+			return true;
+		}
+		IConsolePrintF(CC_DEFAULT, "Wrote " OTTD_PRINTF64U " samples to '%s'.", samples, argv[2]);
+	} else {
+		return false;
+	}
+	return true;
+}
+
 
 DEF_CONSOLE_CMD(ConAlias)
 {
@@ -2133,6 +2226,238 @@ DEF_CONSOLE_CMD(ConDumpLoadDebugLog)
 	return true;
 }
 
+/**
+ * Time iterating over all items of a pool.
+ * @tparam T Pool item type.
+ * @param name Name of the pool to print.
+ * @param loops Number of times to iterate over the pool.
+ */
+template <typename T>
+static void BenchmarkPoolIteration(const char *name, uint loops)
+{
+	size_t checksum = 0;
+	const auto start = std::chrono::steady_clock::now();
+	for (uint i = 0; i < loops; i++) {
+		for (const T *item : T::Iterate()) {
+			checksum += item->index;
+		}
+	}
+	const auto end = std::chrono::steady_clock::now();
+
+	const double total_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+	const size_t items = T::GetNumItems();
+	IConsolePrintF(CC_DEFAULT, "%-12s items: %7u, pool size: %7u, %9.3f us per iteration, %7.2f ns per item (checksum: " PRINTF_SIZEX ")",
+			name, (uint)items, (uint)T::GetPoolSize(), total_ns / (loops * 1000.0), items > 0 ? total_ns / ((double)loops * items) : 0.0, checksum);
+}
+
+DEF_CONSOLE_CMD(ConBenchmarkPoolIteration)
+{
+	if (argc == 0) {
+		IConsoleHelp("Debug: Time iterating over the game object pools.  Usage: 'benchmark_pool_iteration [<loops>]'");
+		return true;
+	}
+
+	if (argc > 2) return false;
+
+	uint32 loops = 100;
+	if (argc == 2 && !GetArgumentInteger(&loops, argv[1])) return false;
+	loops = max<uint32>(loops, 1);
+
+	BenchmarkPoolIteration<Vehicle>("Vehicle", loops);
+	BenchmarkPoolIteration<CargoPacket>("CargoPacket", loops);
+	BenchmarkPoolIteration<Order>("Order", loops);
+	BenchmarkPoolIteration<BaseStation>("Station", loops);
+	BenchmarkPoolIteration<Town>("Town", loops);
+	BenchmarkPoolIteration<Industry>("Industry", loops);
+	BenchmarkPoolIteration<Object>("Object", loops);
+	return true;
+}
+
+/** Coordinates of the elements of the kd-tree benchmark. */
+static std::vector<std::pair<uint16, uint16>> _kdtree_benchmark_coords;
+
+static uint16 Kdtree_BenchmarkXYFunc(uint32 index, int dim)
+{
+	return (dim == 0) ? _kdtree_benchmark_coords[index].first : _kdtree_benchmark_coords[index].second;
+}
+
+typedef Kdtree<uint32, decltype(&Kdtree_BenchmarkXYFunc), uint16, int> BenchmarkKdtree;
+
+DEF_CONSOLE_CMD(ConBenchmarkKdtree)
+{
+	if (argc == 0) {
+		IConsoleHelp("Debug: Time building, updating and querying a kd-tree of random points.  Usage: 'benchmark_kdtree [<elements>]'");
+		return true;
+	}
+
+	if (argc > 2) return false;
+
+	uint32 count = 20000;
+	if (argc == 2 && !GetArgumentInteger(&count, argv[1])) return false;
+	count = Clamp<uint32>(count, 16, 1 << 22);
+
+	/* Use a private generator, the game's random state must not be touched. */
+	std::mt19937 rng(count);
+	_kdtree_benchmark_coords.resize(count);
+	for (auto &coord : _kdtree_benchmark_coords) coord = std::make_pair((uint16)(rng() % 4096), (uint16)(rng() % 4096));
+
+	std::vector<uint32> elements(count);
+	for (uint32 i = 0; i < count; i++) elements[i] = i;
+
+	BenchmarkKdtree tree(&Kdtree_BenchmarkXYFunc);
+	auto time_us = [](std::chrono::steady_clock::time_point start) -> double {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count() / 1000.0;
+	};
+	const uint32 updates = count / 2;
+
+	auto start = std::chrono::steady_clock::now();
+	tree.Build(elements.begin(), elements.end(), &RunParallelTasks);
+	IConsolePrintF(CC_DEFAULT, "Build:         %10.1f us total (%u threads)", time_us(start), GetWorkerThreadCount());
+
+	start = std::chrono::steady_clock::now();
+	tree.Rebuild();
+	IConsolePrintF(CC_DEFAULT, "Rebuild:       %10.1f us total", time_us(start));
+
+	start = std::chrono::steady_clock::now();
+	for (uint32 i = 0; i < updates; i++) tree.Remove(elements[i]);
+	IConsolePrintF(CC_DEFAULT, "Remove:        %10.3f us per element", time_us(start) / updates);
+
+	start = std::chrono::steady_clock::now();
+	for (uint32 i = 0; i < updates; i++) tree.Insert(elements[i]);
+	IConsolePrintF(CC_DEFAULT, "Insert:        %10.3f us per element", time_us(start) / updates);
+
+	/* Move elements around, like signs being renamed or stations being moved. */
+	start = std::chrono::steady_clock::now();
+	for (uint32 i = 0; i < updates; i++) {
+		uint32 element = rng() % count;
+		tree.Remove(element);
+		_kdtree_benchmark_coords[element] = std::make_pair((uint16)(rng() % 4096), (uint16)(rng() % 4096));
+		tree.Insert(element);
+	}
+	IConsolePrintF(CC_DEFAULT, "Move:          %10.3f us per element", time_us(start) / updates);
+
+	uint64 checksum = 0;
+	start = std::chrono::steady_clock::now();
+	for (uint32 i = 0; i < count; i++) checksum += tree.FindNearest(rng() % 4096, rng() % 4096);
+	IConsolePrintF(CC_DEFAULT, "FindNearest:   %10.3f us per query", time_us(start) / count);
+
+	start = std::chrono::steady_clock::now();
+	for (uint32 i = 0; i < count; i++) {
+		uint16 x = rng() % 4064;
+		uint16 y = rng() % 4064;
+		tree.FindContained(x, y, x + 32, y + 32, [&](uint32 element) { checksum += element; });
+	}
+	IConsolePrintF(CC_DEFAULT, "FindContained: %10.3f us per 32x32 query (checksum: " OTTD_PRINTF64U ")", time_us(start) / count, checksum);
+
+	tree.Clear();
+	_kdtree_benchmark_coords.clear();
+	_kdtree_benchmark_coords.shrink_to_fit();
+	return true;
+}
+
+/**
+ * Time reading map arrays in the order of the tile loop, and in the pattern of a pathfinder.
+ * @param m Tile array to read.
+ * @param me Extended tile array to read.
+ * @param name Name of the arrays to print.
+ * @param passes Number of passes over the whole map.
+ */
+static void BenchmarkMapAccess(const Tile *m, const TileExtended *me, const char *name, uint passes)
+{
+	auto time_ns = [](std::chrono::steady_clock::time_point start) -> double {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	};
+	const uint64 reads = (uint64)passes * MapSize();
+	uint64 checksum = 0;
+
+	/* The tile loop, see RunTileLoop. */
+	const uint32 feedback = GetTileLoopFeedback();
+	auto start = std::chrono::steady_clock::now();
+	for (uint i = 0; i < passes; i++) {
+		TileIndex tile = 1;
+		do {
+			checksum += m[tile].type + m[tile].height + m[tile].m1 + m[tile].m2 + m[tile].m3 + m[tile].m4 + m[tile].m5 + me[tile].m6;
+			tile = (tile >> 1) ^ (-(int32)(tile & 1) & feedback);
+		} while (tile != 1);
+	}
+	const double tile_loop_ns = time_ns(start);
+
+	/* Pathfinders follow routes over neighbouring tiles, which jump over whole rows in the arrays. */
+	std::mt19937 rng(MapSize());
+	const TileIndexDiff steps[] = { 1, -1, (TileIndexDiff)MapSizeX(), -(TileIndexDiff)MapSizeX() };
+	start = std::chrono::steady_clock::now();
+	for (uint64 i = 0; i < reads; i += 256) {
+		TileIndex tile = TILE_MASK(rng());
+		for (uint j = 0; j < 256; j++) {
+			checksum += m[tile].type + m[tile].m5 + me[tile].m8;
+			tile = TILE_MASK(tile + steps[rng() % lengthof(steps)]);
+		}
+	}
+	const double pathfinder_ns = time_ns(start);
+
+	IConsolePrintF(CC_DEFAULT, "%-10s tile loop: %7.2f ns per tile, pathfinder walk: %7.2f ns per tile (checksum: " OTTD_PRINTF64U ")",
+			name, tile_loop_ns / reads, pathfinder_ns / reads, checksum);
+}
+
+DEF_CONSOLE_CMD(ConBenchmarkMapAccess)
+{
+	if (argc == 0) {
+		IConsoleHelp("Debug: Time reading the map arrays, as allocated according to the 'huge_pages' setting and as a plain copy.  Usage: 'benchmark_map_access [<passes>]'");
+		return true;
+	}
+
+	if (argc > 2) return false;
+
+	uint32 passes = 4;
+	if (argc == 2 && !GetArgumentInteger(&passes, argv[1])) return false;
+	passes = Clamp<uint32>(passes, 1, 1000);
+
+	static const char * const modes[] = { "off", "transparent", "explicit" };
+	IConsolePrintF(CC_DEFAULT, "Map size: %ux%u, map arrays: %u KiB, huge pages: %s", MapSizeX(), MapSizeY(),
+			(uint)(MapSize() * (sizeof(Tile) + sizeof(TileExtended)) / 1024), modes[_huge_page_mode]);
+
+	Tile *m = CallocT<Tile>(MapSize());
+	TileExtended *me = CallocT<TileExtended>(MapSize());
+	MemCpyT(m, _m, MapSize());
+	MemCpyT(me, _me, MapSize());
+
+	BenchmarkMapAccess(_m, _me, "map", passes);
+	BenchmarkMapAccess(m, me, "plain copy", passes);
+
+	free(m);
+	free(me);
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConBenchmarkLevelLand)
+{
+	if (argc == 0) {
+		IConsoleHelp("Debug: Time a test run of levelling a square of land at the centre of the map to the height of its north corner.  Usage: 'benchmark_level_land [<size>]'");
+		return true;
+	}
+
+	if (argc > 2) return false;
+
+	uint32 size = 100;
+	if (argc == 2 && !GetArgumentInteger(&size, argv[1])) return false;
+	size = Clamp<uint32>(size, 1, min(MapSizeX(), MapSizeY()) - 2);
+
+	TileIndex start = TileXY((MapSizeX() - size) / 2, (MapSizeY() - size) / 2);
+	TileIndex end = start + TileDiffXY(size - 1, size - 1);
+
+	const auto begin = std::chrono::steady_clock::now();
+	CommandCost cost = DoCommand(end, start, LM_LEVEL << 1, DC_NONE, CMD_LEVEL_LAND);
+	const auto finish = std::chrono::steady_clock::now();
+
+	const double ms = std::chrono::duration_cast<std::chrono::microseconds>(finish - begin).count() / 1000.0;
+	if (cost.Succeeded()) {
+		IConsolePrintF(CC_DEFAULT, "Levelling %ux%u tiles: cost " OTTD_PRINTF64 ", %.3f ms", size, size, (int64)cost.GetCost(), ms);
+	} else {
+		IConsolePrintF(CC_DEFAULT, "Levelling %ux%u tiles: failed, %.3f ms", size, size, ms);
+	}
+	return true;
+}
+
 DEF_CONSOLE_CMD(ConCheckCaches)
 {
 	if (argc == 0) {
@@ -2521,6 +2846,8 @@ void IConsoleStdLibRegister()
 	IConsoleCmdRegister("getseed",      ConGetSeed);
 	IConsoleCmdRegister("getdate",      ConGetDate);
 	IConsoleCmdRegister("getsysdate",   ConGetSysDate);
+	IConsoleCmdRegister("memory_usage", ConMemoryUsage);
+	IConsoleCmdRegister("profiler",     ConProfiler);
 	IConsoleCmdRegister("quit",         ConExit);
 	IConsoleCmdRegister("resetengines", ConResetEngines, ConHookNoNetwork);
 	IConsoleCmdRegister("reset_enginepool", ConResetEnginePool, ConHookNoNetwork);
@@ -2648,6 +2975,10 @@ void IConsoleStdLibRegister()
 	IConsoleCmdRegister("dump_game_events", ConDumpGameEvents, nullptr, true);
 	IConsoleCmdRegister("dump_load_debug_log", ConDumpLoadDebugLog, nullptr, true);
 	IConsoleCmdRegister("check_caches", ConCheckCaches, nullptr, true);
+	IConsoleCmdRegister("benchmark_pool_iteration", ConBenchmarkPoolIteration, nullptr, true);
+	IConsoleCmdRegister("benchmark_kdtree", ConBenchmarkKdtree, nullptr, true);
+	IConsoleCmdRegister("benchmark_map_access", ConBenchmarkMapAccess, nullptr, true);
+	IConsoleCmdRegister("benchmark_level_land", ConBenchmarkLevelLand, nullptr, true);
 	IConsoleCmdRegister("show_town_window", ConShowTownWindow, nullptr, true);
 	IConsoleCmdRegister("show_station_window", ConShowStationWindow, nullptr, true);
 	IConsoleCmdRegister("show_industry_window", ConShowIndustryWindow, nullptr, true);
@@ -5,9 +5,15 @@
  * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
  */
 
-/** @file alloc_func.cpp Functions to 'handle' memory allocation errors */
+/** @file alloc_func.cpp Functions to 'handle' memory allocation errors and to make large allocations */
 
 #include "../stdafx.h"
+#include "alloc_func.hpp"
+#include "math_func.hpp"
+
+#if defined(__linux__)
+#	include <sys/mman.h>
+#endif
 
 #include "../safeguards.h"
 
@@ -28,3 +34,64 @@ void NORETURN ReallocError(size_t size)
 {
 	error("Out of memory. Cannot reallocate " PRINTF_SIZE " bytes", size);
 }
+
+byte _huge_page_mode = HPM_TRANSPARENT; ///< How large allocations are backed by huge pages, see #HugePageMode.
+
+/**
+ * Allocate zeroed memory for a large array, see #LargeCallocT.
+ * On Linux allocations of at least #HUGE_PAGE_SIZE are mapped directly, aligned
+ * to a huge page, so they can be backed by huge pages. Elsewhere, and for
+ * smaller allocations, this is a normal calloc().
+ * @param size number of bytes to allocate
+ * @return nullptr when size == 0, non-nullptr otherwise.
+ */
+void *LargeAlloc(size_t size)
+{
+	if (size == 0) return nullptr;
+
+#if defined(__linux__)
+	if (size >= HUGE_PAGE_SIZE) {
+		const size_t map_size = Align(size, HUGE_PAGE_SIZE);
+
+#	ifdef MAP_HUGETLB
+		if (_huge_page_mode == HPM_EXPLICIT) {
+			/* This fails when not enough huge pages are reserved; then fall back to transparent huge pages. */
+			void *ptr = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+			if (ptr != MAP_FAILED) return ptr;
+		}
+#	endif
+
+		/* Map an extra huge page, so the start can be aligned to a huge page boundary. */
+		byte *mapping = (byte *)mmap(nullptr, map_size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (mapping == (byte *)MAP_FAILED) MallocError(size);
+
+		byte *ptr = AlignPtr(mapping, HUGE_PAGE_SIZE);
+		if (ptr != mapping) munmap(mapping, ptr - mapping);
+		munmap(ptr + map_size, mapping + HUGE_PAGE_SIZE - ptr);
+
+#	ifdef MADV_HUGEPAGE
+		if (_huge_page_mode != HPM_OFF) madvise(ptr, map_size, MADV_HUGEPAGE);
+#	endif
+		return ptr;
+	}
+#endif
+
+	return CallocT<byte>(size);
+}
+
+/**
+ * Free memory allocated with #LargeAlloc.
+ * @param ptr the allocation to free, may be nullptr
+ * @param size number of bytes the memory was allocated for
+ */
+void LargeFree(void *ptr, size_t size)
+{
+#if defined(__linux__)
+	if (size >= HUGE_PAGE_SIZE) {
+		if (ptr != nullptr) munmap(ptr, Align(size, HUGE_PAGE_SIZE));
+		return;
+	}
+#endif
+
+	free(ptr);
+}
@@ -20,6 +20,21 @@
 void NORETURN MallocError(size_t size);
 void NORETURN ReallocError(size_t size);
 
+/** How large allocations are backed by huge pages. */
+enum HugePageMode {
+	HPM_OFF,         ///< Use normal pages only.
+	HPM_TRANSPARENT, ///< Advise the kernel to back large allocations with transparent huge pages.
+	HPM_EXPLICIT,    ///< Map large allocations from the reserved huge pages, falling back to #HPM_TRANSPARENT when none are available.
+};
+
+/** Size of a huge page; allocations of at least this size are made by mapping memory directly. */
+static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+extern byte _huge_page_mode;
+
+void *LargeAlloc(size_t size);
+void LargeFree(void *ptr, size_t size);
+
 /**
  * Checks whether allocating memory would overflow size_t.
  *
@@ -128,6 +143,38 @@ static inline T *ReallocT(T *t_ptr, size_t num_elements)
 	return t_ptr;
 }
 
+/**
+ * Allocation function for large, long-lived arrays which are accessed randomly,
+ * such as the map. When supported, the memory is backed by huge pages
+ * according to #_huge_page_mode, which reduces the TLB misses on access.
+ * @note throws an error when there is no memory anymore.
+ * @note the memory contains all zero values.
+ * @note the memory must be freed with #LargeFreeT using the same number of elements.
+ * @tparam T the type of the variable(s) to allocation.
+ * @param num_elements the number of elements to allocate of the given type.
+ * @return nullptr when num_elements == 0, non-nullptr otherwise.
+ */
+template <typename T>
+static inline T *LargeCallocT(size_t num_elements)
+{
+	/* Ensure the size does not overflow. */
+	CheckAllocationConstraints<T>(num_elements);
+
+	return (T*)LargeAlloc(num_elements * sizeof(T));
+}
+
+/**
+ * Free memory allocated with #LargeCallocT.
+ * @tparam T the type of the variable(s) to free.
+ * @param t_ptr the allocation to free, may be nullptr.
+ * @param num_elements the number of elements the memory was allocated for.
+ */
+template <typename T>
+static inline void LargeFreeT(T *t_ptr, size_t num_elements)
+{
+	LargeFree(static_cast<void *>(t_ptr), num_elements * sizeof(T));
+}
+
 /** alloca() has to be called in the parent function, so define AllocaM() as a macro */
 #define AllocaM(T, num_elements) \
 	(CheckAllocationConstraints<T>(num_elements), \
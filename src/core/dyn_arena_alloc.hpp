@@ -5,11 +5,13 @@
  * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
  */
 
-/** @file dyn_arena_alloc.hpp Dynamic chunk-size arena allocator. */
+/** @file dyn_arena_alloc.hpp Dynamic chunk-size arena allocator, and bump arena allocator for short-lived allocations. */
 
 #ifndef DYN_ARENA_ALLOC_HPP
 #define DYN_ARENA_ALLOC_HPP
 
+#include "alloc_func.hpp"
+#include "math_func.hpp"
 #include <vector>
 
 /**
@@ -97,4 +99,129 @@ class DynUniformArenaAllocator {
 	}
 };
 
+/**
+ * Arena allocator for short-lived allocations of any size, which hands out memory by bumping a pointer.
+ * Freeing memory only counts the outstanding allocations; the current block is reused once all
+ * allocations have been freed, and #Reset merges the blocks into one.
+ * @note This is not thread-safe.
+ */
+class BumpArena {
+	std::vector<byte *> blocks; ///< All blocks, the last one is the current block.
+	size_t used = 0;            ///< Number of bytes used of the current block.
+	size_t block_size = 0;      ///< Size of the current block.
+	size_t total_size = 0;      ///< Size of all blocks.
+	size_t allocations = 0;     ///< Number of allocations which have not been freed.
+
+	void NewBlock(size_t min_size)
+	{
+		/* Grow geometrically, so a burst of allocations needs few blocks. */
+		this->block_size = max(min_size, max(this->total_size, MIN_BLOCK_SIZE));
+		this->blocks.push_back(MallocT<byte>(this->block_size));
+		this->total_size += this->block_size;
+		this->used = 0;
+	}
+
+	void FreeBlocks()
+	{
+		for (byte *block : this->blocks) {
+			free(block);
+		}
+		this->blocks.clear();
+		this->used = 0;
+		this->block_size = 0;
+		this->total_size = 0;
+	}
+
+public:
+	static const size_t MIN_BLOCK_SIZE = 64 * 1024; ///< Minimum size of a block.
+	static const size_t ALIGNMENT = 16;             ///< Alignment of all allocations, as the allocation's type is not always known.
+
+	BumpArena() = default;
+	BumpArena(const BumpArena &other) = delete;
+	BumpArena& operator=(const BumpArena &other) = delete;
+
+	~BumpArena()
+	{
+		this->FreeBlocks();
+	}
+
+	void *Allocate(size_t size)
+	{
+		size_t start = Align(this->used, ALIGNMENT);
+		if (this->blocks.empty() || start + size > this->block_size) {
+			this->NewBlock(size);
+			start = 0;
+		}
+		this->used = start + size;
+		this->allocations++;
+		return this->blocks.back() + start;
+	}
+
+	void Free(void *ptr)
+	{
+		if (ptr == nullptr) return;
+		assert(this->allocations > 0);
+		/* Reuse the current block right away once everything is freed. */
+		if (--this->allocations == 0) this->used = 0;
+	}
+
+	/**
+	 * Reclaim all memory, if all allocations have been freed.
+	 * When more than one block was needed since the previous reset, they are
+	 * replaced by a single block which can hold all of them, so the next
+	 * burst of allocations fits in one block.
+	 * @return Whether the memory was reclaimed.
+	 */
+	bool Reset()
+	{
+		if (this->allocations != 0) return false;
+
+		if (this->blocks.size() > 1) {
+			const size_t size = this->total_size;
+			this->FreeBlocks();
+			this->NewBlock(size);
+		}
+		this->used = 0;
+		return true;
+	}
+};
+
+/**
+ * Allocator for standard containers, which takes its memory from a #BumpArena.
+ * @tparam T Type of the allocated objects.
+ * @tparam Tarena The arena to allocate from.
+ */
+template <typename T, BumpArena &Tarena>
+struct BumpArenaAllocator {
+	typedef T value_type;
+
+	template <typename U>
+	struct rebind {
+		typedef BumpArenaAllocator<U, Tarena> other;
+	};
+
+	BumpArenaAllocator() noexcept {}
+
+	template <typename U>
+	BumpArenaAllocator(const BumpArenaAllocator<U, Tarena> &) noexcept {}
+
+	T *allocate(size_t n)
+	{
+		assert_compile(alignof(T) <= BumpArena::ALIGNMENT);
+		CheckAllocationConstraints<T>(n);
+		return static_cast<T *>(Tarena.Allocate(n * sizeof(T)));
+	}
+
+	void deallocate(T *p, size_t n)
+	{
+		Tarena.Free(p);
+	}
+
+	template <typename U>
+	bool operator==(const BumpArenaAllocator<U, Tarena> &) const noexcept { return true; }
+
+	template <typename U>
+	bool operator!=(const BumpArenaAllocator<U, Tarena> &) const noexcept { return false; }
+};
+
 #endif /* DYN_ARENA_ALLOC_HPP */
@@ -38,20 +38,34 @@ template <typename T, typename TxyFunc, typename CoordT, typename DistT>
 class Kdtree {
 	/** Type of a node in the tree */
 	struct node {
-		T      element;  ///< Element stored at node
-		size_t left;     ///< Index of node to the left, INVALID_NODE if none
-		size_t right;    ///< Index of node to the right, INVALID_NODE if none
+		T      element;    ///< Element stored at node
+		size_t left;       ///< Index of node to the left, INVALID_NODE if none
+		size_t right;      ///< Index of node to the right, INVALID_NODE if none
+		size_t count;      ///< Number of elements in the sub-tree rooted at this node, including this one
+		size_t unbalanced; ///< Number approximating how unbalanced the sub-tree rooted at this node might be
 
-		node(T element) : element(element), left(INVALID_NODE), right(INVALID_NODE) { }
+		node(T element) : element(element), left(INVALID_NODE), right(INVALID_NODE), count(1), unbalanced(0) { }
+	};
+
+	/** Range of elements whose sub-tree is built by one task of a parallel build */
+	template <typename It>
+	struct build_task {
+		It begin;      ///< First element of the sub-tree
+		It end;        ///< One past last element of the sub-tree
+		int level;     ///< Depth of the sub-tree root
+		size_t offset; ///< Index of the first node of the sub-tree
 	};
 
 	static const size_t INVALID_NODE = SIZE_MAX; ///< Index value indicating no-such-node
+	static const size_t PARALLEL_BUILD_MIN_COUNT = 8192; ///< Minimum number of elements for Build to split the build into tasks
+	static const size_t PARALLEL_BUILD_TASK_SIZE = 2048; ///< Maximum number of elements handled by one task of a parallel build
+	static const size_t MIN_REBUILD_COUNT = 8; ///< Minimum sub-tree size worth rebalancing
 
 	std::vector<node> nodes;       ///< Pool of all nodes in the tree
 	std::vector<size_t> free_list; ///< List of dead indices in the nodes vector
+	std::vector<size_t> path;      ///< Scratch list of the nodes passed by the last insert or remove, from the root down
 	size_t root;                   ///< Index of root node
 	TxyFunc xyfunc;                ///< Functor to extract a coordinate from an element
-	size_t unbalanced;             ///< Number approximating how unbalanced the tree might be
 
 	/** Create one new node in the tree, return its index in the pool */
 	size_t AddNode(const T &element)
@@ -67,6 +81,12 @@ class Kdtree {
 		}
 	}
 
+	/** Get the number of elements in a sub-tree, which may be INVALID_NODE */
+	size_t SubtreeCount(size_t node_idx) const
+	{
+		return node_idx == INVALID_NODE ? 0 : this->nodes[node_idx].count;
+	}
+
 	/** Find a coordinate value to split a range of elements at */
 	template <typename It>
 	CoordT SelectSplitCoord(It begin, It end, int level)
@@ -90,62 +110,132 @@ class Kdtree {
 			CoordT split_coord = SelectSplitCoord(begin, end, level);
 			It split = std::partition(begin, end, [&](T v) { return this->xyfunc(v, level % 2) < split_coord; });
 			size_t newidx = this->AddNode(*split);
-			this->nodes[newidx].left = this->BuildSubtree(begin, split, level + 1);
-			this->nodes[newidx].right = this->BuildSubtree(split + 1, end, level + 1);
+			size_t left = this->BuildSubtree(begin, split, level + 1);
+			size_t right = this->BuildSubtree(split + 1, end, level + 1);
+			node &n = this->nodes[newidx];
+			n.left = left;
+			n.right = right;
+			n.count = count;
 			return newidx;
 		} else {
 			NOT_REACHED();
 		}
 	}
 
-	/** Rebuild the tree with all existing elements, optionally adding or removing one more */
-	bool Rebuild(const T *include_element, const T *exclude_element)
+	/**
+	 * Construct a subtree from elements between begin and end iterators into preallocated nodes.
+	 * The nodes of the subtree are stored in pre-order at the indices [offset, offset + end - begin),
+	 * so disjoint subtrees can be built concurrently.
+	 * @param tasks If not nullptr, subtrees of at most #PARALLEL_BUILD_TASK_SIZE elements are not built
+	 *              but appended to this list, for building by #BuildSubtreeTask.
+	 * @return Index of root, which is \a offset for a non-empty range.
+	 */
+	template <typename It>
+	size_t BuildSubtreeAt(It begin, It end, int level, size_t offset, std::vector<build_task<It>> *tasks)
 	{
-		size_t initial_count = this->Count();
-		if (initial_count < 8) return false; // arbitrary value for "not worth rebalancing"
+		size_t count = end - begin;
 
-		T root_element = this->nodes[this->root].element;
-		std::vector<T> elements = this->FreeSubtree(this->root);
-		elements.push_back(root_element);
+		if (count == 0) return INVALID_NODE;
 
-		if (include_element != nullptr) {
-			elements.push_back(*include_element);
-			initial_count++;
+		if (tasks != nullptr && count <= PARALLEL_BUILD_TASK_SIZE) {
+			tasks->push_back({ begin, end, level, offset });
+			return offset;
 		}
-		if (exclude_element != nullptr) {
-			typename std::vector<T>::iterator removed = std::remove(elements.begin(), elements.end(), *exclude_element);
-			elements.erase(removed, elements.end());
-			initial_count--;
+
+		if (count == 1) {
+			this->nodes[offset] = node{ *begin };
+			return offset;
 		}
 
-		this->Build(elements.begin(), elements.end());
-		assert(initial_count == this->Count());
-		return true;
+		CoordT split_coord = SelectSplitCoord(begin, end, level);
+		It split = std::partition(begin, end, [&](T v) { return this->xyfunc(v, level % 2) < split_coord; });
+		node &n = this->nodes[offset];
+		n = node{ *split };
+		n.count = count;
+		n.left = this->BuildSubtreeAt(begin, split, level + 1, offset + 1, tasks);
+		n.right = this->BuildSubtreeAt(split + 1, end, level + 1, offset + 1 + (split - begin), tasks);
+		return offset;
 	}
 
-	/** Insert one element in the tree somewhere below node_idx */
-	void InsertRecursive(const T &element, size_t node_idx, int level)
+	/** Build the subtree of one task of a parallel build */
+	template <typename It>
+	void BuildSubtreeTask(const build_task<It> &task)
 	{
-		/* Dimension index of current level */
-		int dim = level % 2;
-		/* Node reference */
-		node &n = this->nodes[node_idx];
+		this->BuildSubtreeAt(task.begin, task.end, task.level, task.offset, (std::vector<build_task<It>> *)nullptr);
+	}
 
-		/* Coordinate of element splitting at this node */
-		CoordT nc = this->xyfunc(n.element, dim);
-		/* Coordinate of the new element */
-		CoordT ec = this->xyfunc(element, dim);
-		/* Which side to insert on */
-		size_t &next = (ec < nc) ? n.left : n.right;
-
-		if (next == INVALID_NODE) {
-			/* New leaf */
-			size_t newidx = this->AddNode(element);
-			/* Vector may have been reallocated at this point, n and next are invalid */
-			node &nn = this->nodes[node_idx];
-			if (ec < nc) nn.left = newidx; else nn.right = newidx;
-		} else {
-			this->InsertRecursive(element, next, level + 1);
+	/**
+	 * Rebuild a sub-tree with its existing elements, letting it be fully balanced.
+	 * @param node_idx Root of the sub-tree.
+	 * @param level    Depth of the sub-tree root.
+	 * @return New root node index of the sub-tree.
+	 */
+	size_t RebuildSubtree(size_t node_idx, int level)
+	{
+		T root_element = this->nodes[node_idx].element;
+		std::vector<T> elements = this->FreeSubtree(node_idx);
+		elements.push_back(root_element);
+		this->free_list.push_back(node_idx);
+
+		return this->BuildSubtree(elements.begin(), elements.end(), level);
+	}
+
+	/**
+	 * Account for one update below each of the nodes in #path, and rebuild the highest sub-tree
+	 * which has seen more updates than a quarter of its size since it was built.
+	 * Each rebuild costs time proportional to the size of the sub-tree, and only happens after
+	 * a proportional number of updates within it, so it is amortised over those updates.
+	 */
+	void RebalancePath()
+	{
+		for (size_t node_idx : this->path) this->nodes[node_idx].unbalanced++;
+
+		for (size_t i = 0; i < this->path.size(); i++) {
+			const node &n = this->nodes[this->path[i]];
+			if (n.count < MIN_REBUILD_COUNT || n.unbalanced <= n.count / 4) continue;
+
+			size_t new_branch = this->RebuildSubtree(this->path[i], (int)i);
+			if (i == 0) {
+				this->root = new_branch;
+			} else {
+				node &parent = this->nodes[this->path[i - 1]];
+				if (parent.left == this->path[i]) parent.left = new_branch; else parent.right = new_branch;
+			}
+			return;
+		}
+	}
+
+	/** Insert one element in the tree below the root, recording the nodes passed in #path */
+	void InsertElement(const T &element)
+	{
+		this->path.clear();
+
+		size_t node_idx = this->root;
+		for (int level = 0;; level++) {
+			this->path.push_back(node_idx);
+
+			/* Dimension index of current level */
+			int dim = level % 2;
+			/* Node reference */
+			node &n = this->nodes[node_idx];
+			n.count++;
+
+			/* Coordinate of element splitting at this node */
+			CoordT nc = this->xyfunc(n.element, dim);
+			/* Coordinate of the new element */
+			CoordT ec = this->xyfunc(element, dim);
+			/* Which side to insert on */
+			size_t next = (ec < nc) ? n.left : n.right;
+
+			if (next == INVALID_NODE) {
+				/* New leaf */
+				size_t newidx = this->AddNode(element);
+				/* Vector may have been reallocated at this point, n is invalid */
+				node &nn = this->nodes[node_idx];
+				if (ec < nc) nn.left = newidx; else nn.right = newidx;
+				return;
+			}
+			node_idx = next;
 		}
 	}
 
@@ -178,47 +268,50 @@ class Kdtree {
 	}
 
 	/**
-	 * Find and remove one element from the tree.
-	 * @param element   The element to search for
-	 * @param node_idx  Sub-tree to search in
-	 * @param level     Current depth in the tree
-	 * @return New root node index of the sub-tree processed
+	 * Find and remove one element from the tree, recording the nodes passed above it in #path.
+	 * @param element The element to search for
 	 */
-	size_t RemoveRecursive(const T &element, size_t node_idx, int level)
+	void RemoveElement(const T &element)
 	{
-		/* Node reference */
-		node &n = this->nodes[node_idx];
+		this->path.clear();
+
+		size_t node_idx = this->root;
+		int level = 0;
+		while (!(this->nodes[node_idx].element == element)) {
+			this->path.push_back(node_idx);
 
-		if (n.element == element) {
-			/* Remove this one */
-			this->free_list.push_back(node_idx);
-			if (n.left == INVALID_NODE && n.right == INVALID_NODE) {
-				/* Simple case, leaf, new child node for parent is "none" */
-				return INVALID_NODE;
-			} else {
-				/* Complex case, rebuild the sub-tree */
-				std::vector<T> subtree_elements = this->FreeSubtree(node_idx);
-				return this->BuildSubtree(subtree_elements.begin(), subtree_elements.end(), level);;
-			}
-		} else {
-			/* Search in a sub-tree */
 			/* Dimension index of current level */
 			int dim = level % 2;
+			/* Node reference */
+			node &n = this->nodes[node_idx];
+			n.count--;
+
 			/* Coordinate of element splitting at this node */
 			CoordT nc = this->xyfunc(n.element, dim);
 			/* Coordinate of the element being removed */
 			CoordT ec = this->xyfunc(element, dim);
 			/* Which side to remove from */
-			size_t next = (ec < nc) ? n.left : n.right;
-			assert(next != INVALID_NODE); // node must exist somewhere and must be found before a leaf is reached
-			/* Descend */
-			size_t new_branch = this->RemoveRecursive(element, next, level + 1);
-			if (new_branch != next) {
-				/* Vector may have been reallocated at this point, n and next are invalid */
-				node &nn = this->nodes[node_idx];
-				if (ec < nc) nn.left = new_branch; else nn.right = new_branch;
-			}
-			return node_idx;
+			node_idx = (ec < nc) ? n.left : n.right;
+			assert(node_idx != INVALID_NODE); // node must exist somewhere and must be found before a leaf is reached
+			level++;
+		}
+
+		/* Remove this one */
+		size_t new_branch = INVALID_NODE;
+		this->free_list.push_back(node_idx);
+		const node &n = this->nodes[node_idx];
+		if (n.left != INVALID_NODE || n.right != INVALID_NODE) {
+			/* Complex case, rebuild the sub-tree */
+			std::vector<T> subtree_elements = this->FreeSubtree(node_idx);
+			new_branch = this->BuildSubtree(subtree_elements.begin(), subtree_elements.end(), level);
+		}
+
+		if (this->path.empty()) {
+			/* The removed element is the root node */
+			this->root = new_branch;
+		} else {
+			node &parent = this->nodes[this->path.back()];
+			if (parent.left == node_idx) parent.left = new_branch; else parent.right = new_branch;
 		}
 	}
 
@@ -305,23 +398,13 @@ class Kdtree {
 		return CountValue(element, n.left) + CountValue(element, n.right) + ((n.element == element) ? 1 : 0);
 	}
 
-	void IncrementUnbalanced(size_t amount = 1)
-	{
-		this->unbalanced += amount;
-	}
-
-	/** Check if the entire tree is in need of rebuilding */
-	bool IsUnbalanced()
-	{
-		size_t count = this->Count();
-		if (count < 8) return false;
-		return this->unbalanced > this->Count() / 4;
-	}
-
-	/** Verify that the invariant is true for a sub-tree, assert if not */
-	void CheckInvariant(size_t node_idx, int level, CoordT min_x, CoordT max_x, CoordT min_y, CoordT max_y)
+	/**
+	 * Verify that the invariant is true for a sub-tree, assert if not
+	 * @return Number of elements in the sub-tree
+	 */
+	size_t CheckInvariant(size_t node_idx, int level, CoordT min_x, CoordT max_x, CoordT min_y, CoordT max_y)
 	{
-		if (node_idx == INVALID_NODE) return;
+		if (node_idx == INVALID_NODE) return 0;
 
 		const node &n = this->nodes[node_idx];
 		CoordT cx = this->xyfunc(n.element, 0);
@@ -332,15 +415,18 @@ class Kdtree {
 		assert(cy >= min_y);
 		assert(cy < max_y);
 
+		size_t count = 1;
 		if (level % 2 == 0) {
 			// split in dimension 0 = x
-			CheckInvariant(n.left,  level + 1, min_x, cx, min_y, max_y);
-			CheckInvariant(n.right, level + 1, cx, max_x, min_y, max_y);
+			count += CheckInvariant(n.left,  level + 1, min_x, cx, min_y, max_y);
+			count += CheckInvariant(n.right, level + 1, cx, max_x, min_y, max_y);
 		} else {
 			// split in dimension 1 = y
-			CheckInvariant(n.left,  level + 1, min_x, max_x, min_y, cy);
-			CheckInvariant(n.right, level + 1, min_x, max_x, cy, max_y);
+			count += CheckInvariant(n.left,  level + 1, min_x, max_x, min_y, cy);
+			count += CheckInvariant(n.right, level + 1, min_x, max_x, cy, max_y);
 		}
+		assert(count == n.count);
+		return count;
 	}
 
 	/** Verify the invariant for the entire tree, does nothing unless KDTREE_DEBUG is defined */
@@ -353,10 +439,10 @@ class Kdtree {
 
 public:
 	/** Construct a new Kdtree with the given xyfunc */
-	Kdtree(TxyFunc xyfunc) : root(INVALID_NODE), xyfunc(xyfunc), unbalanced(0) { }
+	Kdtree(TxyFunc xyfunc) : root(INVALID_NODE), xyfunc(xyfunc) { }
 
 	/**
-	 * Clear and rebuild the tree from a new sequence of elements,
+	 * Clear and rebuild the tree from a new sequence of elements.
 	 * @tparam It    Iterator type for element sequence.
 	 * @param  begin First element in sequence.
 	 * @param  end   One past last element in sequence.
@@ -366,14 +452,47 @@ public:
 	{
 		this->nodes.clear();
 		this->free_list.clear();
-		this->unbalanced = 0;
+		this->root = INVALID_NODE;
 		if (begin == end) return;
-		this->nodes.reserve(end - begin);
 
+		size_t count = end - begin;
+		this->nodes.reserve(count);
 		this->root = this->BuildSubtree(begin, end, 0);
 		CheckInvariant();
 	}
 
+	/**
+	 * Clear and rebuild the tree from a new sequence of elements, splitting large trees into
+	 * independent sub-trees which are built by \a run_tasks.
+	 * The resulting tree is the same as the one built by the serial #Build.
+	 * @tparam It      Iterator type for element sequence.
+	 * @tparam Trunner Functor type called as run_tasks(count, task) with count of type uint, which must call task(i) once for every i below count, in any order and on any thread.
+	 * @param  begin     First element in sequence.
+	 * @param  end       One past last element in sequence.
+	 * @param  run_tasks Functor running the build tasks, for example in parallel.
+	 */
+	template <typename It, typename Trunner>
+	void Build(It begin, It end, Trunner run_tasks)
+	{
+		this->nodes.clear();
+		this->free_list.clear();
+		this->root = INVALID_NODE;
+		if (begin == end) return;
+
+		size_t count = end - begin;
+		if (count < PARALLEL_BUILD_MIN_COUNT) {
+			this->nodes.reserve(count);
+			this->root = this->BuildSubtree(begin, end, 0);
+		} else {
+			/* Split off the top levels here, then build the independent sub-trees below them in parallel. */
+			this->nodes.assign(count, node{ *begin });
+			std::vector<build_task<It>> tasks;
+			this->root = this->BuildSubtreeAt(begin, end, 0, 0, &tasks);
+			run_tasks((uint)tasks.size(), [&](uint i) { this->BuildSubtreeTask(tasks[i]); });
+		}
+		CheckInvariant();
+	}
+
 	/**
 	 * Clear the tree.
 	 */
@@ -381,7 +500,7 @@ public:
 	{
 		this->nodes.clear();
 		this->free_list.clear();
-		this->unbalanced = 0;
+		this->root = INVALID_NODE;
 		return;
 	}
 
@@ -390,23 +509,25 @@ public:
 	 */
 	void Rebuild()
 	{
-		this->Rebuild(nullptr, nullptr);
+		if (this->Count() < MIN_REBUILD_COUNT) return;
+		this->root = this->RebuildSubtree(this->root, 0);
+		CheckInvariant();
 	}
 
 	/**
 	 * Insert a single element in the tree.
-	 * Repeatedly inserting single elements may cause the tree to become unbalanced.
+	 * Sub-trees which became unbalanced by repeated inserts and removals are rebuilt as needed.
 	 * Undefined behaviour if the element already exists in the tree.
 	 */
 	void Insert(const T &element)
 	{
 		if (this->Count() == 0) {
+			this->nodes.clear();
+			this->free_list.clear();
 			this->root = this->AddNode(element);
 		} else {
-			if (!this->IsUnbalanced() || !this->Rebuild(&element, nullptr)) {
-				this->InsertRecursive(element, this->root, 0);
-				this->IncrementUnbalanced();
-			}
+			this->InsertElement(element);
+			this->RebalancePath();
 			CheckInvariant();
 		}
 	}
@@ -414,18 +535,15 @@ public:
 	/**
 	 * Remove a single element from the tree, if it exists.
 	 * Since elements are stored in interior nodes as well as leaf nodes, removing one may
-	 * require a larger sub-tree to be re-built. Because of this, worst case run time is
-	 * as bad as a full tree rebuild.
+	 * require a sub-tree below it to be re-built.
+	 * Sub-trees which became unbalanced by repeated inserts and removals are rebuilt as needed.
 	 */
 	void Remove(const T &element)
 	{
 		size_t count = this->Count();
 		if (count == 0) return;
-		if (!this->IsUnbalanced() || !this->Rebuild(nullptr, &element)) {
-			/* If the removed element is the root node, this modifies this->root */
-			this->root = this->RemoveRecursive(element, this->root, 0);
-			this->IncrementUnbalanced();
-		}
+		this->RemoveElement(element);
+		this->RebalancePath();
 		CheckInvariant();
 	}
 
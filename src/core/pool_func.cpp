@@ -9,6 +9,8 @@
 
 #include "../stdafx.h"
 #include "pool_type.hpp"
+#include "alloc_func.hpp"
+#include "../memory_usage.h"
 
 #include "../safeguards.h"
 
@@ -33,3 +35,68 @@
 		if (pool->type & pt) pool->CleanPool();
 	}
 }
+
+/**
+ * Account memory allocated by this pool.
+ * @param bytes Number of bytes allocated.
+ */
+void PoolBase::AddMemoryUsage(size_t bytes)
+{
+	this->memory_usage += bytes;
+	this->memory_peak = max(this->memory_peak, this->memory_usage);
+	::AddMemoryUsage(MUC_POOLS, bytes);
+}
+
+/**
+ * Account memory freed by this pool.
+ * @param bytes Number of bytes freed.
+ */
+void PoolBase::RemoveMemoryUsage(size_t bytes)
+{
+	assert(bytes <= this->memory_usage);
+	this->memory_usage -= bytes;
+	::RemoveMemoryUsage(MUC_POOLS, bytes);
+}
+
+/**
+ * Allocate a storage slab for items. Slabs are only freed all at once, by #FreeSlabs.
+ * Once the slabs of a pool exceed a huge page, further slabs are taken from chunks
+ * of a huge page, so the items of large pools are covered by few TLB entries.
+ * @param bytes Size of the slab.
+ * @return Zeroed memory for the slab.
+ */
+byte *PoolBase::AllocateSlab(size_t bytes)
+{
+	/* Keep the slabs in a chunk aligned for any item type. */
+	bytes = Align(bytes, 64);
+	this->slab_bytes += bytes;
+
+	if (_huge_page_mode != HPM_OFF && this->slab_bytes > HUGE_PAGE_SIZE && bytes <= HUGE_PAGE_SIZE) {
+		if (this->slab_chunks.empty() || this->slab_chunks.back().size - this->slab_chunk_used < bytes) {
+			this->slab_chunks.push_back({ LargeCallocT<byte>(HUGE_PAGE_SIZE), HUGE_PAGE_SIZE });
+			this->slab_chunk_used = 0;
+			this->AddMemoryUsage(HUGE_PAGE_SIZE);
+		}
+		byte *slab = this->slab_chunks.back().ptr + this->slab_chunk_used;
+		this->slab_chunk_used += bytes;
+		return slab;
+	}
+
+	/* Small pools get a chunk of exactly the size of each slab. */
+	this->slab_chunks.push_back({ LargeCallocT<byte>(bytes), bytes });
+	this->slab_chunk_used = bytes;
+	this->AddMemoryUsage(bytes);
+	return this->slab_chunks.back().ptr;
+}
+
+/** Free all storage slabs allocated by #AllocateSlab. */
+void PoolBase::FreeSlabs()
+{
+	for (const SlabChunk &chunk : this->slab_chunks) {
+		LargeFreeT(chunk.ptr, chunk.size);
+		this->RemoveMemoryUsage(chunk.size);
+	}
+	this->slab_chunks.clear();
+	this->slab_chunk_used = 0;
+	this->slab_bytes = 0;
+}
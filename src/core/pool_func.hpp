@@ -21,16 +21,18 @@
  * @param type The return type of the method.
  */
 #define DEFINE_POOL_METHOD(type) \
-	template <class Titem, typename Tindex, size_t Tgrowth_step, size_t Tmax_size, PoolType Tpool_type, bool Tcache, bool Tzero> \
-	type Pool<Titem, Tindex, Tgrowth_step, Tmax_size, Tpool_type, Tcache, Tzero>
+	template <class Titem, typename Tindex, size_t Tgrowth_step, size_t Tmax_size, PoolType Tpool_type, bool Tzero> \
+	type Pool<Titem, Tindex, Tgrowth_step, Tmax_size, Tpool_type, Tzero>
 
 /**
  * Create a clean pool.
  * @param name The name for the pool.
+ * @param slot_size Size of the item slots in the storage slabs. Pools of types with derived types should pass the size of the largest one.
  */
-DEFINE_POOL_METHOD(inline)::Pool(const char *name) :
+DEFINE_POOL_METHOD(inline)::Pool(const char *name, size_t slot_size) :
 		PoolBase(Tpool_type),
 		name(name),
+		slot_size(Align(max(slot_size, sizeof(Titem)), alignof(Titem))),
 		size(0),
 		first_free(0),
 		first_unused(0),
@@ -41,7 +43,7 @@ DEFINE_POOL_METHOD(inline)::Pool(const char *name) :
 		cleaning(false),
 		data(nullptr),
 		free_bitmap(nullptr),
-		alloc_cache(nullptr)
+		slabs(nullptr)
 { }
 
 /**
@@ -56,6 +58,9 @@ DEFINE_POOL_METHOD(inline void)::ResizeFor(size_t index)
 	assert(index < Tmax_size);
 
 	size_t new_size = min(Tmax_size, Align(index + 1, max<uint>(64, Tgrowth_step)));
+	this->AddMemoryUsage((new_size - this->size) * sizeof(Titem *) +
+			(CeilDiv(new_size, 64) - CeilDiv(this->size, 64)) * sizeof(uint64) +
+			(CeilDiv(new_size, SLAB_ITEMS) - CeilDiv(this->size, SLAB_ITEMS)) * sizeof(byte *));
 
 	this->data = ReallocT(this->data, new_size);
 	MemSetT(this->data + this->size, 0, new_size - this->size);
@@ -66,6 +71,9 @@ DEFINE_POOL_METHOD(inline void)::ResizeFor(size_t index)
 		this->free_bitmap[new_size / 64] |= (~((uint64) 0)) << (new_size % 64);
 	}
 
+	this->slabs = ReallocT(this->slabs, CeilDiv(new_size, SLAB_ITEMS));
+	MemSetT(this->slabs + CeilDiv(this->size, SLAB_ITEMS), 0, CeilDiv(new_size, SLAB_ITEMS) - CeilDiv(this->size, SLAB_ITEMS));
+
 	this->size = new_size;
 }
 
@@ -100,6 +108,37 @@ DEFINE_POOL_METHOD(inline size_t)::FindFirstFree()
 	return NO_FREE_ITEM;
 }
 
+/**
+ * Get the storage slot for the item with the given index in its slab, allocating the slab if necessary.
+ * @param index index of item
+ * @return pointer to the (unconstructed) item storage
+ * @pre index < this->size
+ */
+DEFINE_POOL_METHOD(inline Titem *)::GetSlabSlot(size_t index)
+{
+	byte *&slab = this->slabs[index / SLAB_ITEMS];
+	if (slab == nullptr) {
+		/* The last slab does not need to extend beyond the maximum pool size */
+		const size_t slab_start = index - (index % SLAB_ITEMS);
+		const size_t slab_size = min(SLAB_ITEMS, Tmax_size - slab_start) * this->slot_size;
+		slab = this->AllocateSlab(slab_size);
+	}
+	return (Titem *)(slab + (index % SLAB_ITEMS) * this->slot_size);
+}
+
+/**
+ * Is the given item stored in its slab slot, rather than in a separate allocation?
+ * @param index index of item
+ * @param item pointer to item
+ * @return true if \a item is stored in the slab slot for \a index
+ * @pre index < this->size
+ */
+DEFINE_POOL_METHOD(inline bool)::IsSlabSlot(size_t index, const Titem *item) const
+{
+	const byte *slab = this->slabs[index / SLAB_ITEMS];
+	return slab != nullptr && (const byte *)item == slab + (index % SLAB_ITEMS) * this->slot_size;
+}
+
 /**
  * Makes given index valid
  * @param size size of item
@@ -115,19 +154,22 @@ DEFINE_POOL_METHOD(inline void *)::AllocateItem(size_t size, size_t index)
 	this->items++;
 
 	Titem *item;
-	if (Tcache && this->alloc_cache != nullptr) {
-		assert(sizeof(Titem) == size);
-		item = (Titem *)this->alloc_cache;
-		this->alloc_cache = this->alloc_cache->next;
+	if (size <= this->slot_size) {
+		/* Items are stored contiguously in index order, in slots large enough for any derived type. */
+		item = this->GetSlabSlot(index);
 		if (Tzero) {
 			/* Explicitly casting to (void *) prevents a clang warning -
 			 * we are actually memsetting a (not-yet-constructed) object */
-			memset((void *)item, 0, sizeof(Titem));
+			memset((void *)item, 0, size);
 		}
-	} else if (Tzero) {
-		item = (Titem *)CallocT<byte>(size);
 	} else {
-		item = (Titem *)MallocT<byte>(size);
+		/* Types larger than the slots are allocated separately. Their size is stored in front
+		 * of them, so the memory they use can be accounted for when they are freed. */
+		const size_t bytes = SEPARATE_ITEM_HEADER + size;
+		byte *mem = Tzero ? CallocT<byte>(bytes) : MallocT<byte>(bytes);
+		*(size_t *)mem = bytes;
+		item = (Titem *)(mem + SEPARATE_ITEM_HEADER);
+		this->AddMemoryUsage(bytes);
 	}
 	this->data[index] = item;
 	SetBit(this->free_bitmap[index / 64], index % 64);
@@ -191,12 +233,11 @@ DEFINE_POOL_METHOD(void)::FreeItem(size_t index)
 {
 	assert(index < this->size);
 	assert(this->data[index] != nullptr);
-	if (Tcache) {
-		AllocCache *ac = (AllocCache *)this->data[index];
-		ac->next = this->alloc_cache;
-		this->alloc_cache = ac;
-	} else {
-		free(this->data[index]);
+	if (!this->IsSlabSlot(index, this->data[index])) {
+		/* Slab storage is retained until the pool is cleaned, separately allocated items are freed now. */
+		byte *mem = (byte *)this->data[index] - SEPARATE_ITEM_HEADER;
+		this->RemoveMemoryUsage(*(size_t *)mem);
+		free(mem);
 	}
 	this->data[index] = nullptr;
 	ClrBit(this->free_bitmap[index / 64], index % 64);
@@ -214,20 +255,18 @@ DEFINE_POOL_METHOD(void)::CleanPool()
 		delete this->Get(i); // 'delete nullptr;' is very valid
 	}
 	assert(this->items == 0);
+	this->FreeSlabs();
 	free(this->data);
 	free(this->free_bitmap);
+	free(this->slabs);
 	this->first_unused = this->first_free = this->size = 0;
 	this->data = nullptr;
 	this->free_bitmap = nullptr;
+	this->slabs = nullptr;
 	this->cleaning = false;
 
-	if (Tcache) {
-		while (this->alloc_cache != nullptr) {
-			AllocCache *ac = this->alloc_cache;
-			this->alloc_cache = ac->next;
-			free(ac);
-		}
-	}
+	/* Everything allocated by the pool has been freed now. */
+	this->RemoveMemoryUsage(this->memory_usage);
 }
 
 #undef DEFINE_POOL_METHOD
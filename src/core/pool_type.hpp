@@ -12,6 +12,8 @@
 
 #include "smallvec_type.hpp"
 #include "enum_type.hpp"
+#include "bitmath_func.hpp"
+#include "math_func.hpp"
 
 /** Various types of a pool. */
 enum PoolType {
@@ -29,6 +31,17 @@ typedef std::vector<struct PoolBase *> PoolVector; ///< Vector of pointers to Po
 /** Base class for base of all pools. */
 struct PoolBase {
 	const PoolType type; ///< Type of this pool.
+	size_t memory_usage; ///< Number of bytes allocated by this pool, including its items
+	size_t memory_peak;  ///< Largest number of bytes allocated by this pool at any time
+
+	/** Memory from which storage slabs for items are taken. */
+	struct SlabChunk {
+		byte *ptr;   ///< Start of the chunk
+		size_t size; ///< Size of the chunk in bytes
+	};
+	std::vector<SlabChunk> slab_chunks; ///< Chunks of all storage slabs of this pool
+	size_t slab_chunk_used;             ///< Number of bytes used in the last chunk of #slab_chunks
+	size_t slab_bytes;                  ///< Number of bytes in storage slabs of this pool
 
 	/**
 	 * Function used to access the vector of all pools.
@@ -46,7 +59,7 @@ struct PoolBase {
 	 * Constructor registers this object in the pool vector.
 	 * @param pt type of this pool.
 	 */
-	PoolBase(PoolType pt) : type(pt)
+	PoolBase(PoolType pt) : type(pt), memory_usage(0), memory_peak(0), slab_chunk_used(0), slab_bytes(0)
 	{
 		PoolBase::GetPools()->push_back(this);
 	}
@@ -58,6 +71,18 @@ struct PoolBase {
 	 */
 	virtual void CleanPool() = 0;
 
+	/**
+	 * Get the name of the pool.
+	 * @return name of the pool
+	 */
+	virtual const char *GetName() const = 0;
+
+protected:
+	void AddMemoryUsage(size_t bytes);
+	void RemoveMemoryUsage(size_t bytes);
+	byte *AllocateSlab(size_t bytes);
+	void FreeSlabs();
+
 private:
 	/**
 	 * Dummy private copy constructor to prevent compilers from
@@ -73,18 +98,18 @@ private:
  * @tparam Tgrowth_step Size of growths; if the pool is full increase the size by this amount
  * @tparam Tmax_size    Maximum size of the pool
  * @tparam Tpool_type   Type of this pool
- * @tparam Tcache       Whether to perform 'alloc' caching, i.e. don't actually free/malloc just reuse the memory
  * @tparam Tzero        Whether to zero the memory
- * @warning when Tcache is enabled *all* instances of this pool's item must be of the same size.
  */
-template <class Titem, typename Tindex, size_t Tgrowth_step, size_t Tmax_size, PoolType Tpool_type = PT_NORMAL, bool Tcache = false, bool Tzero = true>
+template <class Titem, typename Tindex, size_t Tgrowth_step, size_t Tmax_size, PoolType Tpool_type = PT_NORMAL, bool Tzero = true>
 struct Pool : PoolBase {
 	/* Ensure Tmax_size is within the bounds of Tindex. */
 	assert_compile((uint64)(Tmax_size - 1) >> 8 * sizeof(Tindex) == 0);
 
 	static const size_t MAX_SIZE = Tmax_size; ///< Make template parameter accessible from outside
+	static const size_t SLAB_ITEMS = Tgrowth_step > 64 ? Tgrowth_step : 64; ///< Number of items in each storage slab
 
 	const char * const name; ///< Name of this pool
+	const size_t slot_size;  ///< Size of each item slot in the storage slabs, large enough for any type derived from Titem stored in this pool
 
 	size_t size;         ///< Current allocated size
 	size_t first_free;   ///< No item with index lower than this is free (doesn't say anything about this one!)
@@ -96,11 +121,17 @@ struct Pool : PoolBase {
 	bool cleaning;       ///< True if cleaning pool (deleting all items)
 
 	Titem **data;        ///< Pointer to array of pointers to Titem
-	uint64 *free_bitmap; ///< Pointer to free bitmap
+	uint64 *free_bitmap; ///< Pointer to free bitmap (a set bit means that the index is in use)
+	byte **slabs;        ///< Pointer to array of contiguous storage slabs, each holding SLAB_ITEMS item slots of slot_size bytes, allocated on demand
 
-	Pool(const char *name);
+	Pool(const char *name, size_t slot_size = sizeof(Titem));
 	virtual void CleanPool();
 
+	const char *GetName() const override
+	{
+		return this->name;
+	}
+
 	/**
 	 * Returns Titem with given index
 	 * @param index of item to get
@@ -123,6 +154,27 @@ struct Pool : PoolBase {
 		return index < this->first_unused && this->Get(index) != nullptr;
 	}
 
+	/**
+	 * Find the first valid index which is not lower than the given index, using the free bitmap.
+	 * Unused indices are skipped 64 at a time.
+	 * @param index index to start searching from
+	 * @return first valid index >= \a index, or first_unused if there is none
+	 */
+	inline size_t GetNextValidIndex(size_t index) const
+	{
+		const size_t end = this->first_unused;
+		if (index >= end) return end;
+
+		size_t word = index / 64;
+		uint64 used = this->free_bitmap[word] & ((~(uint64) 0) << (index % 64));
+		while (used == 0) {
+			word++;
+			if (word * 64 >= end) return end;
+			used = this->free_bitmap[word];
+		}
+		return min<size_t>(word * 64 + FindFirstBit64(used), end);
+	}
+
 	/**
 	 * Tests whether we can allocate 'n' items
 	 * @param n number of items we want to allocate
@@ -161,7 +213,7 @@ struct Pool : PoolBase {
 
 	private:
 		size_t index;
-		void ValidateIndex() { while (this->index < T::GetPoolSize() && !(T::IsValidID(this->index))) this->index++; }
+		void ValidateIndex() { while ((this->index = T::GetNextValidIndex(this->index)) < T::GetPoolSize() && !(T::IsValidID(this->index))) this->index++; }
 	};
 
 	/*
@@ -202,7 +254,7 @@ struct Pool : PoolBase {
 	private:
 		size_t index;
 		F filter;
-		void ValidateIndex() { while (this->index < T::GetPoolSize() && !(T::IsValidID(this->index) && this->filter(this->index))) this->index++; }
+		void ValidateIndex() { while ((this->index = T::GetNextValidIndex(this->index)) < T::GetPoolSize() && !(T::IsValidID(this->index) && this->filter(this->index))) this->index++; }
 	};
 
 	/*
@@ -223,12 +275,12 @@ struct Pool : PoolBase {
 	 * Base class for all PoolItems
 	 * @tparam Tpool The pool this item is going to be part of
 	 */
-	template <struct Pool<Titem, Tindex, Tgrowth_step, Tmax_size, Tpool_type, Tcache, Tzero> *Tpool>
+	template <struct Pool<Titem, Tindex, Tgrowth_step, Tmax_size, Tpool_type, Tzero> *Tpool>
 	struct PoolItem {
 		Tindex index; ///< Index of this pool item
 
 		/** Type of the pool this item is going to be part of */
-		typedef struct Pool<Titem, Tindex, Tgrowth_step, Tmax_size, Tpool_type, Tcache, Tzero> Pool;
+		typedef struct Pool<Titem, Tindex, Tgrowth_step, Tmax_size, Tpool_type, Tzero> Pool;
 
 		/**
 		 * Allocates space for new Titem
@@ -353,6 +405,17 @@ struct Pool : PoolBase {
 			return Tpool->first_unused;
 		}
 
+		/**
+		 * Returns the first index not lower than the given one which is in use.
+		 * Useful for skipping over unused parts of the pool when iterating.
+		 * @param index index to start searching from
+		 * @return first used index >= \a index, or GetPoolSize() if there is none
+		 */
+		static inline size_t GetNextValidIndex(size_t index)
+		{
+			return Tpool->GetNextValidIndex(index);
+		}
+
 		/**
 		 * Returns number of valid items in the pool
 		 * @return number of valid items in the pool
@@ -389,19 +452,12 @@ struct Pool : PoolBase {
 private:
 	static const size_t NO_FREE_ITEM = MAX_UVALUE(size_t); ///< Constant to indicate we can't allocate any more items
 
-	/**
-	 * Helper struct to cache 'freed' PoolItems so we
-	 * do not need to allocate them again.
-	 */
-	struct AllocCache {
-		/** The next in our 'cache' */
-		AllocCache *next;
-	};
-
-	/** Cache of freed pointers */
-	AllocCache *alloc_cache;
+	/** Size of the header storing the size of items too large for a slab slot, keeping the item aligned. */
+	static const size_t SEPARATE_ITEM_HEADER = 16;
 
 	void *AllocateItem(size_t size, size_t index);
+	Titem *GetSlabSlot(size_t index);
+	bool IsSlabSlot(size_t index, const Titem *item) const;
 	void ResizeFor(size_t index);
 	size_t FindFirstFree();
 
@@ -58,6 +58,23 @@ void Randomizer::SetSeed(uint32 seed)
 	this->state[1] = seed;
 }
 
+/**
+ * (Re)set the state of the random number generator to one of many independent streams of a seed.
+ * This allows giving each of a set of entities its own generator, derived from a single seed.
+ * @param seed the seed shared by all streams
+ * @param stream the number of the stream, e.g. the index of the entity
+ */
+void Randomizer::SetSeed(uint32 seed, uint32 stream)
+{
+	/* Mix the seed and the stream number, so neighbouring streams do not start with related states. */
+	uint64 x = (((uint64)seed << 32) | stream) + 0x9E3779B97F4A7C15ULL;
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+	x ^= x >> 31;
+	this->state[0] = (uint32)x;
+	this->state[1] = (uint32)(x >> 32);
+}
+
 /**
  * (Re)set the state of the random number generators.
  * @param seed the new state
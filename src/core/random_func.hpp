@@ -27,6 +27,7 @@ struct Randomizer {
 	uint32 Next();
 	uint32 Next(uint32 limit);
 	void SetSeed(uint32 seed);
+	void SetSeed(uint32 seed, uint32 stream);
 };
 extern Randomizer _random; ///< Random used in the game state calculations
 extern Randomizer _interactive_random; ///< Random used everywhere else, where it does not (directly) influence the game state
@@ -12,6 +12,7 @@
 
 #include "alloc_func.hpp"
 #include "mem_func.hpp"
+#include "../memory_usage.h"
 
 /**
  * Simple matrix template class.
@@ -33,8 +34,9 @@
  * same for all openttd "SmallContainer" classes.
  *
  * @tparam T The type of the items stored
+ * @tparam Tcategory Subsystem the allocated memory is accounted to
  */
-template <typename T>
+template <typename T, MemoryUsageCategory Tcategory>
 class SmallMatrix {
 protected:
 	T *data;       ///< The pointer to the first item
@@ -42,6 +44,17 @@ protected:
 	uint height;   ///< Number of items over second axis
 	uint capacity; ///< The available space for storing items
 
+	/**
+	 * Account a change of the capacity.
+	 * @param new_capacity The new capacity.
+	 */
+	inline void SetCapacity(uint new_capacity)
+	{
+		RemoveMemoryUsage(Tcategory, this->capacity * sizeof(T));
+		AddMemoryUsage(Tcategory, new_capacity * sizeof(T));
+		this->capacity = new_capacity;
+	}
+
 public:
 
 	SmallMatrix() : data(nullptr), width(0), height(0), capacity(0) {}
@@ -57,6 +70,7 @@ public:
 
 	~SmallMatrix()
 	{
+		RemoveMemoryUsage(Tcategory, this->capacity * sizeof(T));
 		free(this->data);
 	}
 
@@ -81,7 +95,7 @@ public:
 		this->width = other.Width();
 		uint num_items = this->width * this->height;
 		if (num_items > this->capacity) {
-			this->capacity = num_items;
+			this->SetCapacity(num_items);
 			free(this->data);
 			this->data = MallocT<T>(num_items);
 			MemCpyT(this->data, other[0], num_items);
@@ -108,7 +122,7 @@ public:
 	{
 		this->height = 0;
 		this->width = 0;
-		this->capacity = 0;
+		this->SetCapacity(0);
 		free(this->data);
 		this->data = nullptr;
 	}
@@ -120,7 +134,7 @@ public:
 	{
 		uint capacity = this->height * this->width;
 		if (capacity >= this->capacity) return;
-		this->capacity = capacity;
+		this->SetCapacity(capacity);
 		this->data = ReallocT(this->data, this->capacity);
 	}
 
@@ -250,7 +264,7 @@ public:
 			if (new_data != this->data) {
 				free(this->data);
 				this->data = new_data;
-				this->capacity = new_capacity;
+				this->SetCapacity(new_capacity);
 			}
 		}
 		this->width = new_width;
@@ -414,6 +414,9 @@ char *CrashLog::LogCommandLog(char *buffer, const char *last) const
  */
 char *CrashLog::FillCrashLog(char *buffer, const char *last) const
 {
+	/* Write the debug lines logged up to the crash, before anything else can go wrong. */
+	CrashFlushAsyncDebugLog();
+
 	time_t cur_time = time(nullptr);
 	buffer += seprintf(buffer, last, "*** OpenTTD Crash Report ***\n\n");
 
@@ -12,6 +12,7 @@
 #include "network/network_func.h"
 #include "currency.h"
 #include "window_func.h"
+#include "viewport_func.h"
 #include "settings_type.h"
 #include "date_func.h"
 #include "vehicle_base.h"
@@ -280,6 +281,7 @@ static void OnNewDay()
 		SetWindowWidgetDirty(WC_STATUS_BAR, 0, 0);
 	}
 	EnginesDailyLoop();
+	InvalidateNewGRFTileDrawCache();
 
 	/* Refresh after possible snowline change */
 	SetWindowClassesDirty(WC_TOWN_VIEW);
@@ -15,7 +15,15 @@
 #include "fileio_func.h"
 #include "settings_type.h"
 #include "date_func.h"
+#include "thread.h"
 #include <array>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#if defined(__MINGW32__)
+#include "3rdparty/mingw-std-threads/mingw.mutex.h"
+#include "3rdparty/mingw-std-threads/mingw.condition_variable.h"
+#endif
 
 #if defined(_WIN32)
 #include "os/windows/win32.h"
@@ -116,25 +124,49 @@ char *DumpDebugFacilityNames(char *buf, char *last)
 }
 
 /**
- * Internal function for outputting the debug line.
+ * Write the prefix for logs into a buffer; if show_date_in_logs is enabled this is
+ * the current date, otherwise nothing. Unlike #GetLogPrefix this may be called by any thread.
+ * @param buf Start address for storing the prefix.
+ * @param last Last valid address for storing the prefix.
+ */
+static void FormatLogPrefix(char *buf, const char *last)
+{
+	if (_settings_client.gui.show_date_in_logs) {
+		time_t cur_time = time(nullptr);
+		struct tm local_time;
+#if defined(_WIN32)
+		localtime_s(&local_time, &cur_time);
+#else
+		localtime_r(&cur_time, &local_time);
+#endif
+		strftime(buf, last - buf + 1, "[%Y-%m-%d %H:%M:%S] ", &local_time);
+	} else {
+		*buf = '\0';
+	}
+}
+
+/**
+ * Internal function for writing the debug line to the debug socket, a log file or stderr.
  * @param dbg Debug category.
  * @param buf Text line to output.
+ * @param prefix Log prefix of the time the line was logged, see #GetLogPrefix.
+ * @return Whether the line should also be shown in the console and sent to the admin port.
  */
-static void debug_print(const char *dbg, const char *buf)
+static bool debug_print_output(const char *dbg, const char *buf, const char *prefix)
 {
 	if (_debug_socket != INVALID_SOCKET) {
 		char buf2[1024 + 32];
 
-		seprintf(buf2, lastof(buf2), "%sdbg: [%s] %s\n", GetLogPrefix(), dbg, buf);
+		seprintf(buf2, lastof(buf2), "%sdbg: [%s] %s\n", prefix, dbg, buf);
 		/* Sending out an error when this fails would be nice, however... the error
 		 * would have to be send over this failing socket which won't work. */
 		send(_debug_socket, buf2, (int)strlen(buf2), 0);
-		return;
+		return false;
 	}
 	if (strcmp(dbg, "desync") == 0) {
 		static FILE *f = FioFOpenFile("commands-out.log", "wb", AUTOSAVE_DIR);
 		if (f != nullptr) {
-			fprintf(f, "%s%s\n", GetLogPrefix(), buf);
+			fprintf(f, "%s%s\n", prefix, buf);
 			fflush(f);
 		}
 #ifdef RANDOM_DEBUG
@@ -165,13 +197,13 @@ static void debug_print(const char *dbg, const char *buf)
 #endif
 		if (f != nullptr) {
 			fprintf(f, "%s\n", buf);
-			return;
+			return false;
 		}
 #endif
 	}
 
 	char buffer[512];
-	seprintf(buffer, lastof(buffer), "%sdbg: [%s] %s\n", GetLogPrefix(), dbg, buf);
+	seprintf(buffer, lastof(buffer), "%sdbg: [%s] %s\n", prefix, dbg, buf);
 
 	str_strip_colours(buffer);
 
@@ -188,10 +220,278 @@ static void debug_print(const char *dbg, const char *buf)
 	fputs(buffer, stderr);
 #endif
 
+	return true;
+}
+
+/**
+ * Internal function for outputting the debug line.
+ * @param dbg Debug category.
+ * @param buf Text line to output.
+ */
+static void debug_print(const char *dbg, const char *buf)
+{
+	if (!debug_print_output(dbg, buf, GetLogPrefix())) return;
+
 	NetworkAdminConsole(dbg, buf);
 	IConsoleDebug(dbg, buf);
 }
 
+/**
+ * A debug line waiting to be written by the debug log thread.
+ * The slots of #_debug_log_ring form a bounded lock-free queue: a slot is free for the
+ * producer claiming queue position \c pos when its sequence is \c pos, and holds the
+ * record for that position when its sequence is \c pos + 1.
+ */
+struct DebugLogRecord {
+	std::atomic<uint32> sequence; ///< Queue position this slot is free for, or holds the record of.
+	const char *dbg;              ///< Debug category.
+	char prefix[24];              ///< Log prefix of the time the line was logged.
+	char text[1024];              ///< Formatted text of the line.
+};
+
+static const uint32 DEBUG_LOG_RING_SIZE = 1024; ///< Number of slots in #_debug_log_ring, must be a power of 2.
+
+static std::atomic<DebugLogRecord *> _debug_log_ring;      ///< Ring of debug lines to write, nullptr when debug lines are written synchronously.
+static std::atomic<uint32> _debug_log_enqueue_pos;          ///< Next position in the ring to write a line to.
+static std::atomic<uint32> _debug_log_dequeue_pos;          ///< Next position in the ring to read a line from, only written by the debug log thread.
+static std::atomic<uint32> _debug_log_overflow;             ///< Number of lines dropped because the ring was full.
+static std::atomic<bool> _debug_log_stop;                   ///< Whether the debug log thread should stop once the ring is empty.
+static std::thread *_debug_log_thread = nullptr;            ///< The debug log thread.
+static std::atomic<bool> _debug_log_sleeping;               ///< Whether the debug log thread is (about to start) waiting for #_debug_log_wake.
+static std::mutex _debug_log_wake_mutex;                    ///< Mutex for #_debug_log_wake.
+static std::condition_variable _debug_log_wake;             ///< Signalled when a line is queued or the debug log thread should stop.
+static std::mutex _debug_log_console_mutex;                 ///< Mutex for #_debug_log_console_lines.
+static std::vector<std::pair<const char *, std::string>> _debug_log_console_lines; ///< Written lines still to be shown in the console and sent to the admin port.
+
+/**
+ * Wake the debug log thread when it is waiting for lines.
+ * The mutex is only taken when the thread is waiting, so queueing lines while it is busy does not block.
+ */
+static void debug_log_wake()
+{
+	/* Pairs with the fence in DebugLogThread: either the thread sees the new state, or we see it waiting. */
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (!_debug_log_sleeping.load(std::memory_order_relaxed)) return;
+
+	std::lock_guard<std::mutex> lock(_debug_log_wake_mutex);
+	_debug_log_wake.notify_one();
+}
+
+/**
+ * Queue a debug line for the debug log thread, without blocking.
+ * @param ring The ring to queue the line in.
+ * @param dbg Debug category.
+ * @param buf Text line to output.
+ * @return False if the ring was full and the line was dropped.
+ */
+static bool debug_log_enqueue(DebugLogRecord *ring, const char *dbg, const char *buf)
+{
+	uint32 pos = _debug_log_enqueue_pos.load(std::memory_order_relaxed);
+	DebugLogRecord *record;
+	for (;;) {
+		record = &ring[pos & (DEBUG_LOG_RING_SIZE - 1)];
+		const int32 diff = (int32)(record->sequence.load(std::memory_order_acquire) - pos);
+		if (diff == 0) {
+			if (_debug_log_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+		} else if (diff < 0) {
+			/* The debug log thread has not yet written the line a full ring ago. */
+			_debug_log_overflow.fetch_add(1, std::memory_order_relaxed);
+			debug_log_wake();
+			return false;
+		} else {
+			pos = _debug_log_enqueue_pos.load(std::memory_order_relaxed);
+		}
+	}
+
+	record->dbg = dbg;
+	FormatLogPrefix(record->prefix, lastof(record->prefix));
+	strecpy(record->text, buf, lastof(record->text));
+	record->sequence.store(pos + 1, std::memory_order_release);
+	debug_log_wake();
+	return true;
+}
+
+/**
+ * Write all queued debug lines. Only called by the debug log thread.
+ * @return Whether any line was written.
+ */
+static bool debug_log_write_queued()
+{
+	DebugLogRecord *ring = _debug_log_ring.load(std::memory_order_acquire);
+	if (ring == nullptr) return false;
+	bool written = false;
+	for (uint32 pos = _debug_log_dequeue_pos.load(std::memory_order_relaxed);; pos++) {
+		DebugLogRecord &record = ring[pos & (DEBUG_LOG_RING_SIZE - 1)];
+		if (record.sequence.load(std::memory_order_acquire) != pos + 1) break;
+
+		if (debug_print_output(record.dbg, record.text, record.prefix)) {
+			std::lock_guard<std::mutex> lock(_debug_log_console_mutex);
+			_debug_log_console_lines.emplace_back(record.dbg, record.text);
+		}
+		record.sequence.store(pos + DEBUG_LOG_RING_SIZE, std::memory_order_release);
+		_debug_log_dequeue_pos.store(pos + 1, std::memory_order_release);
+		written = true;
+	}
+
+	const uint32 dropped = _debug_log_overflow.exchange(0, std::memory_order_relaxed);
+	if (dropped != 0) {
+		char buf[64];
+		char prefix[24];
+		FormatLogPrefix(prefix, lastof(prefix));
+		seprintf(buf, lastof(buf), "%u debug lines were dropped, the log could not keep up", dropped);
+		debug_print_output("misc", buf, prefix);
+	}
+	return written;
+}
+
+/**
+ * Write the lines left in the ring, after it has been detached from #_debug_log_ring.
+ * @param ring The ring to write the lines of.
+ */
+static void debug_log_write_remaining(DebugLogRecord *ring)
+{
+	for (uint32 pos = _debug_log_dequeue_pos.load(std::memory_order_acquire);; pos++) {
+		DebugLogRecord &record = ring[pos & (DEBUG_LOG_RING_SIZE - 1)];
+		if (record.sequence.load(std::memory_order_acquire) != pos + 1) break;
+		debug_print_output(record.dbg, record.text, record.prefix);
+		record.sequence.store(pos + DEBUG_LOG_RING_SIZE, std::memory_order_release);
+		_debug_log_dequeue_pos.store(pos + 1, std::memory_order_release);
+	}
+}
+
+/**
+ * Check whether there is anything for the debug log thread to do.
+ * @return Whether a line is queued, lines were dropped or the thread should stop.
+ */
+static bool debug_log_has_work()
+{
+	if (_debug_log_stop.load(std::memory_order_acquire)) return true;
+	if (_debug_log_overflow.load(std::memory_order_relaxed) != 0) return true;
+
+	DebugLogRecord *ring = _debug_log_ring.load(std::memory_order_acquire);
+	if (ring == nullptr) return true;
+	const uint32 pos = _debug_log_dequeue_pos.load(std::memory_order_relaxed);
+	return ring[pos & (DEBUG_LOG_RING_SIZE - 1)].sequence.load(std::memory_order_acquire) == pos + 1;
+}
+
+/** Main function of the debug log thread. */
+static void DebugLogThread()
+{
+	for (;;) {
+		/* Check for stopping before writing, so all lines queued before the stop are written. */
+		const bool stop = _debug_log_stop.load(std::memory_order_acquire);
+		if (debug_log_write_queued()) continue;
+		if (stop) break;
+
+		std::unique_lock<std::mutex> lock(_debug_log_wake_mutex);
+		_debug_log_sleeping.store(true, std::memory_order_relaxed);
+		/* Pairs with the fence in debug_log_wake, so a line queued before announcing the wait is seen here. */
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (!debug_log_has_work()) _debug_log_wake.wait(lock);
+		_debug_log_sleeping.store(false, std::memory_order_relaxed);
+	}
+}
+
+/**
+ * Start writing debug lines asynchronously on a separate thread, so threads logging
+ * them only format the line and queue it, without ever blocking. When the queue is
+ * full, lines are dropped and the number of dropped lines is logged instead.
+ * Lines for the console and admin port are handed to #ProcessAsyncDebugLog on the main thread.
+ */
+void StartAsyncDebugLog()
+{
+	if (_debug_log_thread != nullptr) return;
+
+	DebugLogRecord *ring = new DebugLogRecord[DEBUG_LOG_RING_SIZE];
+	for (uint32 i = 0; i < DEBUG_LOG_RING_SIZE; i++) {
+		ring[i].sequence.store(i, std::memory_order_relaxed);
+	}
+	_debug_log_enqueue_pos.store(0, std::memory_order_relaxed);
+	_debug_log_dequeue_pos.store(0, std::memory_order_relaxed);
+	_debug_log_overflow.store(0, std::memory_order_relaxed);
+	_debug_log_stop.store(false, std::memory_order_relaxed);
+	_debug_log_sleeping.store(false, std::memory_order_relaxed);
+	_debug_log_ring.store(ring, std::memory_order_release);
+
+	_debug_log_thread = new std::thread();
+	if (!StartNewThread(_debug_log_thread, "ottd:debuglog", &DebugLogThread)) {
+		delete _debug_log_thread;
+		_debug_log_thread = nullptr;
+		_debug_log_ring.store(nullptr, std::memory_order_relaxed);
+		delete[] ring;
+		return;
+	}
+
+	/* Write the queued lines when exiting without calling StopAsyncDebugLog. */
+	static bool registered = false;
+	if (!registered) {
+		registered = true;
+		atexit(StopAsyncDebugLog);
+	}
+}
+
+/**
+ * Stop writing debug lines asynchronously, after writing all queued lines.
+ * Lines still to be shown in the console are dropped.
+ */
+void StopAsyncDebugLog()
+{
+	if (_debug_log_thread == nullptr || _debug_log_thread->get_id() == std::this_thread::get_id()) return;
+
+	_debug_log_stop.store(true, std::memory_order_release);
+	debug_log_wake();
+	_debug_log_thread->join();
+	delete _debug_log_thread;
+	_debug_log_thread = nullptr;
+
+	/* Other threads may still be queueing a line in the ring, so it is never freed. */
+	DebugLogRecord *ring = _debug_log_ring.exchange(nullptr, std::memory_order_acq_rel);
+	if (ring != nullptr) debug_log_write_remaining(ring);
+
+	std::lock_guard<std::mutex> lock(_debug_log_console_mutex);
+	_debug_log_console_lines.clear();
+}
+
+/**
+ * Write the debug lines still queued when crashing, before the crash log is written.
+ * The debug log thread gets a moment to write them itself; when it does not (for example
+ * because it is the crashing thread) they are written by the calling thread.
+ * Any later lines are written synchronously.
+ */
+void CrashFlushAsyncDebugLog()
+{
+	if (_debug_log_ring.load(std::memory_order_acquire) == nullptr) return;
+
+	if (_debug_log_thread != nullptr && _debug_log_thread->get_id() != std::this_thread::get_id()) {
+		const uint32 end = _debug_log_enqueue_pos.load(std::memory_order_acquire);
+		for (int i = 0; i < 100 && (int32)(end - _debug_log_dequeue_pos.load(std::memory_order_acquire)) > 0; i++) {
+			CSleep(5);
+		}
+	}
+
+	DebugLogRecord *ring = _debug_log_ring.exchange(nullptr, std::memory_order_acq_rel);
+	if (ring != nullptr) debug_log_write_remaining(ring);
+}
+
+/**
+ * Show the debug lines written by the debug log thread in the console, and send them to the admin port.
+ * Must be called regularly by the main thread, while debug lines are written asynchronously.
+ */
+void ProcessAsyncDebugLog()
+{
+	std::vector<std::pair<const char *, std::string>> lines;
+	{
+		std::lock_guard<std::mutex> lock(_debug_log_console_mutex);
+		if (_debug_log_console_lines.empty()) return;
+		lines.swap(_debug_log_console_lines);
+	}
+
+	for (const auto &line : lines) {
+		NetworkAdminConsole(line.first, line.second.c_str());
+		IConsoleDebug(line.first, line.second.c_str());
+	}
+}
+
 /**
  * Output a debug line.
  * @note Do not call directly, use the #DEBUG macro instead.
@@ -207,7 +507,13 @@ void CDECL debug(const char *dbg, const char *format, ...)
 	vseprintf(buf, lastof(buf), format, va);
 	va_end(va);
 
-	debug_print(dbg, buf);
+	/* Desync and random lines are needed in full to replay a game, so never queue and possibly drop them. */
+	DebugLogRecord *ring = _debug_log_ring.load(std::memory_order_acquire);
+	if (ring != nullptr && strcmp(dbg, "desync") != 0 && strcmp(dbg, "random") != 0) {
+		debug_log_enqueue(ring, dbg, buf);
+	} else {
+		debug_print(dbg, buf);
+	}
 }
 
 /**
@@ -296,12 +602,7 @@ const char *GetDebugString()
 const char *GetLogPrefix()
 {
 	static char _log_prefix[24];
-	if (_settings_client.gui.show_date_in_logs) {
-		time_t cur_time = time(nullptr);
-		strftime(_log_prefix, sizeof(_log_prefix), "[%Y-%m-%d %H:%M:%S] ", localtime(&cur_time));
-	} else {
-		*_log_prefix = '\0';
-	}
+	FormatLogPrefix(_log_prefix, lastof(_log_prefix));
 	return _log_prefix;
 }
 
@@ -66,6 +66,11 @@ char *DumpDebugFacilityNames(char *buf, char *last);
 void SetDebugString(const char *s);
 const char *GetDebugString();
 
+void StartAsyncDebugLog();
+void StopAsyncDebugLog();
+void ProcessAsyncDebugLog();
+void CrashFlushAsyncDebugLog();
+
 /* Shorter form for passing filename and linenumber */
 #define FILE_LINE __FILE__, __LINE__
 
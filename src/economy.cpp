@@ -53,10 +53,13 @@
 #include "tbtr_template_vehicle.h"
 #include "scope_info.h"
 #include "pathfinder/yapf/yapf_cache.h"
+#include "worker_thread.h"
 
 #include "table/strings.h"
 #include "table/pricebase.h"
 
+#include <array>
+
 #include "safeguards.h"
 
 
@@ -104,38 +107,126 @@ Prices _price;
 Money _additional_cash_required;
 static PriceMultipliers _price_base_multiplier;
 
+/** Totals of the vehicles and stations of a company, as used for its value and rating. */
+struct CompanyAssetTotals {
+	uint station_facilities = 0;          ///< Number of station facilities.
+	uint serviced_station_facilities = 0; ///< Number of station facilities of recently serviced stations.
+	uint profitable_vehicles = 0;         ///< Number of primary vehicles with a profit last year.
+	bool has_min_profit = false;          ///< Whether #min_profit is valid, i.e. there is a primary vehicle older than two years.
+	Money min_profit = 0;                 ///< Lowest profit last year of the primary vehicles older than two years.
+	Money vehicle_value = 0;              ///< Value of the vehicles, for the company value.
+};
+
+typedef std::array<CompanyAssetTotals, MAX_COMPANIES> AllCompanyAssetTotals;
+
 /**
- * Calculate the value of the company. That is the value of all
- * assets (vehicles, stations, etc) and money minus the loan,
- * except when including_loan is \c false which is useful when
- * we want to calculate the value for bankruptcy.
- * @param c              the company to get the value of.
- * @param including_loan include the loan in the company value.
- * @return the value of the company.
+ * Add a vehicle to the asset totals of its owner.
+ * @param t Asset totals of the owner of the vehicle.
+ * @param v Vehicle to add.
  */
-Money CalculateCompanyValue(const Company *c, bool including_loan)
+static void AddVehicleToAssetTotals(CompanyAssetTotals &t, const Vehicle *v)
 {
-	Owner owner = c->index;
+	if (HasBit(v->subtype, GVSF_VIRTUAL)) return;
+
+	if (v->type == VEH_TRAIN ||
+			v->type == VEH_ROAD ||
+			(v->type == VEH_AIRCRAFT && Aircraft::From(v)->IsNormalAircraft()) ||
+			v->type == VEH_SHIP) {
+		t.vehicle_value += v->value * 3 >> 1;
+	}
+
+	if (IsCompanyBuildableVehicleType(v->type) && v->IsPrimaryVehicle()) {
+		if (v->profit_last_year > 0) t.profitable_vehicles++; // For the vehicle score only count profitable vehicles
+		if (v->age > 730) {
+			/* Find the vehicle with the lowest amount of profit */
+			if (!t.has_min_profit || t.min_profit > v->profit_last_year) {
+				t.min_profit = v->profit_last_year;
+				t.has_min_profit = true;
+			}
+		}
+	}
+}
 
-	uint num = 0;
+/**
+ * Add a station to the asset totals of its owner.
+ * @param t Asset totals of the owner of the station.
+ * @param st Station to add.
+ */
+static void AddStationToAssetTotals(CompanyAssetTotals &t, const Station *st)
+{
+	uint facilities = CountBits((byte)st->facilities);
+	t.station_facilities += facilities;
+	/* Only count stations that are actually serviced */
+	if (st->time_since_load <= 20 || st->time_since_unload <= 20) t.serviced_station_facilities += facilities;
+}
 
+/**
+ * Gather the asset totals of a single company.
+ * This is a plain serial scan, as starting the worker threads would cost more than it saves for one company.
+ * @param owner The company to gather the totals of.
+ * @return The totals of the company.
+ */
+static CompanyAssetTotals GatherCompanyAssetTotals(Owner owner)
+{
+	CompanyAssetTotals totals;
+	for (const Vehicle *v : Vehicle::Iterate()) {
+		if (v->owner == owner) AddVehicleToAssetTotals(totals, v);
+	}
 	for (const Station *st : Station::Iterate()) {
-		if (st->owner == owner) num += CountBits((byte)st->facilities);
+		if (st->owner == owner) AddStationToAssetTotals(totals, st);
 	}
+	return totals;
+}
 
-	Money value = num * _price[PR_STATION_VALUE] * 25;
-
-	for (const Vehicle *v : Vehicle::Iterate()) {
-		if (v->owner != owner) continue;
-		if (HasBit(v->subtype, GVSF_VIRTUAL)) continue;
+/**
+ * Gather the asset totals of all companies.
+ * The vehicle and station pools are only scanned once, split over the worker threads.
+ * @return The totals, indexed by company.
+ */
+static AllCompanyAssetTotals GatherCompanyAssetTotals()
+{
+	AllCompanyAssetTotals totals = ParallelPoolReduce<Vehicle>(AllCompanyAssetTotals(), [](AllCompanyAssetTotals &partial, const Vehicle *v) {
+		if (v->owner < MAX_COMPANIES) AddVehicleToAssetTotals(partial[v->owner], v);
+	}, [](AllCompanyAssetTotals &result, const AllCompanyAssetTotals &partial) {
+		for (uint i = 0; i < MAX_COMPANIES; i++) {
+			CompanyAssetTotals &t = result[i];
+			const CompanyAssetTotals &p = partial[i];
+			t.vehicle_value += p.vehicle_value;
+			t.profitable_vehicles += p.profitable_vehicles;
+			if (p.has_min_profit && (!t.has_min_profit || t.min_profit > p.min_profit)) {
+				t.min_profit = p.min_profit;
+				t.has_min_profit = true;
+			}
+		}
+	});
 
-		if (v->type == VEH_TRAIN ||
-				v->type == VEH_ROAD ||
-				(v->type == VEH_AIRCRAFT && Aircraft::From(v)->IsNormalAircraft()) ||
-				v->type == VEH_SHIP) {
-			value += v->value * 3 >> 1;
+	AllCompanyAssetTotals stations = ParallelPoolReduce<Station>(AllCompanyAssetTotals(), [](AllCompanyAssetTotals &partial, const Station *st) {
+		if (st->owner < MAX_COMPANIES) AddStationToAssetTotals(partial[st->owner], st);
+	}, [](AllCompanyAssetTotals &result, const AllCompanyAssetTotals &partial) {
+		for (uint i = 0; i < MAX_COMPANIES; i++) {
+			result[i].station_facilities += partial[i].station_facilities;
+			result[i].serviced_station_facilities += partial[i].serviced_station_facilities;
 		}
+	});
+
+	for (uint i = 0; i < MAX_COMPANIES; i++) {
+		totals[i].station_facilities = stations[i].station_facilities;
+		totals[i].serviced_station_facilities = stations[i].serviced_station_facilities;
 	}
+	return totals;
+}
+
+/**
+ * Calculate the value of the company from its asset totals.
+ * @param c              the company to get the value of.
+ * @param totals         the asset totals of the company.
+ * @param including_loan include the loan in the company value.
+ * @return the value of the company.
+ */
+static Money CalculateCompanyValue(const Company *c, const CompanyAssetTotals &totals, bool including_loan)
+{
+	Money value = totals.station_facilities * _price[PR_STATION_VALUE] * 25;
+	value += totals.vehicle_value;
 
 	/* Add real money value */
 	if (including_loan) value -= c->current_loan;
@@ -144,15 +235,30 @@ Money CalculateCompanyValue(const Company *c, bool including_loan)
 	return max(value, (Money)1);
 }
 
+/**
+ * Calculate the value of the company. That is the value of all
+ * assets (vehicles, stations, etc) and money minus the loan,
+ * except when including_loan is \c false which is useful when
+ * we want to calculate the value for bankruptcy.
+ * @param c              the company to get the value of.
+ * @param including_loan include the loan in the company value.
+ * @return the value of the company.
+ */
+Money CalculateCompanyValue(const Company *c, bool including_loan)
+{
+	return CalculateCompanyValue(c, GatherCompanyAssetTotals(c->index), including_loan);
+}
+
 /**
  * if update is set to true, the economy is updated with this score
  *  (also the house is updated, should only be true in the on-tick event)
- * @param update the economy with calculated score
  * @param c company been evaluated
+ * @param totals asset totals of the company
+ * @param update the economy with calculated score
  * @return actual score of this company
  *
  */
-int UpdateCompanyRatingAndValue(Company *c, bool update)
+static int UpdateCompanyRatingAndValue(Company *c, const CompanyAssetTotals &totals, bool update)
 {
 	Owner owner = c->index;
 	int score = 0;
@@ -161,27 +267,9 @@ int UpdateCompanyRatingAndValue(Company *c, bool update)
 
 	/* Count vehicles */
 	{
-		Money min_profit = 0;
-		bool min_profit_first = true;
-		uint num = 0;
-
-		for (const Vehicle *v : Vehicle::Iterate()) {
-			if (v->owner != owner) continue;
-			if (IsCompanyBuildableVehicleType(v->type) && v->IsPrimaryVehicle() && !HasBit(v->subtype, GVSF_VIRTUAL)) {
-				if (v->profit_last_year > 0) num++; // For the vehicle score only count profitable vehicles
-				if (v->age > 730) {
-					/* Find the vehicle with the lowest amount of profit */
-					if (min_profit_first || min_profit > v->profit_last_year) {
-						min_profit = v->profit_last_year;
-						min_profit_first = false;
-					}
-				}
-			}
-		}
-
-		min_profit >>= 8; // remove the fract part
+		Money min_profit = totals.min_profit >> 8; // remove the fract part
 
-		_score_part[owner][SCORE_VEHICLES] = num;
+		_score_part[owner][SCORE_VEHICLES] = totals.profitable_vehicles;
 		/* Don't allow negative min_profit to show */
 		if (min_profit > 0) {
 			_score_part[owner][SCORE_MIN_PROFIT] = min_profit;
@@ -190,12 +278,7 @@ int UpdateCompanyRatingAndValue(Company *c, bool update)
 
 	/* Count stations */
 	{
-		uint num = 0;
-		for (const Station *st : Station::Iterate()) {
-			/* Only count stations that are actually serviced */
-			if (st->owner == owner && (st->time_since_load <= 20 || st->time_since_unload <= 20)) num += CountBits((byte)st->facilities);
-		}
-		_score_part[owner][SCORE_STATIONS] = num;
+		_score_part[owner][SCORE_STATIONS] = totals.serviced_station_facilities;
 	}
 
 	/* Generate statistics depending on recent income statistics */
@@ -273,13 +356,38 @@ int UpdateCompanyRatingAndValue(Company *c, bool update)
 	if (update) {
 		c->old_economy[0].performance_history = score;
 		UpdateCompanyHQ(c->location_of_HQ, score);
-		c->old_economy[0].company_value = CalculateCompanyValue(c);
+		c->old_economy[0].company_value = CalculateCompanyValue(c, totals, true);
 	}
 
 	SetWindowDirty(WC_PERFORMANCE_DETAIL, 0);
 	return score;
 }
 
+/**
+ * if update is set to true, the economy is updated with this score
+ *  (also the house is updated, should only be true in the on-tick event)
+ * @param update the economy with calculated score
+ * @param c company been evaluated
+ * @return actual score of this company
+ *
+ */
+int UpdateCompanyRatingAndValue(Company *c, bool update)
+{
+	return UpdateCompanyRatingAndValue(c, GatherCompanyAssetTotals(c->index), update);
+}
+
+/**
+ * Update the rating of all companies, without updating the economy.
+ * The vehicle and station pools are scanned once for all companies together.
+ */
+void UpdateAllCompanyRatings()
+{
+	const AllCompanyAssetTotals totals = GatherCompanyAssetTotals();
+	for (Company *c : Company::Iterate()) {
+		UpdateCompanyRatingAndValue(c, totals[c->index], false);
+	}
+}
+
 /**
  * Change the ownership of all the items of a company.
  * @param old_owner The company that gets removed.
@@ -722,6 +830,7 @@ static void CompaniesGenStatistics()
 	/* Only run the economic statics and update company stats every 3rd month (1st of quarter). */
 	if (!HasBit(1 << 0 | 1 << 3 | 1 << 6 | 1 << 9, _cur_month)) return;
 
+	const AllCompanyAssetTotals totals = GatherCompanyAssetTotals();
 	for (Company *c : Company::Iterate()) {
 		/* Drop the oldest history off the end */
 		std::copy_backward(c->old_economy, c->old_economy + MAX_HISTORY_QUARTERS - 1, c->old_economy + MAX_HISTORY_QUARTERS);
@@ -730,7 +839,7 @@ static void CompaniesGenStatistics()
 
 		if (c->num_valid_stat_ent != MAX_HISTORY_QUARTERS) c->num_valid_stat_ent++;
 
-		UpdateCompanyRatingAndValue(c, true);
+		UpdateCompanyRatingAndValue(c, totals[c->index], true);
 		if (c->block_preview != 0) c->block_preview--;
 	}
 
@@ -26,10 +26,12 @@ extern Economy _economy;
 extern Prices _price;
 
 int UpdateCompanyRatingAndValue(Company *c, bool update);
+void UpdateAllCompanyRatings();
 void StartupIndustryDailyChanges(bool init_counter);
 
 Money GetTransportedGoodsIncome(uint num_pieces, uint dist, byte transit_days, CargoID cargo_type);
-uint MoveGoodsToStation(CargoID type, uint amount, SourceType source_type, SourceID source_id, const StationList *all_stations);
+template <typename Tstation_list>
+uint MoveGoodsToStation(CargoID type, uint amount, SourceType source_type, SourceID source_id, const Tstation_list *all_stations);
 
 void PrepareUnload(Vehicle *front_v);
 void LoadUnloadStation(Station *st);
@@ -566,7 +566,18 @@ void FiosGetScenarioList(SaveLoadOperation fop, FileList &file_list)
 	FiosGetFileList(fop, &FiosGetScenarioListCallback, subdir, file_list);
 }
 
-static FiosType FiosGetHeightmapListCallback(SaveLoadOperation fop, const char *file, const char *ext, char *title, const char *last)
+/**
+ * Callback for FiosGetFileList. It tells if a file is a heightmap or not.
+ * @param fop Purpose of collecting the list.
+ * @param file Name of the file to check.
+ * @param ext A pointer to the extension identifier inside file
+ * @param title Buffer if a callback wants to lookup the title of the file
+ * @param last Last available byte in buffer (to prevent buffer overflows); not used when title == nullptr
+ * @return a FIOS_TYPE_* type of the found file, FIOS_TYPE_INVALID if not a heightmap
+ * @see FiosGetFileList
+ * @see FiosGetHeightmapList
+ */
+FiosType FiosGetHeightmapListCallback(SaveLoadOperation fop, const char *file, const char *ext, char *title, const char *last)
 {
 	/* Show heightmap files
 	 * .PNG PNG Based heightmap files
@@ -1827,6 +1827,9 @@ void SetDirtyBlocks(int left, int top, int right, int bottom)
 void MarkWholeScreenDirty()
 {
 	_whole_screen_dirty = true;
+
+	extern void ClearTileDrawCache();
+	ClearTileDrawCache();
 }
 
 /**
@@ -1296,9 +1296,7 @@ struct PerformanceRatingDetailWindow : Window {
 	{
 		/* Update all company stats with the current data
 		 * (this is because _score_info is not saved to a savegame) */
-		for (Company *c : Company::Iterate()) {
-			UpdateCompanyRatingAndValue(c, false);
-		}
+		UpdateAllCompanyRatings();
 
 		this->timeout = DAY_TICKS * 5;
 	}
@@ -17,6 +17,7 @@
 #include "gfx_func.h"
 #include "fios.h"
 #include "fileio_func.h"
+#include "worker_thread.h"
 
 #include "table/strings.h"
 
@@ -34,20 +35,43 @@ static inline byte RGBToGrayscale(byte red, byte green, byte blue)
 }
 
 
+/**
+ * Open a heightmap file for reading.
+ * The file is searched for in the heightmap directories first, and then as given,
+ * so heightmaps passed on the command line can be anywhere.
+ * @param filename Name of the file.
+ * @return The opened file, or \c nullptr if it could not be found.
+ */
+static FILE *OpenHeightmapFile(const char *filename)
+{
+	FILE *f = FioFOpenFile(filename, "rb", HEIGHTMAP_DIR);
+	if (f == nullptr) f = FioFOpenFile(filename, "rb", NO_DIRECTORY);
+	return f;
+}
+
 #ifdef WITH_PNG
 
 #include <png.h>
 
 /**
  * The PNG Heightmap loader.
+ * Non-interlaced images are decoded and converted to grayscale one row at a time, so only
+ * the grayscale map is kept in memory. Interlaced images can only be decoded as a whole.
+ * @param map Destination of the grayscale pixels.
+ * @param png_ptr The PNG read structure, after reading the header.
+ * @param info_ptr The PNG info structure.
+ * @param row_buffer Buffer for the decoded rows; resized as needed.
+ * @param row_pointers Buffer for the row pointers of interlaced images; resized as needed.
+ * @note On errors libpng jumps back to the caller, so no objects with destructors may live in this function.
  */
-static void ReadHeightmapPNGImageData(byte *map, png_structp png_ptr, png_infop info_ptr)
+static void ReadHeightmapPNGImageData(byte *map, png_structp png_ptr, png_infop info_ptr, std::vector<png_byte> &row_buffer, std::vector<png_bytep> &row_pointers)
 {
-	uint x, y;
 	byte gray_palette[256];
-	png_bytep *row_pointers = nullptr;
 	bool has_palette = png_get_color_type(png_ptr, info_ptr) == PNG_COLOR_TYPE_PALETTE;
 	uint channels = png_get_channels(png_ptr, info_ptr);
+	uint width = png_get_image_width(png_ptr, info_ptr);
+	uint height = png_get_image_height(png_ptr, info_ptr);
+	size_t row_bytes = png_get_rowbytes(png_ptr, info_ptr);
 
 	/* Get palette and convert it to grayscale */
 	if (has_palette) {
@@ -75,24 +99,36 @@ static void ReadHeightmapPNGImageData(byte *map, png_structp png_ptr, png_infop
 		}
 	}
 
-	row_pointers = png_get_rows(png_ptr, info_ptr);
-
-	/* Read the raw image data and convert in 8-bit grayscale */
-	for (x = 0; x < png_get_image_width(png_ptr, info_ptr); x++) {
-		for (y = 0; y < png_get_image_height(png_ptr, info_ptr); y++) {
-			byte *pixel = &map[y * png_get_image_width(png_ptr, info_ptr) + x];
-			uint x_offset = x * channels;
-
+	/* Convert one row of raw image data into 8-bit grayscale */
+	auto convert_row = [&](byte *pixel, const png_byte *row) {
+		for (uint x = 0; x < width; x++) {
 			if (has_palette) {
-				*pixel = gray_palette[row_pointers[y][x_offset]];
+				*pixel++ = gray_palette[*row++];
 			} else if (channels == 3) {
-				*pixel = RGBToGrayscale(row_pointers[y][x_offset + 0],
-						row_pointers[y][x_offset + 1], row_pointers[y][x_offset + 2]);
+				*pixel++ = RGBToGrayscale(row[0], row[1], row[2]);
+				row += 3;
 			} else {
-				*pixel = row_pointers[y][x_offset];
+				*pixel++ = *row;
+				row += channels;
 			}
 		}
+	};
+
+	if (png_get_interlace_type(png_ptr, info_ptr) == PNG_INTERLACE_NONE) {
+		row_buffer.resize(row_bytes);
+		for (uint y = 0; y < height; y++) {
+			png_read_row(png_ptr, row_buffer.data(), nullptr);
+			convert_row(&map[(size_t)y * width], row_buffer.data());
+		}
+	} else {
+		row_buffer.resize(row_bytes * height);
+		row_pointers.resize(height);
+		for (uint y = 0; y < height; y++) row_pointers[y] = &row_buffer[row_bytes * y];
+		png_read_image(png_ptr, row_pointers.data());
+		for (uint y = 0; y < height; y++) convert_row(&map[(size_t)y * width], row_pointers[y]);
 	}
+
+	png_read_end(png_ptr, nullptr);
 }
 
 /**
@@ -105,8 +141,11 @@ static bool ReadHeightmapPNG(const char *filename, uint *x, uint *y, byte **map)
 	FILE *fp;
 	png_structp png_ptr = nullptr;
 	png_infop info_ptr  = nullptr;
+	/* Declared before setjmp, so a jump back on errors does not skip their destructors. */
+	std::vector<png_byte> row_buffer;
+	std::vector<png_bytep> row_pointers;
 
-	fp = FioFOpenFile(filename, "rb", HEIGHTMAP_DIR);
+	fp = OpenHeightmapFile(filename);
 	if (fp == nullptr) {
 		ShowErrorMessage(STR_ERROR_PNGMAP, STR_ERROR_PNGMAP_FILE_NOT_FOUND, WL_ERROR);
 		return false;
@@ -129,10 +168,14 @@ static bool ReadHeightmapPNG(const char *filename, uint *x, uint *y, byte **map)
 
 	png_init_io(png_ptr, fp);
 
-	/* Allocate memory and read image, without alpha or 16-bit samples
+	/* Read the header and set up decoding without alpha or 16-bit samples
 	 * (result is either 8-bit indexed/grayscale or 24-bit RGB) */
+	png_read_info(png_ptr, info_ptr);
 	png_set_packing(png_ptr);
-	png_read_png(png_ptr, info_ptr, PNG_TRANSFORM_PACKING | PNG_TRANSFORM_STRIP_ALPHA | PNG_TRANSFORM_STRIP_16, nullptr);
+	png_set_strip_alpha(png_ptr);
+	png_set_strip_16(png_ptr);
+	if (png_get_interlace_type(png_ptr, info_ptr) != PNG_INTERLACE_NONE) png_set_interlace_handling(png_ptr);
+	png_read_update_info(png_ptr, info_ptr);
 
 	/* Maps of wrong colour-depth are not used.
 	 * (this should have been taken care of by stripping alpha and 16-bit samples on load) */
@@ -155,8 +198,8 @@ static bool ReadHeightmapPNG(const char *filename, uint *x, uint *y, byte **map)
 	}
 
 	if (map != nullptr) {
-		*map = MallocT<byte>(width * height);
-		ReadHeightmapPNGImageData(*map, png_ptr, info_ptr);
+		*map = MallocT<byte>((size_t)width * height);
+		ReadHeightmapPNGImageData(*map, png_ptr, info_ptr, row_buffer, row_pointers);
 	}
 
 	*x = width;
@@ -172,6 +215,9 @@ static bool ReadHeightmapPNG(const char *filename, uint *x, uint *y, byte **map)
 
 /**
  * The BMP Heightmap loader.
+ * @param map Destination of the grayscale pixels; may be the bitmap of \a data to convert it in place.
+ * @param info The BMP header.
+ * @param data The palette and the decoded bitmap.
  */
 static void ReadHeightmapBMPImageData(byte *map, BmpInfo *info, BmpData *data)
 {
@@ -209,10 +255,11 @@ static void ReadHeightmapBMPImageData(byte *map, BmpInfo *info, BmpData *data)
 		}
 	}
 
-	/* Read the raw image data and convert in 8-bit grayscale */
+	/* Read the raw image data and convert in 8-bit grayscale.
+	 * The map may be the bitmap itself, as no pixel is written before it is read. */
 	for (y = 0; y < info->height; y++) {
-		byte *pixel = &map[y * info->width];
-		byte *bitmap = &data->bitmap[y * info->width * (info->bpp == 24 ? 3 : 1)];
+		byte *pixel = &map[(size_t)y * info->width];
+		const byte *bitmap = &data->bitmap[(size_t)y * info->width * (info->bpp == 24 ? 3 : 1)];
 
 		for (x = 0; x < info->width; x++) {
 			if (info->bpp != 24) {
@@ -240,7 +287,7 @@ static bool ReadHeightmapBMP(const char *filename, uint *x, uint *y, byte **map)
 	/* Init BmpData */
 	memset(&data, 0, sizeof(data));
 
-	f = FioFOpenFile(filename, "rb", HEIGHTMAP_DIR);
+	f = OpenHeightmapFile(filename);
 	if (f == nullptr) {
 		ShowErrorMessage(STR_ERROR_BMPMAP, STR_ERROR_PNGMAP_FILE_NOT_FOUND, WL_ERROR);
 		return false;
@@ -271,8 +318,11 @@ static bool ReadHeightmapBMP(const char *filename, uint *x, uint *y, byte **map)
 			return false;
 		}
 
-		*map = MallocT<byte>(info.width * info.height);
-		ReadHeightmapBMPImageData(*map, &info, &data);
+		/* Convert the bitmap in place, instead of keeping a second copy of the image. */
+		ReadHeightmapBMPImageData(data.bitmap, &info, &data);
+		*map = data.bitmap;
+		data.bitmap = nullptr;
+		if (info.bpp == 24) *map = ReallocT<byte>(*map, (size_t)info.width * info.height);
 	}
 
 	BmpDestroyData(&data);
@@ -284,6 +334,9 @@ static bool ReadHeightmapBMP(const char *filename, uint *x, uint *y, byte **map)
 	return true;
 }
 
+/** Number of map rows converted by each task of #GrayscaleToMapHeights. */
+static const uint HEIGHTMAP_ROW_BAND = 64;
+
 /**
  * Converts a given grayscale map to something that fits in OTTD map system
  * and create a map of that data.
@@ -297,11 +350,8 @@ static void GrayscaleToMapHeights(uint img_width, uint img_height, byte *map)
 	const uint num_div = 16384;
 
 	uint width, height;
-	uint row, col;
 	uint row_pad = 0, col_pad = 0;
 	uint img_scale;
-	uint img_row, img_col;
-	TileIndex tile;
 
 	/* Get map size and calculate scale and padding values */
 	switch (_settings_game.game_creation.heightmap_rotation) {
@@ -331,54 +381,60 @@ static void GrayscaleToMapHeights(uint img_width, uint img_height, byte *map)
 		for (uint y = 0; y < MapSizeY(); y++) MakeVoid(TileXY(0, y));
 	}
 
-	/* Form the landscape */
-	for (row = 0; row < height; row++) {
-		for (col = 0; col < width; col++) {
-			switch (_settings_game.game_creation.heightmap_rotation) {
-				default: NOT_REACHED();
-				case HM_COUNTER_CLOCKWISE: tile = TileXY(col, row); break;
-				case HM_CLOCKWISE:         tile = TileXY(row, col); break;
-			}
+	const bool clockwise = _settings_game.game_creation.heightmap_rotation == HM_CLOCKWISE;
+	const bool freeform_edges = _settings_game.construction.freeform_edges;
+
+	/* Map rows and columns outside the 1-pixel map edge and padding regions; the others get height 0.
+	 * Without freeform edges the map edge are the two outer rows and columns (DistanceFromEdge(tile) <= 1). */
+	const uint first_row = max<uint>(row_pad, freeform_edges ? 0 : 2);
+	const uint end_row = min<uint>(height - row_pad - (freeform_edges ? 0 : 1), freeform_edges ? height : height - 2);
+	const uint first_col = max<uint>(col_pad, freeform_edges ? 0 : 2);
+	const uint end_col = min<uint>(width - col_pad - (freeform_edges ? 0 : 1), freeform_edges ? width : width - 2);
+
+	/* Use nearest neighbour resizing to scale map data.
+	 *  We rotate the map 45 degrees (counter)clockwise */
+	std::vector<uint> img_cols(width);
+	for (uint col = first_col; col < end_col; col++) {
+		img_cols[col] = ((clockwise ? col - col_pad : width - 1 - col - col_pad) * num_div) / img_scale;
+		assert(img_cols[col] < img_width);
+	}
 
-			/* Check if current tile is within the 1-pixel map edge or padding regions */
-			if ((!_settings_game.construction.freeform_edges && DistanceFromEdge(tile) <= 1) ||
-					(row < row_pad) || (row >= (height - row_pad - (_settings_game.construction.freeform_edges ? 0 : 1))) ||
-					(col < col_pad) || (col >= (width  - col_pad - (_settings_game.construction.freeform_edges ? 0 : 1)))) {
-				SetTileHeight(tile, 0);
-			} else {
-				/* Use nearest neighbour resizing to scale map data.
-				 *  We rotate the map 45 degrees (counter)clockwise */
-				img_row = (((row - row_pad) * num_div) / img_scale);
-				switch (_settings_game.game_creation.heightmap_rotation) {
-					default: NOT_REACHED();
-					case HM_COUNTER_CLOCKWISE:
-						img_col = (((width - 1 - col - col_pad) * num_div) / img_scale);
-						break;
-					case HM_CLOCKWISE:
-						img_col = (((col - col_pad) * num_div) / img_scale);
-						break;
-				}
+	/* 0 is sea level.
+	 * Other grey scales are scaled evenly to the available height levels > 0.
+	 * (The coastline is independent from the number of height levels) */
+	uint grey_to_height[256];
+	grey_to_height[0] = 0;
+	for (uint grey = 1; grey < lengthof(grey_to_height); grey++) {
+		grey_to_height[grey] = 1 + (grey - 1) * _settings_game.construction.max_heightlevel / 255;
+	}
 
+	/* Form the landscape. Every tile only depends on its own pixel, so bands of map rows are filled in parallel. */
+	RunParallelTasks(CeilDiv(height, HEIGHTMAP_ROW_BAND), [&](uint band) {
+		const uint band_end = min(height, (band + 1) * HEIGHTMAP_ROW_BAND);
+		for (uint row = band * HEIGHTMAP_ROW_BAND; row < band_end; row++) {
+			const bool in_image = row >= first_row && row < end_row;
+			const byte *img_line = nullptr;
+			if (in_image) {
+				uint img_row = ((row - row_pad) * num_div) / img_scale;
 				assert(img_row < img_height);
-				assert(img_col < img_width);
+				img_line = &map[(size_t)img_row * img_width];
+			}
 
-				uint heightmap_height = map[img_row * img_width + img_col];
+			for (uint col = 0; col < width; col++) {
+				TileIndex tile = clockwise ? TileXY(row, col) : TileXY(col, row);
 
-				if (heightmap_height > 0) {
-					/* 0 is sea level.
-					 * Other grey scales are scaled evenly to the available height levels > 0.
-					 * (The coastline is independent from the number of height levels) */
-					heightmap_height = 1 + (heightmap_height - 1) * _settings_game.construction.max_heightlevel / 255;
+				if (in_image && col >= first_col && col < end_col) {
+					SetTileHeight(tile, grey_to_height[img_line[img_cols[col]]]);
+				} else {
+					SetTileHeight(tile, 0);
+				}
+				/* Only clear the tiles within the map area. */
+				if (IsInnerTile(tile)) {
+					MakeClear(tile, CLEAR_GRASS, 3);
 				}
-
-				SetTileHeight(tile, heightmap_height);
-			}
-			/* Only clear the tiles within the map area. */
-			if (IsInnerTile(tile)) {
-				MakeClear(tile, CLEAR_GRASS, 3);
 			}
 		}
-	}
+	});
 }
 
 /**
@@ -40,6 +40,7 @@
 #include "object_base.h"
 #include "game/game.hpp"
 #include "error.h"
+#include "worker_thread.h"
 
 #include "table/strings.h"
 #include "table/industry_land.h"
@@ -664,6 +665,7 @@ void AnimateTile_Industry(TileIndex tile)
 
 			gfx = (gfx < 155) ? gfx + 1 : 148;
 			SetIndustryGfx(tile, gfx);
+			UpdateAnimatedTileSpeed(tile);
 			MarkTileDirtyByTile(tile, ZOOM_LVL_DRAW_MAP);
 		}
 		break;
@@ -683,6 +685,7 @@ void AnimateTile_Industry(TileIndex tile)
 			} else {
 				SetAnimationFrame(tile, m);
 				SetIndustryGfx(tile, gfx);
+				UpdateAnimatedTileSpeed(tile);
 				MarkTileDirtyByTile(tile, ZOOM_LVL_DRAW_MAP);
 			}
 		}
@@ -841,6 +844,7 @@ static void TileLoop_Industry(TileIndex tile)
 			ResetIndustryConstructionStage(tile);
 			SetIndustryCompleted(tile);
 			SetIndustryGfx(tile, newgfx);
+			UpdateAnimatedTileSpeed(tile);
 			MarkTileDirtyByTile(tile, ZOOM_LVL_DRAW_MAP);
 			return;
 		}
@@ -852,6 +856,7 @@ static void TileLoop_Industry(TileIndex tile)
 	if (newgfx != INDUSTRYTILE_NOANIM) {
 		ResetIndustryConstructionStage(tile);
 		SetIndustryGfx(tile, newgfx);
+		UpdateAnimatedTileSpeed(tile);
 		MarkTileDirtyByTile(tile, ZOOM_LVL_DRAW_MAP);
 		return;
 	}
@@ -868,6 +873,7 @@ static void TileLoop_Industry(TileIndex tile)
 				case GFX_GOLD_MINE_TOWER_NOT_ANIMATED:   gfx = GFX_GOLD_MINE_TOWER_ANIMATED;   break;
 			}
 			SetIndustryGfx(tile, gfx);
+			UpdateAnimatedTileSpeed(tile);
 			SetAnimationFrame(tile, 0x80);
 			AddAnimatedTile(tile);
 		}
@@ -876,6 +882,7 @@ static void TileLoop_Industry(TileIndex tile)
 	case GFX_OILWELL_NOT_ANIMATED:
 		if (Chance16(1, 6)) {
 			SetIndustryGfx(tile, GFX_OILWELL_ANIMATED_1);
+			UpdateAnimatedTileSpeed(tile);
 			SetAnimationFrame(tile, 0);
 			AddAnimatedTile(tile);
 		}
@@ -891,6 +898,7 @@ static void TileLoop_Industry(TileIndex tile)
 				case GFX_GOLD_MINE_TOWER_ANIMATED:   gfx = GFX_GOLD_MINE_TOWER_NOT_ANIMATED;   break;
 			}
 			SetIndustryGfx(tile, gfx);
+			UpdateAnimatedTileSpeed(tile);
 			SetIndustryCompleted(tile);
 			SetIndustryConstructionStage(tile, 3);
 			DeleteAnimatedTile(tile);
@@ -2609,18 +2617,32 @@ static void ReportNewsProductionChangeIndustry(Industry *ind, CargoID type, int
 static const uint PERCENT_TRANSPORTED_60 = 153;
 static const uint PERCENT_TRANSPORTED_80 = 204;
 
+/** Outcome of a production change of an industry, whose side effects have not been applied yet. */
+struct IndustryProductionChange {
+	StringID str = STR_NULL;                          ///< News message about the change, or STR_NULL.
+	bool closeit = false;                             ///< Whether the industry is to close down.
+	bool suppress_message = false;                    ///< Whether the news message has been suppressed by the NewGRF.
+	bool determined = false;                          ///< Whether the change has been determined already, by the parallel part of the monthly loop.
+	uint8 smooth_news_count = 0;                      ///< Number of smooth economy production change news messages.
+	CargoID smooth_news_cargo[INDUSTRY_NUM_OUTPUTS];  ///< Cargo of each smooth economy production change news message.
+	int smooth_news_percent[INDUSTRY_NUM_OUTPUTS];    ///< Percentage of each smooth economy production change news message.
+};
+
 /**
- * Change industry production or do closure
+ * Determine the change of industry production or closure, without applying its side effects.
+ * Only the industry itself is modified, so for industries without production change callbacks this can be done in parallel.
  * @param i Industry for which changes are performed
  * @param monthly true if it's the monthly call, false if it's the random call
+ * @param random Random number generator to use for the change.
+ * @param[out] change The outcome of the change, to pass to #ApplyIndustryProductionChange.
  */
-static void ChangeIndustryProduction(Industry *i, bool monthly)
+static void DetermineIndustryProductionChange(Industry *i, bool monthly, Randomizer &random, IndustryProductionChange &change)
 {
-	StringID str = STR_NULL;
-	bool closeit = false;
+	StringID &str = change.str;
+	bool &closeit = change.closeit;
 	const IndustrySpec *indspec = GetIndustrySpec(i->type);
 	bool standard = false;
-	bool suppress_message = false;
+	bool &suppress_message = change.suppress_message;
 	bool recalculate_multipliers = false; ///< reinitialize production_rate to match prod_level
 	/* don't use smooth economy for industries using production related callbacks */
 	bool smooth_economy = indspec->UsesSmoothEconomy();
@@ -2630,7 +2652,7 @@ static void ChangeIndustryProduction(Industry *i, bool monthly)
 
 	bool callback_enabled = HasBit(indspec->callback_mask, monthly ? CBM_IND_MONTHLYPROD_CHANGE : CBM_IND_PRODUCTION_CHANGE);
 	if (callback_enabled) {
-		uint16 res = GetIndustryCallback(monthly ? CBID_INDUSTRY_MONTHLYPROD_CHANGE : CBID_INDUSTRY_PRODUCTION_CHANGE, 0, Random(), i, i->type, i->location.tile);
+		uint16 res = GetIndustryCallback(monthly ? CBID_INDUSTRY_MONTHLYPROD_CHANGE : CBID_INDUSTRY_PRODUCTION_CHANGE, 0, random.Next(), i, i->type, i->location.tile);
 		if (res != CALLBACK_FAILED) { // failed callback means "do nothing"
 			suppress_message = HasBit(res, 7);
 			/* Get the custom message if any */
@@ -2670,7 +2692,7 @@ static void ChangeIndustryProduction(Industry *i, bool monthly)
 			closeit = true;
 			for (byte j = 0; j < lengthof(i->produced_cargo); j++) {
 				if (i->produced_cargo[j] == CT_INVALID) continue;
-				uint32 r = Random();
+				uint32 r = random.Next();
 				int old_prod, new_prod, percent;
 				/* If over 60% is transported, mult is 1, else mult is -1. */
 				int mult = (i->last_month_pct_transported[j] > PERCENT_TRANSPORTED_60) ? 1 : -1;
@@ -2690,7 +2712,7 @@ static void ChangeIndustryProduction(Industry *i, bool monthly)
 				/* 4.5% chance for 3-23% (or 1 unit for very low productions) production change,
 				 * determined by mult value. If mult = 1 prod. increases, else (-1) it decreases. */
 				if (Chance16I(1, 22, r >> 16)) {
-					new_prod += mult * (max(((RandomRange(50) + 10) * old_prod) >> 8, 1U));
+					new_prod += mult * (max(((random.Next(50) + 10) * old_prod) >> 8, 1U));
 				}
 
 				/* Prevent production to overflow or Oil Rig passengers to be over-"produced" */
@@ -2713,13 +2735,15 @@ static void ChangeIndustryProduction(Industry *i, bool monthly)
 				if (new_prod > 1) closeit = false;
 
 				if (abs(percent) >= 10) {
-					ReportNewsProductionChangeIndustry(i, i->produced_cargo[j], percent);
+					change.smooth_news_cargo[change.smooth_news_count] = i->produced_cargo[j];
+					change.smooth_news_percent[change.smooth_news_count] = percent;
+					change.smooth_news_count++;
 				}
 			}
 		} else {
-			if (only_decrease || Chance16(1, 3)) {
+			if (only_decrease || Chance16I(1, 3, random.Next())) {
 				/* If more than 60% transported, 66% chance of increase, else 33% chance of increase */
-				if (!only_decrease && (i->last_month_pct_transported[0] > PERCENT_TRANSPORTED_60) != Chance16(1, 3)) {
+				if (!only_decrease && (i->last_month_pct_transported[0] > PERCENT_TRANSPORTED_60) != Chance16I(1, 3, random.Next())) {
 					mul = 1; // Increase production
 				} else {
 					div = 1; // Decrease production
@@ -2729,7 +2753,7 @@ static void ChangeIndustryProduction(Industry *i, bool monthly)
 	}
 
 	if (!callback_enabled && (indspec->life_type & INDUSTRYLIFE_PROCESSING)) {
-		if ( (byte)(_cur_year - i->last_prod_year) >= 5 && Chance16(1, smooth_economy ? 180 : 2)) {
+		if ( (byte)(_cur_year - i->last_prod_year) >= 5 && Chance16I(1, smooth_economy ? 180 : 2, random.Next())) {
 			closeit = true;
 		}
 	}
@@ -2765,6 +2789,22 @@ static void ChangeIndustryProduction(Industry *i, bool monthly)
 	/* Recalculate production_rate
 	 * For non-smooth economy these should always be synchronized with prod_level */
 	if (recalculate_multipliers) i->RecomputeProductionMultipliers();
+}
+
+/**
+ * Apply the side effects of a change of industry production, i.e. do the closure and report the news.
+ * @param i Industry for which changes are performed
+ * @param change The outcome of #DetermineIndustryProductionChange.
+ */
+static void ApplyIndustryProductionChange(Industry *i, const IndustryProductionChange &change)
+{
+	StringID str = change.str;
+	const bool closeit = change.closeit;
+	const IndustrySpec *indspec = GetIndustrySpec(i->type);
+
+	for (uint8 j = 0; j < change.smooth_news_count; j++) {
+		ReportNewsProductionChangeIndustry(i, change.smooth_news_cargo[j], change.smooth_news_percent[j]);
+	}
 
 	/* Close if needed and allowed */
 	if (closeit && !CheckIndustryCloseDownProtection(i->type)) {
@@ -2773,7 +2813,7 @@ static void ChangeIndustryProduction(Industry *i, bool monthly)
 		str = indspec->closure_text;
 	}
 
-	if (!suppress_message && str != STR_NULL) {
+	if (!change.suppress_message && str != STR_NULL) {
 		NewsType nt;
 		/* Compute news category */
 		if (closeit) {
@@ -2809,6 +2849,18 @@ static void ChangeIndustryProduction(Industry *i, bool monthly)
 	}
 }
 
+/**
+ * Change industry production or do closure
+ * @param i Industry for which changes are performed
+ * @param monthly true if it's the monthly call, false if it's the random call
+ */
+static void ChangeIndustryProduction(Industry *i, bool monthly)
+{
+	IndustryProductionChange change;
+	DetermineIndustryProductionChange(i, monthly, _random, change);
+	ApplyIndustryProductionChange(i, change);
+}
+
 /**
  * Daily handler for the industry changes
  * Taking the original map size of 256*256, the number of random changes was always of just one unit.
@@ -2858,19 +2910,59 @@ void IndustryDailyLoop()
 	InvalidateWindowData(WC_INDUSTRY_DIRECTORY, 0, IDIWD_PRODUCTION_CHANGE);
 }
 
+/**
+ * Monthly update of all industries, with the statistics and production changes determined in parallel.
+ * Each industry uses its own random number stream, so the outcome does not depend on the number of threads.
+ * Production changes using NewGRF callbacks, closures and all other side effects are done afterwards, in index order.
+ */
+static void IndustryMonthlyLoopParallel()
+{
+	const uint32 seed = Random();
+
+	std::vector<IndustryProductionChange> changes(Industry::GetPoolSize());
+	ParallelPoolForEach<Industry>([&](Industry *i) {
+		UpdateIndustryStatistics(i);
+		if (i->prod_level == PRODLEVEL_CLOSURE || HasBit(GetIndustrySpec(i->type)->callback_mask, CBM_IND_MONTHLYPROD_CHANGE)) return;
+
+		Randomizer random;
+		random.SetSeed(seed, i->index);
+		DetermineIndustryProductionChange(i, true, random, changes[i->index]);
+		changes[i->index].determined = true;
+	});
+
+	for (Industry *i : Industry::Iterate()) {
+		IndustryProductionChange &change = changes[i->index];
+		if (!change.determined) {
+			if (i->prod_level == PRODLEVEL_CLOSURE) {
+				delete i;
+				continue;
+			}
+			Randomizer random;
+			random.SetSeed(seed, i->index);
+			DetermineIndustryProductionChange(i, true, random, change);
+		}
+		ApplyIndustryProductionChange(i, change);
+		SetWindowDirty(WC_INDUSTRY_VIEW, i->index);
+	}
+}
+
 void IndustryMonthlyLoop()
 {
 	Backup<CompanyID> cur_company(_current_company, OWNER_NONE, FILE_LINE);
 
 	_industry_builder.MonthlyLoop();
 
-	for (Industry *i : Industry::Iterate()) {
-		UpdateIndustryStatistics(i);
-		if (i->prod_level == PRODLEVEL_CLOSURE) {
-			delete i;
-		} else {
-			ChangeIndustryProduction(i, true);
-			SetWindowDirty(WC_INDUSTRY_VIEW, i->index);
+	if (_settings_game.economy.parallel_monthly_loops) {
+		IndustryMonthlyLoopParallel();
+	} else {
+		for (Industry *i : Industry::Iterate()) {
+			UpdateIndustryStatistics(i);
+			if (i->prod_level == PRODLEVEL_CLOSURE) {
+				delete i;
+			} else {
+				ChangeIndustryProduction(i, true);
+				SetWindowDirty(WC_INDUSTRY_VIEW, i->index);
+			}
 		}
 	}
 
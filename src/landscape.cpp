@@ -737,6 +737,39 @@ CommandCost CmdLandscapeClear(TileIndex tile, DoCommandFlag flags, uint32 p1, ui
 	return cost;
 }
 
+/**
+ * Check whether a tile is bare land that #ClearBareLandTile can clear.
+ * @param tile tile to check
+ * @return true if the tile is clear land not belonging to an object cleared by the current command
+ */
+bool IsBareLandTile(TileIndex tile)
+{
+	return IsTileType(tile, MP_CLEAR) && FindClearedObject(tile) == nullptr;
+}
+
+/**
+ * Clear a tile of bare land, with the same result as #CmdLandscapeClear but without
+ * the command overhead. For commands which build on many tiles of a drag at once.
+ * @param tile tile to clear, see #IsBareLandTile
+ * @param flags of operation to conduct
+ * @return the cost of this operation or an error
+ */
+CommandCost ClearBareLandTile(TileIndex tile, DoCommandFlag flags)
+{
+	assert_tile(IsBareLandTile(tile), tile);
+
+	Company *c = (flags & (DC_AUTO | DC_BANKRUPT)) ? nullptr : Company::GetIfValid(_current_company);
+	if (c != nullptr && (int)GB(c->clear_limit, 16, 16) < 1) {
+		return_cmd_error(STR_ERROR_CLEARING_LIMIT_REACHED);
+	}
+
+	CommandCost cost(EXPENSES_CONSTRUCTION);
+	cost.AddCost(_tile_type_procs[MP_CLEAR]->clear_tile_proc(tile, flags));
+
+	if ((flags & DC_EXEC) && c != nullptr) c->clear_limit -= 1 << 16;
+	return cost;
+}
+
 /**
  * Clear a big piece of landscape
  * @param tile end tile of area dragging
@@ -804,16 +837,12 @@ CommandCost CmdClearArea(TileIndex tile, DoCommandFlag flags, uint32 p1, uint32
 TileIndex _cur_tileloop_tile;
 
 /**
- * Gradually iterate over all tiles on the map, calling their TileLoopProcs once every 256 ticks.
+ * Get the feedback term of the linear feedback shift register which generates the order
+ * in which #RunTileLoop visits the tiles of the current map.
+ * @return The feedback term.
  */
-void RunTileLoop()
+uint32 GetTileLoopFeedback()
 {
-	PerformanceAccumulator framerate(PFE_GL_LANDSCAPE);
-
-	/* The pseudorandom sequence of tiles is generated using a Galois linear feedback
-	 * shift register (LFSR). This allows a deterministic pseudorandom ordering, but
-	 * still with minimal state and fast iteration. */
-
 	/* Maximal length LFSR feedback terms, from 12-bit (for 64x64 maps) to 28-bit (for 16kx16k maps).
 	 * Extracted from http://www.ece.cmu.edu/~koopman/lfsr/ */
 	static const uint32 feedbacks[] = {
@@ -821,7 +850,20 @@ void RunTileLoop()
 		0x4004B2, 0x800B87, 0x10004F3, 0x200072D, 0x40006AE, 0x80009E3,
 	};
 	assert_compile(lengthof(feedbacks) == MAX_MAP_TILES_BITS - 2 * MIN_MAP_SIZE_BITS + 1);
-	const uint32 feedback = feedbacks[MapLogX() + MapLogY() - 2 * MIN_MAP_SIZE_BITS];
+	return feedbacks[MapLogX() + MapLogY() - 2 * MIN_MAP_SIZE_BITS];
+}
+
+/**
+ * Gradually iterate over all tiles on the map, calling their TileLoopProcs once every 256 ticks.
+ */
+void RunTileLoop()
+{
+	PerformanceAccumulator framerate(PFE_GL_LANDSCAPE);
+
+	/* The pseudorandom sequence of tiles is generated using a Galois linear feedback
+	 * shift register (LFSR). This allows a deterministic pseudorandom ordering, but
+	 * still with minimal state and fast iteration. */
+	const uint32 feedback = GetTileLoopFeedback();
 
 	/* We update every tile every 256 ticks, so divide the map size by 2^8 = 256 */
 	uint count = 1 << (MapLogX() + MapLogY() - 8);
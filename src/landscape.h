@@ -136,6 +136,9 @@ bool HasFoundationNW(TileIndex tile, Slope slope_here, uint z_here);
 bool HasFoundationNE(TileIndex tile, Slope slope_here, uint z_here);
 
 void DoClearSquare(TileIndex tile);
+bool IsBareLandTile(TileIndex tile);
+CommandCost ClearBareLandTile(TileIndex tile, DoCommandFlag flags);
+uint32 GetTileLoopFeedback();
 void RunTileLoop();
 
 void InitializeLandscape();
@@ -2,6 +2,7 @@
 
 #include "../stdafx.h"
 #include "demands.h"
+#include "../worker_thread.h"
 #include <queue>
 #include <algorithm>
 #include <tuple>
@@ -10,6 +11,15 @@
 
 typedef std::queue<NodeID> NodeList;
 
+/** Number of supply nodes per task when sorting the demand nodes by distance in parallel. */
+static const size_t DEMAND_SORT_CHUNK_SIZE = 64;
+
+/** Minimum number of supply nodes per partition when calculating demands in parallel partitions. */
+static const uint DEMAND_PARTITION_MIN_SUPPLIES = 64;
+
+/** Maximum number of partitions when calculating demands in parallel partitions. */
+static const uint DEMAND_MAX_PARTITIONS = 16;
+
 /**
  * Scale various things according to symmetric/asymmetric distribution.
  */
@@ -247,6 +257,113 @@ inline void Scaler::SetDemands(LinkGraphJob &job, NodeID from_id, NodeID to_id,
 	job[from_id].DeliverSupply(to_id, demand_forw);
 }
 
+/**
+ * Get the divisor for the effective supply from one node to another. It scales
+ * the accuracy by the distance between the nodes.
+ * @param from The supplying node.
+ * @param to The receiving node.
+ * @return Divisor, always larger than 0.
+ */
+int32 DemandCalculator::GetDivisor(const Node &from, const Node &to) const
+{
+	/* Scale the distance by mod_dist around max_distance */
+	int32 distance = this->max_distance - (this->max_distance -
+			(int32)DistanceMaxPlusManhattan(from.XY(), to.XY())) *
+			this->mod_dist / 100;
+
+	/* Scale the accuracy by distance around accuracy / 2 */
+	int32 divisor = this->accuracy * (this->mod_dist - 50) / 100 +
+			this->accuracy * distance / this->max_distance + 1;
+
+	assert(divisor > 0);
+	return divisor;
+}
+
+/**
+ * Calculate the demands of a large component in a fixed number of partitions of
+ * its supply nodes, in parallel. Each partition runs the round-robin calculation
+ * for its own supply nodes against all demand nodes, on the state at the start,
+ * and records the demands it would set. These are then applied in the order of
+ * the partitions, skipping or reducing the ones the state doesn't allow anymore.
+ * The result doesn't depend on the number of threads. Supply which couldn't be
+ * distributed this way is left for the serial calculation.
+ * @param job Job to calculate the demands for.
+ * @param supplies Supply nodes of the component.
+ * @param demands Demand nodes of the component, at least two.
+ * @param scaler Scaler to be used for scaling demands.
+ * @tparam Tscaler Scaler to be used for scaling demands.
+ */
+template<class Tscaler>
+void DemandCalculator::CalcPartitionedDemand(LinkGraphJob &job, const std::vector<NodeID> &supplies, const std::vector<NodeID> &demands, Tscaler &scaler)
+{
+	struct DemandProposal {
+		NodeID from_id;
+		NodeID to_id;
+		uint demand;
+	};
+
+	const uint num_partitions = min<uint>(DEMAND_MAX_PARTITIONS, (uint)supplies.size() / DEMAND_PARTITION_MIN_SUPPLIES);
+	std::vector<std::vector<DemandProposal>> proposals(num_partitions);
+	RunParallelTasks(num_partitions, [&](uint partition) {
+		/* Supply nodes of this partition with their undelivered supply. The job isn't modified here. */
+		std::queue<std::pair<NodeID, uint>> part_supplies;
+		for (size_t i = partition; i < supplies.size(); i += num_partitions) {
+			part_supplies.emplace(supplies[i], job[supplies[i]].UndeliveredSupply());
+		}
+
+		/* Start each partition at a different demand node, to spread the demands they set. */
+		std::queue<NodeID> part_demands;
+		const size_t offset = demands.size() * partition / num_partitions;
+		for (size_t i = 0; i < demands.size(); ++i) part_demands.push(demands[(offset + i) % demands.size()]);
+
+		std::vector<DemandProposal> &result = proposals[partition];
+		const uint num_demands = (uint)demands.size();
+		uint num_supplies = (uint)part_supplies.size();
+		uint chance = 0;
+		while (!part_supplies.empty()) {
+			std::pair<NodeID, uint> from = part_supplies.front();
+			part_supplies.pop();
+
+			for (uint i = 0; i < num_demands && from.second > 0; ++i) {
+				NodeID to_id = part_demands.front();
+				part_demands.pop();
+				part_demands.push(to_id);
+				if (from.first == to_id) continue;
+
+				int32 supply = scaler.EffectiveSupply(job[from.first], job[to_id]);
+				assert(supply > 0);
+				int32 divisor = this->GetDivisor(job[from.first], job[to_id]);
+
+				uint demand_forw = 0;
+				if (divisor <= supply) {
+					demand_forw = supply / divisor;
+				} else if (++chance > this->accuracy * num_demands * num_supplies) {
+					demand_forw = 1;
+				}
+
+				demand_forw = min(demand_forw, from.second);
+				if (demand_forw == 0) continue;
+				from.second -= demand_forw;
+				result.push_back({ from.first, to_id, demand_forw });
+			}
+
+			if (from.second != 0) {
+				part_supplies.push(from);
+			} else {
+				num_supplies--;
+			}
+		}
+	});
+
+	for (const std::vector<DemandProposal> &result : proposals) {
+		for (const DemandProposal &proposal : result) {
+			uint undelivered = job[proposal.from_id].UndeliveredSupply();
+			if (undelivered == 0 || !scaler.HasDemandLeft(job[proposal.to_id])) continue;
+			scaler.SetDemands(job, proposal.from_id, proposal.to_id, min(proposal.demand, undelivered));
+		}
+	}
+}
+
 /**
  * Do the actual demand calculation, called from constructor.
  * @param job Job to calculate the demands for.
@@ -256,30 +373,43 @@ inline void Scaler::SetDemands(LinkGraphJob &job, NodeID from_id, NodeID to_id,
 template<class Tscaler>
 void DemandCalculator::CalcDemand(LinkGraphJob &job, const std::vector<bool> &reachable_nodes, Tscaler scaler)
 {
-	NodeList supplies;
-	NodeList demands;
-	uint num_supplies = 0;
-	uint num_demands = 0;
+	std::vector<NodeID> supply_nodes;
+	std::vector<NodeID> demand_nodes;
 
 	for (NodeID node = 0; node < job.Size(); node++) {
 		if (!reachable_nodes[node]) continue;
 		scaler.AddNode(job[node]);
-		if (job[node].Supply() > 0) {
-			supplies.push(node);
-			num_supplies++;
-		}
-		if (job[node].Demand() > 0) {
-			demands.push(node);
-			num_demands++;
-		}
+		if (job[node].Supply() > 0) supply_nodes.push_back(node);
+		if (job[node].Demand() > 0) demand_nodes.push_back(node);
 	}
 
-	if (num_supplies == 0 || num_demands == 0) return;
+	if (supply_nodes.empty() || demand_nodes.empty()) return;
 
 	/* Mean acceptance attributed to each node. If the distribution is
 	 * symmetric this is relative to remote supply, otherwise it is
 	 * relative to remote demand. */
-	scaler.SetDemandPerNode(num_demands);
+	scaler.SetDemandPerNode((uint)demand_nodes.size());
+
+	if (this->parallel && supply_nodes.size() >= 2 * DEMAND_PARTITION_MIN_SUPPLIES && demand_nodes.size() >= 2) {
+		this->CalcPartitionedDemand(job, supply_nodes, demand_nodes, scaler);
+	}
+
+	/* Distribute the supply serially. Before the partitioned calculation all
+	 * supply nodes have undelivered supply and all demand nodes have demand left. */
+	NodeList supplies;
+	NodeList demands;
+	uint num_supplies = 0;
+	uint num_demands = 0;
+	for (NodeID node : supply_nodes) {
+		if (job[node].UndeliveredSupply() == 0) continue;
+		supplies.push(node);
+		num_supplies++;
+	}
+	for (NodeID node : demand_nodes) {
+		if (!scaler.HasDemandLeft(job[node])) continue;
+		demands.push(node);
+		num_demands++;
+	}
 
 	uint chance = 0;
 
@@ -302,16 +432,7 @@ void DemandCalculator::CalcDemand(LinkGraphJob &job, const std::vector<bool> &re
 			int32 supply = scaler.EffectiveSupply(job[from_id], job[to_id]);
 			assert(supply > 0);
 
-			/* Scale the distance by mod_dist around max_distance */
-			int32 distance = this->max_distance - (this->max_distance -
-					(int32)DistanceMaxPlusManhattan(job[from_id].XY(), job[to_id].XY())) *
-					this->mod_dist / 100;
-
-			/* Scale the accuracy by distance around accuracy / 2 */
-			int32 divisor = this->accuracy * (this->mod_dist - 50) / 100 +
-					this->accuracy * distance / this->max_distance + 1;
-
-			assert(divisor > 0);
+			int32 divisor = this->GetDivisor(job[from_id], job[to_id]);
 
 			uint demand_forw = 0;
 			if (divisor <= supply) {
@@ -374,28 +495,59 @@ void DemandCalculator::CalcMinimisedDistanceDemand(LinkGraphJob &job, const std:
 	scaler.SetDemandPerNode(demands.size());
 	scaler.AdjustDemandNodes(job, demands);
 
+	/* The pairs of nodes are handled in order of distance, supply node and demand node.
+	 * Instead of sorting all pairs at once, the demand nodes are sorted by distance for each
+	 * supply node separately, in parallel, and these lists are merged while handling them.
+	 * This gives the same order, and allows skipping the remaining pairs of a supply node
+	 * as soon as its supply has been used up. */
+	const size_t row_size = demands.size();
+	std::vector<NodeID> sorted_demands(supplies.size() * row_size);
+	std::vector<uint> row_lengths(supplies.size());
+	RunParallelTasks((uint)CeilDiv(supplies.size(), DEMAND_SORT_CHUNK_SIZE), [&](uint chunk) {
+		std::vector<std::pair<uint, NodeID>> row;
+		const size_t end = min<size_t>(supplies.size(), (chunk + 1) * DEMAND_SORT_CHUNK_SIZE);
+		for (size_t i = chunk * DEMAND_SORT_CHUNK_SIZE; i < end; i++) {
+			const NodeID from_id = supplies[i];
+			row.clear();
+			for (NodeID to_id : demands) {
+				if (from_id != to_id) row.emplace_back(DistanceMaxPlusManhattan(job[from_id].XY(), job[to_id].XY()), to_id);
+			}
+			std::sort(row.begin(), row.end());
+			for (size_t j = 0; j < row.size(); j++) sorted_demands[i * row_size + j] = row[j].second;
+			row_lengths[i] = (uint)row.size();
+		}
+	});
+
 	struct EdgeCandidate {
+		uint distance;
 		NodeID from_id;
 		NodeID to_id;
-		uint distance;
-	};
-	std::vector<EdgeCandidate> candidates;
-	candidates.reserve(supplies.size() * demands.size() - min(supplies.size(), demands.size()));
-	for (NodeID from_id : supplies) {
-		for (NodeID to_id : demands) {
-			if (from_id != to_id) {
-				candidates.push_back({ from_id, to_id, DistanceMaxPlusManhattan(job[from_id].XY(), job[to_id].XY()) });
-			}
+		uint supply_index; ///< Index of the supply node in supplies.
+		uint position;     ///< Position of the demand node in the sorted demands of the supply node.
+
+		bool operator>(const EdgeCandidate &other) const
+		{
+			return std::tie(this->distance, this->from_id, this->to_id) > std::tie(other.distance, other.from_id, other.to_id);
 		}
-	}
-	std::sort(candidates.begin(), candidates.end(), [](const EdgeCandidate &a, const EdgeCandidate &b) {
-		return std::tie(a.distance, a.from_id, a.to_id) < std::tie(b.distance, b.from_id, b.to_id);
-	});
-	for (const EdgeCandidate &candidate : candidates) {
+	};
+	std::priority_queue<EdgeCandidate, std::vector<EdgeCandidate>, std::greater<EdgeCandidate>> candidates;
+	auto push_candidate = [&](uint supply_index, uint position) {
+		if (position >= row_lengths[supply_index]) return;
+		const NodeID from_id = supplies[supply_index];
+		const NodeID to_id = sorted_demands[supply_index * row_size + position];
+		candidates.push({ DistanceMaxPlusManhattan(job[from_id].XY(), job[to_id].XY()), from_id, to_id, supply_index, position });
+	};
+	for (uint i = 0; i < supplies.size(); i++) push_candidate(i, 0);
+
+	while (!candidates.empty()) {
+		const EdgeCandidate candidate = candidates.top();
+		candidates.pop();
 		if (job[candidate.from_id].UndeliveredSupply() == 0) continue;
-		if (!scaler.HasDemandLeft(job[candidate.to_id])) continue;
 
-		scaler.SetDemands(job, candidate.from_id, candidate.to_id, min(job[candidate.from_id].UndeliveredSupply(), scaler.EffectiveSupply(job[candidate.from_id], job[candidate.to_id])));
+		if (scaler.HasDemandLeft(job[candidate.to_id])) {
+			scaler.SetDemands(job, candidate.from_id, candidate.to_id, min(job[candidate.from_id].UndeliveredSupply(), scaler.EffectiveSupply(job[candidate.from_id], job[candidate.to_id])));
+		}
+		push_candidate(candidate.supply_index, candidate.position + 1);
 	}
 }
 
@@ -410,6 +562,7 @@ DemandCalculator::DemandCalculator(LinkGraphJob &job) :
 	CargoID cargo = job.Cargo();
 
 	this->accuracy = settings.accuracy;
+	this->parallel = settings.parallel_demands;
 	this->mod_dist = settings.demand_distance;
 	if (this->mod_dist > 100) {
 		/* Increase effect of mod_dist > 100 */
@@ -419,18 +572,13 @@ DemandCalculator::DemandCalculator(LinkGraphJob &job) :
 
 	const uint size = job.Size();
 
-	/* Symmetric edge matrix
-	 * Storage order: e01  e02 e12  e03 e13 e23  e04 e14 e24 e34  ... */
-	auto se_index = [](uint i, uint j) -> uint {
-		if (j < i) std::swap(i, j);
-		return i + (j * (j - 1) / 2);
-	};
-	std::vector<bool> symmetric_edges(se_index(0, size));
-
+	/* Neighbours of each node, ignoring the direction of the edges. */
+	std::vector<std::vector<NodeID>> neighbours(size);
 	for (NodeID node_id = 0; node_id < size; ++node_id) {
 		Node from = job[node_id];
 		for (EdgeIterator it(from.Begin()); it != from.End(); ++it) {
-			symmetric_edges[se_index(node_id, it->first)] = true;
+			neighbours[node_id].push_back(it->first);
+			neighbours[it->first].push_back(node_id);
 		}
 	}
 	uint first_unseen = 0;
@@ -443,14 +591,11 @@ DemandCalculator::DemandCalculator(LinkGraphJob &job) :
 		while (!queue.empty()) {
 			NodeID from = queue.back();
 			queue.pop_back();
-			for (NodeID to = 0; to < size; ++to) {
-				if (from == to) continue;
-				if (symmetric_edges[se_index(from, to)]) {
-					std::vector<bool>::reference bit = reachable_nodes[to];
-					if (!bit) {
-						bit = true;
-						queue.push_back(to);
-					}
+			for (NodeID to : neighbours[from]) {
+				std::vector<bool>::reference bit = reachable_nodes[to];
+				if (!bit) {
+					bit = true;
+					queue.push_back(to);
 				}
 			}
 		}
@@ -18,9 +18,16 @@ private:
 	int32 mod_dist;     ///< Distance modifier, determines how much demands decrease with distance.
 	int32 accuracy;     ///< Accuracy of the calculation.
 
+	bool parallel;      ///< Calculate the demands of large components in parallel partitions.
+
+	int32 GetDivisor(const Node &from, const Node &to) const;
+
 	template<class Tscaler>
 	void CalcDemand(LinkGraphJob &job, const std::vector<bool> &reachable_nodes, Tscaler scaler);
 
+	template<class Tscaler>
+	void CalcPartitionedDemand(LinkGraphJob &job, const std::vector<NodeID> &supplies, const std::vector<NodeID> &demands, Tscaler &scaler);
+
 	template<class Tscaler>
 	void CalcMinimisedDistanceDemand(LinkGraphJob &job, const std::vector<bool> &reachable_nodes, Tscaler scaler);
 };
@@ -35,7 +42,11 @@ public:
 	 * Call the demand calculator on the given component.
 	 * @param job Component to calculate the demands for.
 	 */
-	virtual void Run(LinkGraphJob &job) const { DemandCalculator c(job); }
+	virtual void Run(LinkGraphJob &job) const
+	{
+		/* Demands are only used for calculating flows, so skip them if all flows are reused. */
+		if (job.HasRecalculatedNodes()) DemandCalculator c(job);
+	}
 
 	/**
 	 * Virtual destructor has to be defined because of virtual Run().
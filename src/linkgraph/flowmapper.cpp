@@ -57,6 +57,8 @@ void FlowMapper::Run(LinkGraphJob &job) const
 			for (FlowStatMap::iterator i = flows.begin(); i != flows.end(); ++i) {
 				i->ScaleToMonthly(runtime);
 			}
+			/* Sort the final flows here, so that joining the job only has to merge them with the kept ones. */
+			flows.SortStorage();
 		}
 		/* Clear paths. */
 		node.Paths().clear();
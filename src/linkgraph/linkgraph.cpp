@@ -17,6 +17,9 @@
 LinkGraphPool _link_graph_pool("LinkGraph");
 INSTANTIATE_POOL_METHODS(LinkGraph)
 
+/** Changed whenever links or nodes are added to or removed from any link graph. */
+uint32 _link_graph_topology_version = 0;
+
 /**
  * Create a node or clear it.
  * @param xy Location of the associated station.
@@ -30,6 +33,7 @@ inline void LinkGraph::BaseNode::Init(TileIndex xy, StationID st, uint demand)
 	this->demand = demand;
 	this->station = st;
 	this->last_update = INVALID_DATE;
+	this->solved = { 0, 0, 0 };
 }
 
 /**
@@ -87,6 +91,7 @@ void LinkGraph::Merge(LinkGraph *other)
 	Date age = _date - this->last_compression + 1;
 	Date other_age = _date - other->last_compression + 1;
 	NodeID first = this->Size();
+	const EdgeMatrix &other_edges = other->edges;
 	for (NodeID node1 = 0; node1 < other->Size(); ++node1) {
 		Station *st = Station::Get(other->nodes[node1].station);
 		NodeID new_node = this->AddNode(st);
@@ -95,9 +100,9 @@ void LinkGraph::Merge(LinkGraph *other)
 		st->goods[this->cargo].node = new_node;
 		for (NodeID node2 = 0; node2 < node1; ++node2) {
 			BaseEdge &forward = this->edges[new_node][first + node2];
-			BaseEdge &backward = this->edges[first + node2][new_node];
-			forward = other->edges[node1][node2];
-			backward = other->edges[node2][node1];
+			BaseEdge &backward = this->edges.GetForUpdate(first + node2, new_node);
+			forward = other_edges[node1][node2];
+			backward = other_edges[node2][node1];
 			forward.capacity = LinkGraph::Scale(forward.capacity, age, other_age);
 			forward.usage = LinkGraph::Scale(forward.usage, age, other_age);
 			if (forward.next_edge != INVALID_NODE) forward.next_edge += first;
@@ -106,7 +111,7 @@ void LinkGraph::Merge(LinkGraph *other)
 			if (backward.next_edge != INVALID_NODE) backward.next_edge += first;
 		}
 		BaseEdge &new_start = this->edges[new_node][new_node];
-		new_start = other->edges[node1][node1];
+		new_start = other_edges[node1][node1];
 		if (new_start.next_edge != INVALID_NODE) new_start.next_edge += first;
 	}
 	delete other;
@@ -142,6 +147,7 @@ void LinkGraph::RemoveNode(NodeID id)
 	this->nodes[id] = this->nodes.back();
 	this->nodes.pop_back();
 	this->edges.EraseColumn(id);
+	_link_graph_topology_version++;
 	/* Not doing EraseRow here, as having the extra invalid row doesn't hurt
 	 * and removing it would trigger a lot of memmove. The data has already
 	 * been copied around in the loop above. */
@@ -176,8 +182,9 @@ NodeID LinkGraph::AddNode(const Station *st)
 
 	for (NodeID i = 0; i <= new_node; ++i) {
 		new_edges[i].Init();
-		this->edges[i][new_node].Init();
+		this->edges.GetForUpdate(i, new_node).Init();
 	}
+	_link_graph_topology_version++;
 	return new_node;
 }
 
@@ -200,6 +207,7 @@ void LinkGraph::Node::AddEdge(NodeID to, uint capacity, uint usage, EdgeUpdateMo
 	first.next_edge = to;
 	if (mode & EUM_UNRESTRICTED)  edge.last_unrestricted_update = _date;
 	if (mode & EUM_RESTRICTED) edge.last_restricted_update = _date;
+	_link_graph_topology_version++;
 }
 
 /**
@@ -240,6 +248,7 @@ void LinkGraph::Node::RemoveEdge(NodeID to)
 			/* Will be removed, skip it. */
 			this->edges[prev].next_edge = edge.next_edge;
 			edge.next_edge = INVALID_NODE;
+			_link_graph_topology_version++;
 			break;
 		} else {
 			prev = next;
@@ -273,6 +282,73 @@ void LinkGraph::Edge::Update(uint capacity, uint usage, EdgeUpdateMode mode)
 	if (mode & EUM_RESTRICTED) this->edge.last_restricted_update = _date;
 }
 
+/**
+ * Share the columns of another edge matrix. Both matrices will copy a column
+ * before modifying it as long as it is shared.
+ * @param other Matrix to be copied.
+ * @return This matrix.
+ */
+LinkGraph::EdgeMatrix &LinkGraph::EdgeMatrix::operator=(const EdgeMatrix &other)
+{
+	if (this == &other) return *this;
+	this->columns = other.columns;
+	this->height = other.height;
+	this->snapshot = true;
+	for (auto &column : this->columns) column->shared_height = max(column->shared_height, this->height);
+	return *this;
+}
+
+/**
+ * Replace a column by an unshared copy with the given capacity.
+ * @param x Column to be replaced.
+ * @param capacity New capacity of the column, at least the height of the matrix.
+ */
+void LinkGraph::EdgeMatrix::Reallocate(uint x, uint capacity)
+{
+	assert(capacity >= this->height);
+	const Column &old_column = *this->columns[x];
+	std::shared_ptr<Column> column = std::make_shared<Column>();
+	column->edges.reserve(capacity);
+	column->edges.assign(old_column.edges.begin(), old_column.edges.begin() + min<size_t>(old_column.edges.size(), capacity));
+	column->edges.resize(capacity);
+	this->columns[x] = std::move(column);
+}
+
+/**
+ * Change the size of the matrix. New edges are left uninitialised. Columns
+ * are grown with some headroom, so that adding nodes one by one doesn't copy
+ * every column each time.
+ * @param new_width New number of columns.
+ * @param new_height New number of edges per column.
+ */
+void LinkGraph::EdgeMatrix::Resize(uint new_width, uint new_height)
+{
+	if (new_width < this->Width()) this->columns.resize(new_width);
+	if (new_height > this->height) {
+		for (uint x = 0; x < this->Width(); ++x) {
+			uint capacity = (uint)this->columns[x]->edges.size();
+			if (capacity < new_height) this->Reallocate(x, max(new_height, capacity + capacity / 4 + 1));
+		}
+	}
+	this->height = new_height;
+	while (this->Width() < new_width) {
+		std::shared_ptr<Column> column = std::make_shared<Column>();
+		column->edges.resize(new_height);
+		this->columns.push_back(std::move(column));
+	}
+}
+
+/**
+ * Remove a column by overwriting it with the last one.
+ * @param x Column to be removed.
+ */
+void LinkGraph::EdgeMatrix::EraseColumn(uint x)
+{
+	assert(x < this->Width());
+	this->columns[x] = std::move(this->columns.back());
+	this->columns.pop_back();
+}
+
 /**
  * Resize the component and fill it with empty nodes and edges. Used when
  * loading from save games. The component is expected to be empty before.
@@ -281,6 +357,7 @@ void LinkGraph::Edge::Update(uint capacity, uint usage, EdgeUpdateMode mode)
 void LinkGraph::Init(uint size)
 {
 	assert(this->Size() == 0);
+	_link_graph_topology_version++;
 	this->edges.Resize(size, size);
 	this->nodes.resize(size);
 
@@ -18,6 +18,8 @@
 #include "../cargotype.h"
 #include "../date_func.h"
 #include "linkgraph_type.h"
+#include <memory>
+#include <vector>
 
 struct SaveLoad;
 class LinkGraph;
@@ -39,6 +41,16 @@ extern LinkGraphPool _link_graph_pool;
 class LinkGraph : public LinkGraphPool::PoolItem<&_link_graph_pool> {
 public:
 
+	/**
+	 * Summary of the part of the link graph reachable from a node, used to
+	 * detect whether flows from the node need to be recalculated.
+	 */
+	struct SolveSignature {
+		uint32 hash;     ///< Hash of the reachable stations and links, 0 if flows have never been calculated.
+		uint64 capacity; ///< Monthly capacity of the reachable links.
+		uint64 supply;   ///< Monthly supply of the reachable stations.
+	};
+
 	/**
 	 * Node of the link graph. contains all relevant information from the associated
 	 * station. It's copied so that the link graph job can work on its own data set
@@ -50,6 +62,7 @@ public:
 		StationID station;       ///< Station ID.
 		TileIndex xy;            ///< Location of the station referred to by the node.
 		Date last_update;        ///< When the supply was last updated.
+		SolveSignature solved;   ///< Reachable part of the graph when flows from the node were last calculated.
 		void Init(TileIndex xy = INVALID_TILE, StationID st = INVALID_STATION, uint demand = 0);
 	};
 
@@ -163,6 +176,12 @@ public:
 		 */
 		Date LastUpdate() const { return this->node.last_update; }
 
+		/**
+		 * Get the reachable part of the graph when flows from the node were last calculated.
+		 * @return Solve signature.
+		 */
+		const SolveSignature &Solved() const { return this->node.solved; }
+
 		/**
 		 * Get the location of the station associated with the node.
 		 * @return Location of the station.
@@ -434,8 +453,102 @@ public:
 		void RemoveEdge(NodeID to);
 	};
 
-	typedef std::vector<BaseNode> NodeVector;
-	typedef SmallMatrix<BaseEdge> EdgeMatrix;
+	typedef std::vector<BaseNode, TrackedAllocator<BaseNode, MUC_LINKGRAPH>> NodeVector;
+
+	/**
+	 * Flow of one origin over one link, as calculated by the last job of the link graph.
+	 * It refers to stations rather than nodes, as nodes can be added, removed or merged
+	 * before the next job runs.
+	 */
+	struct PriorFlow {
+		StationID station; ///< Station the flow leaves from.
+		StationID origin;  ///< Station the flow originates at.
+		StationID via;     ///< Next station of the flow.
+		uint32 flow;       ///< Monthly amount of the flow.
+	};
+
+	typedef std::vector<PriorFlow, TrackedAllocator<PriorFlow, MUC_LINKGRAPH>> PriorFlowVector;
+
+	/**
+	 * Matrix of edges, stored as one column of outgoing edges per node. Copies of the
+	 * matrix share their columns, and a column is only copied when it is modified while
+	 * it is still shared. Copying a link graph for a job is therefore cheap, and the cost
+	 * of copying is spread over the modifications of the original afterwards.
+	 * Copies must only be made on the main thread, but shared columns can be read
+	 * from any thread.
+	 */
+	class EdgeMatrix {
+		/** Column of the matrix, possibly shared by several matrices. */
+		struct Column {
+			std::vector<BaseEdge, TrackedAllocator<BaseEdge, MUC_LINKGRAPH>> edges; ///< Edges of the column; its size is the capacity of the column.
+			uint shared_height = 0; ///< Number of edges which may be read by other matrices sharing this column.
+		};
+
+		std::vector<std::shared_ptr<Column>> columns; ///< Columns of the matrix.
+		uint height = 0;                              ///< Number of edges per column.
+		bool snapshot = false;                        ///< Whether the matrix is a copy; copies never extend shared columns in place.
+
+		void Reallocate(uint x, uint capacity);
+
+		/**
+		 * Make sure a column is not shared with any other matrix.
+		 * @param x Column to be modified.
+		 * @return The column.
+		 */
+		inline Column &Unshare(uint x)
+		{
+			if (this->columns[x].use_count() > 1) this->Reallocate(x, (uint)this->columns[x]->edges.size());
+			return *this->columns[x];
+		}
+
+	public:
+		EdgeMatrix() {}
+		EdgeMatrix(const EdgeMatrix &other) { *this = other; }
+		EdgeMatrix &operator=(const EdgeMatrix &other);
+
+		/**
+		 * Get the number of columns, i.e. the number of nodes.
+		 * @return Width of the matrix.
+		 */
+		inline uint Width() const { return (uint)this->columns.size(); }
+
+		/**
+		 * Get the number of edges per column.
+		 * @return Height of the matrix.
+		 */
+		inline uint Height() const { return this->height; }
+
+		/**
+		 * Get a column for reading.
+		 * @param x Column to get.
+		 * @return Edges of the column.
+		 */
+		inline const BaseEdge *operator[](uint x) const { return this->columns[x]->edges.data(); }
+
+		/**
+		 * Get a column for modification. The column is copied first if it is shared.
+		 * @param x Column to get.
+		 * @return Edges of the column.
+		 */
+		inline BaseEdge *operator[](uint x) { return this->Unshare(x).edges.data(); }
+
+		/**
+		 * Get a single edge for modification. The column is only copied if it is shared
+		 * and the edge may be read by one of the other matrices sharing it, so edges of
+		 * nodes added after copying the matrix can be initialised without copying.
+		 * @param x Column of the edge.
+		 * @param y Row of the edge.
+		 * @return The edge.
+		 */
+		inline BaseEdge &GetForUpdate(uint x, uint y)
+		{
+			if (this->snapshot || y < this->columns[x]->shared_height) return this->Unshare(x).edges[y];
+			return this->columns[x]->edges[y];
+		}
+
+		void Resize(uint new_width, uint new_height);
+		void EraseColumn(uint x);
+	};
 
 	/** Minimum effective distance for timeout calculation. */
 	static const uint MIN_TIMEOUT_DISTANCE = 32;
@@ -519,6 +632,27 @@ public:
 		return base * 30 / (_date - this->last_compression + 1);
 	}
 
+	/**
+	 * Record the reachable part of the graph after calculating the flows from a node.
+	 * This doesn't touch the edges, so it doesn't copy any edges shared with a job.
+	 * @param node Node whose flows have been calculated.
+	 * @param solved Reachable part of the graph at the time of the calculation.
+	 */
+	inline void SetSolved(NodeID node, const SolveSignature &solved) { this->nodes[node].solved = solved; }
+
+	/**
+	 * Get the flows calculated by the last job of this link graph.
+	 * @return Prior flows, or nullptr if there are none.
+	 */
+	inline const PriorFlowVector *PriorFlows() const { return this->prior_flows.get(); }
+
+	/**
+	 * Set the flows calculated by the last job of this link graph. They are shared with
+	 * the copies made for later jobs, and never modified.
+	 * @param flows New prior flows, may be nullptr.
+	 */
+	inline void SetPriorFlows(std::shared_ptr<const PriorFlowVector> flows) { this->prior_flows = std::move(flows); }
+
 	NodeID AddNode(const Station *st);
 	void RemoveNode(NodeID id);
 
@@ -539,6 +673,9 @@ protected:
 	Date last_compression; ///< Last time the capacities and supplies were compressed.
 	NodeVector nodes;      ///< Nodes in the component.
 	EdgeMatrix edges;      ///< Edges in the component.
+	std::shared_ptr<const PriorFlowVector> prior_flows; ///< Flows calculated by the last job, shared with later jobs.
 };
 
+extern uint32 _link_graph_topology_version;
+
 #endif /* LINKGRAPH_H */
@@ -16,6 +16,9 @@
 #include "../viewport_func.h"
 #include "../smallmap_gui.h"
 #include "../zoom_func.h"
+#include "../station_kdtree.h"
+#include "../landscape.h"
+#include "../settings_type.h"
 #include "../core/geometry_func.hpp"
 #include "../widgets/link_graph_legend_widget.h"
 
@@ -64,15 +67,160 @@ bool LinkGraphOverlay::CacheStillValid() const
 	}
 }
 
+/**
+ * Check whether the links between two stations are combined into one when drawing.
+ * This is done when the viewport is zoomed out so far that the two directions
+ * can't be told apart anyway.
+ * @return True if links are aggregated.
+ */
+bool LinkGraphOverlay::ShouldAggregateLinks() const
+{
+	return this->window->viewport != nullptr && this->window->viewport->zoom > ZOOM_LVL_DETAIL;
+}
+
+/**
+ * Check whether a link between two stations is to be shown at all.
+ * Shows links between stations of selected companies or "neutral" ones like oilrigs.
+ * @param from Source station.
+ * @param to Destination station.
+ * @return True if the link may be shown.
+ */
+bool LinkGraphOverlay::IsLinkShown(const Station *from, const Station *to) const
+{
+	if (to->owner != OWNER_NONE && from->owner != OWNER_NONE && !HasBit(this->company_mask, to->owner)) return false;
+	return !from->rect.IsEmpty() && !to->rect.IsEmpty();
+}
+
+/**
+ * Add the statistics of the link from one station to another, for all shown cargoes.
+ * @param from Source station.
+ * @param to Destination station.
+ * @param prop Link properties to add the statistics to.
+ * @return True if there is a link with capacity for any of the shown cargoes.
+ */
+bool LinkGraphOverlay::GetLinkProperties(const Station *from, const Station *to, LinkProperties &prop) const
+{
+	bool found = false;
+	CargoID c;
+	FOR_EACH_SET_CARGO_ID(c, this->cargo_mask) {
+		if (!CargoSpec::Get(c)->IsValid()) continue;
+		const GoodsEntry &ge = from->goods[c];
+		if (!LinkGraph::IsValidID(ge.link_graph) ||
+				ge.link_graph != to->goods[c].link_graph) {
+			continue;
+		}
+		const LinkGraph &lg = *LinkGraph::Get(ge.link_graph);
+		ConstEdge edge = lg[ge.node][to->goods[c].node];
+		if (edge.Capacity() > 0) {
+			this->AddStats(lg.Monthly(edge.Capacity()), lg.Monthly(edge.Usage()),
+					ge.flows.GetFlowVia(to->index), from->owner == OWNER_NONE || to->owner == OWNER_NONE,
+					prop);
+			found = true;
+		}
+	}
+	return found;
+}
+
+/**
+ * Get the supply of the shown cargoes at a station.
+ * @param st Station to get the supply for.
+ * @return Monthly supply.
+ */
+uint LinkGraphOverlay::GetStationSupply(const Station *st) const
+{
+	uint supply = 0;
+	CargoID c;
+	FOR_EACH_SET_CARGO_ID(c, this->cargo_mask) {
+		if (!CargoSpec::Get(c)->IsValid()) continue;
+		if (!LinkGraph::IsValidID(st->goods[c].link_graph)) continue;
+		const LinkGraph &lg = *LinkGraph::Get(st->goods[c].link_graph);
+		supply += lg.Monthly(lg[st->goods[c].node].Supply());
+	}
+	return supply;
+}
+
+/**
+ * Get the largest distance between the ends of any link of the shown cargoes.
+ * It is only recalculated when links have been added or removed, or the shown cargoes change.
+ * @return Largest distance in tiles.
+ */
+uint LinkGraphOverlay::GetLinkExtent()
+{
+	if (this->link_extent != UINT_MAX && this->link_extent_version == _link_graph_topology_version &&
+			this->link_extent_cargo_mask == this->cargo_mask) {
+		return this->link_extent;
+	}
+
+	this->link_extent = 0;
+	this->link_extent_version = _link_graph_topology_version;
+	this->link_extent_cargo_mask = this->cargo_mask;
+	for (const LinkGraph *lg : LinkGraph::Iterate()) {
+		if (!HasBit(this->cargo_mask, lg->Cargo())) continue;
+		for (NodeID node_id = 0; node_id < lg->Size(); ++node_id) {
+			ConstNode node = (*lg)[node_id];
+			for (ConstEdgeIterator i = node.Begin(); i != node.End(); ++i) {
+				this->link_extent = max(this->link_extent, DistanceMax(node.XY(), (*lg)[i->first].XY()));
+			}
+		}
+	}
+	return this->link_extent;
+}
+
+/**
+ * Update the statistics of the cached links and stations, without searching
+ * for links again. This is only possible if no links or stations have been
+ * added or removed since the cache was built.
+ * @return True if the cache has been updated, false if it has to be rebuilt.
+ */
+bool LinkGraphOverlay::RefreshCachedProperties()
+{
+	if (this->cached_links.empty() && this->cached_stations.empty()) return false;
+	if (this->cached_topology_version != _link_graph_topology_version ||
+			this->cached_station_count != Station::GetNumItems() ||
+			this->cached_aggregated != this->ShouldAggregateLinks()) {
+		return false;
+	}
+
+	for (LinkInfo &link : this->cached_links) {
+		const Station *sta = Station::GetIfValid(link.from_id);
+		const Station *stb = Station::GetIfValid(link.to_id);
+		if (sta == nullptr || stb == nullptr) return false;
+
+		LinkProperties prop;
+		bool found = false;
+		if (this->IsLinkShown(sta, stb)) found = this->GetLinkProperties(sta, stb, prop);
+		if (this->cached_aggregated && this->IsLinkShown(stb, sta)) found = this->GetLinkProperties(stb, sta, prop) || found;
+		if (!found) return false;
+		link.prop = prop;
+	}
+	for (StationSupplyInfo &info : this->cached_stations) {
+		const Station *st = Station::GetIfValid(info.id);
+		if (st == nullptr || st->rect.IsEmpty()) return false;
+		info.quantity = this->GetStationSupply(st);
+	}
+	return true;
+}
+
 /**
  * Rebuild the cache and recalculate which links and stations to be shown.
+ * For viewports only the stations which can have a link through the cached
+ * region are considered, using the station kd-tree.
+ * @param incremental Only add links and stations which aren't cached yet, for the grown cached region.
  */
 void LinkGraphOverlay::RebuildCache(bool incremental)
 {
+	if (incremental && (this->cached_topology_version != _link_graph_topology_version ||
+			this->cached_aggregated != this->ShouldAggregateLinks())) {
+		/* Cached links are outdated, so they can't be extended. */
+		incremental = false;
+	}
 	if (!incremental) {
 		this->cached_links.clear();
 		this->cached_stations.clear();
 		this->last_update_number = GetWindowUpdateNumber();
+		this->cached_topology_version = _link_graph_topology_version;
+		this->cached_station_count = Station::GetNumItems();
+		this->cached_aggregated = this->ShouldAggregateLinks();
 	}
 	if (this->company_mask == 0) return;
 
@@ -89,6 +237,7 @@ void LinkGraphOverlay::RebuildCache(bool incremental)
 		this->GetWidgetDpi(&dpi);
 		cache_all = true;
 	}
+	const bool aggregate = this->cached_aggregated;
 
 	struct LinkCacheItem {
 		Point from_pt;
@@ -110,43 +259,16 @@ void LinkGraphOverlay::RebuildCache(bool incremental)
 		}
 	}
 
-	auto AddLinks = [&](const Station *from, const Station *to, Point from_pt, Point to_pt, btree::btree_map<std::pair<StationID, StationID>, LinkCacheItem>::iterator insert_iter) {
-		LinkCacheItem *item = nullptr;
-		CargoID c;
-		FOR_EACH_SET_CARGO_ID(c, this->cargo_mask) {
-			if (!CargoSpec::Get(c)->IsValid()) continue;
-			const GoodsEntry &ge = from->goods[c];
-			if (!LinkGraph::IsValidID(ge.link_graph) ||
-					ge.link_graph != to->goods[c].link_graph) {
-				continue;
-			}
-			const LinkGraph &lg = *LinkGraph::Get(ge.link_graph);
-			ConstEdge edge = lg[ge.node][to->goods[c].node];
-			if (edge.Capacity() > 0) {
-				if (!item) {
-					auto iter = link_cache_map.insert(insert_iter, std::make_pair(std::make_pair(from->index, to->index), LinkCacheItem()));
-					item = &(iter->second);
-					item->from_pt = from_pt;
-					item->to_pt = to_pt;
-				}
-				this->AddStats(lg.Monthly(edge.Capacity()), lg.Monthly(edge.Usage()),
-						ge.flows.GetFlowVia(to->index), from->owner == OWNER_NONE || to->owner == OWNER_NONE,
-						item->prop);
-			}
-		}
-	};
-
 	const size_t previous_cached_stations_count = this->cached_stations.size();
-	for (const Station *sta : Station::Iterate()) {
-		if (sta->rect.IsEmpty()) continue;
+	auto ProcessStation = [&](const Station *sta) {
+		if (sta->rect.IsEmpty()) return;
 
-		if (incremental && std::binary_search(incremental_station_exclude.begin(), incremental_station_exclude.end(), sta->index)) continue;
+		if (incremental && std::binary_search(incremental_station_exclude.begin(), incremental_station_exclude.end(), sta->index)) return;
 
 		Point pta = this->GetStationMiddle(sta);
 
 		StationID from = sta->index;
 
-		uint supply = 0;
 		CargoID c;
 		FOR_EACH_SET_CARGO_ID(c, this->cargo_mask) {
 			if (!CargoSpec::Get(c)->IsValid()) continue;
@@ -154,7 +276,6 @@ void LinkGraphOverlay::RebuildCache(bool incremental)
 			const LinkGraph &lg = *LinkGraph::Get(sta->goods[c].link_graph);
 
 			ConstNode from_node = lg[sta->goods[c].node];
-			supply += lg.Monthly(from_node.Supply());
 			for (ConstEdgeIterator i = from_node.Begin(); i != from_node.End(); ++i) {
 				StationID to = lg[i->first].Station();
 				assert(from != to);
@@ -163,14 +284,16 @@ void LinkGraphOverlay::RebuildCache(bool incremental)
 				const Station *stb = Station::Get(to);
 				assert(sta != stb);
 
-				/* Show links between stations of selected companies or "neutral" ones like oilrigs. */
-				if (stb->owner != OWNER_NONE && sta->owner != OWNER_NONE && !HasBit(this->company_mask, stb->owner)) continue;
-				if (stb->rect.IsEmpty()) continue;
+				if (!this->IsLinkShown(sta, stb)) continue;
 
 				if (incremental && std::binary_search(incremental_station_exclude.begin(), incremental_station_exclude.end(), to)) continue;
-				if (incremental && std::binary_search(incremental_link_exclude.begin(), incremental_link_exclude.end(), std::make_pair(from, to))) continue;
 
-				auto key = std::make_pair(from, to);
+				/* When aggregating, both directions are stored under the lower station ID first. */
+				const Station *first = (aggregate && to < from) ? stb : sta;
+				const Station *second = (first == sta) ? stb : sta;
+				auto key = std::make_pair(first->index, second->index);
+				if (incremental && std::binary_search(incremental_link_exclude.begin(), incremental_link_exclude.end(), key)) continue;
+
 				auto iter = link_cache_map.lower_bound(key);
 				if (iter != link_cache_map.end() && !(link_cache_map.key_comp()(key, iter->first))) {
 					continue;
@@ -180,12 +303,50 @@ void LinkGraphOverlay::RebuildCache(bool incremental)
 
 				if (!cache_all && !this->IsLinkVisible(pta, ptb, &dpi)) continue;
 
-				AddLinks(sta, stb, pta, ptb, iter);
+				LinkCacheItem item;
+				item.from_pt = first == sta ? pta : ptb;
+				item.to_pt = first == sta ? ptb : pta;
+				bool found = false;
+				if (this->IsLinkShown(first, second)) found = this->GetLinkProperties(first, second, item.prop);
+				if (aggregate && this->IsLinkShown(second, first)) found = this->GetLinkProperties(second, first, item.prop) || found;
+				if (found) link_cache_map.insert(iter, std::make_pair(key, item));
 			}
 		}
 		if (cache_all || this->IsPointVisible(pta, &dpi)) {
-			this->cached_stations.push_back({ from, supply, pta });
+			this->cached_stations.push_back({ from, this->GetStationSupply(sta), pta });
+		}
+	};
+
+	if (cache_all) {
+		for (const Station *sta : Station::Iterate()) ProcessStation(sta);
+	} else {
+		/* Tile area covered by the cached region, see RemapCoords. Heights move
+		 * tiles up in the viewport, so extend the area downwards by the highest
+		 * possible height. Any link crossing the region has both of its ends
+		 * within the longest link of this area. Links are drawn between the
+		 * middles of the station rects, which can be up to half the station
+		 * spread away from the station tile the kd-tree and the link length
+		 * are based on, so add the spread of both ends as well. */
+		const Rect &r = this->cached_region;
+		const int diff_min = r.left / (2 * ZOOM_LVL_BASE);
+		const int diff_max = r.right / (2 * ZOOM_LVL_BASE);
+		const int sum_min = r.top / ZOOM_LVL_BASE;
+		const int sum_max = r.bottom / ZOOM_LVL_BASE + (int)(MAX_TILE_HEIGHT * TILE_HEIGHT);
+		const int extent = (int)min<uint>(this->GetLinkExtent() + 2 * _settings_game.station.station_spread, max(MapSizeX(), MapSizeY())) + 1;
+		const int x1 = Clamp((sum_min - diff_max) / (2 * (int)TILE_SIZE) - extent, 0, MapSizeX());
+		const int x2 = Clamp((sum_max - diff_min) / (2 * (int)TILE_SIZE) + extent + 1, 0, MapSizeX());
+		const int y1 = Clamp((sum_min + diff_min) / (2 * (int)TILE_SIZE) - extent, 0, MapSizeY());
+		const int y2 = Clamp((sum_max + diff_max) / (2 * (int)TILE_SIZE) + extent + 1, 0, MapSizeY());
+
+		std::vector<StationID> candidates;
+		if (x1 < x2 && y1 < y2) {
+			_station_kdtree.FindContained((uint16)x1, (uint16)y1, (uint16)x2, (uint16)y2, [&](StationID id) {
+				candidates.push_back(id);
+			});
 		}
+		/* The cached stations must be sorted by ID. */
+		std::sort(candidates.begin(), candidates.end());
+		for (StationID id : candidates) ProcessStation(Station::Get(id));
 	}
 
 	const size_t previous_cached_links_count = this->cached_links.size();
@@ -343,7 +504,8 @@ void LinkGraphOverlay::RefreshDrawCache()
 void LinkGraphOverlay::Draw(const DrawPixelInfo *dpi)
 {
 	if (this->dirty) {
-		this->RebuildCache();
+		/* Usually only the statistics of the links change, so only search for links again when needed. */
+		if (!this->RefreshCachedProperties()) this->RebuildCache();
 		this->dirty = false;
 	}
 	if (this->last_update_number != GetWindowUpdateNumber()) {
@@ -93,10 +93,22 @@ protected:
 	uint scale;                        ///< Width of link lines.
 	bool dirty;                        ///< Set if overlay should be rebuilt.
 	uint64 last_update_number = 0;     ///< Last window update number
+	uint32 cached_topology_version = 0; ///< Link graph topology version the cache has been built for.
+	size_t cached_station_count = 0;   ///< Number of stations when the cache was built.
+	bool cached_aggregated = false;    ///< Whether the cached links combine both directions between two stations.
+	uint32 link_extent_version = 0;    ///< Link graph topology version #link_extent has been calculated for.
+	CargoTypes link_extent_cargo_mask = 0; ///< Cargo mask #link_extent has been calculated for.
+	uint link_extent = UINT_MAX;       ///< Largest distance in tiles between the ends of any link, UINT_MAX if not calculated yet.
 
 	Point GetStationMiddle(const Station *st) const;
 
 	void RefreshDrawCache();
+	bool RefreshCachedProperties();
+	bool ShouldAggregateLinks() const;
+	bool IsLinkShown(const Station *from, const Station *to) const;
+	bool GetLinkProperties(const Station *from, const Station *to, LinkProperties &prop) const;
+	uint GetStationSupply(const Station *st) const;
+	uint GetLinkExtent();
 	void DrawLinks(const DrawPixelInfo *dpi) const;
 	void DrawStationDots(const DrawPixelInfo *dpi) const;
 	void DrawContent(Point pta, Point ptb, const LinkProperties &cargo) const;
@@ -12,6 +12,7 @@
 #include "../window_func.h"
 #include "linkgraphjob.h"
 #include "linkgraphschedule.h"
+#include <algorithm>
 
 #include "../safeguards.h"
 
@@ -38,7 +39,9 @@ static DateTicks GetLinkGraphJobJoinDateTicks(uint duration_multiplier)
 /**
  * Create a link graph job from a link graph. The link graph will be copied so
  * that the calculations don't interfer with the normal operations on the
- * original. The job is immediately started.
+ * original. The copy shares the edges with the original until they are
+ * modified, so creating it only takes time proportional to the number of nodes.
+ * The job is immediately started.
  * @param orig Original LinkGraph to be copied.
  */
 LinkGraphJob::LinkGraphJob(const LinkGraph &orig, uint duration_multiplier) :
@@ -48,11 +51,144 @@ LinkGraphJob::LinkGraphJob(const LinkGraph &orig, uint duration_multiplier) :
 		settings(_settings_game.linkgraph),
 		join_date_ticks(GetLinkGraphJobJoinDateTicks(duration_multiplier)),
 		start_date_ticks((_date * DAY_TICKS) + _date_fract),
+		recalculated_nodes(0),
 		job_completed(false),
 		abort_job(false)
 {
 }
 
+/**
+ * Mix a value into a well distributed hash.
+ * @param x Value to be mixed.
+ * @return Hash of the value.
+ */
+static inline uint32 MixSolveHash(uint32 x)
+{
+	x ^= x >> 16;
+	x *= 0x85EBCA6B;
+	x ^= x >> 13;
+	x *= 0xC2B2AE35;
+	x ^= x >> 16;
+	return x;
+}
+
+/**
+ * Decide which nodes' flows have to be recalculated, by comparing the part of
+ * the graph reachable from each node with the one at its last calculation.
+ * The previous flows of the other nodes are kept, and the capacity they take
+ * is reserved on the edges before the new flows are calculated.
+ */
+void LinkGraphJob::PrepareIncremental()
+{
+	uint size = this->Size();
+	uint threshold = this->settings.incremental_threshold;
+	/* Scale capacities and supplies the same way as the flows are scaled by FlowMapper. */
+	uint runtime = (uint)max<DateTicks>(1, (this->StartDateTicks() / DAY_TICKS) - this->LastCompression() + 1);
+
+	/* The prior flows refer to stations, as nodes can have changed since they were calculated. */
+	std::vector<std::pair<StationID, NodeID>> station_nodes;
+	station_nodes.reserve(size);
+	for (NodeID node = 0; node < size; ++node) station_nodes.emplace_back(this->link_graph[node].Station(), node);
+	std::sort(station_nodes.begin(), station_nodes.end());
+	auto get_node = [&station_nodes](StationID station) -> NodeID {
+		auto it = std::lower_bound(station_nodes.begin(), station_nodes.end(), std::make_pair(station, (NodeID)0));
+		return (it != station_nodes.end() && it->first == station) ? it->second : INVALID_NODE;
+	};
+
+	/* Only reuse flows of nodes which actually had flows after the last job. */
+	const LinkGraph::PriorFlowVector *prior_flows = this->link_graph.PriorFlows();
+	std::vector<bool> has_prior_flows(size);
+	if (prior_flows != nullptr) {
+		for (const LinkGraph::PriorFlow &prior : *prior_flows) {
+			if (prior.station != prior.origin) continue;
+			NodeID node = get_node(prior.station);
+			if (node != INVALID_NODE) has_prior_flows[node] = true;
+		}
+	}
+
+	auto within_threshold = [threshold](uint64 old_value, uint64 new_value) -> bool {
+		uint64 diff = old_value > new_value ? old_value - new_value : new_value - old_value;
+		return diff * 100 <= old_value * threshold;
+	};
+
+	this->signatures.resize(size);
+	this->reused_flows.assign(size, false);
+	this->recalculated_nodes = 0;
+	std::vector<NodeID> visited(size, INVALID_NODE);
+	std::vector<NodeID> queue;
+	for (NodeID origin = 0; origin < size; ++origin) {
+		LinkGraph::SolveSignature &signature = this->signatures[origin];
+		signature = { 0, 0, 0 };
+		queue.clear();
+		queue.push_back(origin);
+		visited[origin] = origin;
+		for (size_t i = 0; i < queue.size(); ++i) {
+			LinkGraph::ConstNode node = this->link_graph[queue[i]];
+			signature.hash += MixSolveHash((node.Station() << 1) | (node.Demand() > 0 ? 1 : 0));
+			signature.supply += node.Supply();
+			for (LinkGraph::ConstEdgeIterator it(node.Begin()); it != node.End(); ++it) {
+				signature.hash += MixSolveHash(MixSolveHash((node.Station() << 16) | this->link_graph[it->first].Station()) + 1);
+				signature.capacity += it->second.Capacity();
+				if (visited[it->first] != origin) {
+					visited[it->first] = origin;
+					queue.push_back(it->first);
+				}
+			}
+		}
+		if (signature.hash == 0) signature.hash = 1;
+		signature.capacity = signature.capacity * 30 / runtime;
+		signature.supply = signature.supply * 30 / runtime;
+
+		const LinkGraph::SolveSignature &solved = this->link_graph[origin].Solved();
+		if (has_prior_flows[origin] && solved.hash == signature.hash &&
+				within_threshold(solved.capacity, signature.capacity) && within_threshold(solved.supply, signature.supply)) {
+			this->reused_flows[origin] = true;
+		} else {
+			this->recalculated_nodes++;
+		}
+	}
+
+	/* Reserve the capacity taken by the reused flows, and carry them over to the results of this job. */
+	this->result_flows = std::make_shared<LinkGraph::PriorFlowVector>();
+	if (prior_flows != nullptr) {
+		for (const LinkGraph::PriorFlow &prior : *prior_flows) {
+			NodeID node = get_node(prior.station);
+			NodeID origin = get_node(prior.origin);
+			NodeID via = get_node(prior.via);
+			if (node == INVALID_NODE || origin == INVALID_NODE || via == INVALID_NODE || !this->reused_flows[origin]) continue;
+			(*this)[node][via].AddFlow(max<uint>(1, (uint)((uint64)prior.flow * runtime / 30)));
+			this->result_flows->push_back(prior);
+		}
+	}
+
+	DEBUG(linkgraph, 3, "LinkGraphJob::PrepareIncremental(): id: %u, nodes: %u, recalculated: %u",
+			this->link_graph.index, size, this->recalculated_nodes);
+}
+
+/**
+ * Record the flows calculated by this job, in addition to the reused ones, so
+ * that the next job of the link graph can reserve the capacity they take.
+ * This runs in the job thread after the flows have been mapped.
+ */
+void LinkGraphJob::RecordResultFlows()
+{
+	if (this->result_flows == nullptr) return;
+
+	for (NodeID node_id = 0; node_id < this->Size(); ++node_id) {
+		StationID station = this->link_graph[node_id].Station();
+		const FlowStatMap &flows = (*this)[node_id].Flows();
+		for (FlowStatMap::const_iterator it(flows.begin()); it != flows.end(); ++it) {
+			uint32 prev = 0;
+			for (FlowStat::const_iterator share(it->begin()); share != it->end(); ++share) {
+				uint32 flow = share->first - prev;
+				prev = share->first;
+				if (share->second == station || flow == 0) continue;
+				this->result_flows->push_back({ station, it->GetOrigin(), share->second, flow });
+			}
+		}
+	}
+}
+
 /**
  * Erase all flows originating at a specific node.
  * @param from Node to erase flows for.
@@ -99,6 +235,17 @@ void LinkGraphJob::FinaliseJob()
 	if (!LinkGraph::IsValidID(this->link_graph.index)) return;
 
 	uint size = this->Size();
+
+	/* The flows of this job are the prior flows of the next one. */
+	LinkGraph::Get(this->link_graph.index)->SetPriorFlows(std::move(this->result_flows));
+
+	/* Origins whose previous flows are kept. */
+	std::vector<StationID> reused_origins;
+	for (NodeID node_id = 0; node_id < size; ++node_id) {
+		if (this->IsFlowReused(node_id)) reused_origins.push_back(this->link_graph[node_id].Station());
+	}
+	std::sort(reused_origins.begin(), reused_origins.end());
+
 	for (NodeID node_id = 0; node_id < size; ++node_id) {
 		Node from = (*this)[node_id];
 
@@ -117,7 +264,10 @@ void LinkGraphJob::FinaliseJob()
 			continue;
 		}
 
-		LinkGraph *lg = LinkGraph::Get(ge.link_graph);
+		const LinkGraph *lg = LinkGraph::Get(ge.link_graph);
+		if (!this->signatures.empty() && !this->IsFlowReused(node_id)) {
+			LinkGraph::Get(ge.link_graph)->SetSolved(node_id, this->signatures[node_id]);
+		}
 		FlowStatMap &flows = from.Flows();
 
 		for (EdgeIterator it(from.Begin()); it != from.End(); ++it) {
@@ -139,38 +289,35 @@ void LinkGraphJob::FinaliseJob()
 			}
 		}
 
-		/* Swap shares and invalidate ones that are completely deleted. Don't
-		 * really delete them as we could then end up with unroutable cargo
-		 * somewhere. Do delete them and also reroute relevant cargo if
-		 * automatic distribution has been turned off for that cargo. */
-		for (FlowStatMap::iterator it(ge.flows.begin()); it != ge.flows.end();) {
-			FlowStatMap::iterator new_it = flows.find(it->GetOrigin());
-			if (new_it == flows.end()) {
+		/* The new flows have been prepared in the job thread and replace the old
+		 * ones. Keep the old flows of origins which haven't been recalculated, and
+		 * invalidate the ones that are completely deleted. Don't really delete them
+		 * as we could then end up with unroutable cargo somewhere. Do delete them
+		 * and also reroute relevant cargo if automatic distribution has been turned
+		 * off for that cargo. */
+		std::vector<FlowStat> kept_flows;
+		std::vector<StationID> reroute_via;
+		for (FlowStatMap::iterator it(ge.flows.begin()); it != ge.flows.end(); ++it) {
+			if (flows.find(it->GetOrigin()) != flows.end()) continue;
+			if (!std::binary_search(reused_origins.begin(), reused_origins.end(), it->GetOrigin())) {
 				bool should_erase = true;
 				if (_settings_game.linkgraph.GetDistributionType(this->Cargo()) != DT_MANUAL) {
 					should_erase = it->Invalidate();
 				}
 				if (should_erase) {
-					FlowStat shares(INVALID_STATION, INVALID_STATION, 1);
-					it->SwapShares(shares);
-					it = ge.flows.erase(it);
-					for (FlowStat::const_iterator shares_it(shares.begin());
-							shares_it != shares.end(); ++shares_it) {
-						RerouteCargo(st, this->Cargo(), shares_it->second, st->index);
+					for (FlowStat::const_iterator shares_it(it->begin()); shares_it != it->end(); ++shares_it) {
+						reroute_via.push_back(shares_it->second);
 					}
-				} else {
-					++it;
+					continue;
 				}
-			} else {
-				it->SwapShares(*new_it);
-				flows.erase(new_it);
-				++it;
 			}
+			kept_flows.push_back(std::move(*it));
 		}
-		for (FlowStatMap::iterator it(flows.begin()); it != flows.end(); ++it) {
-			ge.flows.insert(std::move(*it));
-		}
-		ge.flows.SortStorage();
+		flows.MergeStorage(kept_flows);
+		ge.flows.swap(flows);
+		std::sort(reroute_via.begin(), reroute_via.end());
+		reroute_via.erase(std::unique(reroute_via.begin(), reroute_via.end()), reroute_via.end());
+		for (StationID via : reroute_via) RerouteCargo(st, this->Cargo(), via, st->index);
 		InvalidateWindowData(WC_STATION_VIEW, st->index, this->Cargo());
 	}
 }
@@ -241,6 +388,12 @@ void LinkGraphJob::Init()
 			node_edges[j].Init();
 		}
 	}
+
+	if (this->settings.incremental_threshold > 0) {
+		this->PrepareIncremental();
+	} else {
+		this->recalculated_nodes = size;
+	}
 }
 
 /**
@@ -52,8 +52,8 @@ private:
 		void Init(uint supply);
 	};
 
-	typedef std::vector<NodeAnnotation> NodeAnnotationVector;
-	typedef SmallMatrix<EdgeAnnotation> EdgeAnnotationMatrix;
+	typedef std::vector<NodeAnnotation, TrackedAllocator<NodeAnnotation, MUC_LINKGRAPH>> NodeAnnotationVector;
+	typedef SmallMatrix<EdgeAnnotation, MUC_LINKGRAPH> EdgeAnnotationMatrix;
 
 	friend const SaveLoad *GetLinkGraphJobDesc();
 	friend void GetLinkGraphJobDayLengthScaleAfterLoad(LinkGraphJob *lgj);
@@ -68,10 +68,16 @@ protected:
 	DateTicks start_date_ticks;       ///< Date when the job was started.
 	NodeAnnotationVector nodes;       ///< Extra node data necessary for link graph calculation.
 	EdgeAnnotationMatrix edges;       ///< Extra edge data necessary for link graph calculation.
+	std::shared_ptr<LinkGraph::PriorFlowVector> result_flows; ///< Flows calculated or reused by this job, for the next job's incremental recalculation.
+	std::vector<bool> reused_flows;   ///< For each node, whether its previous flows are reused instead of recalculated.
+	std::vector<LinkGraph::SolveSignature> signatures; ///< For each node, the part of the graph reachable from it.
+	uint recalculated_nodes;          ///< Number of nodes whose flows are recalculated.
 	bool job_completed;               ///< Is the job still running. This is accessed by multiple threads and is permitted to be spuriously incorrect.
 	bool abort_job;                   ///< Abort the job at the next available opportunity. This is accessed by multiple threads.
 
 	void EraseFlows(NodeID from);
+	void PrepareIncremental();
+	void RecordResultFlows();
 	void JoinThread();
 	void SetJobGroup(std::shared_ptr<LinkGraphJobGroup> group);
 
@@ -293,7 +299,7 @@ public:
 	 * settings have to be brutally const-casted in order to populate them.
 	 */
 	LinkGraphJob() : settings(_settings_game.linkgraph),
-			join_date_ticks(INVALID_DATE), start_date_ticks(INVALID_DATE), job_completed(false), abort_job(false) {}
+			join_date_ticks(INVALID_DATE), start_date_ticks(INVALID_DATE), recalculated_nodes(0), job_completed(false), abort_job(false) {}
 
 	LinkGraphJob(const LinkGraph &orig, uint duration_multiplier);
 	~LinkGraphJob();
@@ -329,6 +335,19 @@ public:
 	 */
 	inline void ShiftJoinDate(int interval) { this->join_date_ticks += interval * DAY_TICKS; }
 
+	/**
+	 * Check whether the previous flows from a node are reused instead of being recalculated.
+	 * @param node Origin of the flows.
+	 * @return True if the flows from the node don't have to be calculated.
+	 */
+	inline bool IsFlowReused(NodeID node) const { return !this->reused_flows.empty() && this->reused_flows[node]; }
+
+	/**
+	 * Check whether any flows have to be calculated at all.
+	 * @return True if the flows from at least one node have to be calculated.
+	 */
+	inline bool HasRecalculatedNodes() const { return this->recalculated_nodes > 0; }
+
 	/**
 	 * Get the link graph settings for this component.
 	 * @return Settings.
@@ -150,6 +150,7 @@ void LinkGraphSchedule::JoinNext()
 		if (job->IsJobAborted()) return;
 		instance.handlers[i]->Run(*job);
 	}
+	job->RecordResultFlows();
 
 	/*
 	 * Note that this it not guaranteed to be an atomic write and there are no memory barriers or other protections.
@@ -524,6 +524,10 @@ MCF1stPass::MCF1stPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 	uint accuracy = job.Settings().accuracy;
 	bool more_loops;
 	std::vector<bool> finished_sources(size);
+	for (NodeID source = 0; source < size; ++source) {
+		/* Reused flows have already been reserved on the edges. */
+		finished_sources[source] = job.IsFlowReused(source);
+	}
 
 	do {
 		more_loops = false;
@@ -573,6 +577,10 @@ MCF2ndPass::MCF2ndPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 	uint accuracy = job.Settings().accuracy;
 	bool demand_left = true;
 	std::vector<bool> finished_sources(size);
+	for (NodeID source = 0; source < size; ++source) {
+		/* Reused flows have already been reserved on the edges. */
+		finished_sources[source] = job.IsFlowReused(source);
+	}
 	while (demand_left && !job.IsJobAborted()) {
 		demand_left = false;
 		for (NodeID source = 0; source < size; ++source) {
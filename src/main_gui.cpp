@@ -155,6 +155,7 @@ bool DoZoomInOutWindow(ZoomStateChange how, Window *w)
 	w->InvalidateData();
 	if (how != ZOOM_NONE) {
 		RebuildViewportOverlay(w, false);
+		ViewportPrefetchAdjacentZoom(vp);
 	}
 	return true;
 }
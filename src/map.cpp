@@ -14,6 +14,7 @@
 #include "string_func.h"
 #include "rail_map.h"
 #include "tunnelbridge_map.h"
+#include "memory_usage.h"
 #include "3rdparty/cpp-btree/btree_map.h"
 #include <array>
 
@@ -68,6 +69,12 @@ void AllocateMap(uint size_x, uint size_y)
 		error("Invalid map size");
 	}
 
+	if (_m != nullptr) {
+		RemoveMemoryUsage(MUC_MAP, _map_size * (sizeof(Tile) + sizeof(TileExtended)));
+		LargeFreeT(_m, _map_size);
+		LargeFreeT(_me, _map_size);
+	}
+
 	_map_log_x = FindFirstBit(size_x);
 	_map_log_y = FindFirstBit(size_y);
 	_map_size_x = size_x;
@@ -75,11 +82,9 @@ void AllocateMap(uint size_x, uint size_y)
 	_map_size = size_x * size_y;
 	_map_tile_mask = _map_size - 1;
 
-	free(_m);
-	free(_me);
-
-	_m = CallocT<Tile>(_map_size);
-	_me = CallocT<TileExtended>(_map_size);
+	_m = LargeCallocT<Tile>(_map_size);
+	_me = LargeCallocT<TileExtended>(_map_size);
+	AddMemoryUsage(MUC_MAP, _map_size * (sizeof(Tile) + sizeof(TileExtended)));
 }
 
 
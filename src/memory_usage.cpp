@@ -0,0 +1,50 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file memory_usage.cpp Accounting of the memory used by the larger subsystems. */
+
+#include "stdafx.h"
+#include "memory_usage.h"
+#include "cargopacket.h"
+
+#include "safeguards.h"
+
+MemoryUsageCounter _memory_usage[MUC_END];
+
+/**
+ * Get the name of a memory usage category, as reported to the console and admin port.
+ * @param category The category.
+ * @return Name of the category.
+ */
+const char *GetMemoryUsageCategoryName(MemoryUsageCategory category)
+{
+	static const char * const names[] = {
+		"map",
+		"pools",
+		"sprite cache",
+		"link graph",
+		"cargo lists",
+		"scripts",
+		"network",
+	};
+	assert_compile(lengthof(names) == MUC_END);
+
+	assert(category < MUC_END);
+	return names[category];
+}
+
+/**
+ * Update the usage of the categories which are estimated instead of accounted on every allocation.
+ * Their peak usage only includes the values seen by this function.
+ */
+void UpdateEstimatedMemoryUsage()
+{
+	MemoryUsageCounter &counter = _memory_usage[MUC_CARGO_PACKET_LISTS];
+	const size_t bytes = GetCargoPacketListMemoryUsage();
+	counter.current.store(bytes, std::memory_order_relaxed);
+	UpdateMemoryUsagePeak(counter, bytes);
+}
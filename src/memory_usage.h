@@ -0,0 +1,113 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file memory_usage.h Accounting of the memory used by the larger subsystems. */
+
+#ifndef MEMORY_USAGE_H
+#define MEMORY_USAGE_H
+
+#include "core/enum_type.hpp"
+#include <atomic>
+#include <memory>
+
+/** Subsystems of which the memory usage is accounted. */
+enum MemoryUsageCategory {
+	MUC_BEGIN = 0,
+	MUC_MAP = MUC_BEGIN,    ///< Map arrays.
+	MUC_POOLS,              ///< Pools, including their items. Items of derived types are counted with the size of the pool's item type.
+	MUC_SPRITE_CACHE,       ///< Sprites in the sprite cache.
+	MUC_LINKGRAPH,          ///< Link graph edge matrices, of both the link graphs and the running jobs.
+	MUC_CARGO_PACKET_LISTS, ///< Lists of cargo packets of vehicles and stations. Estimated when usage is reported.
+	MUC_SCRIPT,             ///< Script virtual machines.
+	MUC_NETWORK,            ///< Network packet buffers.
+	MUC_END,
+};
+DECLARE_POSTFIX_INCREMENT(MemoryUsageCategory)
+
+/** Current and peak memory usage of one category. */
+struct MemoryUsageCounter {
+	std::atomic<size_t> current; ///< Number of bytes currently in use.
+	std::atomic<size_t> peak;    ///< Largest number of bytes in use at any time.
+};
+
+extern MemoryUsageCounter _memory_usage[MUC_END];
+
+/**
+ * Raise the peak usage of a category to at least the given value.
+ * @param counter Counter of the category.
+ * @param current Current usage.
+ */
+static inline void UpdateMemoryUsagePeak(MemoryUsageCounter &counter, size_t current)
+{
+	size_t peak = counter.peak.load(std::memory_order_relaxed);
+	while (current > peak && !counter.peak.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {}
+}
+
+/**
+ * Account memory allocated by a subsystem. This may be called from any thread.
+ * @param category Subsystem the memory belongs to.
+ * @param bytes Number of bytes allocated.
+ */
+static inline void AddMemoryUsage(MemoryUsageCategory category, size_t bytes)
+{
+	MemoryUsageCounter &counter = _memory_usage[category];
+	UpdateMemoryUsagePeak(counter, counter.current.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+}
+
+/**
+ * Account memory freed by a subsystem. This may be called from any thread.
+ * @param category Subsystem the memory belonged to.
+ * @param bytes Number of bytes freed.
+ */
+static inline void RemoveMemoryUsage(MemoryUsageCategory category, size_t bytes)
+{
+	_memory_usage[category].current.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+const char *GetMemoryUsageCategoryName(MemoryUsageCategory category);
+void UpdateEstimatedMemoryUsage();
+
+/**
+ * Allocator for standard containers, which accounts the memory it allocates.
+ * @tparam T Type of the allocated objects.
+ * @tparam Tcategory Subsystem the memory belongs to.
+ */
+template <typename T, MemoryUsageCategory Tcategory>
+struct TrackedAllocator {
+	typedef T value_type;
+
+	template <typename U>
+	struct rebind {
+		typedef TrackedAllocator<U, Tcategory> other;
+	};
+
+	TrackedAllocator() noexcept {}
+
+	template <typename U>
+	TrackedAllocator(const TrackedAllocator<U, Tcategory> &) noexcept {}
+
+	T *allocate(size_t n)
+	{
+		T *p = std::allocator<T>().allocate(n);
+		AddMemoryUsage(Tcategory, n * sizeof(T));
+		return p;
+	}
+
+	void deallocate(T *p, size_t n)
+	{
+		RemoveMemoryUsage(Tcategory, n * sizeof(T));
+		std::allocator<T>().deallocate(p, n);
+	}
+
+	template <typename U>
+	bool operator==(const TrackedAllocator<U, Tcategory> &) const noexcept { return true; }
+
+	template <typename U>
+	bool operator!=(const TrackedAllocator<U, Tcategory> &) const noexcept { return false; }
+};
+
+#endif /* MEMORY_USAGE_H */
@@ -12,6 +12,7 @@
 #include "../../stdafx.h"
 #include "../../string_func.h"
 #include "../../command_type.h"
+#include "../../memory_usage.h"
 
 #include "packet.h"
 
@@ -30,6 +31,7 @@ Packet::Packet(NetworkSocketHandler *cs)
 	this->pos    = 0; // We start reading from here
 	this->size   = 0;
 	this->buffer = MallocT<byte>(SHRT_MAX);
+	AddMemoryUsage(MUC_NETWORK, SHRT_MAX);
 }
 
 /**
@@ -39,6 +41,7 @@ Packet::Packet(NetworkSocketHandler *cs)
 Packet::Packet(PacketType type)
 {
 	this->buffer = MallocT<byte>(SHRT_MAX);
+	AddMemoryUsage(MUC_NETWORK, SHRT_MAX);
 	this->ResetState(type);
 }
 
@@ -48,6 +51,7 @@ Packet::Packet(PacketType type)
 Packet::~Packet()
 {
 	free(this->buffer);
+	RemoveMemoryUsage(MUC_NETWORK, SHRT_MAX);
 }
 
 void Packet::ResetState(PacketType type)
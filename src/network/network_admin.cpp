@@ -18,6 +18,7 @@
 #include "../console_func.h"
 #include "../core/pool_func.hpp"
 #include "../map_func.h"
+#include "../memory_usage.h"
 #include "../rev.h"
 #include "../game/game.hpp"
 
@@ -52,6 +53,7 @@ static const AdminUpdateFrequency _admin_update_type_frequencies[] = {
 	ADMIN_FREQUENCY_POLL,                                                                                                                                  ///< ADMIN_UPDATE_CMD_NAMES
 	                       ADMIN_FREQUENCY_AUTOMATIC,                                                                                                      ///< ADMIN_UPDATE_CMD_LOGGING
 	                       ADMIN_FREQUENCY_AUTOMATIC,                                                                                                      ///< ADMIN_UPDATE_GAMESCRIPT
+	ADMIN_FREQUENCY_POLL | ADMIN_FREQUENCY_DAILY | ADMIN_FREQUENCY_WEEKLY | ADMIN_FREQUENCY_MONTHLY | ADMIN_FREQUENCY_QUARTERLY | ADMIN_FREQUENCY_ANUALLY, ///< ADMIN_UPDATE_MEMORY_USAGE
 };
 /** Sanity check. */
 assert_compile(lengthof(_admin_update_type_frequencies) == ADMIN_UPDATE_END);
@@ -602,6 +604,24 @@ NetworkRecvStatus ServerNetworkAdminSocketHandler::SendPong(uint32 d1)
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
+/** Send the memory usage of the subsystems. */
+NetworkRecvStatus ServerNetworkAdminSocketHandler::SendMemoryUsage()
+{
+	UpdateEstimatedMemoryUsage();
+
+	Packet *p = new Packet(ADMIN_PACKET_SERVER_MEMORY_USAGE);
+
+	p->Send_uint8(MUC_END);
+	for (MemoryUsageCategory category = MUC_BEGIN; category < MUC_END; category++) {
+		p->Send_string(GetMemoryUsageCategoryName(category));
+		p->Send_uint64(_memory_usage[category].current.load(std::memory_order_relaxed));
+		p->Send_uint64(_memory_usage[category].peak.load(std::memory_order_relaxed));
+	}
+	this->SendPacket(p);
+
+	return NETWORK_RECV_STATUS_OKAY;
+}
+
 /** Send the names of the commands. */
 NetworkRecvStatus ServerNetworkAdminSocketHandler::SendCmdNames()
 {
@@ -768,6 +788,11 @@ NetworkRecvStatus ServerNetworkAdminSocketHandler::Receive_ADMIN_POLL(Packet *p)
 			this->SendCmdNames();
 			break;
 
+		case ADMIN_UPDATE_MEMORY_USAGE:
+			/* The admin is requesting the memory usage. */
+			this->SendMemoryUsage();
+			break;
+
 		default:
 			/* An unsupported "poll" update type. */
 			DEBUG(net, 3, "[admin] Not supported poll %d (%d) from '%s' (%s).", type, d1, this->admin_name, this->admin_version);
@@ -1016,6 +1041,10 @@ void NetworkAdminUpdate(AdminUpdateFrequency freq)
 						as->SendCompanyStats();
 						break;
 
+					case ADMIN_UPDATE_MEMORY_USAGE:
+						as->SendMemoryUsage();
+						break;
+
 					default: NOT_REACHED();
 				}
 			}
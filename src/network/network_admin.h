@@ -66,6 +66,7 @@ public:
 	NetworkRecvStatus SendConsole(const char *origin, const char *command);
 	NetworkRecvStatus SendGameScript(const char *json);
 	NetworkRecvStatus SendCmdNames();
+	NetworkRecvStatus SendMemoryUsage();
 	NetworkRecvStatus SendCmdLogging(ClientID client_id, const CommandPacket *cp);
 	NetworkRecvStatus SendRconEnd(const char *command);
 
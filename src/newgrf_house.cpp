@@ -385,7 +385,7 @@ static uint32 GetDistanceFromNearbyHouse(uint8 parameter, TileIndex tile, HouseI
 			TileIndex testtile = TILE_MASK(this->tile + TileDiffXY(x_offs, y_offs));
 
 			StationFinder stations(TileArea(testtile, 1, 1));
-			const StationList *sl = stations.GetStations();
+			const TickStationList *sl = stations.GetStations();
 
 			/* Collect acceptance stats. */
 			uint32 res = 0;
@@ -29,6 +29,7 @@
 #include "train.h"
 #include "ship.h"
 #include "console_func.h"
+#include "sampling_profiler.h"
 #include "screenshot.h"
 #include "network/network.h"
 #include "network/network_func.h"
@@ -80,6 +81,10 @@
 
 #include "linkgraph/linkgraphschedule.h"
 #include "tracerestrict.h"
+#include "worker_thread.h"
+#include "tick_arena.h"
+#include "batch_mode.h"
+#include "spritecache.h"
 
 #include <stdarg.h>
 #include <system_error>
@@ -105,6 +110,8 @@ time_t _game_load_time;
 
 SimpleChecksum64 _state_checksum;
 
+BumpArena _tick_arena;
+
 /**
  * Error handling for fatal user errors.
  * @param s the string to print.
@@ -214,6 +221,7 @@ static void ShowHelp()
 		"  -d [[fac=]lvl[,...]]= Debug mode\n"
 		"  -e                  = Start Editor\n"
 		"  -g [savegame]       = Start new/save game immediately\n"
+		"                        (a .png/.bmp heightmap starts a new game, or scenario with -e, from it)\n"
 		"  -G seed             = Set random seed\n"
 		"  -n [ip:port#company]= Join network game\n"
 		"  -p password         = Password to join server\n"
@@ -229,6 +237,12 @@ static void ShowHelp()
 		"  -c config_file      = Use 'config_file' instead of 'openttd.cfg'\n"
 		"  -x                  = Do not automatically save to config file on exit\n"
 		"  -q savegame         = Write some information about the savegame and exit\n"
+		"  -o file             = Save the game to 'file' once it has started and quit\n"
+		"  -B op[,op...]       = Run operations on the started game without graphics and quit;\n"
+		"                        ticks=N, checkcaches, screenshot=minimap|heightmap[:name],\n"
+		"                        format=fmt[:level], save=file ('%f' is the loaded file's name)\n"
+		"  -j jobs             = Number of files processed at once by -B (default: CPU count)\n"
+		"                        (for instance -v null:until_exit -s null -m null -e -g map.png -o map.scn)\n"
 		"  -Z                  = Write detailed version information and exit\n"
 		"\n",
 		lastof(buf)
@@ -420,6 +434,7 @@ static void ShutdownGame()
 	UninitFreeType();
 
 	ViewportMapClearTunnelCache();
+	ClearTileDrawCache();
 	InvalidateVehicleTickCaches();
 	ClearVehicleTickCaches();
 	ClearCommandLog();
@@ -649,9 +664,39 @@ static const OptionData _options[] = {
 	 GETOPT_SHORT_NOVAL('h'),
 	 GETOPT_SHORT_VALUE('J'),
 	 GETOPT_SHORT_NOVAL('Z'),
+	 GETOPT_SHORT_VALUE('o'),
+	 GETOPT_SHORT_VALUE('B'),
+	 GETOPT_SHORT_VALUE('j'),
 	GETOPT_END()
 };
 
+/**
+ * Select the savegame, scenario or heightmap to start with, as given by -g or to the batch mode.
+ * Scenarios, and heightmaps, are opened in the editor when -e was given before.
+ * @param file The file to start.
+ */
+static void SelectStartupFile(const char *file)
+{
+	_file_to_saveload.SetName(file);
+	bool is_scenario = _switch_mode == SM_EDITOR || _switch_mode == SM_LOAD_SCENARIO;
+	_switch_mode = is_scenario ? SM_LOAD_SCENARIO : SM_LOAD_GAME;
+	_file_to_saveload.SetMode(SLO_LOAD, is_scenario ? FT_SCENARIO : FT_SAVEGAME, DFT_GAME_FILE);
+
+	/* if the file doesn't exist or it is not a valid savegame, let the saveload code show an error */
+	const char *t = strrchr(_file_to_saveload.name, '.');
+	if (t != nullptr) {
+		FiosType ft = FiosGetSavegameListCallback(SLO_LOAD, _file_to_saveload.name, t, nullptr, nullptr);
+		if (ft != FIOS_TYPE_INVALID) _file_to_saveload.SetMode(ft);
+
+		/* Heightmaps start a new game, or a new scenario in the editor, from the map. */
+		ft = FiosGetHeightmapListCallback(SLO_LOAD, _file_to_saveload.name, t, _file_to_saveload.title, lastof(_file_to_saveload.title));
+		if (ft != FIOS_TYPE_INVALID) {
+			_file_to_saveload.SetMode(ft);
+			_switch_mode = is_scenario ? SM_LOAD_HEIGHTMAP : SM_START_HEIGHTMAP;
+		}
+	}
+}
+
 /**
  * Main entry point for this lovely game.
  * @param argc The number of arguments passed to this game.
@@ -673,6 +718,8 @@ int openttd_main(int argc, char *argv[])
 	bool save_config = false;
 	AfterNewGRFScan *scanner = new AfterNewGRFScan(&save_config);
 	bool dedicated = false;
+	bool batch = false;
+	uint batch_jobs = GetWorkerThreadCount();
 	char *debuglog_conn = nullptr;
 
 	extern bool _dedicated_forks;
@@ -741,21 +788,16 @@ int openttd_main(int argc, char *argv[])
 				if (mgo.opt != nullptr) SetDebugString(mgo.opt);
 				break;
 			}
-		case 'e': _switch_mode = (_switch_mode == SM_LOAD_GAME || _switch_mode == SM_LOAD_SCENARIO ? SM_LOAD_SCENARIO : SM_EDITOR); break;
+		case 'e':
+			if (_switch_mode == SM_START_HEIGHTMAP || _switch_mode == SM_LOAD_HEIGHTMAP) {
+				_switch_mode = SM_LOAD_HEIGHTMAP;
+			} else {
+				_switch_mode = (_switch_mode == SM_LOAD_GAME || _switch_mode == SM_LOAD_SCENARIO ? SM_LOAD_SCENARIO : SM_EDITOR);
+			}
+			break;
 		case 'g':
 			if (mgo.opt != nullptr) {
-				_file_to_saveload.SetName(mgo.opt);
-				bool is_scenario = _switch_mode == SM_EDITOR || _switch_mode == SM_LOAD_SCENARIO;
-				_switch_mode = is_scenario ? SM_LOAD_SCENARIO : SM_LOAD_GAME;
-				_file_to_saveload.SetMode(SLO_LOAD, is_scenario ? FT_SCENARIO : FT_SAVEGAME, DFT_GAME_FILE);
-
-				/* if the file doesn't exist or it is not a valid savegame, let the saveload code show an error */
-				const char *t = strrchr(_file_to_saveload.name, '.');
-				if (t != nullptr) {
-					FiosType ft = FiosGetSavegameListCallback(SLO_LOAD, _file_to_saveload.name, t, nullptr, nullptr);
-					if (ft != FIOS_TYPE_INVALID) _file_to_saveload.SetMode(ft);
-				}
-
+				SelectStartupFile(mgo.opt);
 				break;
 			}
 
@@ -808,6 +850,24 @@ int openttd_main(int argc, char *argv[])
 			CrashLog::VersionInfoLog();
 			goto exit_noshutdown;
 		}
+		case 'o': AddBatchSaveOperation(mgo.opt); break;
+		case 'B':
+			if (!ParseBatchOperations(mgo.opt)) {
+				ret = 1;
+				goto exit_noshutdown;
+			}
+			free(musicdriver);
+			free(sounddriver);
+			free(videodriver);
+			free(blitter);
+			musicdriver = stredup("null");
+			sounddriver = stredup("null");
+			videodriver = stredup("null:until_exit");
+			blitter = stredup("null");
+			batch = true;
+			scanner->save_config = false;
+			break;
+		case 'j': batch_jobs = Clamp(atoi(mgo.opt), 1, 1024); break;
 		case 'h':
 			i = -2; // Force printing of help.
 			break;
@@ -815,7 +875,13 @@ int openttd_main(int argc, char *argv[])
 		if (i == -2) break;
 	}
 
-	if (i == -2 || mgo.numleft > 0) {
+	if (i != -2 && batch && mgo.numleft == 1) {
+		/* A single file is processed by ourselves. */
+		SelectStartupFile(mgo.argv[0]);
+	} else if (i != -2 && batch && mgo.numleft > 1) {
+		ret = RunBatchWorkers(argv[0], argv + 1, argc - 1 - mgo.numleft, mgo.argv, mgo.numleft, batch_jobs);
+		goto exit_noshutdown;
+	} else if (i == -2 || mgo.numleft > 0) {
 		/* Either the user typed '-h', he made an error, or he added unrecognized command line arguments.
 		 * In all cases, print the help, and exit.
 		 *
@@ -842,6 +908,9 @@ int openttd_main(int argc, char *argv[])
 	if (_dedicated_forks) DedicatedFork();
 #endif
 
+	/* Only start after forking, as the debug log thread does not survive it. */
+	StartAsyncDebugLog();
+
 	LoadFromConfig(true);
 
 	if (resolution.width != 0) _cur_resolution = resolution;
@@ -906,6 +975,9 @@ int openttd_main(int argc, char *argv[])
 	}
 	free(blitter);
 
+	/* Nothing is drawn in batch mode, so there is no need to decode any sprites. */
+	if (batch) _sprite_decoding_disabled = true;
+
 	if (videodriver == nullptr && _ini_videodriver != nullptr) videodriver = stredup(_ini_videodriver);
 	DriverFactoryBase::SelectDriver(videodriver, Driver::DT_VIDEO);
 	free(videodriver);
@@ -1000,6 +1072,8 @@ int openttd_main(int argc, char *argv[])
 
 	CrashLog::MainThreadExitCheckPendingCrashlog();
 
+	ret = GetBatchExitCode();
+
 	WaitTillSaved();
 	WaitTillGeneratedWorld(); // Make sure any generate world threads have been joined.
 
@@ -1040,6 +1114,8 @@ exit_normal:
 
 	delete scanner;
 
+	StopAsyncDebugLog();
+
 	extern FILE *_log_fd;
 	if (_log_fd != nullptr) {
 		fclose(_log_fd);
@@ -1292,6 +1368,11 @@ void SwitchToMode(SwitchMode new_mode)
 			break;
 
 		case SM_LOAD_HEIGHTMAP: // Load heightmap from scenario editor
+			if (_game_mode != GM_EDITOR) {
+				/* Started from the command line, without opening the editor first. */
+				_game_mode = GM_EDITOR;
+				ResetGRFConfig(true);
+			}
 			SetLocalCompany(OWNER_NONE);
 
 			FixConfigMapSize();
@@ -1518,6 +1599,8 @@ void CheckCaches(bool force_check, std::function<void(const char *)> log)
 		rs->GetEntry(DIAGDIR_NW)->CheckIntegrity(rs);
 	}
 
+	if (!ValidateLevelCrossingTrainCounts()) CCLOG("level crossing train counts mismatch");
+
 	for (Vehicle *v : Vehicle::Iterate()) {
 		extern bool ValidateVehicleTileHash(const Vehicle *v);
 		if (!ValidateVehicleTileHash(v)) {
@@ -1670,22 +1753,37 @@ void CheckCaches(bool force_check, std::function<void(const char *)> log)
 		free(veh_old);
 	}
 
-	/* Check whether the caches are still valid */
-	for (Vehicle *v : Vehicle::Iterate()) {
+	/* Check whether the caches are still valid; each recount only touches its own cargo list, so they can run in parallel. */
+	typedef std::vector<uint> IndexList;
+	auto append_indices = [](IndexList &result, const IndexList &partial) {
+		result.insert(result.end(), partial.begin(), partial.end());
+	};
+
+	IndexList bad_vehicles = ParallelPoolReduce<Vehicle>(IndexList(), [](IndexList &bad, Vehicle *v) {
 		byte buff[sizeof(VehicleCargoList)];
 		memcpy(buff, &v->cargo, sizeof(VehicleCargoList));
 		v->cargo.InvalidateCache();
-		assert(memcmp(&v->cargo, buff, sizeof(VehicleCargoList)) == 0);
-	}
+		if (memcmp(&v->cargo, buff, sizeof(VehicleCargoList)) != 0) bad.push_back(v->index);
+	}, append_indices);
+	assert(bad_vehicles.empty());
 
-	for (Station *st : Station::Iterate()) {
+	IndexList bad_stations = ParallelPoolReduce<Station>(IndexList(), [](IndexList &bad, Station *st) {
 		for (CargoID c = 0; c < NUM_CARGO; c++) {
 			byte buff[sizeof(StationCargoList)];
 			memcpy(buff, &st->goods[c].cargo, sizeof(StationCargoList));
+			const StationCargoSourceCountList source_counts = st->goods[c].cargo.SourceCounts();
 			st->goods[c].cargo.InvalidateCache();
-			assert(memcmp(&st->goods[c].cargo, buff, sizeof(StationCargoList)) == 0);
+			if (memcmp(&st->goods[c].cargo, buff, sizeof(StationCargoList)) != 0 ||
+					source_counts.size() != st->goods[c].cargo.SourceCounts().size() ||
+					!std::equal(source_counts.begin(), source_counts.end(), st->goods[c].cargo.SourceCounts().begin(),
+					[](const StationCargoSourceCount &a, const StationCargoSourceCount &b) {
+						return a.next == b.next && a.source == b.source && a.count == b.count;
+					})) {
+				bad.push_back(st->index);
+			}
 		}
-	}
+	}, append_indices);
+	assert(bad_stations.empty());
 
 	for (OrderList *order_list : OrderList::Iterate()) {
 		order_list->DebugCheckSanity();
@@ -1771,6 +1869,7 @@ void StateGameLoop()
 #ifndef DEBUG_DUMP_COMMANDS
 		Game::GameLoop();
 #endif
+		_tick_arena.Reset();
 		return;
 	}
 
@@ -1839,6 +1938,8 @@ void StateGameLoop()
 		}
 	}
 
+	_tick_arena.Reset();
+
 	assert(IsLocalCompany());
 }
 
@@ -1870,6 +1971,9 @@ static void DoAutosave()
 
 void GameLoop()
 {
+	ProcessAsyncDebugLog();
+	ProcessSamplingProfiler();
+
 	if (_game_mode == GM_BOOTSTRAP) {
 		/* Check for UDP stuff */
 		if (_network_available) NetworkBackgroundLoop();
@@ -1892,6 +1996,9 @@ void GameLoop()
 		_switch_mode = SM_NONE;
 	}
 
+	/* Process the game started from the command line and quit? */
+	if (ProcessBatchOperations()) return;
+
 	IncreaseSpriteLRU();
 	InteractiveRandom();
 
@@ -706,6 +706,7 @@ CommandCost CmdBuildSingleRail(TileIndex tile, DoCommandFlag flags, uint32 p1, u
 
 					if (flags & DC_EXEC) {
 						MakeRoadCrossing(tile, road_owner, tram_owner, _current_company, (track == TRACK_X ? AXIS_Y : AXIS_X), railtype, roadtype_road, roadtype_tram, GetTownIndex(tile));
+						UpdateLevelCrossingTrainCountsAround(tile);
 						UpdateLevelCrossing(tile, false);
 						Company::Get(_current_company)->infrastructure.rail[railtype] += LEVELCROSSING_TRACKBIT_FACTOR;
 						DirtyCompanyInfrastructureWindows(_current_company);
@@ -964,7 +965,11 @@ CommandCost CmdRemoveSingleRail(TileIndex tile, DoCommandFlag flags, uint32 p1,
 			YapfNotifyTrackLayoutChange(tile, track);
 		}
 
-		if (v != nullptr) TryPathReserve(v, true);
+		if (v != nullptr) {
+			/* The reservation must see the signals of the changed layout, also in the middle of a drag. */
+			FlushSignalBufferBatch();
+			TryPathReserve(v, true);
+		}
 	}
 
 	_rail_track_endtile = tile;
@@ -1081,6 +1086,49 @@ static CommandCost ValidateAutoDrag(Trackdir *trackdir, TileIndex start, TileInd
 	return CommandCost();
 }
 
+/** Tile of a rail drag, with the data for building on it gathered before anything is built. */
+struct RailDragTile {
+	TileIndex tile;         ///< Tile of the drag.
+	Track track;            ///< Track to build or remove on the tile.
+	bool bare_land;         ///< Whether the track is built on bare land by #BuildRailOnBareLand.
+	CommandCost foundation; ///< For bare land: the result of the slope check, i.e. the foundation cost.
+};
+
+/**
+ * Build a piece of a rail drag on a bare land tile, with the same result
+ * as #CmdBuildSingleRail but without the command overhead and without
+ * updating the infrastructure windows, which is done once for the drag.
+ * @param t the validated tile of the drag
+ * @param flags operation to perform
+ * @param railtype railtype to build
+ * @return the cost of this operation or an error
+ */
+static CommandCost BuildRailOnBareLand(const RailDragTile &t, DoCommandFlag flags, RailType railtype)
+{
+	_rail_track_endtile = INVALID_TILE;
+	if (t.foundation.Failed()) return t.foundation;
+
+	CommandCost cost(EXPENSES_CONSTRUCTION);
+	cost.AddCost(t.foundation);
+
+	CommandCost ret = ClearBareLandTile(t.tile, flags | DC_ALLOW_REMOVE_WATER);
+	if (ret.Failed()) return ret;
+	cost.AddCost(ret);
+
+	if (flags & DC_EXEC) {
+		MakeRailNormal(t.tile, _current_company, TrackToTrackBits(t.track), railtype);
+		Company::Get(_current_company)->infrastructure.rail[railtype]++;
+
+		MarkTileDirtyByTile(t.tile);
+		AddTrackToSignalBuffer(t.tile, t.track, _current_company);
+		YapfNotifyTrackLayoutChange(t.tile, t.track);
+	}
+
+	cost.AddCost(RailBuildCost(railtype));
+	_rail_track_endtile = t.tile;
+	return cost;
+}
+
 /**
  * Build or remove a stretch of railroad tracks.
  * @param tile start tile of drag
@@ -1114,17 +1162,48 @@ static CommandCost CmdRailTrackHelper(TileIndex tile, DoCommandFlag flags, uint3
 	CommandCost ret = ValidateAutoDrag(&trackdir, tile, end_tile);
 	if (ret.Failed()) return ret;
 
+	/* Validate the drag in one pass, so the tiles on bare land do not need to go via the per-tile command.
+	 * Building stops at the first bare land tile with an invalid slope, so the drag ends there. */
+	std::vector<RailDragTile> drag;
+	for (;;) {
+		RailDragTile t;
+		t.tile = tile;
+		t.track = TrackdirToTrack(trackdir);
+		t.bare_land = !remove && IsBareLandTile(tile);
+		if (t.bare_land) t.foundation = CheckRailSlope(GetTileSlope(tile), TrackToTrackBits(t.track), TRACK_BIT_NONE, tile);
+		drag.push_back(t);
+
+		if (tile == end_tile || (t.bare_land && t.foundation.Failed())) break;
+
+		tile += ToTileIndexDiff(_trackdelta[trackdir]);
+
+		/* toggle railbit for the non-diagonal tracks */
+		if (!IsDiagonalTrackdir(trackdir)) ToggleBit(trackdir, 0);
+	}
+
+	/* Update the signals of the whole drag at once instead of every few pieces. */
+	SignalBufferBatch signal_batch;
+
 	bool had_success = false;
+	bool built_on_bare_land = false;
 	CommandCost last_error = CMD_ERROR;
-	for (;;) {
+	CommandCost obstacle_error;
+	for (const RailDragTile &t : drag) {
 		TileIndex last_endtile = _rail_track_endtile;
-		CommandCost ret = DoCommand(tile, remove ? 0 : railtype, TrackdirToTrack(trackdir) | (no_custom_bridge_heads ? 1 << 4 : 0) | (no_dual_rail_type ? 1 << 5 : 0), flags, remove ? CMD_REMOVE_SINGLE_RAIL : CMD_BUILD_SINGLE_RAIL);
+		CommandCost ret;
+		/* An object cleared by an earlier tile of the drag leaves bare land that was not validated as such. */
+		if (t.bare_land && IsBareLandTile(t.tile)) {
+			ret = BuildRailOnBareLand(t, flags, railtype);
+			if (ret.Succeeded()) built_on_bare_land = true;
+		} else {
+			ret = DoCommand(t.tile, remove ? 0 : railtype, t.track | (no_custom_bridge_heads ? 1 << 4 : 0) | (no_dual_rail_type ? 1 << 5 : 0), flags, remove ? CMD_REMOVE_SINGLE_RAIL : CMD_BUILD_SINGLE_RAIL);
+		}
 
 		if (ret.Failed()) {
 			last_error = ret;
 			if (_rail_track_endtile == INVALID_TILE) _rail_track_endtile = last_endtile;
 			if (last_error.GetErrorMessage() != STR_ERROR_ALREADY_BUILT && !remove) {
-				if (fail_if_obstacle) return last_error;
+				if (fail_if_obstacle) obstacle_error = last_error;
 				break;
 			}
 
@@ -1134,15 +1213,11 @@ static CommandCost CmdRailTrackHelper(TileIndex tile, DoCommandFlag flags, uint3
 			had_success = true;
 			total_cost.AddCost(ret);
 		}
-
-		if (tile == end_tile) break;
-
-		tile += ToTileIndexDiff(_trackdelta[trackdir]);
-
-		/* toggle railbit for the non-diagonal tracks */
-		if (!IsDiagonalTrackdir(trackdir)) ToggleBit(trackdir, 0);
 	}
 
+	if (built_on_bare_land && (flags & DC_EXEC)) DirtyCompanyInfrastructureWindows(_current_company);
+
+	if (obstacle_error.Failed()) return obstacle_error;
 	if (had_success) return total_cost;
 	return last_error;
 }
@@ -2509,6 +2584,8 @@ void MarkSingleSignalDirty(TileIndex tile, Trackdir td)
 		0,  // TRACKDIR_RVREV_NW
 	};
 
+	InvalidateTileDrawCache(tile);
+
 	uint x, y;
 	GetSignalXY(tile, trackdir_to_pos[td], x, y);
 	Point pt = RemapCoords(x, y, GetSaveSlopeZ(x, y, TrackdirToTrack(td)));
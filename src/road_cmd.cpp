@@ -27,6 +27,7 @@
 #include "effectvehicle_base.h"
 #include "elrail_func.h"
 #include "roadveh.h"
+#include "train.h"
 #include "town.h"
 #include "company_base.h"
 #include "core/random_func.hpp"
@@ -859,6 +860,7 @@ CommandCost CmdBuildRoad(TileIndex tile, DoCommandFlag flags, uint32 p1, uint32
 				bool reserved = HasBit(GetRailReservationTrackBits(tile), railtrack);
 				MakeRoadCrossing(tile, company, company, GetTileOwner(tile), roaddir, GetRailType(tile), rtt == RTT_ROAD ? rt : INVALID_ROADTYPE, (rtt == RTT_TRAM) ? rt : INVALID_ROADTYPE, p2);
 				SetCrossingReservation(tile, reserved);
+				UpdateLevelCrossingTrainCountsAround(tile);
 				UpdateLevelCrossing(tile, false);
 				NotifyRoadLayoutChangedIfTileNonLeaf(tile, rtt, GetCrossingRoadBits(tile));
 				MarkTileDirtyByTile(tile);
@@ -1162,6 +1164,57 @@ static bool CanConnectToRoad(TileIndex tile, RoadType rt, DiagDirection dir)
 	return (bits & DiagDirToRoadBits(ReverseDiagDir(dir))) != 0;
 }
 
+/** Tile of a long road, with the data for building on it gathered before anything is built. */
+struct RoadDragTile {
+	TileIndex tile;         ///< Tile of the drag.
+	RoadBits bits;          ///< Road bits to build on the tile.
+	bool bare_land;         ///< Whether the road is built on bare land by #BuildRoadOnBareLand.
+	RoadBits pieces;        ///< For bare land: the road bits after completing them for the slope.
+	CommandCost foundation; ///< For bare land: the result of the slope check, i.e. the foundation cost.
+	TownID town;            ///< For bare land: the town the road will belong to.
+};
+
+/**
+ * Build a piece of a long road on a bare land tile, with the same result
+ * as #CmdBuildRoad but without the command overhead and without updating
+ * the company infrastructure, which is done once for the drag.
+ * @param t the validated tile of the drag
+ * @param flags operation to perform
+ * @param rt road type to build
+ * @param toggle_drd disallowed directions to toggle
+ * @return the cost of this operation or an error
+ */
+static CommandCost BuildRoadOnBareLand(const RoadDragTile &t, DoCommandFlag flags, RoadType rt, DisallowedRoadDirections toggle_drd)
+{
+	CommandCost cost(EXPENSES_CONSTRUCTION);
+
+	/* The tile is cleared before the slope is checked, as for any other tile that needs clearing. */
+	CommandCost ret = ClearBareLandTile(t.tile, flags);
+	if (ret.Failed()) return ret;
+	cost.AddCost(ret);
+
+	/* Return an error if we need to build a foundation (foundation != 0) but the
+	 * current setting is turned off */
+	if (t.foundation.Failed() || (t.foundation.GetCost() != 0 && !_settings_game.construction.build_on_slopes)) {
+		return_cmd_error(STR_ERROR_LAND_SLOPED_IN_WRONG_DIRECTION);
+	}
+	cost.AddCost(t.foundation);
+	cost.AddCost(CountBits(t.pieces) * RoadBuildCost(rt));
+
+	if (flags & DC_EXEC) {
+		RoadTramType rtt = GetRoadTramType(rt);
+		MakeRoadNormal(t.tile, t.pieces, (rtt == RTT_ROAD) ? rt : INVALID_ROADTYPE, (rtt == RTT_TRAM) ? rt : INVALID_ROADTYPE, t.town, _current_company, _current_company);
+		NotifyRoadLayoutChangedIfTileNonLeaf(t.tile, rtt, t.pieces);
+
+		if (rtt == RTT_ROAD) {
+			SetDisallowedRoadDirections(t.tile, IsStraightRoad(t.pieces) ? GetDisallowedRoadDirections(t.tile) ^ toggle_drd : DRD_NONE);
+		}
+
+		MarkTileDirtyByTile(t.tile);
+	}
+	return cost;
+}
+
 /**
  * Build a long piece of road.
  * @param start_tile start tile of drag (the building cost will appear over this tile)
@@ -1216,6 +1269,10 @@ CommandCost CmdBuildLongRoad(TileIndex start_tile, DoCommandFlag flags, uint32 p
 	bool had_success = false;
 	bool is_ai = HasBit(p2, 11);
 
+	/* Validate the drag in one pass, so the tiles on bare land do not need to go via the per-tile command.
+	 * Building stops at the first bare land tile with an invalid slope, so the drag ends there. */
+	std::vector<RoadDragTile> drag;
+
 	/* Start tile is the first tile clicked by the user. */
 	for (;;) {
 		RoadBits bits = AxisToRoadBits(axis);
@@ -1234,17 +1291,20 @@ CommandCost CmdBuildLongRoad(TileIndex start_tile, DoCommandFlag flags, uint32 p
 			if (tile == start_tile && HasBit(p2, 0)) bits &= DiagDirToRoadBits(dir);
 		}
 
-		CommandCost ret = DoCommand(tile, drd << 11 | rt << 4 | bits | (is_ai ? 1 << 13 : 0), 0, flags, CMD_BUILD_ROAD);
-		if (ret.Failed()) {
-			last_error = ret;
-			if (last_error.GetErrorMessage() != STR_ERROR_ALREADY_BUILT) {
-				if (is_ai) return last_error;
-				break;
-			}
-		} else {
-			had_success = true;
-			cost.AddCost(ret);
+		RoadDragTile t;
+		t.tile = tile;
+		t.bits = bits;
+		t.bare_land = bits != ROAD_NONE && Company::IsValidID(_current_company) && IsBareLandTile(tile);
+		if (t.bare_land) {
+			t.pieces = bits;
+			t.foundation = CheckRoadSlope(GetTileSlope(tile), &t.pieces, ROAD_NONE, ROAD_NONE);
+			const Town *town = CalcClosestTownFromTile(tile);
+			t.town = (town != nullptr) ? town->index : INVALID_TOWN;
 		}
+		drag.push_back(t);
+
+		if (t.bare_land && (t.foundation.Failed() || (t.foundation.GetCost() != 0 && !_settings_game.construction.build_on_slopes))) break;
+
 		/* Do not run into or across bridges/tunnels */
 		if (IsTileType(tile, MP_TUNNELBRIDGE)) {
 			if (GetTunnelBridgeDirection(tile) == dir) break;
@@ -1260,6 +1320,33 @@ CommandCost CmdBuildLongRoad(TileIndex start_tile, DoCommandFlag flags, uint32 p
 		}
 	}
 
+	uint bare_land_pieces = 0;
+	CommandCost obstacle_error;
+	for (const RoadDragTile &t : drag) {
+		CommandCost ret;
+		/* An object cleared by an earlier tile of the drag leaves bare land that was not validated as such. */
+		if (t.bare_land && IsBareLandTile(t.tile)) {
+			ret = BuildRoadOnBareLand(t, flags, rt, drd);
+			if (ret.Succeeded()) bare_land_pieces += CountBits(t.pieces);
+		} else {
+			ret = DoCommand(t.tile, drd << 11 | rt << 4 | t.bits | (is_ai ? 1 << 13 : 0), 0, flags, CMD_BUILD_ROAD);
+		}
+
+		if (ret.Failed()) {
+			last_error = ret;
+			if (last_error.GetErrorMessage() != STR_ERROR_ALREADY_BUILT) {
+				if (is_ai) obstacle_error = last_error;
+				break;
+			}
+		} else {
+			had_success = true;
+			cost.AddCost(ret);
+		}
+	}
+
+	if (bare_land_pieces > 0 && (flags & DC_EXEC)) UpdateCompanyRoadInfrastructure(rt, _current_company, bare_land_pieces);
+
+	if (obstacle_error.Failed()) return obstacle_error;
 	return had_success ? cost : last_error;
 }
 
@@ -2364,6 +2451,7 @@ static VehicleEnterTileStatus VehicleEnter_Road(Vehicle *v, TileIndex tile, int
 				rv->direction = ReverseDir(rv->direction);
 				if (rv->Next() == nullptr) VehicleEnterDepot(rv->First());
 				rv->tile = tile;
+				rv->UpdatePosition();
 				rv->UpdateIsDrawn();
 
 				InvalidateWindowData(WC_VEHICLE_DEPOT, rv->tile);
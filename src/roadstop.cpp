@@ -311,39 +311,6 @@ void RoadStop::Entry::Enter(const RoadVehicle *rv)
 			IsDriveThroughStopTile(next);
 }
 
-typedef std::list<const RoadVehicle *> RVList; ///< A list of road vehicles
-
-/** Helper for finding RVs in a road stop. */
-struct RoadStopEntryRebuilderHelper {
-	RVList vehicles;   ///< The list of vehicles to possibly add to.
-	DiagDirection dir; ///< The direction the vehicle has to face to be added.
-};
-
-/**
- * Add road vehicles to the station's list if needed.
- * @param v the found vehicle
- * @param data the extra data used to make our decision
- * @return always nullptr
- */
-Vehicle *FindVehiclesInRoadStop(Vehicle *v, void *data)
-{
-	RoadStopEntryRebuilderHelper *rserh = (RoadStopEntryRebuilderHelper*)data;
-	/* Not a RV or not in the right direction or crashed :( */
-	if (DirToDiagDir(v->direction) != rserh->dir || !v->IsPrimaryVehicle() || (v->vehstatus & VS_CRASHED) != 0) return nullptr;
-
-	RoadVehicle *rv = RoadVehicle::From(v);
-	/* Don't add ones not in a road stop */
-	if (rv->state < RVSB_IN_ROAD_STOP) return nullptr;
-
-	/* Do not add duplicates! */
-	for (RVList::iterator it = rserh->vehicles.begin(); it != rserh->vehicles.end(); it++) {
-		if (rv == *it) return nullptr;
-	}
-
-	rserh->vehicles.push_back(rv);
-	return nullptr;
-}
-
 /**
  * Rebuild, from scratch, the vehicles and other metadata on this stop.
  * @param rs   the roadstop this entry is part of
@@ -356,19 +323,26 @@ void RoadStop::Entry::Rebuild(const RoadStop *rs, int side)
 	DiagDirection dir = GetRoadStopDir(rs->xy);
 	if (side == -1) side = (rs->east == this);
 
-	RoadStopEntryRebuilderHelper rserh;
-	rserh.dir = side ? dir : ReverseDiagDir(dir);
+	/* Vehicles count for the side they are facing, which has the lanes of two directions. */
+	const DiagDirection side_dir = side ? dir : ReverseDiagDir(dir);
+	const Direction lane_dirs[] = { (Direction)(side_dir * 2), (Direction)(side_dir * 2 + 1) };
 
 	this->length = 0;
+	this->occupied = 0;
 	TileIndexDiff offset = abs(TileOffsByDiagDir(dir));
 	for (TileIndex tile = rs->xy; IsDriveThroughRoadStopContinuation(rs->xy, tile); tile += offset) {
 		this->length += TILE_SIZE;
-		FindVehicleOnPos(tile, VEH_ROAD, &rserh, FindVehiclesInRoadStop);
-	}
 
-	this->occupied = 0;
-	for (RVList::iterator it = rserh.vehicles.begin(); it != rserh.vehicles.end(); it++) {
-		this->occupied += (*it)->gcache.cached_total_length;
+		const RoadVehicleTileLanes *tile_lanes = GetRoadVehicleTileLanes(tile);
+		if (tile_lanes == nullptr) continue;
+		for (Direction lane_dir : lane_dirs) {
+			for (const RoadVehicle *rv = tile_lanes->lanes[lane_dir].first; rv != nullptr; rv = rv->lane_next) {
+				/* Only count primary vehicles in the road stop which aren't crashed. */
+				if (rv->tile != tile || !rv->IsPrimaryVehicle() || (rv->vehstatus & VS_CRASHED) != 0) continue;
+				if (rv->state < RVSB_IN_ROAD_STOP) continue;
+				this->occupied += rv->gcache.cached_total_length;
+			}
+		}
 	}
 }
 
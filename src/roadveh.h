@@ -120,6 +120,12 @@ struct RoadVehicle FINAL : public GroundVehicle<RoadVehicle, VEH_ROAD> {
 
 	byte critical_breakdown_count; ///< Counter for the number of critical breakdowns since last service
 
+	RoadVehicle *lane_next;         ///< NOSAVE: Next road vehicle in the same lane, further along it.
+	RoadVehicle *lane_prev;         ///< NOSAVE: Previous road vehicle in the same lane, less far along it.
+	TileIndex lane_tile;            ///< NOSAVE: Tile of the lane this vehicle is in, if any.
+	Direction lane_dir;             ///< NOSAVE: Direction of the lane this vehicle is in, if any.
+	bool in_lane;                   ///< NOSAVE: Whether this vehicle is in a lane.
+
 	/** We don't want GCC to zero our struct! It already is zeroed and has an index! */
 	RoadVehicle() : GroundVehicleBase() {}
 	/** We want to 'destruct' the right class. */
@@ -355,4 +361,31 @@ protected: // These functions should not be called outside acceleration code.
 	}
 };
 
+/** Road vehicles on a tile facing the same direction, ordered by how far they are along that direction. */
+struct RoadVehicleLane {
+	RoadVehicle *first; ///< Vehicle the least far along the lane.
+	uint count;         ///< Number of vehicles in the lane.
+};
+
+/** Road vehicles on a tile, by lane. */
+struct RoadVehicleTileLanes {
+	RoadVehicleLane lanes[DIR_END]; ///< Lanes of the tile, by direction of the vehicles.
+	uint count;                     ///< Number of vehicles on the tile.
+};
+
+const RoadVehicleTileLanes *GetRoadVehicleTileLanes(TileIndex tile);
+
+/**
+ * Get how far a position is along a lane.
+ * @param x X coordinate of the position.
+ * @param y Y coordinate of the position.
+ * @param dir Direction of the lane.
+ * @return Progress along the lane, larger is further along.
+ */
+static inline int GetRoadVehicleLaneProgress(int x, int y, Direction dir)
+{
+	TileIndexDiffC diff = TileIndexDiffCByDir(dir);
+	return x * diff.x + y * diff.y;
+}
+
 #endif /* ROADVEH_H */
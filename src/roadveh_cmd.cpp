@@ -517,6 +517,7 @@ static void RoadVehSetRandomDirection(RoadVehicle *v)
 		uint32 r = Random();
 
 		v->direction = ChangeDir(v->direction, delta[r & 3]);
+		v->UpdatePosition();
 		v->UpdateViewport(true, true);
 	} while ((v = v->Next()) != nullptr);
 }
@@ -689,6 +690,27 @@ static Vehicle *EnumCheckRoadVehClose(Vehicle *v, void *data)
 	return nullptr;
 }
 
+/**
+ * Check the road vehicles in the lane of a tile facing the searched direction
+ * for the closest one ahead of the searched position.
+ * @param tile The tile.
+ * @param rvf The search data.
+ */
+static void RoadVehFindCloseToInLane(TileIndex tile, RoadVehFindData *rvf)
+{
+	const RoadVehicleTileLanes *tile_lanes = GetRoadVehicleTileLanes(tile);
+	if (tile_lanes == nullptr || tile_lanes->lanes[rvf->dir].count == 0) return;
+
+	/* Vehicles close enough are between 0 and 8 pixels further along the lane, and the lane is ordered by that. */
+	const int progress = GetRoadVehicleLaneProgress(rvf->x, rvf->y, rvf->dir);
+	for (RoadVehicle *u = tile_lanes->lanes[rvf->dir].first; u != nullptr; u = u->lane_next) {
+		const int diff = GetRoadVehicleLaneProgress(u->x_pos, u->y_pos, rvf->dir) - progress;
+		if (diff < 0 || u->tile != tile) continue;
+		if (diff >= 8) break;
+		EnumCheckRoadVehClose(u, rvf);
+	}
+}
+
 static RoadVehicle *RoadVehFindCloseTo(RoadVehicle *v, int x, int y, Direction dir, bool update_blocked_ctr = true)
 {
 	RoadVehFindData rvf;
@@ -703,10 +725,20 @@ static RoadVehicle *RoadVehFindCloseTo(RoadVehicle *v, int x, int y, Direction d
 	rvf.best_diff = UINT_MAX;
 
 	if (front->state == RVSB_WORMHOLE) {
-		FindVehicleOnPos(v->tile, VEH_ROAD, &rvf, EnumCheckRoadVehClose);
-		FindVehicleOnPos(GetOtherTunnelBridgeEnd(v->tile), VEH_ROAD, &rvf, EnumCheckRoadVehClose);
+		RoadVehFindCloseToInLane(v->tile, &rvf);
+		RoadVehFindCloseToInLane(GetOtherTunnelBridgeEnd(v->tile), &rvf);
 	} else {
-		FindVehicleOnPosXY(x, y, VEH_ROAD, &rvf, EnumCheckRoadVehClose);
+		/* Check the same tiles as FindVehicleOnPosXY does. */
+		const int COLL_DIST = 6;
+		const uint xl = max(x - COLL_DIST, 0) / TILE_SIZE;
+		const uint xu = min<uint>(max(x + COLL_DIST, 0) / TILE_SIZE, MapMaxX());
+		const uint yl = max(y - COLL_DIST, 0) / TILE_SIZE;
+		const uint yu = min<uint>(max(y + COLL_DIST, 0) / TILE_SIZE, MapMaxY());
+		for (uint ty = yl; ty <= yu; ty++) {
+			for (uint tx = xl; tx <= xu; tx++) {
+				RoadVehFindCloseToInLane(TileXY(tx, ty), &rvf);
+			}
+		}
 	}
 
 	/* This code protects a roadvehicle from being blocked for ever
@@ -816,13 +848,6 @@ struct OvertakeData {
 	Trackdir trackdir;
 };
 
-static Vehicle *EnumFindVehBlockingOvertake(Vehicle *v, void *data)
-{
-	const OvertakeData *od = (OvertakeData*)data;
-
-	return (v->First() == v && v != od->u && v != od->v) ? v : nullptr;
-}
-
 /**
  * Check if overtaking is possible on a piece of track
  *
@@ -840,8 +865,15 @@ static bool CheckRoadBlockedForOvertaking(OvertakeData *od)
 	/* Track does not continue along overtaking direction || track has junction || levelcrossing is barred */
 	if (!HasBit(trackdirbits, od->trackdir) || (trackbits & ~TRACK_BIT_CROSS) || (red_signals != TRACKDIR_BIT_NONE)) return true;
 
-	/* Are there more vehicles on the tile except the two vehicles involved in overtaking */
-	return HasVehicleOnPos(od->tile, VEH_ROAD, od, EnumFindVehBlockingOvertake);
+	/* Are there more vehicles on the tile except the two vehicles involved in overtaking, in any lane */
+	const RoadVehicleTileLanes *tile_lanes = GetRoadVehicleTileLanes(od->tile);
+	if (tile_lanes == nullptr) return false;
+	for (const RoadVehicleLane &lane : tile_lanes->lanes) {
+		for (const RoadVehicle *w = lane.first; w != nullptr; w = w->lane_next) {
+			if (w->tile == od->tile && w->First() == w && w != od->u && w != od->v) return true;
+		}
+	}
+	return false;
 }
 
 static void RoadVehCheckOvertake(RoadVehicle *v, RoadVehicle *u)
@@ -1567,6 +1599,7 @@ again:
 	Direction old_dir = v->direction;
 	if (new_dir != old_dir) {
 		v->direction = new_dir;
+		v->UpdatePosition();
 		if (_settings_game.vehicle.roadveh_acceleration_model == AM_ORIGINAL) v->cur_speed -= v->cur_speed >> 2;
 
 		/* Delay the vehicle in curves by making it require one additional frame per turning direction (two in total).
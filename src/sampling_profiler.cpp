@@ -0,0 +1,414 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file sampling_profiler.cpp Sampling profiler of the main thread, writing folded stacks.
+ *
+ * A CPU time timer of the main thread raises SIGPROF on that thread. The signal handler records
+ * the call stack and the format strings of the active SCOPE_INFO scopes in a lock-free sample ring.
+ * The main thread regularly moves the samples from the ring into a table counting each distinct
+ * stack, which is written as folded stacks, as read by flame graph tools. The scopes are written as
+ * the outermost frames, so the flame graph is split by what is being processed.
+ */
+
+#include "stdafx.h"
+#include "sampling_profiler.h"
+#include "debug.h"
+#include "core/math_func.hpp"
+#include "scope_info.h"
+#include "string_func.h"
+#include "thread.h"
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+
+#if defined(__linux__) && defined(__GLIBC__) && defined(WITH_SIGACTION) && !defined(NO_THREADS)
+#	define WITH_SAMPLING_PROFILER
+#	include <errno.h>
+#	include <signal.h>
+#	include <time.h>
+#	include <unistd.h>
+#	include <sys/syscall.h>
+#	include <execinfo.h>
+#	if defined(WITH_DL)
+#		include <dlfcn.h>
+#	endif
+#	if defined(WITH_DEMANGLE)
+#		include <cxxabi.h>
+#	endif
+#endif
+
+#include "safeguards.h"
+
+#ifdef WITH_SAMPLING_PROFILER
+
+static const uint PROFILER_MAX_FRAMES = 48;        ///< Maximum number of frames recorded per sample.
+static const uint PROFILER_RING_SIZE = 2048;       ///< Number of samples in #_profiler_ring, must be a power of 2.
+static const uint PROFILER_MAX_FREQUENCY = 10000;  ///< Maximum number of samples per second.
+
+#ifdef USE_SCOPE_INFO
+static const uint PROFILER_MAX_SCOPES = SCOPE_NAME_STACK_SIZE; ///< Maximum number of scopes recorded per sample.
+#else
+static const uint PROFILER_MAX_SCOPES = 1;
+#endif
+
+/** A call stack recorded by the signal handler. */
+struct ProfilerSample {
+	uint8 frames;                            ///< Number of entries in #pc.
+	uint8 scopes;                            ///< Number of entries in #scope.
+	void *pc[PROFILER_MAX_FRAMES];           ///< Program counters, innermost frame first.
+	const char *scope[PROFILER_MAX_SCOPES];  ///< Format strings of the active scopes, outermost first.
+};
+
+static ProfilerSample *_profiler_ring = nullptr;   ///< Samples not yet counted; never freed as a late signal may still write to it.
+static std::atomic<uint32> _profiler_head;         ///< Number of samples written to the ring, only changed by the signal handler.
+static std::atomic<uint32> _profiler_tail;         ///< Number of samples read from the ring, only changed by #ProcessSamplingProfiler.
+static std::atomic<uint32> _profiler_dropped;      ///< Number of samples dropped by the signal handler since they were last counted.
+static std::atomic<bool> _profiler_running;        ///< Whether the signal handler should record samples.
+static bool _profiler_handler_installed = false;   ///< Whether the SIGPROF handler is installed.
+static timer_t _profiler_timer;                    ///< CPU time timer of the main thread, if running.
+static uint _profiler_frequency = 0;               ///< Samples per second of the running timer.
+
+/**
+ * The key of a distinct stack: the scope format strings, outermost first, followed by
+ * a nullptr and the program counters, innermost first.
+ */
+typedef std::vector<const void *> ProfilerStackKey;
+static std::map<ProfilerStackKey, uint32> _profiler_stacks; ///< Number of samples per distinct stack.
+static uint64 _profiler_samples = 0;                        ///< Number of samples counted in #_profiler_stacks.
+static uint64 _profiler_total_dropped = 0;                  ///< Number of samples dropped since the last dump.
+
+/**
+ * Handler of SIGPROF, only raised on the main thread.
+ * This only takes a backtrace and copies the scope name stack, which the main thread keeps consistent
+ * at every point it can be interrupted. The backtrace is taken by the unwinder of libgcc, which is
+ * loaded before the timer is started, so it does not allocate.
+ */
+static void ProfilerSignalHandler(int sig, siginfo_t *info, void *context)
+{
+	if (!_profiler_running.load(std::memory_order_relaxed)) return;
+
+	const int saved_errno = errno;
+
+	const uint32 head = _profiler_head.load(std::memory_order_relaxed);
+	if (head - _profiler_tail.load(std::memory_order_acquire) >= PROFILER_RING_SIZE) {
+		_profiler_dropped.fetch_add(1, std::memory_order_relaxed);
+		errno = saved_errno;
+		return;
+	}
+
+	ProfilerSample &sample = _profiler_ring[head & (PROFILER_RING_SIZE - 1)];
+
+	/* Skip the frames of this handler and the signal trampoline. */
+	void *trace[PROFILER_MAX_FRAMES + 2];
+	const int frames = backtrace(trace, lengthof(trace));
+	sample.frames = (uint8)max(frames - 2, 0);
+	for (uint i = 0; i < sample.frames; i++) sample.pc[i] = trace[i + 2];
+
+	sample.scopes = 0;
+#ifdef USE_SCOPE_INFO
+	const uint depth = min<uint>(_scope_name_depth, PROFILER_MAX_SCOPES);
+	std::atomic_signal_fence(std::memory_order_acquire);
+	for (uint i = 0; i < depth; i++) sample.scope[i] = _scope_name_stack[i];
+	sample.scopes = (uint8)depth;
+#endif
+
+	_profiler_head.store(head + 1, std::memory_order_release);
+	errno = saved_errno;
+}
+
+bool IsSamplingProfilerSupported()
+{
+	return true;
+}
+
+/**
+ * Start sampling the call stack of the main thread. Must be called from the main thread.
+ * @param frequency Number of samples per second of CPU time used by the main thread.
+ *                  The kernel may limit the effective frequency to its timer tick rate.
+ * @return Whether the profiler is running.
+ */
+bool StartSamplingProfiler(uint frequency)
+{
+	assert(IsMainThread());
+	if (_profiler_running.load(std::memory_order_relaxed)) return true;
+
+	frequency = Clamp<uint>(frequency, 1, PROFILER_MAX_FREQUENCY);
+
+	if (_profiler_ring == nullptr) {
+		_profiler_ring = new ProfilerSample[PROFILER_RING_SIZE];
+		_profiler_head.store(0, std::memory_order_relaxed);
+		_profiler_tail.store(0, std::memory_order_relaxed);
+		_profiler_dropped.store(0, std::memory_order_relaxed);
+	}
+
+	/* The first backtrace loads the unwinder, which must not happen in the signal handler. */
+	void *warm_up[1];
+	backtrace(warm_up, lengthof(warm_up));
+
+	if (!_profiler_handler_installed) {
+		/* The handler is never uninstalled, as a signal may still be pending when the timer is deleted. */
+		struct sigaction sa;
+		memset(&sa, 0, sizeof(sa));
+		sa.sa_sigaction = ProfilerSignalHandler;
+		sa.sa_flags = SA_SIGINFO | SA_RESTART;
+		sigemptyset(&sa.sa_mask);
+		if (sigaction(SIGPROF, &sa, nullptr) != 0) {
+			DEBUG(misc, 0, "Sampling profiler: could not install the SIGPROF handler: %s", strerror(errno));
+			return false;
+		}
+		_profiler_handler_installed = true;
+	}
+
+	struct sigevent sev;
+	memset(&sev, 0, sizeof(sev));
+	sev.sigev_notify = SIGEV_THREAD_ID;
+	sev.sigev_signo = SIGPROF;
+#ifdef sigev_notify_thread_id
+	sev.sigev_notify_thread_id = (pid_t)syscall(SYS_gettid);
+#else
+	sev._sigev_un._tid = (pid_t)syscall(SYS_gettid);
+#endif
+	if (timer_create(CLOCK_THREAD_CPUTIME_ID, &sev, &_profiler_timer) != 0) {
+		DEBUG(misc, 0, "Sampling profiler: could not create the timer: %s", strerror(errno));
+		return false;
+	}
+
+	_profiler_running.store(true, std::memory_order_relaxed);
+
+	struct itimerspec spec;
+	spec.it_interval.tv_sec = 0;
+	spec.it_interval.tv_nsec = (long)(1000000000 / frequency);
+	if (frequency == 1) {
+		spec.it_interval.tv_sec = 1;
+		spec.it_interval.tv_nsec = 0;
+	}
+	spec.it_value = spec.it_interval;
+	if (timer_settime(_profiler_timer, 0, &spec, nullptr) != 0) {
+		DEBUG(misc, 0, "Sampling profiler: could not start the timer: %s", strerror(errno));
+		_profiler_running.store(false, std::memory_order_relaxed);
+		timer_delete(_profiler_timer);
+		return false;
+	}
+
+	_profiler_frequency = frequency;
+	DEBUG(misc, 1, "Sampling profiler: started at %u Hz", frequency);
+	return true;
+}
+
+/** Stop sampling the call stack of the main thread. The recorded samples are kept until the next dump. */
+void StopSamplingProfiler()
+{
+	if (!_profiler_running.load(std::memory_order_relaxed)) return;
+
+	timer_delete(_profiler_timer);
+	_profiler_running.store(false, std::memory_order_relaxed);
+	_profiler_frequency = 0;
+	ProcessSamplingProfiler();
+	DEBUG(misc, 1, "Sampling profiler: stopped");
+}
+
+/**
+ * Count the samples recorded by the signal handler. Must be called regularly by the main thread while the profiler is running.
+ */
+void ProcessSamplingProfiler()
+{
+	if (_profiler_ring == nullptr) return;
+
+	const uint32 head = _profiler_head.load(std::memory_order_acquire);
+	uint32 tail = _profiler_tail.load(std::memory_order_relaxed);
+	if (head != tail) {
+		ProfilerStackKey key;
+		for (; tail != head; tail++) {
+			const ProfilerSample &sample = _profiler_ring[tail & (PROFILER_RING_SIZE - 1)];
+			key.assign(sample.scope, sample.scope + sample.scopes);
+			key.push_back(nullptr);
+			key.insert(key.end(), sample.pc, sample.pc + sample.frames);
+			_profiler_stacks[key]++;
+			_profiler_samples++;
+		}
+		_profiler_tail.store(tail, std::memory_order_release);
+	}
+
+	_profiler_total_dropped += _profiler_dropped.exchange(0, std::memory_order_relaxed);
+}
+
+/**
+ * Append a frame name to a folded stack line. Semicolons separate the frames, so they are replaced.
+ * @param line The line to append to.
+ * @param name The frame name.
+ * @param length Length of the frame name.
+ * @param scope Whether the frame is a scope instead of a function, which is shown in brackets.
+ */
+static void AppendFoldedFrame(std::string &line, const char *name, size_t length, bool scope)
+{
+	if (!line.empty()) line += ';';
+	if (scope) line += '[';
+	for (size_t i = 0; i < length; i++) line += (name[i] == ';') ? ',' : name[i];
+	if (scope) line += ']';
+}
+
+/**
+ * Get the name of a scope from its format string, that is the first part up to any parameters.
+ * @param format The format string passed to SCOPE_INFO_FMT.
+ * @param[out] length Length of the name.
+ * @return Start of the name.
+ */
+static const char *GetProfilerScopeName(const char *format, size_t *length)
+{
+	/* "CallVehicleTicks: LoadUnloadStation: %s" becomes "CallVehicleTicks: LoadUnloadStation". */
+	const char *percent = strchr(format, '%');
+	size_t len = (percent != nullptr) ? percent - format : strlen(format);
+	while (len > 0 && (format[len - 1] == ' ' || format[len - 1] == ':')) len--;
+	*length = len;
+	return format;
+}
+
+/**
+ * Get the symbol name of a program counter.
+ * @param pc The program counter.
+ * @param return_address Whether this is the return address of a call, instead of the interrupted instruction.
+ * @param cache Cache of the symbol names.
+ * @return The name of the function, or the module and offset if unknown.
+ */
+static const std::string &GetProfilerSymbolName(const void *pc, bool return_address, std::map<const void *, std::string> &cache)
+{
+	/* Look up the call instruction, instead of the instruction after it, which may be in the next function. */
+	const void *addr = return_address ? (const char *)pc - 1 : pc;
+	auto iter = cache.find(addr);
+	if (iter != cache.end()) return iter->second;
+
+	std::string &name = cache[addr];
+#if defined(WITH_DL)
+	Dl_info info;
+	if (dladdr(addr, &info) != 0) {
+		if (info.dli_sname != nullptr) {
+			int status = -1;
+			char *demangled = nullptr;
+#if defined(WITH_DEMANGLE)
+			demangled = abi::__cxa_demangle(info.dli_sname, nullptr, 0, &status);
+#endif /* WITH_DEMANGLE */
+			name = (demangled != nullptr && status == 0) ? demangled : info.dli_sname;
+			free(demangled);
+			return name;
+		}
+		if (info.dli_fname != nullptr) {
+			const char *file = strrchr(info.dli_fname, '/');
+			char buf[64];
+			seprintf(buf, lastof(buf), "+0x" PRINTF_SIZEX, (size_t)((const char *)addr - (const char *)info.dli_fbase));
+			name = std::string(file != nullptr ? file + 1 : info.dli_fname) + buf;
+			return name;
+		}
+	}
+#endif /* WITH_DL */
+	char buf[32];
+	seprintf(buf, lastof(buf), "%p", addr);
+	name = buf;
+	return name;
+}
+
+/**
+ * Write the stacks recorded since the last dump as folded stacks, and start recording anew.
+ * @param filename File to write to.
+ * @return Whether the file could be written.
+ */
+bool DumpSamplingProfile(const char *filename)
+{
+	ProcessSamplingProfiler();
+
+	FILE *f = fopen(filename, "w");
+	if (f == nullptr) return false;
+
+	/* Different program counters in the same function give the same line. */
+	std::map<const void *, std::string> symbols;
+	std::map<std::string, uint64> lines;
+	std::string line;
+	for (const auto &it : _profiler_stacks) {
+		const ProfilerStackKey &key = it.first;
+		line.clear();
+
+		size_t separator = 0;
+		while (key[separator] != nullptr) {
+			size_t length;
+			const char *name = GetProfilerScopeName((const char *)key[separator], &length);
+			AppendFoldedFrame(line, name, length, true);
+			separator++;
+		}
+
+		/* Flame graph tools expect the outermost frame first. */
+		for (size_t i = key.size() - 1; i > separator; i--) {
+			const std::string &name = GetProfilerSymbolName(key[i], i != separator + 1, symbols);
+			AppendFoldedFrame(line, name.c_str(), name.size(), false);
+		}
+		lines[line] += it.second;
+	}
+
+	for (const auto &it : lines) {
+		fprintf(f, "%s " OTTD_PRINTF64U "\n", it.first.c_str(), it.second);
+	}
+
+	const bool ok = ferror(f) == 0;
+	fclose(f);
+
+	_profiler_stacks.clear();
+	_profiler_samples = 0;
+	_profiler_total_dropped = 0;
+	return ok;
+}
+
+/**
+ * Get the statistics of the sampling profiler.
+ * @return The statistics.
+ */
+SamplingProfilerStatus GetSamplingProfilerStatus()
+{
+	ProcessSamplingProfiler();
+
+	SamplingProfilerStatus status;
+	status.running = _profiler_running.load(std::memory_order_relaxed);
+	status.frequency = _profiler_frequency;
+	status.samples = _profiler_samples;
+	status.dropped = _profiler_total_dropped;
+	status.stacks = _profiler_stacks.size();
+	return status;
+}
+
+#else /* WITH_SAMPLING_PROFILER */
+
+bool IsSamplingProfilerSupported()
+{
+	return false;
+}
+
+bool StartSamplingProfiler(uint frequency)
+{
+	return false;
+}
+
+void StopSamplingProfiler()
+{
+}
+
+void ProcessSamplingProfiler()
+{
+}
+
+bool DumpSamplingProfile(const char *filename)
+{
+	return false;
+}
+
+SamplingProfilerStatus GetSamplingProfilerStatus()
+{
+	SamplingProfilerStatus status;
+	memset(&status, 0, sizeof(status));
+	return status;
+}
+
+#endif /* WITH_SAMPLING_PROFILER */
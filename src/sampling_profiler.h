@@ -0,0 +1,29 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file sampling_profiler.h Sampling profiler of the main thread, writing folded stacks. */
+
+#ifndef SAMPLING_PROFILER_H
+#define SAMPLING_PROFILER_H
+
+/** Statistics of the sampling profiler. */
+struct SamplingProfilerStatus {
+	bool running;       ///< Whether samples are currently being taken.
+	uint frequency;     ///< Number of samples taken per second of CPU time of the main thread, while running.
+	uint64 samples;     ///< Number of samples recorded since the last dump.
+	uint64 dropped;     ///< Number of samples dropped since the last dump, because the sample buffer was full.
+	size_t stacks;      ///< Number of distinct stacks recorded since the last dump.
+};
+
+bool IsSamplingProfilerSupported();
+bool StartSamplingProfiler(uint frequency);
+void StopSamplingProfiler();
+void ProcessSamplingProfiler();
+bool DumpSamplingProfile(const char *filename);
+SamplingProfilerStatus GetSamplingProfilerStatus();
+
+#endif /* SAMPLING_PROFILER_H */
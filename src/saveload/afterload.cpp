@@ -2444,24 +2444,10 @@ bool AfterLoadGame()
 
 	if (IsSavegameVersionBefore(SLV_122)) {
 		/* Animated tiles would sometimes not be actually animated or
-		 * in case of old savegames duplicate. */
-
-		extern std::vector<TileIndex> _animated_tiles;
-
-		for (auto tile = _animated_tiles.begin(); tile < _animated_tiles.end(); /* Nothing */) {
+		 * in case of old savegames duplicate. Duplicates are already dropped when loading. */
+		for (TileIndex tile : GetAnimatedTiles()) {
 			/* Remove if tile is not animated */
-			bool remove = _tile_type_procs[GetTileType(*tile)]->animate_tile_proc == nullptr;
-
-			/* and remove if duplicate */
-			for (auto j = _animated_tiles.begin(); !remove && j < tile; j++) {
-				remove = *tile == *j;
-			}
-
-			if (remove) {
-				DeleteAnimatedTile(*tile);
-			} else {
-				tile++;
-			}
+			if (_tile_type_procs[GetTileType(tile)]->animate_tile_proc == nullptr) DeleteAnimatedTile(tile);
 		}
 	}
 
@@ -3798,6 +3784,9 @@ bool AfterLoadGame()
 
 	UpdateAllVehiclesIsDrawn();
 
+	/* Level crossings may have been added or removed by the conversions above. */
+	RebuildLevelCrossingTrainCounts();
+
 	extern void YapfCheckRailSignalPenalties();
 	YapfCheckRailSignalPenalties();
 
@@ -3849,6 +3838,8 @@ void ReloadNewGRFData()
 	GroupStatistics::UpdateAfterLoad();
 	/* update station graphics */
 	AfterLoadStations();
+	/* the animation speeds of the tiles may have changed */
+	InvalidateAnimatedTileSpeeds();
 
 	RailType rail_type_translate_map[RAILTYPE_END];
 	for (RailType old_type = RAILTYPE_BEGIN; old_type != RAILTYPE_END; old_type++) {
@@ -9,6 +9,7 @@
 
 #include "../stdafx.h"
 #include "../tile_type.h"
+#include "../animated_tile_func.h"
 #include "../core/alloc_func.hpp"
 #include "../core/smallvec_type.hpp"
 
@@ -16,15 +17,14 @@
 
 #include "../safeguards.h"
 
-extern std::vector<TileIndex> _animated_tiles;
-
 /**
  * Save the ANIT chunk.
  */
 static void Save_ANIT()
 {
-	SlSetLength(_animated_tiles.size() * sizeof(_animated_tiles.front()));
-	SlArray(_animated_tiles.data(), _animated_tiles.size(), SLE_UINT32);
+	std::vector<TileIndex> animated_tiles = GetAnimatedTiles();
+	SlSetLength(animated_tiles.size() * sizeof(TileIndex));
+	SlArray(animated_tiles.data(), animated_tiles.size(), SLE_UINT32);
 }
 
 /**
@@ -38,17 +38,19 @@ static void Load_ANIT()
 		TileIndex anim_list[256];
 		SlArray(anim_list, 256, IsSavegameVersionBefore(SLV_6) ? (SLE_FILE_U16 | SLE_VAR_U32) : SLE_UINT32);
 
+		std::vector<TileIndex> animated_tiles;
 		for (int i = 0; i < 256; i++) {
 			if (anim_list[i] == 0) break;
-			_animated_tiles.push_back(anim_list[i]);
+			animated_tiles.push_back(anim_list[i]);
 		}
+		SetAnimatedTiles(animated_tiles);
 		return;
 	}
 
-	uint count = (uint)SlGetFieldLength() / sizeof(_animated_tiles.front());
-	_animated_tiles.clear();
-	_animated_tiles.resize(_animated_tiles.size() + count);
-	SlArray(_animated_tiles.data(), count, SLE_UINT32);
+	uint count = (uint)SlGetFieldLength() / sizeof(TileIndex);
+	std::vector<TileIndex> animated_tiles(count);
+	SlArray(animated_tiles.data(), count, SLE_UINT32);
+	SetAnimatedTiles(animated_tiles);
 }
 
 /**
@@ -112,6 +112,8 @@ const SlxiSubChunkInfo _sl_xv_sub_chunk_infos[] = {
 	{ XSLFI_DEBUG,                  XSCF_IGNORABLE_ALL,       1,   1, "debug",                     nullptr, nullptr, "DBGL"      },
 	{ XSLFI_FLOW_STAT_FLAGS,        XSCF_NULL,                1,   1, "flow_stat_flags",           nullptr, nullptr, nullptr        },
 	{ XSLFI_SPEED_RESTRICTION,      XSCF_NULL,                1,   1, "speed_restriction",         nullptr, nullptr, "VESR"         },
+	{ XSLFI_LINKGRAPH_INCREMENTAL,  XSCF_NULL,                2,   2, "linkgraph_incremental",     nullptr, nullptr, nullptr        },
+	{ XSLFI_LINKGRAPH_PARALLEL_DEMANDS,XSCF_NULL,             1,   1, "linkgraph_parallel_demands",nullptr, nullptr, nullptr        },
 	{ XSLFI_NULL, XSCF_NULL, 0, 0, nullptr, nullptr, nullptr, nullptr },// This is the end marker
 };
 
@@ -22,6 +22,7 @@ typedef LinkGraph::BaseEdge Edge;
 const SettingDesc *GetSettingDescription(uint index);
 
 static uint16 _num_nodes;
+static std::vector<uint32> _discarded_job_prior_flows;
 
 /**
  * Get a SaveLoad array for a link graph.
@@ -83,6 +84,7 @@ const SaveLoad *GetLinkGraphJobDesc()
 			SLE_VAR(LinkGraphJob, join_date_ticks,  SLE_INT32),
 			SLE_CONDVAR_X(LinkGraphJob, start_date_ticks,  SLE_INT32, SL_MIN_VERSION, SL_MAX_VERSION, SlXvFeatureTest(XSLFTO_AND, XSLFI_LINKGRAPH_DAY_SCALE)),
 			SLE_VAR(LinkGraphJob, link_graph.index, SLE_UINT16),
+			SLEG_GENERAL_X(SL_VARVEC, _discarded_job_prior_flows, SLE_UINT32, 0, SL_MIN_VERSION, SL_MAX_VERSION, SlXvFeatureTest(XSLFTO_AND, XSLFI_LINKGRAPH_INCREMENTAL, 1, 1)),
 			SLE_END()
 		};
 
@@ -120,6 +122,9 @@ static const SaveLoad _node_desc[] = {
 	    SLE_VAR(Node, demand,      SLE_UINT32),
 	    SLE_VAR(Node, station,     SLE_UINT16),
 	    SLE_VAR(Node, last_update, SLE_INT32),
+	SLE_CONDVAR_X(Node, solved.hash,     SLE_UINT32, SL_MIN_VERSION, SL_MAX_VERSION, SlXvFeatureTest(XSLFTO_AND, XSLFI_LINKGRAPH_INCREMENTAL)),
+	SLE_CONDVAR_X(Node, solved.capacity, SLE_UINT64, SL_MIN_VERSION, SL_MAX_VERSION, SlXvFeatureTest(XSLFTO_AND, XSLFI_LINKGRAPH_INCREMENTAL)),
+	SLE_CONDVAR_X(Node, solved.supply,   SLE_UINT64, SL_MIN_VERSION, SL_MAX_VERSION, SlXvFeatureTest(XSLFTO_AND, XSLFI_LINKGRAPH_INCREMENTAL)),
 	    SLE_END()
 };
 
@@ -136,6 +141,17 @@ static const SaveLoad _edge_desc[] = {
 	     SLE_END()
 };
 
+/**
+ * SaveLoad desc for a prior flow of a link graph.
+ */
+static const SaveLoad _prior_flow_desc[] = {
+	SLE_VAR(LinkGraph::PriorFlow, station, SLE_UINT16),
+	SLE_VAR(LinkGraph::PriorFlow, origin,  SLE_UINT16),
+	SLE_VAR(LinkGraph::PriorFlow, via,     SLE_UINT16),
+	SLE_VAR(LinkGraph::PriorFlow, flow,    SLE_UINT32),
+	SLE_END()
+};
+
 std::vector<SaveLoad> _filtered_node_desc;
 std::vector<SaveLoad> _filtered_edge_desc;
 std::vector<SaveLoad> _filtered_job_desc;
@@ -157,9 +173,19 @@ void Save_LinkGraph(LinkGraph &lg)
 	for (NodeID from = 0; from < size; ++from) {
 		Node *node = &lg.nodes[from];
 		SlObjectSaveFiltered(node, _filtered_node_desc.data());
-		/* ... but as that wasted a lot of space we save a sparse matrix now. */
-		for (NodeID to = from; to != INVALID_NODE; to = lg.edges[from][to].next_edge) {
-			SlObjectSaveFiltered(&lg.edges[from][to], _filtered_edge_desc.data());
+		/* ... but as that wasted a lot of space we save a sparse matrix now.
+		 * Read the edges through a const matrix, so that shared edges aren't copied. */
+		const Edge *edges = static_cast<const LinkGraph::EdgeMatrix &>(lg.edges)[from];
+		for (NodeID to = from; to != INVALID_NODE; to = edges[to].next_edge) {
+			SlObjectSaveFiltered(const_cast<Edge *>(&edges[to]), _filtered_edge_desc.data());
+		}
+	}
+
+	const LinkGraph::PriorFlowVector *prior_flows = lg.PriorFlows();
+	SlWriteUint32(prior_flows != nullptr ? (uint32)prior_flows->size() : 0);
+	if (prior_flows != nullptr) {
+		for (const LinkGraph::PriorFlow &prior : *prior_flows) {
+			SlObject(const_cast<LinkGraph::PriorFlow *>(&prior), _prior_flow_desc); // _prior_flow_desc has no conditionals
 		}
 	}
 }
@@ -186,6 +212,15 @@ void Load_LinkGraph(LinkGraph &lg)
 			}
 		}
 	}
+
+	if (SlXvIsFeaturePresent(XSLFI_LINKGRAPH_INCREMENTAL, 2)) {
+		uint32 count = SlReadUint32();
+		if (count > 0) {
+			auto prior_flows = std::make_shared<LinkGraph::PriorFlowVector>(count);
+			for (LinkGraph::PriorFlow &prior : *prior_flows) SlObject(&prior, _prior_flow_desc);
+			lg.SetPriorFlows(std::move(prior_flows));
+		}
+	}
 }
 
 /**
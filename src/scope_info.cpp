@@ -23,6 +23,8 @@
 #ifdef USE_SCOPE_INFO
 
 std::vector<std::function<int(char *, const char *)>> _scope_stack;
+const char *_scope_name_stack[SCOPE_NAME_STACK_SIZE];
+volatile uint _scope_name_depth = 0;
 
 int WriteScopeLog(char *buf, const char *last)
 {
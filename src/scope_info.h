@@ -12,6 +12,7 @@
 
 #include "tile_type.h"
 
+#include <atomic>
 #include <functional>
 #include <vector>
 
@@ -22,16 +23,33 @@ struct BaseStation;
 
 extern std::vector<std::function<int(char *, const char *)>> _scope_stack;
 
+static const uint SCOPE_NAME_STACK_SIZE = 16; ///< Number of scope format strings kept in #_scope_name_stack.
+
+/**
+ * The format strings of the innermost scopes of #_scope_stack, which unlike the scope stack itself
+ * can be read from a signal handler interrupting the main thread. Only the first
+ * #SCOPE_NAME_STACK_SIZE entries of a deeper stack are kept.
+ */
+extern const char *_scope_name_stack[SCOPE_NAME_STACK_SIZE];
+extern volatile uint _scope_name_depth; ///< Depth of the scope stack, may exceed #SCOPE_NAME_STACK_SIZE.
+
 struct scope_info_func_obj {
-	scope_info_func_obj(std::function<int(char *, const char *)> func)
+	scope_info_func_obj(const char *format, std::function<int(char *, const char *)> func)
 	{
 		_scope_stack.emplace_back(std::move(func));
+
+		const uint depth = _scope_name_depth;
+		if (depth < SCOPE_NAME_STACK_SIZE) _scope_name_stack[depth] = format;
+		std::atomic_signal_fence(std::memory_order_release);
+		_scope_name_depth = depth + 1;
 	}
 
 	scope_info_func_obj(const scope_info_func_obj &copysrc) = delete;
 
 	~scope_info_func_obj()
 	{
+		_scope_name_depth = _scope_name_depth - 1;
+		std::atomic_signal_fence(std::memory_order_release);
 		_scope_stack.pop_back();
 	}
 };
@@ -39,17 +57,21 @@ struct scope_info_func_obj {
 int WriteScopeLog(char *buf, const char *last);
 
 #define SCOPE_INFO_PASTE(a, b) a ## b
+#define SCOPE_INFO_EXPAND(x) x
+#define SCOPE_INFO_FORMAT_(format, ...) format
+#define SCOPE_INFO_FORMAT(...) SCOPE_INFO_EXPAND(SCOPE_INFO_FORMAT_(__VA_ARGS__, 0))
 
 /**
  * This creates a lambda in the current scope with the specified capture which outputs the given args as a format string.
  * This lambda is then captured by reference in a std::function which is pushed onto the scope stack
  * The scope stack is popped at the end of the scope
+ * The format string is also pushed onto the scope name stack, for use by the sampling profiler
  */
 #define SCOPE_INFO_FMT(capture, ...) \
 	auto SCOPE_INFO_PASTE(_sc_lm_, __LINE__) = capture (char *buf, const char *last) { \
 		return seprintf(buf, last, __VA_ARGS__); \
 	}; \
-	scope_info_func_obj SCOPE_INFO_PASTE(_sc_obj_, __LINE__) ([&](char *buf, const char *last) -> int { \
+	scope_info_func_obj SCOPE_INFO_PASTE(_sc_obj_, __LINE__) (SCOPE_INFO_FORMAT(__VA_ARGS__), [&](char *buf, const char *last) -> int { \
 		return SCOPE_INFO_PASTE(_sc_lm_, __LINE__) (buf, last); \
 	});
 
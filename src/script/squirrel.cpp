@@ -20,6 +20,7 @@
 #include <../squirrel/sqpcheader.h>
 #include <../squirrel/sqvm.h>
 #include "../core/alloc_func.hpp"
+#include "../memory_usage.h"
 
 #include "../safeguards.h"
 
@@ -48,6 +49,7 @@ struct ScriptAllocator {
 	{
 		void *p = MallocT<char>(size);
 		this->allocated_size += size;
+		AddMemoryUsage(MUC_SCRIPT, size);
 
 #ifdef SCRIPT_DEBUG_ALLOCATIONS
 		assert(p != nullptr);
@@ -77,6 +79,8 @@ struct ScriptAllocator {
 
 		this->allocated_size -= oldsize;
 		this->allocated_size += size;
+		RemoveMemoryUsage(MUC_SCRIPT, oldsize);
+		AddMemoryUsage(MUC_SCRIPT, size);
 
 #ifdef SCRIPT_DEBUG_ALLOCATIONS
 		assert(new_p != nullptr);
@@ -92,6 +96,7 @@ struct ScriptAllocator {
 		if (p == nullptr) return;
 		free(p);
 		this->allocated_size -= size;
+		RemoveMemoryUsage(MUC_SCRIPT, size);
 
 #ifdef SCRIPT_DEBUG_ALLOCATIONS
 		assert(this->allocations.at(p) == size);
@@ -66,6 +66,7 @@
 #include "string_func.h"
 #include "debug.h"
 #include "zoning.h"
+#include "viewport_func.h"
 
 #include "void_map.h"
 #include "station_base.h"
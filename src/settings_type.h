@@ -583,6 +583,7 @@ struct EconomySettings {
 	bool   infrastructure_maintenance;       ///< enable monthly maintenance fee for owner infrastructure
 	uint8  day_length_factor;                ///< factor which the length of day is multiplied
 	uint16 random_road_reconstruction;       ///< chance out of 1000 per tile loop for towns to start random road re-construction
+	bool   parallel_monthly_loops;           ///< update towns and industries at the start of a month in parallel, using a random stream per town/industry
 };
 
 struct LinkGraphSettings {
@@ -598,6 +599,8 @@ struct LinkGraphSettings {
 	uint8 demand_size;                          ///< influence of supply ("station size") on the demand function
 	uint8 demand_distance;                      ///< influence of distance between stations on the demand function
 	uint8 short_path_saturation;                ///< percentage up to which short paths are saturated before saturating most capacious paths
+	uint8 incremental_threshold;                ///< percentage by which the capacity or supply reachable from a node may change before its flows are recalculated, 0 to always recalculate
+	bool parallel_demands;                      ///< calculate the symmetric and asymmetric demands of large components in parallel partitions
 
 	inline DistributionType GetDistributionType(CargoID cargo) const {
 		if (this->distribution_per_cargo[cargo] != DT_PER_CARGO_DEFAULT) return this->distribution_per_cargo[cargo];
@@ -21,6 +21,8 @@
 #include "error.h"
 #include "infrastructure_func.h"
 
+#include <unordered_set>
+
 #include "safeguards.h"
 
 /// List of signals dependent upon this one
@@ -202,6 +204,29 @@ static SmallSet<DiagDirection, SIG_GLOB_SIZE> _globset("_globset"); ///< set of
 
 static uint _num_signals_evaluated; ///< Number of programmable pre-signals evaluated
 
+/** Addition to the signal buffer collected by a batch. */
+struct SignalBatchItem {
+	TileIndex tile;    ///< Tile to start at.
+	DiagDirection dir; ///< Side of the tile to start at.
+	Owner owner;       ///< Owner whose signals to update.
+};
+
+static uint _signal_batch_depth = 0;                       ///< Number of active signal buffer batches; additions are collected while non-zero
+static bool _signal_batch_flushing = false;                ///< Whether the collected batch is currently being flushed
+static std::vector<SignalBatchItem> _signal_batch;         ///< Additions collected by the active batch
+static std::unordered_set<uint64> _signal_batch_visited;   ///< Tile sides already searched while flushing the batch
+
+/**
+ * Remember that a tile side has been searched while flushing a batch,
+ * so collected additions starting at it do not need another search.
+ * @param tile tile
+ * @param dir side of the tile
+ */
+static inline void MarkSignalBatchVisited(TileIndex tile, DiagDirection dir)
+{
+	if (_signal_batch_flushing) _signal_batch_visited.insert((uint64)tile << 8 | dir);
+}
+
 /** Check whether there is a train on rail, not in a depot */
 static Vehicle *TrainOnTileEnum(Vehicle *v, void *)
 {
@@ -238,6 +263,8 @@ static inline bool CheckAddToTodoSet(TileIndex t1, DiagDirection d1, TileIndex t
 {
 	_globset.Remove(t1, d1); // it can be in Global but not in Todo
 	_globset.Remove(t2, d2); // remove in all cases
+	MarkSignalBatchVisited(t1, d1);
+	MarkSignalBatchVisited(t2, d2);
 
 	assert(!_tbdset.IsIn(t1, d1)); // it really shouldn't be there already
 
@@ -596,6 +623,8 @@ static inline void ResetSets()
 	_tbuset.Reset();
 	_tbdset.Reset();
 	_globset.Reset();
+	/* The aborted searches did not update their blocks. */
+	_signal_batch_visited.clear();
 }
 
 
@@ -657,6 +686,8 @@ static SigSegState UpdateSignalsInBuffer(Owner owner)
 					/* only add to set when there is some 'interesting' track */
 					_tbdset.Add(tile, dir);
 					_tbdset.Add(tile + TileOffsByDiagDir(dir), ReverseDiagDir(dir));
+					MarkSignalBatchVisited(tile, dir);
+					MarkSignalBatchVisited(tile + TileOffsByDiagDir(dir), ReverseDiagDir(dir));
 					break;
 				}
 				FALLTHROUGH;
@@ -737,14 +768,20 @@ void AddTrackToSignalBuffer(TileIndex tile, Track track, Owner owner)
 		DIAGDIR_SW, DIAGDIR_NW, DIAGDIR_NW, DIAGDIR_SW, DIAGDIR_NW, DIAGDIR_NE
 	};
 
+	DiagDirection wormhole_dir = IsTileType(tile, MP_TUNNELBRIDGE) ? GetTunnelBridgeDirection(tile) : INVALID_DIAGDIR;
+
+	if (_signal_batch_depth > 0) {
+		_signal_batch.push_back({ tile, _search_dir_1[track] == wormhole_dir ? INVALID_DIAGDIR : _search_dir_1[track], owner });
+		_signal_batch.push_back({ tile, _search_dir_2[track] == wormhole_dir ? INVALID_DIAGDIR : _search_dir_2[track], owner });
+		return;
+	}
+
 	/* do not allow signal updates for two companies in one run,
 	 * if these companies are not part of the same signal block */
 	assert(_globset.IsEmpty() || IsOneSignalBlock(owner, _last_owner));
 
 	_last_owner = owner;
 
-	DiagDirection wormhole_dir = IsTileType(tile, MP_TUNNELBRIDGE) ? GetTunnelBridgeDirection(tile) : INVALID_DIAGDIR;
-
 	auto add_dir = [&](DiagDirection dir) {
 		_globset.Add(tile, dir == wormhole_dir ? INVALID_DIAGDIR : dir);
 	};
@@ -768,6 +805,11 @@ void AddTrackToSignalBuffer(TileIndex tile, Track track, Owner owner)
  */
 void AddSideToSignalBuffer(TileIndex tile, DiagDirection side, Owner owner)
 {
+	if (_signal_batch_depth > 0) {
+		_signal_batch.push_back({ tile, side, owner });
+		return;
+	}
+
 	/* do not allow signal updates for two companies in one run,
 	 * if these companies are not part of the same signal block */
 	assert(_globset.IsEmpty() || IsOneSignalBlock(owner, _last_owner));
@@ -783,6 +825,66 @@ void AddSideToSignalBuffer(TileIndex tile, DiagDirection side, Owner owner)
 	}
 }
 
+/**
+ * Put the additions collected by the batch into the signal buffer and update the signals.
+ * Additions at tile sides that were already searched by a previous block search of
+ * this update are skipped, as that search would have removed them from the buffer too.
+ */
+static void UpdateSignalsOfBatch()
+{
+	_signal_batch_flushing = true;
+	for (const SignalBatchItem &item : _signal_batch) {
+		if (!_signal_batch_visited.insert((uint64)item.tile << 8 | item.dir).second) continue;
+		AddSideToSignalBuffer(item.tile, item.dir, item.owner);
+	}
+	UpdateSignalsInBuffer();
+	_signal_batch_flushing = false;
+
+	_signal_batch.clear();
+	_signal_batch_visited.clear();
+}
+
+/**
+ * Start collecting the additions to the signal buffer instead of adding them to it.
+ * Batches may be nested; the collected additions are processed when the outermost one finishes.
+ * @see SignalBufferBatch
+ */
+void StartSignalBufferBatch()
+{
+	_signal_batch_depth++;
+}
+
+/**
+ * Finish a batch started by #StartSignalBufferBatch. When it is the outermost batch,
+ * the collected additions are put into the signal buffer and the signals are updated.
+ * The signal states after this are the same as when the additions had been put into
+ * the buffer directly, as the states only depend on the final track layout and the
+ * (unchanged) trains in the blocks.
+ */
+void FinishSignalBufferBatch()
+{
+	assert(_signal_batch_depth > 0);
+	if (--_signal_batch_depth > 0 || _signal_batch.empty()) return;
+
+	UpdateSignalsOfBatch();
+}
+
+/**
+ * Update the signals of the additions collected by the active batch so far, so
+ * that e.g. a path can be reserved through the affected blocks in the middle of
+ * the batch. The batch stays active. Does nothing when there is no active batch.
+ */
+void FlushSignalBufferBatch()
+{
+	if (_signal_batch_depth == 0 || _signal_batch.empty()) return;
+
+	/* Additions made while updating must go to the buffer, not to the batch. */
+	uint depth = _signal_batch_depth;
+	_signal_batch_depth = 0;
+	UpdateSignalsOfBatch();
+	_signal_batch_depth = depth;
+}
+
 /**
  * Update signals, starting at one side of a tile
  * Will check tile next to this at opposite side too
@@ -138,5 +138,18 @@ void SetSignalsOnBothDir(TileIndex tile, Track track, Owner owner);
 void AddTrackToSignalBuffer(TileIndex tile, Track track, Owner owner);
 void AddSideToSignalBuffer(TileIndex tile, DiagDirection side, Owner owner);
 void UpdateSignalsInBuffer();
+void StartSignalBufferBatch();
+void FinishSignalBufferBatch();
+void FlushSignalBufferBatch();
+
+/**
+ * Collect the additions to the signal buffer made during its lifetime, and update
+ * the signals of all affected blocks once when it goes out of scope. Each block is
+ * searched only once, instead of once per buffer flush.
+ */
+struct SignalBufferBatch {
+	SignalBufferBatch() { StartSignalBufferBatch(); }
+	~SignalBufferBatch() { FinishSignalBufferBatch(); }
+};
 
 #endif /* SIGNAL_FUNC_H */
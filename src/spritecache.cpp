@@ -19,6 +19,8 @@
 #include "core/math_func.hpp"
 #include "core/mem_func.hpp"
 #include "scope_info.h"
+#include "memory_usage.h"
+#include "worker_thread.h"
 
 #include "table/sprites.h"
 #include "table/strings.h"
@@ -28,6 +30,7 @@
 
 #include <vector>
 #include <algorithm>
+#include <chrono>
 
 #include "safeguards.h"
 
@@ -36,6 +39,8 @@ uint _sprite_cache_size = 4;
 
 static size_t _spritecache_bytes_used = 0;
 
+bool _sprite_decoding_disabled = false; ///< Whether normal sprites are never decoded, as nothing is going to be drawn. See #GetRawSprite.
+
 PACK_N(class SpriteDataBuffer {
 	void *ptr = nullptr;
 	uint32 size = 0;
@@ -47,15 +52,32 @@ public:
 	void Allocate(uint32 size)
 	{
 		_spritecache_bytes_used -= this->size;
+		RemoveMemoryUsage(MUC_SPRITE_CACHE, this->size);
 		free(this->ptr);
 		this->ptr = MallocT<byte>(size);
 		this->size = size;
 		_spritecache_bytes_used += this->size;
+		AddMemoryUsage(MUC_SPRITE_CACHE, this->size);
+	}
+
+	/**
+	 * Take ownership of memory allocated with MallocT elsewhere, e.g. on another thread.
+	 * @param ptr The memory.
+	 * @param size Size of the memory.
+	 */
+	void Adopt(void *ptr, uint32 size)
+	{
+		this->Clear();
+		this->ptr = ptr;
+		this->size = size;
+		_spritecache_bytes_used += this->size;
+		AddMemoryUsage(MUC_SPRITE_CACHE, this->size);
 	}
 
 	void Clear()
 	{
 		_spritecache_bytes_used -= this->size;
+		RemoveMemoryUsage(MUC_SPRITE_CACHE, this->size);
 		free(this->ptr);
 		this->ptr = nullptr;
 		this->size = 0;
@@ -90,11 +112,12 @@ PACK_N(struct SpriteCache {
 	size_t file_pos;
 	SpriteDataBuffer buffer;
 	uint32 id;
-	uint32 lru;
+	uint32 clock_pos = UINT32_MAX; ///< Position of this entry in the eviction clock ring, UINT32_MAX if not in the ring.
 	uint16 file_slot;
 
 	/**
-	 * Bits 6 - 0:  SpriteType type  In some cases a single sprite is misused by two NewGRFs. Once as real sprite and once as recolour sprite. If the recolour sprite gets into the cache it might be drawn as real sprite which causes enormous trouble.
+	 * Bits 5 - 0:  SpriteType type  In some cases a single sprite is misused by two NewGRFs. Once as real sprite and once as recolour sprite. If the recolour sprite gets into the cache it might be drawn as real sprite which causes enormous trouble.
+	 * Bit      6:  bool referenced  True iff the sprite has been used since the eviction clock hand last passed it.
 	 * Bit      7:  bool warned      True iff the user has been warned about incorrect use of this sprite.
 	 */
 	byte type_field;
@@ -103,8 +126,10 @@ PACK_N(struct SpriteCache {
 
 	void *GetPtr() { return this->buffer.GetPtr(); }
 
-	SpriteType GetType() const { return (SpriteType) GB(this->type_field, 0, 7); }
-	void SetType(SpriteType type) { SB(this->type_field, 0, 7, type); }
+	SpriteType GetType() const { return (SpriteType) GB(this->type_field, 0, 6); }
+	void SetType(SpriteType type) { SB(this->type_field, 0, 6, type); }
+	bool GetReferenced() const { return GB(this->type_field, 6, 1); }
+	void SetReferenced(bool referenced) { SB(this->type_field, 6, 1, referenced ? 1 : 0); }
 	bool GetWarned() const { return GB(this->type_field, 7, 1); }
 	void SetWarned(bool warned) { SB(this->type_field, 7, 1, warned ? 1 : 0); }
 }, 4);
@@ -132,7 +157,64 @@ static SpriteCache *AllocateSpriteCache(uint index)
 	return GetSpriteCache(index);
 }
 
-static uint32 _sprite_lru_counter;
+/**
+ * Eviction clock ring: the IDs of all evictable sprites which are currently loaded.
+ * Touching a sprite only sets its referenced bit, eviction advances the clock hand
+ * over this ring giving referenced sprites a second chance, so both are O(1) amortised
+ * and never need to scan the whole of _spritecache.
+ */
+static std::vector<SpriteID> _sprite_clock;
+static uint32 _sprite_clock_hand = 0;
+
+/** Sprite cache hit/miss/eviction counters, reported under the sprite debug category. */
+static struct SpriteCacheStats {
+	uint64 hits;
+	uint64 misses;
+	uint64 evictions;
+	uint64 prefetched;
+} _sprite_cache_stats;
+
+/** Maximum number of pending prefetch requests per queue. */
+static const size_t MAX_SPRITE_PREFETCH_QUEUE = 4096;
+
+/** Number of sprites per worker thread which #ProcessSpritePrefetchQueue decodes at once. */
+static const uint SPRITE_PREFETCH_BATCH_PER_THREAD = 4;
+
+/** Sprites which are expected to be drawn soon, see #PrefetchSprite. */
+static struct {
+	std::vector<SpriteID> sprites; ///< The queued sprites.
+	size_t pos = 0;                ///< Next position to process in #sprites.
+} _sprite_prefetch_queues[SPQ_END];
+
+/**
+ * Add a newly loaded sprite cache entry to the eviction clock ring.
+ * @param sc Sprite cache entry.
+ * @param id Sprite ID of the entry.
+ */
+static void SpriteClockInsert(SpriteCache *sc, SpriteID id)
+{
+	assert(sc->clock_pos == UINT32_MAX);
+	sc->clock_pos = (uint32)_sprite_clock.size();
+	sc->SetReferenced(true);
+	_sprite_clock.push_back(id);
+}
+
+/**
+ * Remove a sprite cache entry from the eviction clock ring, if it is in it.
+ * @param sc Sprite cache entry.
+ */
+static void SpriteClockRemove(SpriteCache *sc)
+{
+	const uint32 pos = sc->clock_pos;
+	if (pos == UINT32_MAX) return;
+
+	/* Move the last entry into the vacated slot. */
+	const SpriteID last = _sprite_clock.back();
+	_sprite_clock[pos] = last;
+	_spritecache[last].clock_pos = pos;
+	_sprite_clock.pop_back();
+	sc->clock_pos = UINT32_MAX;
+}
 
 static void *AllocSprite(size_t mem_req);
 
@@ -637,13 +719,17 @@ bool LoadNextSprite(int load_index, uint file_slot, uint file_sprite_id, byte co
 	}
 
 	SpriteCache *sc = AllocateSpriteCache(load_index);
+	if (sc->clock_pos != UINT32_MAX) {
+		/* Discard any previously cached data for this slot, it belongs to the old sprite. */
+		SpriteClockRemove(sc);
+		sc->buffer.Clear();
+	}
 	sc->file_slot = file_slot;
 	sc->file_pos = file_pos;
 	if (data != nullptr) {
 		assert(data == _last_sprite_allocation.GetPtr());
 		sc->buffer = std::move(_last_sprite_allocation);
 	}
-	sc->lru = 0;
 	sc->id = file_sprite_id;
 	sc->SetType(type);
 	sc->SetWarned(false);
@@ -677,62 +763,41 @@ static size_t GetSpriteCacheUsage()
  */
 static void DeleteEntryFromSpriteCache(uint item)
 {
-	GetSpriteCache(item)->buffer.Clear();
+	SpriteCache *sc = GetSpriteCache(item);
+	SpriteClockRemove(sc);
+	sc->buffer.Clear();
 }
 
+/**
+ * Evict sprites from the cache using the clock algorithm until at least \a target bytes have been freed,
+ * or there is nothing left to evict.
+ * @param target Number of bytes to free.
+ */
 static void DeleteEntriesFromSpriteCache(size_t target)
 {
 	const size_t initial_in_use = GetSpriteCacheUsage();
-
-	struct SpriteInfo {
-		uint32 lru;
-		SpriteID id;
-		uint32 size;
-
-		bool operator<(const SpriteInfo &other) const
-		{
-			return this->lru < other.lru;
-		}
-	};
-	std::vector<SpriteInfo> candidates;
-	size_t candidate_bytes = 0;
-
-	auto push = [&](SpriteInfo info) {
-		candidates.push_back(info);
-		std::push_heap(candidates.begin(), candidates.end());
-		candidate_bytes += info.size;
-	};
-
-	auto pop = [&]() {
-		candidate_bytes -= candidates.front().size;
-		std::pop_heap(candidates.begin(), candidates.end());
-		candidates.pop_back();
-	};
-
-	SpriteID i = 0;
-	for (; i != _spritecache.size() && candidate_bytes < target; i++) {
-		SpriteCache *sc = GetSpriteCache(i);
-		if (sc->GetType() != ST_RECOLOUR && sc->GetPtr() != nullptr) {
-			push({ sc->lru, i, sc->buffer.GetSize() });
-			if (candidate_bytes >= target) break;
-		}
-	}
-	for (; i != _spritecache.size(); i++) {
-		SpriteCache *sc = GetSpriteCache(i);
-		if (sc->GetType() != ST_RECOLOUR && sc->GetPtr() != nullptr && sc->lru <= candidates.front().lru) {
-			push({ sc->lru, i, sc->buffer.GetSize() });
-			while (!candidates.empty() && candidate_bytes - candidates.front().size >= target) {
-				pop();
-			}
+	size_t deleted = 0;
+
+	/* Each step of the hand either clears a referenced bit or evicts an entry, so two full sweeps are sufficient. */
+	size_t steps = _sprite_clock.size() * 2;
+	while (initial_in_use - GetSpriteCacheUsage() < target && !_sprite_clock.empty() && steps-- > 0) {
+		if (_sprite_clock_hand >= _sprite_clock.size()) _sprite_clock_hand = 0;
+
+		const SpriteID id = _sprite_clock[_sprite_clock_hand];
+		SpriteCache *sc = GetSpriteCache(id);
+		if (sc->GetReferenced()) {
+			sc->SetReferenced(false);
+			_sprite_clock_hand++;
+		} else {
+			/* This moves the last entry in the ring under the hand, so do not advance. */
+			DeleteEntryFromSpriteCache(id);
+			deleted++;
 		}
 	}
+	_sprite_cache_stats.evictions += deleted;
 
-	for (auto &it : candidates) {
-		DeleteEntryFromSpriteCache(it.id);
-	}
-
-	DEBUG(sprite, 3, "DeleteEntriesFromSpriteCache, deleted: " PRINTF_SIZE ", freed: " PRINTF_SIZE ", in use: " PRINTF_SIZE " --> " PRINTF_SIZE ", delta: " PRINTF_SIZE ", requested: " PRINTF_SIZE,
-			candidates.size(), candidate_bytes, initial_in_use, GetSpriteCacheUsage(), initial_in_use - GetSpriteCacheUsage(), target);
+	DEBUG(sprite, 3, "DeleteEntriesFromSpriteCache, deleted: " PRINTF_SIZE ", freed: " PRINTF_SIZE ", in use: " PRINTF_SIZE " --> " PRINTF_SIZE ", requested: " PRINTF_SIZE,
+			deleted, initial_in_use - GetSpriteCacheUsage(), initial_in_use, GetSpriteCacheUsage(), target);
 }
 
 void IncreaseSpriteLRU()
@@ -743,23 +808,16 @@ void IncreaseSpriteLRU()
 		DeleteEntriesFromSpriteCache(_spritecache_bytes_used - target_size + 512 * 1024);
 	}
 
-	/* Increase all LRU values */
-	if (_sprite_lru_counter >= 0xC0000000) {
-		SpriteID i;
-
-		DEBUG(sprite, 3, "Fixing lru %u, inuse=" PRINTF_SIZE, _sprite_lru_counter, GetSpriteCacheUsage());
-
-		for (i = 0; i != _spritecache.size(); i++) {
-			SpriteCache *sc = GetSpriteCache(i);
-			if (sc->GetPtr() != nullptr) {
-				if (sc->lru > 0x80000000) {
-					sc->lru -= 0x80000000;
-				} else {
-					sc->lru = 0;
-				}
-			}
+	/* Periodically report and reset the cache statistics */
+	static uint stats_counter = 0;
+	if (++stats_counter >= 0x1000) {
+		stats_counter = 0;
+		const SpriteCacheStats &stats = _sprite_cache_stats;
+		if (stats.hits + stats.misses > 0) {
+			DEBUG(sprite, 4, "Sprite cache: hits: " OTTD_PRINTF64U ", misses: " OTTD_PRINTF64U " (%.2f%%), evictions: " OTTD_PRINTF64U ", prefetched: " OTTD_PRINTF64U ", loaded: " PRINTF_SIZE ", in use: " PRINTF_SIZE,
+					stats.hits, stats.misses, (100.0 * stats.misses) / (stats.hits + stats.misses), stats.evictions, stats.prefetched, _sprite_clock.size(), GetSpriteCacheUsage());
 		}
-		_sprite_lru_counter -= 0x80000000;
+		_sprite_cache_stats = {};
 	}
 }
 
@@ -815,6 +873,20 @@ static void *HandleInvalidSpriteRequest(SpriteID sprite, SpriteType requested, S
 	}
 }
 
+/**
+ * Read a sprite from disk and store it in the sprite cache.
+ * @param sc Sprite cache entry, which must not currently be loaded.
+ * @param sprite Sprite to read.
+ * @param type Expected sprite type.
+ */
+static void LoadSpriteIntoCache(SpriteCache *sc, SpriteID sprite, SpriteType type)
+{
+	void *ptr = ReadSprite(sc, sprite, type, AllocSprite);
+	assert(ptr == _last_sprite_allocation.GetPtr());
+	sc->buffer = std::move(_last_sprite_allocation);
+	if (type != ST_RECOLOUR) SpriteClockInsert(sc, sprite);
+}
+
 /**
  * Reads a sprite (from disk or sprite cache).
  * If the sprite is not available or of wrong type, a fallback sprite is returned.
@@ -839,17 +911,23 @@ void *GetRawSprite(SpriteID sprite, SpriteType type, AllocatorProc *allocator)
 
 	if (sc->GetType() != type) return HandleInvalidSpriteRequest(sprite, type, sc, allocator);
 
+	if (_sprite_decoding_disabled && type == ST_NORMAL && allocator == nullptr) {
+		/* Nothing gets drawn, so all normal sprites can share one empty sprite. */
+		static Sprite placeholder = { 1, 1, 0, 0 };
+		return &placeholder;
+	}
+
 	if (allocator == nullptr) {
 		/* Load sprite into/from spritecache */
 
-		/* Update LRU */
-		sc->lru = ++_sprite_lru_counter;
-
-		/* Load the sprite, if it is not loaded, yet */
-		if (sc->GetPtr() == nullptr) {
-			void *ptr = ReadSprite(sc, sprite, type, AllocSprite);
-			assert(ptr == _last_sprite_allocation.GetPtr());
-			sc->buffer = std::move(_last_sprite_allocation);
+		if (sc->GetPtr() != nullptr) {
+			/* Mark as recently used */
+			_sprite_cache_stats.hits++;
+			sc->SetReferenced(true);
+		} else {
+			/* Load the sprite, if it is not loaded, yet */
+			_sprite_cache_stats.misses++;
+			LoadSpriteIntoCache(sc, sprite, type);
 		}
 
 		return sc->GetPtr();
@@ -859,6 +937,183 @@ void *GetRawSprite(SpriteID sprite, SpriteType type, AllocatorProc *allocator)
 	}
 }
 
+/**
+ * Queue a normal sprite which is expected to be drawn soon for loading into the sprite cache,
+ * so that it can be decoded ahead of time by #ProcessSpritePrefetchQueue instead of in the frame which first draws it.
+ * Sprites which are already cached, or which do not exist, are ignored.
+ * @param sprite Sprite to prefetch.
+ * @param queue Queue to add the sprite to.
+ */
+void PrefetchSprite(SpriteID sprite, SpritePrefetchQueue queue)
+{
+	if (_sprite_decoding_disabled || !SpriteExists(sprite)) return;
+
+	SpriteCache *sc = GetSpriteCache(sprite);
+	if (sc->GetType() != ST_NORMAL || sc->GetPtr() != nullptr) return;
+
+	auto &q = _sprite_prefetch_queues[queue];
+	if (!q.sprites.empty() && q.sprites.back() == sprite) return;
+	if (q.sprites.size() - q.pos >= MAX_SPRITE_PREFETCH_QUEUE) {
+		/* The area which comes into view when zooming out is queued in one go, so keep its first part. */
+		if (queue == SPQ_ADJACENT_ZOOM) return;
+
+		/* If loading cannot keep up with scrolling, the oldest requests are for areas which have already been drawn. */
+		ClearSpritePrefetchQueue(queue);
+	}
+
+	q.sprites.push_back(sprite);
+}
+
+/**
+ * Discard the queued prefetch requests of a queue.
+ * @param queue The queue.
+ */
+void ClearSpritePrefetchQueue(SpritePrefetchQueue queue)
+{
+	_sprite_prefetch_queues[queue].sprites.clear();
+	_sprite_prefetch_queues[queue].pos = 0;
+}
+
+/**
+ * Discard all queued prefetch requests.
+ */
+void ClearSpritePrefetchQueue()
+{
+	for (SpritePrefetchQueue queue = SPQ_SCROLL; queue != SPQ_END; queue = (SpritePrefetchQueue)(queue + 1)) {
+		ClearSpritePrefetchQueue(queue);
+	}
+}
+
+/**
+ * Take the next sprite to prefetch, from the queue with the highest priority.
+ * @param[out] sprite The sprite.
+ * @return False if all queues are empty.
+ */
+static bool PopSpritePrefetch(SpriteID *sprite)
+{
+	for (auto &q : _sprite_prefetch_queues) {
+		if (q.pos < q.sprites.size()) {
+			*sprite = q.sprites[q.pos++];
+			if (q.pos == q.sprites.size()) {
+				q.sprites.clear();
+				q.pos = 0;
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+/** Sprite which is prefetched by #ProcessSpritePrefetchQueue. */
+struct StagedSprite {
+	SpriteID sprite;         ///< The sprite.
+	uint file_slot;          ///< GRF the sprite is in.
+	uint32 id;               ///< Sprite number in the GRF.
+	byte container_ver;      ///< Container version of the GRF.
+	GrfSpriteData staged;    ///< Data of the sprite read from the GRF.
+	void *data = nullptr;    ///< The decoded sprite, or nullptr if it has to be loaded from the file instead.
+	uint32 size = 0;         ///< Size of #data.
+};
+
+static thread_local StagedSprite *_staged_sprite_allocation_target = nullptr; ///< Sprite which #AllocStagedSprite allocates for on the current thread.
+
+/**
+ * Allocator for sprites decoded by #DecodeStagedSprite.
+ * The memory is only accounted to the sprite cache once the main thread inserts it.
+ */
+static void *AllocStagedSprite(size_t mem_req)
+{
+	StagedSprite *s = _staged_sprite_allocation_target;
+	assert(s != nullptr && s->data == nullptr);
+	s->data = MallocT<byte>(mem_req);
+	s->size = (uint32)mem_req;
+	return s->data;
+}
+
+/**
+ * Decode a staged sprite like #ReadSprite does for a normal sprite, without accessing any files or the sprite cache.
+ * This is called on worker threads. Sprites with problems, or which need a fallback sprite, are left to be loaded from the file.
+ * @param s The sprite.
+ */
+static void DecodeStagedSprite(StagedSprite *s)
+{
+	SpriteLoader::Sprite sprite[ZOOM_LVL_COUNT];
+	uint8 sprite_avail = 0;
+	sprite[ZOOM_LVL_NORMAL].type = ST_NORMAL;
+
+	SpriteLoaderGrf sprite_loader(s->container_ver, &s->staged);
+	if (BlitterFactory::GetCurrentBlitter()->GetScreenDepth() == 32) {
+		/* Try for 32bpp sprites first. */
+		sprite_avail = sprite_loader.LoadSprite(sprite, s->file_slot, s->staged.file_pos, ST_NORMAL, true);
+	}
+	if (sprite_avail == 0 && !sprite_loader.needs_file) {
+		sprite_avail = sprite_loader.LoadSprite(sprite, s->file_slot, s->staged.file_pos, ST_NORMAL, false);
+	}
+
+	if (sprite_avail == 0 || sprite_loader.needs_file) return;
+	if (!ResizeSprites(sprite, sprite_avail, s->file_slot, s->id)) return;
+
+	_staged_sprite_allocation_target = s;
+	BlitterFactory::GetCurrentBlitter()->Encode(sprite, AllocStagedSprite);
+	_staged_sprite_allocation_target = nullptr;
+}
+
+/**
+ * Load queued prefetch sprites into the sprite cache, until the queues are empty or the time budget is used up.
+ * This is called by the video drivers in the idle time between frames, instead of sleeping.
+ *
+ * The sprites are handled in batches: their data is read from the GRFs on this thread, as the file IO is not
+ * thread-safe, then decoded on worker threads into staging buffers, and finally inserted into the cache on this thread.
+ * Sprites which cannot be decoded from the staged data alone are loaded as usual.
+ * Prefetched sprites are loaded with all their zoom levels, so no further loading is required when zooming in or out.
+ * @param budget_us Time budget in microseconds.
+ * @return True if any queued sprites were processed, false if the queues were empty.
+ */
+bool ProcessSpritePrefetchQueue(uint budget_us)
+{
+	SpriteID sprite;
+	if (!PopSpritePrefetch(&sprite)) return false;
+
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(budget_us);
+	const size_t batch_size = GetWorkerThreadCount() * SPRITE_PREFETCH_BATCH_PER_THREAD;
+	std::vector<StagedSprite> batch;
+	bool more = true;
+	do {
+		batch.clear();
+		do {
+			/* The queues may contain duplicates, or sprites which have been loaded by drawing in the meantime. */
+			SpriteCache *sc = GetSpriteCache(sprite);
+			if (sc->GetType() != ST_NORMAL || sc->GetPtr() != nullptr) continue;
+			if (std::any_of(batch.begin(), batch.end(), [&](const StagedSprite &s) { return s.sprite == sprite; })) continue;
+
+			batch.emplace_back();
+			StagedSprite &s = batch.back();
+			s.sprite = sprite;
+			s.file_slot = sc->file_slot;
+			s.id = sc->id;
+			s.container_ver = sc->container_ver;
+			if (!ReadGrfSpriteData(&s.staged, sc->file_slot, sc->file_pos, sc->container_ver)) s.staged.data.clear();
+		} while (batch.size() < batch_size && (more = PopSpritePrefetch(&sprite)));
+
+		RunParallelTasks((uint)batch.size(), [&](uint i) {
+			if (!batch[i].staged.data.empty()) DecodeStagedSprite(&batch[i]);
+		});
+
+		for (StagedSprite &s : batch) {
+			SpriteCache *sc = GetSpriteCache(s.sprite);
+			if (s.data != nullptr) {
+				sc->buffer.Adopt(s.data, s.size);
+				SpriteClockInsert(sc, s.sprite);
+			} else {
+				LoadSpriteIntoCache(sc, s.sprite, ST_NORMAL);
+			}
+			_sprite_cache_stats.prefetched++;
+		}
+	} while (more && std::chrono::steady_clock::now() < deadline && (more = PopSpritePrefetch(&sprite)));
+
+	return true;
+}
+
 /**
  * Reads a sprite and finds its most representative colour.
  * @param sprite Sprite to read.
@@ -960,6 +1215,9 @@ void GfxInitSpriteMem()
 {
 	/* Reset the spritecache 'pool' */
 	_spritecache.clear();
+	ClearSpritePrefetchQueue();
+	_sprite_clock.clear();
+	_sprite_clock_hand = 0;
 	assert(_spritecache_bytes_used == 0);
 }
 
@@ -969,6 +1227,8 @@ void GfxInitSpriteMem()
  */
 void GfxClearSpriteCache()
 {
+	ClearSpritePrefetchQueue();
+
 	/* Clear sprite ptr for all cached items */
 	for (uint i = 0; i != _spritecache.size(); i++) {
 		SpriteCache *sc = GetSpriteCache(i);
@@ -976,4 +1236,4 @@ void GfxClearSpriteCache()
 	}
 }
 
-/* static */ ReusableBuffer<SpriteLoader::CommonPixel> SpriteLoader::Sprite::buffer[ZOOM_LVL_COUNT];
+/* static */ thread_local ReusableBuffer<SpriteLoader::CommonPixel> SpriteLoader::Sprite::buffer[ZOOM_LVL_COUNT];
@@ -22,6 +22,7 @@ struct Sprite {
 };
 
 extern uint _sprite_cache_size;
+extern bool _sprite_decoding_disabled;
 
 typedef void *AllocatorProc(size_t size);
 
@@ -51,6 +52,18 @@ void GfxInitSpriteMem();
 void GfxClearSpriteCache();
 void IncreaseSpriteLRU();
 
+/** Queues of sprites to prefetch into the sprite cache, in order of priority. */
+enum SpritePrefetchQueue {
+	SPQ_SCROLL,        ///< Sprites of the areas about to be scrolled into view.
+	SPQ_ADJACENT_ZOOM, ///< Sprites of the area which comes into view when zooming out.
+	SPQ_END,           ///< End marker.
+};
+
+void PrefetchSprite(SpriteID sprite, SpritePrefetchQueue queue = SPQ_SCROLL);
+void ClearSpritePrefetchQueue();
+void ClearSpritePrefetchQueue(SpritePrefetchQueue queue);
+bool ProcessSpritePrefetchQueue(uint budget_us);
+
 void ReadGRFSpriteOffsets(byte container_version);
 size_t GetGRFSpriteOffset(uint32 id);
 bool LoadNextSprite(int load_index, uint file_index, uint file_sprite_id, byte container_version);
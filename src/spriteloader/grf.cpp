@@ -52,8 +52,98 @@ static bool WarnCorruptSprite(uint file_slot, size_t file_pos, int line)
 	return false;
 }
 
+/** Reader of sprite data from the GRF files opened by the file IO, see #FioSeekToFile. */
+struct FioSpriteReader {
+	void SeekToFile(uint file_slot, size_t pos) { FioSeekToFile(file_slot, pos); }
+	size_t GetPos() const { return FioGetPos(); }
+	byte ReadByte() { return FioReadByte(); }
+	uint16 ReadWord() { return FioReadWord(); }
+	uint32 ReadDword() { return FioReadDword(); }
+	void SkipBytes(int n) { FioSkipBytes(n); }
+
+	/**
+	 * Check whether problems with the sprite can be reported while reading it.
+	 * @return Always true.
+	 */
+	bool CanReport() { return true; }
+};
+
+/**
+ * Reader of sprite data staged in memory by #ReadGrfSpriteData.
+ * It only touches its own state, so several can be used at the same time on different threads.
+ */
+struct StagedSpriteReader {
+	const GrfSpriteData &staged; ///< The data to read.
+	size_t pos;                  ///< Current position in the data.
+	bool needs_file;             ///< Set when something outside the staged data was read, or a problem would have been reported.
+
+	StagedSpriteReader(const GrfSpriteData &staged) : staged(staged), pos(0), needs_file(false) {}
+
+	void SeekToFile(uint file_slot, size_t pos)
+	{
+		if (pos < this->staged.file_pos) this->needs_file = true;
+		this->pos = pos - this->staged.file_pos;
+	}
+
+	size_t GetPos() const { return this->staged.file_pos + this->pos; }
+
+	byte ReadByte()
+	{
+		if (this->pos >= this->staged.data.size()) {
+			this->needs_file = true;
+			return 0;
+		}
+		return this->staged.data[this->pos++];
+	}
+
+	uint16 ReadWord()
+	{
+		byte b = this->ReadByte();
+		return (this->ReadByte() << 8) | b;
+	}
+
+	uint32 ReadDword()
+	{
+		uint b = this->ReadWord();
+		return (this->ReadWord() << 16) | b;
+	}
+
+	void SkipBytes(int n)
+	{
+		if (n < 0 || this->pos + n > this->staged.data.size()) this->needs_file = true;
+		this->pos += n;
+	}
+
+	/**
+	 * Check whether problems with the sprite can be reported while reading it.
+	 * Reporting is not thread-safe, so instead the sprite is marked to be loaded from the file, which reports them.
+	 * @return Always false.
+	 */
+	bool CanReport()
+	{
+		this->needs_file = true;
+		return false;
+	}
+};
+
+/**
+ * Report a corrupted sprite, if the reader allows it.
+ * @param reader Reader of the sprite data.
+ * @param file_slot the file the errored sprite is in
+ * @param file_pos the location in the file of the errored sprite
+ * @param line the line where the error occurs.
+ * @return always false (to tell loading the sprite failed)
+ */
+template <class T>
+static bool WarnCorruptSprite(T &reader, uint file_slot, size_t file_pos, int line)
+{
+	if (!reader.CanReport()) return false;
+	return WarnCorruptSprite(file_slot, file_pos, line);
+}
+
 /**
  * Decode the image data of a single sprite.
+ * @param reader Reader of the sprite data.
  * @param[in,out] sprite Filled with the sprite image data.
  * @param file_slot File slot.
  * @param file_pos File position.
@@ -65,7 +155,8 @@ static bool WarnCorruptSprite(uint file_slot, size_t file_pos, int line)
  * @param container_format Container format of the GRF this sprite is in.
  * @return True if the sprite was successfully loaded.
  */
-bool DecodeSingleSprite(SpriteLoader::Sprite *sprite, uint file_slot, size_t file_pos, SpriteType sprite_type, int64 num, byte type, ZoomLevel zoom_lvl, byte colour_fmt, byte container_format)
+template <class T>
+static bool DecodeSingleSprite(T &reader, SpriteLoader::Sprite *sprite, uint file_slot, size_t file_pos, SpriteType sprite_type, int64 num, byte type, ZoomLevel zoom_lvl, byte colour_fmt, byte container_format)
 {
 	std::unique_ptr<byte[]> dest_orig(new byte[num]);
 	byte *dest = dest_orig.get();
@@ -73,24 +164,24 @@ bool DecodeSingleSprite(SpriteLoader::Sprite *sprite, uint file_slot, size_t fil
 
 	/* Read the file, which has some kind of compression */
 	while (num > 0) {
-		int8 code = FioReadByte();
+		int8 code = reader.ReadByte();
 
 		if (code >= 0) {
 			/* Plain bytes to read */
 			int size = (code == 0) ? 0x80 : code;
 			num -= size;
-			if (num < 0) return WarnCorruptSprite(file_slot, file_pos, __LINE__);
+			if (num < 0) return WarnCorruptSprite(reader, file_slot, file_pos, __LINE__);
 			for (; size > 0; size--) {
-				*dest = FioReadByte();
+				*dest = reader.ReadByte();
 				dest++;
 			}
 		} else {
 			/* Copy bytes from earlier in the sprite */
-			const uint data_offset = ((code & 7) << 8) | FioReadByte();
-			if (dest - data_offset < dest_orig.get()) return WarnCorruptSprite(file_slot, file_pos, __LINE__);
+			const uint data_offset = ((code & 7) << 8) | reader.ReadByte();
+			if (dest - data_offset < dest_orig.get()) return WarnCorruptSprite(reader, file_slot, file_pos, __LINE__);
 			int size = -(code >> 3);
 			num -= size;
-			if (num < 0) return WarnCorruptSprite(file_slot, file_pos, __LINE__);
+			if (num < 0) return WarnCorruptSprite(reader, file_slot, file_pos, __LINE__);
 			for (; size > 0; size--) {
 				*dest = *(dest - data_offset);
 				dest++;
@@ -98,7 +189,7 @@ bool DecodeSingleSprite(SpriteLoader::Sprite *sprite, uint file_slot, size_t fil
 		}
 	}
 
-	if (num != 0) return WarnCorruptSprite(file_slot, file_pos, __LINE__);
+	if (num != 0) return WarnCorruptSprite(reader, file_slot, file_pos, __LINE__);
 
 	sprite->AllocateData(zoom_lvl, sprite->width * sprite->height);
 
@@ -125,7 +216,7 @@ bool DecodeSingleSprite(SpriteLoader::Sprite *sprite, uint file_slot, size_t fil
 
 			do {
 				if (dest + (container_format >= 2 && sprite->width > 256 ? 4 : 2) > dest_orig.get() + dest_size) {
-					return WarnCorruptSprite(file_slot, file_pos, __LINE__);
+					return WarnCorruptSprite(reader, file_slot, file_pos, __LINE__);
 				}
 
 				SpriteLoader::CommonPixel *data;
@@ -151,7 +242,7 @@ bool DecodeSingleSprite(SpriteLoader::Sprite *sprite, uint file_slot, size_t fil
 				data = &sprite->data[y * sprite->width + skip];
 
 				if (skip + length > sprite->width || dest + length * bpp > dest_orig.get() + dest_size) {
-					return WarnCorruptSprite(file_slot, file_pos, __LINE__);
+					return WarnCorruptSprite(reader, file_slot, file_pos, __LINE__);
 				}
 
 				for (int x = 0; x < length; x++) {
@@ -177,10 +268,11 @@ bool DecodeSingleSprite(SpriteLoader::Sprite *sprite, uint file_slot, size_t fil
 		}
 	} else {
 		if (dest_size < sprite->width * sprite->height * bpp) {
-			return WarnCorruptSprite(file_slot, file_pos, __LINE__);
+			return WarnCorruptSprite(reader, file_slot, file_pos, __LINE__);
 		}
 
 		if (dest_size > sprite->width * sprite->height * bpp) {
+			if (!reader.CanReport()) return false;
 			static byte warning_level = 0;
 			DEBUG(sprite, warning_level, "Ignoring " OTTD_PRINTF64 " unused extra bytes from the sprite from %s at position %i", dest_size - sprite->width * sprite->height * bpp, FioGetFilename(file_slot), (int)file_pos);
 			warning_level = 6;
@@ -213,30 +305,31 @@ bool DecodeSingleSprite(SpriteLoader::Sprite *sprite, uint file_slot, size_t fil
 	return true;
 }
 
-uint8 LoadSpriteV1(SpriteLoader::Sprite *sprite, uint file_slot, size_t file_pos, SpriteType sprite_type, bool load_32bpp)
+template <class T>
+static uint8 LoadSpriteV1(T &reader, SpriteLoader::Sprite *sprite, uint file_slot, size_t file_pos, SpriteType sprite_type, bool load_32bpp)
 {
 	/* Check the requested colour depth. */
 	if (load_32bpp) return 0;
 
 	/* Open the right file and go to the correct position */
-	FioSeekToFile(file_slot, file_pos);
+	reader.SeekToFile(file_slot, file_pos);
 
 	/* Read the size and type */
-	int num = FioReadWord();
-	byte type = FioReadByte();
+	int num = reader.ReadWord();
+	byte type = reader.ReadByte();
 
 	/* Type 0xFF indicates either a colourmap or some other non-sprite info; we do not handle them here */
 	if (type == 0xFF) return 0;
 
 	ZoomLevel zoom_lvl = (sprite_type != ST_MAPGEN) ? ZOOM_LVL_OUT_4X : ZOOM_LVL_NORMAL;
 
-	sprite[zoom_lvl].height = FioReadByte();
-	sprite[zoom_lvl].width  = FioReadWord();
-	sprite[zoom_lvl].x_offs = FioReadWord();
-	sprite[zoom_lvl].y_offs = FioReadWord();
+	sprite[zoom_lvl].height = reader.ReadByte();
+	sprite[zoom_lvl].width  = reader.ReadWord();
+	sprite[zoom_lvl].x_offs = reader.ReadWord();
+	sprite[zoom_lvl].y_offs = reader.ReadWord();
 
 	if (sprite[zoom_lvl].width > INT16_MAX) {
-		WarnCorruptSprite(file_slot, file_pos, __LINE__);
+		WarnCorruptSprite(reader, file_slot, file_pos, __LINE__);
 		return 0;
 	}
 
@@ -244,16 +337,17 @@ uint8 LoadSpriteV1(SpriteLoader::Sprite *sprite, uint file_slot, size_t file_pos
 	 * In case it is uncompressed, the size is 'num' - 8 (header-size). */
 	num = (type & 0x02) ? sprite[zoom_lvl].width * sprite[zoom_lvl].height : num - 8;
 	if (num < 0) {
-		WarnCorruptSprite(file_slot, file_pos, __LINE__);
+		WarnCorruptSprite(reader, file_slot, file_pos, __LINE__);
 		return 0;
 	}
 
-	if (DecodeSingleSprite(&sprite[zoom_lvl], file_slot, file_pos, sprite_type, num, type, zoom_lvl, SCC_PAL, 1)) return 1 << zoom_lvl;
+	if (DecodeSingleSprite(reader, &sprite[zoom_lvl], file_slot, file_pos, sprite_type, num, type, zoom_lvl, SCC_PAL, 1)) return 1 << zoom_lvl;
 
 	return 0;
 }
 
-uint8 LoadSpriteV2(SpriteLoader::Sprite *sprite, uint file_slot, size_t file_pos, SpriteType sprite_type, bool load_32bpp)
+template <class T>
+static uint8 LoadSpriteV2(T &reader, SpriteLoader::Sprite *sprite, uint file_slot, size_t file_pos, SpriteType sprite_type, bool load_32bpp)
 {
 	static const ZoomLevel zoom_lvl_map[6] = {ZOOM_LVL_OUT_4X, ZOOM_LVL_NORMAL, ZOOM_LVL_OUT_2X, ZOOM_LVL_OUT_8X, ZOOM_LVL_OUT_16X, ZOOM_LVL_OUT_32X};
 
@@ -261,39 +355,40 @@ uint8 LoadSpriteV2(SpriteLoader::Sprite *sprite, uint file_slot, size_t file_pos
 	if (file_pos == SIZE_MAX) return 0;
 
 	/* Open the right file and go to the correct position */
-	FioSeekToFile(file_slot, file_pos);
+	reader.SeekToFile(file_slot, file_pos);
 
-	uint32 id = FioReadDword();
+	uint32 id = reader.ReadDword();
 
 	uint8 loaded_sprites = 0;
 	do {
-		int64 num = FioReadDword();
-		size_t start_pos = FioGetPos();
-		byte type = FioReadByte();
+		int64 num = reader.ReadDword();
+		size_t start_pos = reader.GetPos();
+		byte type = reader.ReadByte();
 
 		/* Type 0xFF indicates either a colourmap or some other non-sprite info; we do not handle them here. */
 		if (type == 0xFF) return 0;
 
 		byte colour = type & SCC_MASK;
-		byte zoom = FioReadByte();
+		byte zoom = reader.ReadByte();
 
 		if (colour != 0 && (load_32bpp ? colour != SCC_PAL : colour == SCC_PAL) && (sprite_type != ST_MAPGEN ? zoom < lengthof(zoom_lvl_map) : zoom == 0)) {
 			ZoomLevel zoom_lvl = (sprite_type != ST_MAPGEN) ? zoom_lvl_map[zoom] : ZOOM_LVL_NORMAL;
 
 			if (HasBit(loaded_sprites, zoom_lvl)) {
 				/* We already have this zoom level, skip sprite. */
+				if (!reader.CanReport()) return 0;
 				DEBUG(sprite, 1, "Ignoring duplicate zoom level sprite %u from %s", id, FioGetFilename(file_slot));
-				FioSkipBytes(num - 2);
+				reader.SkipBytes(num - 2);
 				continue;
 			}
 
-			sprite[zoom_lvl].height = FioReadWord();
-			sprite[zoom_lvl].width  = FioReadWord();
-			sprite[zoom_lvl].x_offs = FioReadWord();
-			sprite[zoom_lvl].y_offs = FioReadWord();
+			sprite[zoom_lvl].height = reader.ReadWord();
+			sprite[zoom_lvl].width  = reader.ReadWord();
+			sprite[zoom_lvl].x_offs = reader.ReadWord();
+			sprite[zoom_lvl].y_offs = reader.ReadWord();
 
 			if (sprite[zoom_lvl].width > INT16_MAX || sprite[zoom_lvl].height > INT16_MAX) {
-				WarnCorruptSprite(file_slot, file_pos, __LINE__);
+				WarnCorruptSprite(reader, file_slot, file_pos, __LINE__);
 				return 0;
 			}
 
@@ -308,30 +403,119 @@ uint8 LoadSpriteV2(SpriteLoader::Sprite *sprite, uint file_slot, size_t file_pos
 
 			/* For chunked encoding we store the decompressed size in the file,
 			 * otherwise we can calculate it from the image dimensions. */
-			uint decomp_size = (type & 0x08) ? FioReadDword() : sprite[zoom_lvl].width * sprite[zoom_lvl].height * bpp;
+			uint decomp_size = (type & 0x08) ? reader.ReadDword() : sprite[zoom_lvl].width * sprite[zoom_lvl].height * bpp;
 
-			bool valid = DecodeSingleSprite(&sprite[zoom_lvl], file_slot, file_pos, sprite_type, decomp_size, type, zoom_lvl, colour, 2);
-			if (FioGetPos() != start_pos + num) {
-				WarnCorruptSprite(file_slot, file_pos, __LINE__);
+			bool valid = DecodeSingleSprite(reader, &sprite[zoom_lvl], file_slot, file_pos, sprite_type, decomp_size, type, zoom_lvl, colour, 2);
+			if (reader.GetPos() != start_pos + num) {
+				WarnCorruptSprite(reader, file_slot, file_pos, __LINE__);
 				return 0;
 			}
 
 			if (valid) SetBit(loaded_sprites, zoom_lvl);
 		} else {
 			/* Not the wanted zoom level or colour depth, continue searching. */
-			FioSkipBytes(num - 2);
+			reader.SkipBytes(num - 2);
 		}
 
-	} while (FioReadDword() == id);
+	} while (reader.ReadDword() == id);
 
 	return loaded_sprites;
 }
 
 uint8 SpriteLoaderGrf::LoadSprite(SpriteLoader::Sprite *sprite, uint file_slot, size_t file_pos, SpriteType sprite_type, bool load_32bpp)
 {
+	if (this->staged != nullptr) {
+		StagedSpriteReader reader(*this->staged);
+		uint8 loaded_sprites = (this->container_ver >= 2) ?
+				LoadSpriteV2(reader, sprite, file_slot, file_pos, sprite_type, load_32bpp) :
+				LoadSpriteV1(reader, sprite, file_slot, file_pos, sprite_type, load_32bpp);
+		if (!reader.needs_file) return loaded_sprites;
+
+		this->needs_file = true;
+		return 0;
+	}
+
+	FioSpriteReader reader;
 	if (this->container_ver >= 2) {
-		return LoadSpriteV2(sprite, file_slot, file_pos, sprite_type, load_32bpp);
+		return LoadSpriteV2(reader, sprite, file_slot, file_pos, sprite_type, load_32bpp);
 	} else {
-		return LoadSpriteV1(sprite, file_slot, file_pos, sprite_type, load_32bpp);
+		return LoadSpriteV1(reader, sprite, file_slot, file_pos, sprite_type, load_32bpp);
+	}
+}
+
+/** Upper limit on the size of a sprite record which #ReadGrfSpriteData stages; larger ones are left to be read from the file. */
+static const uint32 MAX_STAGED_SPRITE_RECORD = 16 * 1024 * 1024;
+
+/**
+ * Read all the data of a sprite from its GRF into memory, so it can be decoded
+ * later by a #SpriteLoaderGrf without accessing the file, e.g. on another thread.
+ * @param[out] staged The read data.
+ * @param file_slot GRF the sprite is in.
+ * @param file_pos Position of the sprite in the GRF.
+ * @param container_ver Container version of the GRF.
+ * @return True if the data was read, false if there is no sprite data to decode.
+ */
+bool ReadGrfSpriteData(GrfSpriteData *staged, uint file_slot, size_t file_pos, byte container_ver)
+{
+	staged->file_pos = file_pos;
+	staged->data.clear();
+
+	/* Is the sprite not present/stripped in the GRF? */
+	if (file_pos == SIZE_MAX) return false;
+
+	FioSeekToFile(file_slot, file_pos);
+
+	auto read_byte = [&]() -> byte {
+		byte b = FioReadByte();
+		staged->data.push_back(b);
+		return b;
+	};
+	auto read_word = [&]() -> uint16 {
+		byte b = read_byte();
+		return (read_byte() << 8) | b;
+	};
+	auto read_dword = [&]() -> uint32 {
+		uint b = read_word();
+		return (read_word() << 16) | b;
+	};
+	auto read_bytes = [&](size_t size) {
+		for (; size > 0; size--) read_byte();
+	};
+
+	if (container_ver >= 2) {
+		/* Records of all zoom levels and colour depths of the sprite, up to and including the ID following them. */
+		uint32 id = read_dword();
+		do {
+			uint32 num = read_dword();
+			if (num > MAX_STAGED_SPRITE_RECORD) return false;
+			size_t start = staged->data.size();
+			staged->data.resize(start + num);
+			FioReadBlock(staged->data.data() + start, num);
+		} while (read_dword() == id);
+		return true;
+	}
+
+	/* A single inline record, whose size is only known by walking the compressed data. */
+	int num = read_word();
+	byte type = read_byte();
+	if (type == 0xFF) return false;
+
+	uint height = read_byte();
+	uint width = read_word();
+	read_bytes(4);
+
+	int64 size = (type & 0x02) ? width * height : num - 8;
+	while (size > 0) {
+		int8 code = read_byte();
+		if (code >= 0) {
+			int length = (code == 0) ? 0x80 : code;
+			size -= length;
+			if (size < 0) return false;
+			read_bytes(length);
+		} else {
+			read_byte();
+			size += code >> 3;
+		}
 	}
+	return size == 0;
 }
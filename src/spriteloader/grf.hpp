@@ -11,12 +11,24 @@
 #define SPRITELOADER_GRF_HPP
 
 #include "spriteloader.hpp"
+#include <vector>
+
+/** Data of a sprite read from its (New)GRF, so it can be decoded without accessing the file, e.g. on another thread. */
+struct GrfSpriteData {
+	size_t file_pos;        ///< Position in the file the data was read from.
+	std::vector<byte> data; ///< All the records of the sprite, as in the file.
+};
+
+bool ReadGrfSpriteData(GrfSpriteData *staged, uint file_slot, size_t file_pos, byte container_ver);
 
 /** Sprite loader for graphics coming from a (New)GRF. */
 class SpriteLoaderGrf : public SpriteLoader {
 	byte container_ver;
+	const GrfSpriteData *staged; ///< Data to decode instead of reading the file, or nullptr.
 public:
-	SpriteLoaderGrf(byte container_ver) : container_ver(container_ver) {}
+	bool needs_file = false;     ///< Set when the staged data could not be decoded without reporting a problem, so the sprite has to be loaded from the file instead.
+
+	SpriteLoaderGrf(byte container_ver, const GrfSpriteData *staged = nullptr) : container_ver(container_ver), staged(staged) {}
 	uint8 LoadSprite(SpriteLoader::Sprite *sprite, uint file_slot, size_t file_pos, SpriteType sprite_type, bool load_32bpp);
 };
 
@@ -20,7 +20,9 @@
 #include "vehiclelist.h"
 #include "core/pool_func.hpp"
 #include "station_base.h"
+#include "waypoint_base.h"
 #include "station_kdtree.h"
+#include "worker_thread.h"
 #include "roadstop_base.h"
 #include "industry.h"
 #include "town.h"
@@ -34,8 +36,8 @@
 
 #include "safeguards.h"
 
-/** The pool of stations. */
-StationPool _station_pool("Station");
+/** The pool of stations, with slots large enough for both stations and waypoints. */
+StationPool _station_pool("Station", std::max(sizeof(Station), sizeof(Waypoint)));
 INSTANTIATE_POOL_METHODS(Station)
 
 
@@ -47,7 +49,7 @@ void RebuildStationKdtree()
 	for (const Station *st : Station::Iterate()) {
 		stids.push_back(st->index);
 	}
-	_station_kdtree.Build(stids.begin(), stids.end());
+	_station_kdtree.Build(stids.begin(), stids.end(), &RunParallelTasks);
 }
 
 
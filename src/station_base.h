@@ -473,7 +473,18 @@ public:
 		return this->flows_index.begin()->first;
 	}
 
+	/**
+	 * Swap the flows of two maps.
+	 * @param other Map to swap with.
+	 */
+	void swap(FlowStatMap &other)
+	{
+		this->flows_storage.swap(other.flows_storage);
+		this->flows_index.swap(other.flows_index);
+	}
+
 	void SortStorage();
+	void MergeStorage(std::vector<FlowStat> &flows);
 };
 
 /**
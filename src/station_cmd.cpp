@@ -410,14 +410,15 @@ void Station::UpdateVirtCoord()
 	pt.y -= 32 * ZOOM_LVL_BASE;
 	if ((this->facilities & FACIL_AIRPORT) && this->airport.type == AT_OILRIG) pt.y -= 16 * ZOOM_LVL_BASE;
 
-	if (_viewport_sign_kdtree_valid && this->sign.kdtree_valid) _viewport_sign_kdtree.Remove(ViewportSignKdtreeItem::MakeStation(this->index));
+	const bool kdtree_update = _viewport_sign_kdtree_valid && this->sign.IsKdtreeEntryChanged(pt.x, pt.y);
+	if (kdtree_update && this->sign.kdtree_valid) _viewport_sign_kdtree.Remove(ViewportSignKdtreeItem::MakeStation(this->index));
 
 	SetDParam(0, this->index);
 	SetDParam(1, this->facilities);
 	bool shown = HasBit(_display_opt, DO_SHOW_STATION_NAMES) && !(_local_company != this->owner && this->owner != OWNER_NONE && !HasBit(_display_opt, DO_SHOW_COMPETITOR_SIGNS));
 	this->sign.UpdatePosition(shown ? ZOOM_LVL_DRAW_SPR : ZOOM_LVL_END, pt.x, pt.y, STR_VIEWPORT_STATION);
 
-	if (_viewport_sign_kdtree_valid) _viewport_sign_kdtree.Insert(ViewportSignKdtreeItem::MakeStation(this->index));
+	if (kdtree_update) _viewport_sign_kdtree.Insert(ViewportSignKdtreeItem::MakeStation(this->index));
 
 	SetWindowDirty(WC_STATION_VIEW, this->index);
 }
@@ -1513,6 +1514,7 @@ CommandCost CmdBuildRailStation(TileIndex tile_org, DoCommandFlag flags, uint32
 				DeallocateSpecFromStation(st, old_specindex);
 
 				SetCustomStationSpecIndex(tile, specindex);
+				UpdateAnimatedTileSpeed(tile);
 				SetStationTileRandomBits(tile, GB(Random(), 0, 4));
 				SetAnimationFrame(tile, 0);
 
@@ -4179,7 +4181,8 @@ CommandCost CmdRenameStation(TileIndex tile, DoCommandFlag flags, uint32 p1, uin
 	return CommandCost();
 }
 
-static void AddNearbyStationsByCatchment(TileIndex tile, StationList *stations, StationList &nearby)
+template <typename Tstation_list>
+static void AddNearbyStationsByCatchment(TileIndex tile, Tstation_list *stations, StationList &nearby)
 {
 	for (Station *st : nearby) {
 		if (st->TileIsInCatchment(tile)) stations->insert(st);
@@ -4193,13 +4196,15 @@ static void AddNearbyStationsByCatchment(TileIndex tile, StationList *stations,
  * @param[out] stations The list to store the stations in
  * @param use_nearby Use nearby station list of industry/town associated with location.tile
  */
-void FindStationsAroundTiles(const TileArea &location, StationList * const stations, bool use_nearby, const IndustryID industry_filter)
+template <typename Tstation_list>
+void FindStationsAroundTiles(const TileArea &location, Tstation_list * const stations, bool use_nearby, const IndustryID industry_filter)
 {
 	if (use_nearby) {
 		/* Industries and towns maintain a list of nearby stations */
 		if (IsTileType(location.tile, MP_INDUSTRY)) {
 			/* Industry nearby stations are already filtered by catchment. */
-			*stations = Industry::GetByTile(location.tile)->stations_near;
+			const StationList &stations_near = Industry::GetByTile(location.tile)->stations_near;
+			stations->insert(stations_near.begin(), stations_near.end());
 			return;
 		} else if (IsTileType(location.tile, MP_HOUSE)) {
 			/* Town nearby stations need to be filtered per tile. */
@@ -4211,7 +4216,7 @@ void FindStationsAroundTiles(const TileArea &location, StationList * const stati
 
 	/* Not using, or don't have a nearby stations list, so we need to scan. */
 
-	btree::btree_set<StationID> seen_stations;
+	btree::btree_set<StationID, std::less<StationID>, TickAllocator<StationID>> seen_stations;
 
 	/* Scan an area around the building covering the maximum possible station
 	 * to find the possible nearby stations. */
@@ -4240,11 +4245,14 @@ void FindStationsAroundTiles(const TileArea &location, StationList * const stati
 	}
 }
 
+template void FindStationsAroundTiles(const TileArea &location, StationList * const stations, bool use_nearby, const IndustryID industry_filter);
+template void FindStationsAroundTiles(const TileArea &location, TickStationList * const stations, bool use_nearby, const IndustryID industry_filter);
+
 /**
  * Run a tile loop to find stations around a tile, on demand. Cache the result for further requests
  * @return pointer to a StationList containing all stations found
  */
-const StationList *StationFinder::GetStations()
+const TickStationList *StationFinder::GetStations()
 {
 	if (this->tile != INVALID_TILE) {
 		FindStationsAroundTiles(*this, &this->stations);
@@ -4274,7 +4282,8 @@ static bool CanMoveGoodsToStation(const Station *st, CargoID type)
 	return true;
 }
 
-uint MoveGoodsToStation(CargoID type, uint amount, SourceType source_type, SourceID source_id, const StationList *all_stations)
+template <typename Tstation_list>
+uint MoveGoodsToStation(CargoID type, uint amount, SourceType source_type, SourceID source_id, const Tstation_list *all_stations)
 {
 	/* Return if nothing to do. Also the rounding below fails for 0. */
 	if (all_stations->empty()) return 0;
@@ -4282,7 +4291,7 @@ uint MoveGoodsToStation(CargoID type, uint amount, SourceType source_type, Sourc
 
 	Station *first_station = nullptr;
 	typedef std::pair<Station *, uint> StationInfo;
-	std::vector<StationInfo> used_stations;
+	std::vector<StationInfo, TickAllocator<StationInfo>> used_stations;
 
 	for (Station *st : *all_stations) {
 		if (!CanMoveGoodsToStation(st, type)) continue;
@@ -4361,6 +4370,9 @@ uint MoveGoodsToStation(CargoID type, uint amount, SourceType source_type, Sourc
 	return moved;
 }
 
+template uint MoveGoodsToStation(CargoID type, uint amount, SourceType source_type, SourceID source_id, const StationList *all_stations);
+template uint MoveGoodsToStation(CargoID type, uint amount, SourceType source_type, SourceID source_id, const TickStationList *all_stations);
+
 void UpdateStationDockingTiles(Station *st)
 {
 	st->docking_station.Clear();
@@ -5003,6 +5015,30 @@ void FlowStatMap::SortStorage()
 	}
 }
 
+/**
+ * Add flows of origins which aren't in the map yet, merging them into the
+ * storage so that it stays sorted if it was sorted before. This is cheaper
+ * than inserting them one by one and sorting the storage afterwards.
+ * @param flows Flows to be added, sorted by origin. They are moved out of the vector.
+ */
+void FlowStatMap::MergeStorage(std::vector<FlowStat> &flows)
+{
+	if (flows.empty()) return;
+	size_t middle = this->flows_storage.size();
+	for (FlowStat &flow : flows) {
+		this->flows_index[flow.origin] = 0;
+		this->flows_storage.push_back(std::move(flow));
+	}
+	flows.clear();
+	assert(this->flows_storage.size() == this->flows_index.size());
+	std::inplace_merge(this->flows_storage.begin(), this->flows_storage.begin() + middle, this->flows_storage.end(), [](const FlowStat &a, const FlowStat &b) -> bool {
+		return a.origin < b.origin;
+	});
+	for (uint16 index = 0; index < this->flows_storage.size(); ++index) {
+		this->flows_index[this->flows_storage[index].origin] = index;
+	}
+}
+
 void DumpStationFlowStats(char *b, const char *last)
 {
 	btree::btree_map<uint, uint> count_map;
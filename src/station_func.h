@@ -22,7 +22,8 @@
 
 void ModifyStationRatingAround(TileIndex tile, Owner owner, int amount, uint radius);
 
-void FindStationsAroundTiles(const TileArea &location, StationList *stations, bool use_nearby = true, IndustryID industry_filter = INVALID_INDUSTRY);
+template <typename Tstation_list>
+void FindStationsAroundTiles(const TileArea &location, Tstation_list *stations, bool use_nearby = true, IndustryID industry_filter = INVALID_INDUSTRY);
 
 void ShowStationViewWindow(StationID station);
 void UpdateAllStationVirtCoords();
@@ -1601,6 +1601,8 @@ struct StationViewWindow : public Window {
 
 	/**
 	 * Build up the cargo view for WAITING mode and a specific cargo.
+	 * The cargo list keeps the waiting amounts per next hop and source station, so
+	 * this doesn't need to look at the individual packets.
 	 * @param i Cargo to show.
 	 * @param packets The current station's cargo list for that cargo.
 	 * @param cargo The CargoDataEntry to save the result in.
@@ -1608,26 +1610,23 @@ struct StationViewWindow : public Window {
 	void BuildCargoList(CargoID i, const StationCargoList &packets, CargoDataEntry *cargo)
 	{
 		const CargoDataEntry *source_dest = this->cached_destinations.Retrieve(i);
-		for (StationCargoList::ConstIterator it = packets.Packets()->begin(); it != packets.Packets()->end(); it++) {
-			const CargoPacket *cp = *it;
-			StationID next = it.GetKey();
-
-			const CargoDataEntry *source_entry = source_dest->Retrieve(cp->SourceStation());
+		for (const StationCargoSourceCount &entry : packets.SourceCounts()) {
+			const CargoDataEntry *source_entry = source_dest->Retrieve(entry.source);
 			if (source_entry == nullptr) {
-				this->ShowCargo(cargo, i, cp->SourceStation(), next, INVALID_STATION, cp->Count());
+				this->ShowCargo(cargo, i, entry.source, entry.next, INVALID_STATION, entry.count);
 				continue;
 			}
 
-			const CargoDataEntry *via_entry = source_entry->Retrieve(next);
+			const CargoDataEntry *via_entry = source_entry->Retrieve(entry.next);
 			if (via_entry == nullptr) {
-				this->ShowCargo(cargo, i, cp->SourceStation(), next, INVALID_STATION, cp->Count());
+				this->ShowCargo(cargo, i, entry.source, entry.next, INVALID_STATION, entry.count);
 				continue;
 			}
 
 			for (CargoDataSet::iterator dest_it = via_entry->Begin(); dest_it != via_entry->End(); ++dest_it) {
 				CargoDataEntry *dest_entry = *dest_it;
-				uint val = DivideApprox(cp->Count() * dest_entry->GetCount(), via_entry->GetCount());
-				this->ShowCargo(cargo, i, cp->SourceStation(), next, dest_entry->GetStation(), val);
+				uint val = (uint)(((uint64)entry.count * dest_entry->GetCount() + via_entry->GetCount() / 2) / via_entry->GetCount());
+				this->ShowCargo(cargo, i, entry.source, entry.next, dest_entry->GetStation(), val);
 			}
 		}
 		this->ShowCargo(cargo, i, NEW_STATION, NEW_STATION, NEW_STATION, packets.ReservedCount());
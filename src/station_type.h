@@ -13,6 +13,7 @@
 #include "core/smallstack_type.hpp"
 #include "tilearea_type.h"
 #include "3rdparty/cpp-btree/btree_set.h"
+#include "tick_arena.h"
 
 typedef uint16 StationID;
 typedef uint16 RoadStopID;
@@ -94,19 +95,22 @@ struct StationCompare {
 /** List of stations */
 typedef btree::btree_set<Station *, StationCompare> StationList;
 
+/** List of stations which only lives during a tick, see #TickAllocator. */
+typedef btree::btree_set<Station *, StationCompare, TickAllocator<Station *>> TickStationList;
+
 /**
  * Structure contains cached list of stations nearby. The list
  * is created upon first call to GetStations()
  */
 class StationFinder : TileArea {
-	StationList stations; ///< List of stations nearby
+	TickStationList stations; ///< List of stations nearby
 public:
 	/**
 	 * Constructs StationFinder
 	 * @param area the area to search from
 	 */
 	StationFinder(const TileArea &area) : TileArea(area) {}
-	const StationList *GetStations();
+	const TickStationList *GetStations();
 };
 
 #endif /* STATION_TYPE_H */
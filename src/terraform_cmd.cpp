@@ -175,6 +175,64 @@ static CommandCost TerraformTileHeight(TerraformerState *ts, TileIndex tile, int
 	return total_cost;
 }
 
+/**
+ * Check whether a tile allows its slope to be changed by terraforming, and let it adapt to the new slope when executing.
+ * @param tile Tile to check.
+ * @param flags Flags of the terraforming command.
+ * @param test Whether to only test the tile, which never executes and does not change town ratings.
+ * @param z_min New height of the lowest corner of the tile.
+ * @param tileh New slope of the tile.
+ * @return Error or cost.
+ */
+static CommandCost TerraformCheckTile(TileIndex tile, DoCommandFlag flags, bool test, int z_min, Slope tileh)
+{
+	/* Is the tile already cleared? */
+	const ClearedObjectArea *coa = FindClearedObject(tile);
+	bool indirectly_cleared = coa != nullptr && coa->first_tile != tile;
+
+	/* Check tiletype-specific things, and add extra-cost */
+	const bool curr_gen = _generating_world;
+	if (_game_mode == GM_EDITOR) _generating_world = true; // used to create green terraformed land
+	DoCommandFlag tile_flags = flags | DC_AUTO | DC_FORCE_CLEAR_TILE;
+	if (test) {
+		tile_flags &= ~DC_EXEC;
+		tile_flags |= DC_NO_MODIFY_TOWN_RATING;
+	}
+	CommandCost cost;
+	if (indirectly_cleared) {
+		cost = DoCommand(tile, 0, 0, tile_flags, CMD_LANDSCAPE_CLEAR);
+	} else {
+		cost = _tile_type_procs[GetTileType(tile)]->terraform_tile_proc(tile, tile_flags, z_min, tileh);
+	}
+	_generating_world = curr_gen;
+	return cost;
+}
+
+/**
+ * Compute the slope of a tile from the heights of its corners.
+ * @param z_N Height of the north corner.
+ * @param z_W Height of the west corner.
+ * @param z_S Height of the south corner.
+ * @param z_E Height of the east corner.
+ * @param[out] z_min Height of the lowest corner.
+ * @param[out] z_max Height of the highest corner.
+ * @return Slope of the tile.
+ */
+static Slope TerraformGetSlope(int z_N, int z_W, int z_S, int z_E, int &z_min, int &z_max)
+{
+	/* Find min and max height of tile */
+	z_min = min(min(z_N, z_W), min(z_S, z_E));
+	z_max = max(max(z_N, z_W), max(z_S, z_E));
+
+	/* Compute tile slope */
+	Slope tileh = (z_max > z_min + 1 ? SLOPE_STEEP : SLOPE_FLAT);
+	if (z_W > z_min) tileh |= SLOPE_W;
+	if (z_S > z_min) tileh |= SLOPE_S;
+	if (z_E > z_min) tileh |= SLOPE_E;
+	if (z_N > z_min) tileh |= SLOPE_N;
+	return tileh;
+}
+
 /**
  * Terraform land
  * @param tile tile to terraform
@@ -239,16 +297,8 @@ CommandCost CmdTerraformLand(TileIndex tile, DoCommandFlag flags, uint32 p1, uin
 			int z_S = TerraformGetHeightOfTile(&ts, tile + TileDiffXY(1, 1));
 			int z_E = TerraformGetHeightOfTile(&ts, tile + TileDiffXY(0, 1));
 
-			/* Find min and max height of tile */
-			int z_min = min(min(z_N, z_W), min(z_S, z_E));
-			int z_max = max(max(z_N, z_W), max(z_S, z_E));
-
-			/* Compute tile slope */
-			Slope tileh = (z_max > z_min + 1 ? SLOPE_STEEP : SLOPE_FLAT);
-			if (z_W > z_min) tileh |= SLOPE_W;
-			if (z_S > z_min) tileh |= SLOPE_S;
-			if (z_E > z_min) tileh |= SLOPE_E;
-			if (z_N > z_min) tileh |= SLOPE_N;
+			int z_min, z_max;
+			Slope tileh = TerraformGetSlope(z_N, z_W, z_S, z_E, z_min, z_max);
 
 			if (pass == 0) {
 				/* Check if bridge would take damage */
@@ -274,25 +324,7 @@ CommandCost CmdTerraformLand(TileIndex tile, DoCommandFlag flags, uint32 p1, uin
 				}
 			}
 
-			/* Is the tile already cleared? */
-			const ClearedObjectArea *coa = FindClearedObject(tile);
-			bool indirectly_cleared = coa != nullptr && coa->first_tile != tile;
-
-			/* Check tiletype-specific things, and add extra-cost */
-			const bool curr_gen = _generating_world;
-			if (_game_mode == GM_EDITOR) _generating_world = true; // used to create green terraformed land
-			DoCommandFlag tile_flags = flags | DC_AUTO | DC_FORCE_CLEAR_TILE;
-			if (pass == 0) {
-				tile_flags &= ~DC_EXEC;
-				tile_flags |= DC_NO_MODIFY_TOWN_RATING;
-			}
-			CommandCost cost;
-			if (indirectly_cleared) {
-				cost = DoCommand(tile, 0, 0, tile_flags, CMD_LANDSCAPE_CLEAR);
-			} else {
-				cost = _tile_type_procs[GetTileType(tile)]->terraform_tile_proc(tile, tile_flags, z_min, tileh);
-			}
-			_generating_world = curr_gen;
+			CommandCost cost = TerraformCheckTile(tile, flags, pass == 0, z_min, tileh);
 			if (cost.Failed()) {
 				_terraform_err_tile = tile;
 				return cost;
@@ -330,6 +362,249 @@ CommandCost CmdTerraformLand(TileIndex tile, DoCommandFlag flags, uint32 p1, uin
 }
 
 
+/** Value of a corner in a #TerraformRegion distance transform which is not bounded by any corner. */
+static const int TERRAFORM_REGION_UNBOUNDED = INT32_MIN / 2;
+
+/** Flags of the corners of a #TerraformRegion. */
+enum TerraformRegionCornerFlags {
+	TRCF_AREA   = 1 << 0, ///< The corner is to be levelled.
+	TRCF_PINNED = 1 << 1, ///< The corner may not change its height.
+	TRCF_EDGE   = 1 << 2, ///< The corner may not change its height, as it is too close to the edge of the map.
+};
+
+/**
+ * Rectangular region of the map whose tile corners are levelled in bulk.
+ * A corner is identified by the tile it is the north corner of.
+ *
+ * Levelling a corner to a height forces the corners around it to be within one height level per step
+ * of Manhattan distance, just like the recursion of #TerraformTileHeight does for single corners.
+ * Instead of terraforming one corner by one height level at a time, the final heights of all corners
+ * are computed at once as distance transforms over flat arrays.
+ */
+struct TerraformRegion {
+	uint left;                   ///< X coordinate of the western most corners.
+	uint top;                    ///< Y coordinate of the northern most corners.
+	uint width;                  ///< Number of corners in X direction.
+	uint height;                 ///< Number of corners in Y direction.
+	std::vector<int> old_height; ///< Current heights of the corners.
+	std::vector<int> new_height; ///< Heights of the corners after levelling.
+	std::vector<byte> flags;     ///< #TerraformRegionCornerFlags of the corners.
+
+	/**
+	 * Create the region, with the current heights of the map.
+	 * @param left X coordinate of the western most corners.
+	 * @param top Y coordinate of the northern most corners.
+	 * @param right X coordinate of the eastern most corners.
+	 * @param bottom Y coordinate of the southern most corners.
+	 */
+	TerraformRegion(uint left, uint top, uint right, uint bottom) : left(left), top(top), width(right - left + 1), height(bottom - top + 1)
+	{
+		this->old_height.resize(this->width * this->height);
+		this->flags.resize(this->width * this->height, 0);
+		for (uint y = 0; y < this->height; y++) {
+			for (uint x = 0; x < this->width; x++) {
+				this->old_height[y * this->width + x] = TileHeight(TileXY(this->left + x, this->top + y));
+			}
+		}
+		this->new_height = this->old_height;
+	}
+
+	/**
+	 * Get the index of a corner in the arrays of the region.
+	 * @param tile Tile of the corner, which must be in the region.
+	 * @return Index of the corner.
+	 */
+	inline uint Index(TileIndex tile) const
+	{
+		return (TileY(tile) - this->top) * this->width + (TileX(tile) - this->left);
+	}
+
+	/**
+	 * Prevent the corners of a tile from changing their height.
+	 * @param tile Tile, whose four corners must be in the region.
+	 * @param flag Flag to set on the corners, #TRCF_PINNED or #TRCF_EDGE.
+	 */
+	void Pin(TileIndex tile, byte flag)
+	{
+		uint i = this->Index(tile);
+		this->flags[i] |= flag;
+		this->flags[i + 1] |= flag;
+		this->flags[i + this->width] |= flag;
+		this->flags[i + this->width + 1] |= flag;
+	}
+
+	/**
+	 * Replace every value by the maximum over all corners of their value minus their Manhattan distance.
+	 * Corners which do not bound any other corner hold #TERRAFORM_REGION_UNBOUNDED.
+	 * @param values Values of all corners.
+	 */
+	void DistanceTransform(std::vector<int> &values) const
+	{
+		const uint w = this->width;
+		for (uint y = 0; y < this->height; y++) {
+			for (uint x = 0; x < w; x++) {
+				int &v = values[y * w + x];
+				if (x > 0) v = max(v, values[y * w + x - 1] - 1);
+				if (y > 0) v = max(v, values[(y - 1) * w + x] - 1);
+			}
+		}
+		for (uint y = this->height; y-- > 0;) {
+			for (uint x = w; x-- > 0;) {
+				int &v = values[y * w + x];
+				if (x + 1 < w) v = max(v, values[y * w + x + 1] - 1);
+				if (y + 1 < this->height) v = max(v, values[(y + 1) * w + x] - 1);
+			}
+		}
+	}
+
+	/**
+	 * Compute the new heights of all corners, when levelling the area corners to a height.
+	 * Pinned corners keep their height. Area corners which cannot reach the height because of
+	 * them get as close as possible, and all other corners change as little as possible.
+	 * @param h Height to level to.
+	 * @return Whether any area corner could not reach the height because of a corner close to the edge of the map.
+	 */
+	bool Level(int h)
+	{
+		const uint n = this->width * this->height;
+
+		/* Bounds due to the pinned corners: lower[c] = max(old[p] - d(c, p)), upper[c] = min(old[p] + d(c, p)). */
+		std::vector<int> lower(n, TERRAFORM_REGION_UNBOUNDED);
+		std::vector<int> upper(n, TERRAFORM_REGION_UNBOUNDED);
+		for (uint i = 0; i < n; i++) {
+			if ((this->flags[i] & (TRCF_PINNED | TRCF_EDGE)) == 0) continue;
+			lower[i] = this->old_height[i];
+			upper[i] = -this->old_height[i];
+		}
+		this->DistanceTransform(lower);
+		this->DistanceTransform(upper);
+
+		/* Heights the area corners can reach, and the bounds they impose on the other corners. */
+		bool edge_limited = false;
+		std::vector<int> raise(n, TERRAFORM_REGION_UNBOUNDED);
+		std::vector<int> lower_to(n, TERRAFORM_REGION_UNBOUNDED);
+		for (uint i = 0; i < n; i++) {
+			if ((this->flags[i] & TRCF_AREA) == 0) continue;
+			int target = h;
+			if (lower[i] != TERRAFORM_REGION_UNBOUNDED) target = Clamp(target, lower[i], -upper[i]);
+			if (target != h && (this->flags[i] & TRCF_EDGE) != 0) edge_limited = true;
+			raise[i] = target;
+			lower_to[i] = -target;
+		}
+		this->DistanceTransform(raise);
+		this->DistanceTransform(lower_to);
+
+		for (uint i = 0; i < n; i++) {
+			int z = this->old_height[i];
+			if (raise[i] != TERRAFORM_REGION_UNBOUNDED) {
+				z = max(z, raise[i]);
+				z = min(z, -lower_to[i]);
+			}
+			this->new_height[i] = z;
+		}
+		return edge_limited;
+	}
+
+	/**
+	 * Get the new height of the four corners of a tile.
+	 * @param tile Tile, whose four corners must be in the region.
+	 * @param[out] z_min New height of the lowest corner.
+	 * @param[out] z_max New height of the highest corner.
+	 * @param[out] raised Whether any corner is raised.
+	 * @param[out] lowered Whether any corner is lowered.
+	 * @return New slope of the tile.
+	 */
+	Slope GetNewSlope(TileIndex tile, int &z_min, int &z_max, bool &raised, bool &lowered) const
+	{
+		const uint i = this->Index(tile);
+		const uint corners[] = { i, i + 1, i + this->width + 1, i + this->width }; // N, W, S, E
+		raised = false;
+		lowered = false;
+		for (uint c : corners) {
+			if (this->new_height[c] > this->old_height[c]) raised = true;
+			if (this->new_height[c] < this->old_height[c]) lowered = true;
+		}
+		return TerraformGetSlope(this->new_height[corners[0]], this->new_height[corners[1]], this->new_height[corners[2]], this->new_height[corners[3]], z_min, z_max);
+	}
+
+	/**
+	 * Check whether levelling changes corners at the border of the region, which is not at the edge of the map.
+	 * In that case corners outside of the region might have to change as well, so a larger region is needed.
+	 * @return Whether the region is too small.
+	 */
+	bool IsTooSmall() const
+	{
+		for (uint y = 0; y < this->height; y++) {
+			for (uint x = 0; x < this->width; x++) {
+				if ((x == 0 && this->left > 0) || (y == 0 && this->top > 0) ||
+						(x == this->width - 1 && this->left + x < MapMaxX()) || (y == this->height - 1 && this->top + y < MapMaxY())) {
+					if (this->new_height[y * this->width + x] != this->old_height[y * this->width + x]) return true;
+				}
+			}
+		}
+		return false;
+	}
+};
+
+/**
+ * Check whether the tiles changed by levelling a region can be terraformed.
+ * Tiles that cannot be terraformed get their corners pinned, so the region must be levelled again.
+ * @param region Levelled region.
+ * @param flags Flags of the command.
+ * @param[out] error Set to the error of the first tile that cannot be terraformed.
+ * @param[out] pinned_tiles The tiles that cannot be terraformed are added to this.
+ * @return Whether all changed tiles can be terraformed.
+ */
+static bool CheckTerraformRegion(TerraformRegion &region, DoCommandFlag flags, CommandCost &error, std::vector<TileIndex> &pinned_tiles)
+{
+	bool ok = true;
+	for (uint y = region.top; y < region.top + region.height - 1; y++) {
+		for (uint x = region.left; x < region.left + region.width - 1; x++) {
+			TileIndex t = TileXY(x, y);
+
+			/* MP_VOID tiles can be terraformed but as tunnels and bridges
+			 * cannot go under / over these tiles they don't need checking. */
+			if (IsTileType(t, MP_VOID)) continue;
+
+			int z_min, z_max;
+			bool raised, lowered;
+			Slope tileh = region.GetNewSlope(t, z_min, z_max, raised, lowered);
+			if (!raised && !lowered) continue;
+
+			CommandCost ret;
+			if (IsBridgeAbove(t)) {
+				int bridge_height = GetBridgeHeight(GetSouthernBridgeEnd(t));
+
+				/* Check if bridge would take damage. */
+				if (raised && bridge_height <= z_max) {
+					ret = CommandCost(STR_ERROR_MUST_DEMOLISH_BRIDGE_FIRST);
+				}
+
+				/* Is the bridge above not too high afterwards? */
+				if (lowered && bridge_height > (z_min + _settings_game.construction.max_bridge_height)) {
+					ret = CommandCost(STR_ERROR_BRIDGE_TOO_HIGH_AFTER_LOWER_LAND);
+				}
+			}
+			/* Check if tunnel would take damage */
+			if (ret.Succeeded() && lowered && IsTunnelInWay(t, z_min, ITIWF_IGNORE_CHUNNEL)) {
+				ret = CommandCost(STR_ERROR_EXCAVATION_WOULD_DAMAGE);
+			}
+			if (ret.Succeeded()) ret = TerraformCheckTile(t, flags, true, z_min, tileh);
+
+			if (ret.Failed()) {
+				if (ok) {
+					error = ret;
+					_terraform_err_tile = t;
+				}
+				ok = false;
+				region.Pin(t, TRCF_PINNED);
+				pinned_tiles.push_back(t);
+			}
+		}
+	}
+	return ok;
+}
+
 /**
  * Levels a selected (rectangle) area of land
  * @param tile end tile of area-drag
@@ -363,57 +638,134 @@ CommandCost CmdLevelLand(TileIndex tile, DoCommandFlag flags, uint32 p1, uint32
 	/* Check range of destination height */
 	if (h > _settings_game.construction.max_heightlevel) return_cmd_error((oldh == 0) ? STR_ERROR_ALREADY_AT_SEA_LEVEL : STR_ERROR_TOO_HIGH);
 
-	Money money = GetAvailableMoneyForCommand();
-	CommandCost cost(EXPENSES_CONSTRUCTION);
 	CommandCost last_error(lm == LM_LEVEL ? STR_ERROR_ALREADY_LEVELLED : INVALID_STRING_ID);
-	bool had_success = false;
 
-	const Company *c = Company::GetIfValid(_current_company);
-	int limit = (c == nullptr ? INT32_MAX : GB(c->terraform_limit, 16, 16));
+	Company *c = Company::GetIfValid(_current_company);
+	uint limit = (c == nullptr ? UINT32_MAX : GB(c->terraform_limit, 16, 16));
 	if (limit == 0) return_cmd_error(STR_ERROR_TERRAFORM_LIMIT_REACHED);
 
+	/* Collect the corners to level. The region to consider starts as the area extended by the
+	 * largest height difference, and is enlarged when the changes propagate any further. */
+	std::vector<TileIndex> area;
+	uint min_x = MapMaxX(), min_y = MapMaxY(), max_x = 0, max_y = 0;
+	uint margin = 0;
 	TileIterator *iter = HasBit(p2, 0) ? (TileIterator *)new DiagonalTileIterator(tile, p1) : new OrthogonalTileIterator(tile, p1);
 	for (; *iter != INVALID_TILE; ++(*iter)) {
 		TileIndex t = *iter;
-		uint curh = TileHeight(t);
-		while (curh != h) {
-			CommandCost ret = DoCommand(t, SLOPE_N, (curh > h) ? 0 : 1, flags & ~DC_EXEC, CMD_TERRAFORM_LAND);
-			if (ret.Failed()) {
-				last_error = ret;
+		area.push_back(t);
+		min_x = min(min_x, TileX(t));
+		min_y = min(min_y, TileY(t));
+		max_x = max(max_x, TileX(t));
+		max_y = max(max_y, TileY(t));
+		margin = max(margin, Delta(TileHeight(t), h));
+	}
+	delete iter;
+	if (margin == 0) return last_error;
+
+	/* Level the region, and level it again without the tiles that turn out not to allow terraforming,
+	 * until all changed tiles can be terraformed. Every round pins at least one more tile.
+	 * When the changes reach the border of the region, start over with a larger region. */
+	std::unique_ptr<TerraformRegion> region;
+	std::vector<TileIndex> pinned_tiles;
+	const size_t cleared_object_areas = _cleared_object_areas.size();
+	for (margin++;; margin *= 2) {
+		/* The region also contains the south corners of the tiles whose north corners may change. */
+		region.reset(new TerraformRegion(min_x > margin ? min_x - margin : 0, min_y > margin ? min_y - margin : 0,
+				min(max_x + margin, MapMaxX()), min(max_y + margin, MapMaxY())));
+		for (TileIndex t : area) region->flags[region->Index(t)] |= TRCF_AREA;
+		for (TileIndex t : pinned_tiles) region->Pin(t, TRCF_PINNED);
+
+		/* Check "too close to edge of map". Only possible when freeform-edges is off. */
+		if (!_settings_game.construction.freeform_edges) {
+			for (uint y = region->top; y < region->top + region->height; y++) {
+				for (uint x = region->left; x < region->left + region->width; x++) {
+					if (x <= 1 || y <= 1 || x >= MapMaxX() - 1 || y >= MapMaxY() - 1) region->flags[region->Index(TileXY(x, y))] |= TRCF_EDGE;
+				}
+			}
+		}
 
-				/* Did we reach the limit? */
-				if (ret.GetErrorMessage() == STR_ERROR_TERRAFORM_LIMIT_REACHED) limit = 0;
+		bool too_small = false;
+		for (;;) {
+			if (region->Level(h) && last_error.GetErrorMessage() != STR_ERROR_TOO_CLOSE_TO_EDGE_OF_MAP) {
+				last_error = CommandCost(STR_ERROR_TOO_CLOSE_TO_EDGE_OF_MAP);
+			}
+			if (region->IsTooSmall()) {
+				too_small = true;
 				break;
 			}
+			_cleared_object_areas.resize(cleared_object_areas);
+			if (CheckTerraformRegion(*region, flags, last_error, pinned_tiles)) break;
+		}
+		if (!too_small) break;
+	}
 
-			if (flags & DC_EXEC) {
-				money -= ret.GetCost();
-				if (money < 0) {
-					_additional_cash_required = ret.GetCost();
-					delete iter;
-					return cost;
-				}
-				DoCommand(t, SLOPE_N, (curh > h) ? 0 : 1, flags, CMD_TERRAFORM_LAND);
-			} else {
-				/* When we're at the terraform limit we better bail (unneeded) testing as well.
-				 * This will probably cause the terraforming cost to be underestimated, but only
-				 * when it's near the terraforming limit. Even then, the estimation is
-				 * completely off due to it basically counting terraforming double, so it being
-				 * cut off earlier might even give a better estimate in some cases. */
-				if (--limit <= 0) {
-					had_success = true;
-					break;
-				}
+	/* Count the height levels by which the corners change. */
+	uint changes = 0;
+	for (uint i = 0; i < region->old_height.size(); i++) {
+		changes += Delta(region->old_height[i], region->new_height[i]);
+	}
+	if (changes == 0) return last_error;
+	if (changes > limit) return_cmd_error(STR_ERROR_TERRAFORM_LIMIT_REACHED);
+
+	CommandCost total_cost(EXPENSES_CONSTRUCTION);
+	total_cost.AddCost(_price[PR_TERRAFORM] * changes);
+
+	/* Collect the actual cost of the changed tiles. This command is not tested before executing it,
+	 * so when executing check the running cost against the money of the company before changing anything. */
+	Money money = GetAvailableMoneyForCommand();
+	std::vector<TileIndex> changed_tiles;
+	for (uint y = region->top; y < region->top + region->height - 1; y++) {
+		for (uint x = region->left; x < region->left + region->width - 1; x++) {
+			TileIndex t = TileXY(x, y);
+			int z_min, z_max;
+			bool raised, lowered;
+			Slope tileh = region->GetNewSlope(t, z_min, z_max, raised, lowered);
+			if (!raised && !lowered) continue;
+			changed_tiles.push_back(t);
+			if (IsTileType(t, MP_VOID)) continue;
+
+			CommandCost cost = TerraformCheckTile(t, flags, true, z_min, tileh);
+			if (cost.Failed()) {
+				_terraform_err_tile = t;
+				return cost;
+			}
+			total_cost.AddCost(cost);
+			if ((flags & DC_EXEC) && total_cost.GetCost() > money) {
+				_additional_cash_required = total_cost.GetCost();
+				return CommandCost(EXPENSES_CONSTRUCTION);
 			}
+		}
+	}
 
-			cost.AddCost(ret);
-			curh += (curh > h) ? -1 : 1;
-			had_success = true;
+	if (flags & DC_EXEC) {
+		/* Let the changed tiles adapt to their new slope. */
+		for (TileIndex t : changed_tiles) {
+			if (IsTileType(t, MP_VOID)) continue;
+			int z_min, z_max;
+			bool raised, lowered;
+			Slope tileh = region->GetNewSlope(t, z_min, z_max, raised, lowered);
+			CommandCost cost = TerraformCheckTile(t, flags, false, z_min, tileh);
+			if (cost.Failed()) {
+				_terraform_err_tile = t;
+				return cost;
+			}
 		}
 
-		if (limit <= 0) break;
-	}
+		/* Mark affected areas dirty, at their old and at their new height. */
+		for (TileIndex t : changed_tiles) MarkTileDirtyByTile(t);
 
-	delete iter;
-	return had_success ? cost : last_error;
+		/* change the height */
+		for (uint y = region->top; y < region->top + region->height; y++) {
+			for (uint x = region->left; x < region->left + region->width; x++) {
+				TileIndex t = TileXY(x, y);
+				uint i = region->Index(t);
+				if (region->new_height[i] != region->old_height[i]) SetTileHeight(t, (uint)region->new_height[i]);
+			}
+		}
+
+		for (TileIndex t : changed_tiles) MarkTileDirtyByTile(t);
+
+		if (c != nullptr) c->terraform_limit -= changes << 16;
+	}
+	return total_cost;
 }
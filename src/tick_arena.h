@@ -0,0 +1,29 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file tick_arena.h Arena for containers which only live during a game tick. */
+
+#ifndef TICK_ARENA_H
+#define TICK_ARENA_H
+
+#include "core/dyn_arena_alloc.hpp"
+
+/**
+ * Arena for short-lived containers of the game loop, such as the lists of vehicles to handle this tick.
+ * It is reset at the end of every game tick, if all its allocations have been freed by then.
+ */
+extern BumpArena _tick_arena;
+
+/**
+ * Allocator for standard containers using the #_tick_arena.
+ * Containers using this must only be used by the thread running the game loop or generating the world,
+ * and should be emptied before the end of the tick.
+ */
+template <typename T>
+using TickAllocator = BumpArenaAllocator<T, _tick_arena>;
+
+#endif /* TICK_ARENA_H */
@@ -52,7 +52,7 @@
 #include "game/game.hpp"
 #include "zoom_func.h"
 #include "zoning.h"
-#include "scope.h"
+#include "worker_thread.h"
 
 #include "table/strings.h"
 #include "table/town_land.h"
@@ -76,7 +76,7 @@ void RebuildTownKdtree()
 	for (const Town *town : Town::Iterate()) {
 		townids.push_back(town->index);
 	}
-	_town_kdtree.Build(townids.begin(), townids.end());
+	_town_kdtree.Build(townids.begin(), townids.end(), &RunParallelTasks);
 }
 
 
@@ -508,14 +508,16 @@ void Town::UpdateVirtCoord()
 {
 	this->UpdateLabel();
 	Point pt = RemapCoords2(TileX(this->xy) * TILE_SIZE, TileY(this->xy) * TILE_SIZE);
+	pt.y -= 24 * ZOOM_LVL_BASE;
 
-	if (_viewport_sign_kdtree_valid && this->cache.sign.kdtree_valid) _viewport_sign_kdtree.Remove(ViewportSignKdtreeItem::MakeTown(this->index));
+	const bool kdtree_update = _viewport_sign_kdtree_valid && this->cache.sign.IsKdtreeEntryChanged(pt.x, pt.y);
+	if (kdtree_update && this->cache.sign.kdtree_valid) _viewport_sign_kdtree.Remove(ViewportSignKdtreeItem::MakeTown(this->index));
 
 	SetDParam(0, this->index);
 	SetDParam(1, this->cache.population);
-	this->cache.sign.UpdatePosition(HasBit(_display_opt, DO_SHOW_TOWN_NAMES) ? ZOOM_LVL_OUT_128X : ZOOM_LVL_END, pt.x, pt.y - 24 * ZOOM_LVL_BASE, this->Label(), STR_VIEWPORT_TOWN);
+	this->cache.sign.UpdatePosition(HasBit(_display_opt, DO_SHOW_TOWN_NAMES) ? ZOOM_LVL_OUT_128X : ZOOM_LVL_END, pt.x, pt.y, this->Label(), STR_VIEWPORT_TOWN);
 
-	if (_viewport_sign_kdtree_valid) _viewport_sign_kdtree.Insert(ViewportSignKdtreeItem::MakeTown(this->index));
+	if (kdtree_update) _viewport_sign_kdtree.Insert(ViewportSignKdtreeItem::MakeTown(this->index));
 
 	SetWindowDirty(WC_TOWN_VIEW, this->index);
 }
@@ -3638,9 +3640,6 @@ static void UpdateTownRating(Town *t)
 	for (uint i = 0; i < MAX_COMPANIES; i++) {
 		t->ratings[i] = Clamp(t->ratings[i], RATING_MINIMUM, RATING_MAXIMUM);
 	}
-
-	t->UpdateVirtCoord();
-	SetWindowDirty(WC_TOWN_AUTHORITY, t->index);
 }
 
 
@@ -3733,30 +3732,36 @@ static uint GetNormalGrowthRate(Town *t)
 }
 
 /**
- * Updates town growth rate.
+ * Updates town growth rate, without marking the town window dirty.
  * @param t The town to update growth rate for
  */
-static void UpdateTownGrowthRate(Town *t)
+static void UpdateTownGrowthRateNoDirty(Town *t)
 {
 	if (HasBit(t->flags, TOWN_CUSTOM_GROWTH)) return;
 	uint old_rate = t->growth_rate;
 	t->growth_rate = GetNormalGrowthRate(t);
 	UpdateTownGrowCounter(t, old_rate);
+}
+
+/**
+ * Updates town growth rate.
+ * @param t The town to update growth rate for
+ */
+static void UpdateTownGrowthRate(Town *t)
+{
+	UpdateTownGrowthRateNoDirty(t);
 	SetWindowDirty(WC_TOWN_VIEW, t->index);
 }
 
 /**
- * Updates town growth state (whether it is growing or not).
+ * Updates town growth state (whether it is growing or not), without marking the town window dirty.
  * @param t The town to update growth for
+ * @param random Random number generator to use.
  */
-static void UpdateTownGrowth(Town *t)
+static void UpdateTownGrowthNoDirty(Town *t, Randomizer &random)
 {
-	auto guard = scope_guard([t]() {
-		SetWindowDirty(WC_TOWN_VIEW, t->index);
-	});
-
 	SetBit(t->flags, TOWN_IS_GROWING);
-	UpdateTownGrowthRate(t);
+	UpdateTownGrowthRateNoDirty(t);
 	if (!HasBit(t->flags, TOWN_IS_GROWING)) return;
 
 	ClrBit(t->flags, TOWN_IS_GROWING);
@@ -3782,22 +3787,29 @@ static void UpdateTownGrowth(Town *t)
 
 	if (HasBit(t->flags, TOWN_CUSTOM_GROWTH)) {
 		if (t->growth_rate != TOWN_GROWTH_RATE_NONE) SetBit(t->flags, TOWN_IS_GROWING);
-		SetWindowDirty(WC_TOWN_VIEW, t->index);
 		return;
 	}
 
-	if (t->fund_buildings_months == 0 && CountActiveStations(t) == 0 && !Chance16(1, 12)) return;
+	if (t->fund_buildings_months == 0 && CountActiveStations(t) == 0 && !Chance16I(1, 12, random.Next())) return;
 
 	SetBit(t->flags, TOWN_IS_GROWING);
 }
 
+/**
+ * Updates town growth state (whether it is growing or not).
+ * @param t The town to update growth for
+ */
+static void UpdateTownGrowth(Town *t)
+{
+	UpdateTownGrowthNoDirty(t, _random);
+	SetWindowDirty(WC_TOWN_VIEW, t->index);
+}
+
 static void UpdateTownAmounts(Town *t)
 {
 	for (CargoID i = 0; i < NUM_CARGO; i++) t->supplied[i].NewMonth();
 	for (int i = TE_BEGIN; i < TE_END; i++) t->received[i].NewMonth();
 	if (t->fund_buildings_months != 0) t->fund_buildings_months--;
-
-	SetWindowDirty(WC_TOWN_VIEW, t->index);
 }
 
 static void UpdateTownUnwanted(Town *t)
@@ -4003,20 +4015,46 @@ CommandCost CheckforTownRating(DoCommandFlag flags, Town *t, TownRatingCheckType
 	return CommandCost();
 }
 
-void TownsMonthlyLoop()
+/**
+ * Monthly update of the statistics, growth and ratings of a town.
+ * Only the town itself is modified, so this can be done for all towns in parallel.
+ * @param t The town to update.
+ * @param random Random number generator to use.
+ */
+static void UpdateTownMonthly(Town *t, Randomizer &random)
 {
-	for (Town *t : Town::Iterate()) {
-		if (t->road_build_months != 0) t->road_build_months--;
+	if (t->road_build_months != 0) t->road_build_months--;
 
-		if (t->exclusive_counter != 0) {
-			if (--t->exclusive_counter == 0) t->exclusivity = INVALID_COMPANY;
-		}
+	if (t->exclusive_counter != 0) {
+		if (--t->exclusive_counter == 0) t->exclusivity = INVALID_COMPANY;
+	}
 
-		UpdateTownAmounts(t);
-		UpdateTownGrowth(t);
-		UpdateTownRating(t);
-		UpdateTownUnwanted(t);
+	UpdateTownAmounts(t);
+	UpdateTownGrowthNoDirty(t, random);
+	UpdateTownRating(t);
+	UpdateTownUnwanted(t);
+}
+
+void TownsMonthlyLoop()
+{
+	if (_settings_game.economy.parallel_monthly_loops) {
+		/* Each town uses its own random number stream, so the outcome does not depend on the number of threads. */
+		const uint32 seed = Random();
+		ParallelPoolForEach<Town>([seed](Town *t) {
+			Randomizer random;
+			random.SetSeed(seed, t->index);
+			UpdateTownMonthly(t, random);
+		});
+	} else {
+		for (Town *t : Town::Iterate()) UpdateTownMonthly(t, _random);
+	}
+
+	/* The cargo acceptance may use NewGRF callbacks, so it is always updated in index order. */
+	for (Town *t : Town::Iterate()) {
 		UpdateTownCargoes(t);
+		t->UpdateVirtCoord();
+		SetWindowDirty(WC_TOWN_VIEW, t->index);
+		SetWindowDirty(WC_TOWN_AUTHORITY, t->index);
 	}
 
 	UpdateTownCargoBitmap();
@@ -82,6 +82,12 @@ void DeleteVisibleTrain(Train *v);
 void CheckBreakdownFlags(Train *v);
 void GetTrainSpriteSize(EngineID engine, uint &width, uint &height, int &xoffs, int &yoffs, EngineImageType image_type);
 
+void UpdateLevelCrossingTrainCounts(Train *v, bool remove);
+void UpdateLevelCrossingTrainCountsAround(TileIndex tile);
+void ResetLevelCrossingTrainCounts();
+void RebuildLevelCrossingTrainCounts();
+bool ValidateLevelCrossingTrainCounts();
+
 /** Variables that are cached to improve performance and such */
 struct TrainCache {
 	/* Cached wagon override spritegroup */
@@ -123,6 +129,10 @@ struct Train FINAL : public GroundVehicle<Train, VEH_TRAIN> {
 	uint16 tunnel_bridge_signal_num;
 	uint16 speed_restriction;
 
+	TileIndex crossing_count_tile;  ///< NOSAVE: Tile this vehicle is counted at in the level crossing train counts.
+	uint8 crossing_count_mask;      ///< NOSAVE: Level crossings this vehicle is counted at, see #GetLevelCrossingTrainCountMask.
+	bool crossing_counted;          ///< NOSAVE: Whether this vehicle is counted in the level crossing train counts.
+
 	/** We don't want GCC to zero our struct! It already is zeroed and has an index! */
 	Train() : GroundVehicleBase() {}
 	/** We want to 'destruct' the right class. */
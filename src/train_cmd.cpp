@@ -46,6 +46,8 @@
 #include "table/strings.h"
 #include "table/train_cmd.h"
 
+#include <unordered_map>
+
 #include "safeguards.h"
 
 static Track ChooseTrainTrack(Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool force_res, bool *p_got_reservation, bool mark_stuck);
@@ -1909,16 +1911,139 @@ void ReverseTrainSwapVeh(Train *v, int l, int r)
 }
 
 
+/** Number of train vehicles on and next to a level crossing. */
+struct LevelCrossingTrainCount {
+	uint16 on;   ///< Train vehicles on the crossing.
+	uint16 near; ///< Train vehicles on the tiles next to the crossing along its rail, which possibly approach it.
+};
+
+/** Train vehicle counts of the level crossings with any train vehicle on or next to them. */
+static std::unordered_map<TileIndex, LevelCrossingTrainCount> _level_crossing_train_counts;
+
+static const uint LCTC_ON_CROSSING_BIT = DIAGDIR_END; ///< Bit of Train::crossing_count_mask for being on the level crossing of the own tile.
+
 /**
- * Check if the vehicle is a train
- * @param v vehicle on tile
- * @return v if it is a train, nullptr otherwise
+ * Get the level crossings a train vehicle on a tile is counted at.
+ * @param tile Tile of the vehicle.
+ * @return Bit #LCTC_ON_CROSSING_BIT for the tile itself, and a bit per direction of neighbouring crossings whose rail leads to the tile.
  */
-static Vehicle *TrainOnTileEnum(Vehicle *v, void *)
+static uint8 GetLevelCrossingTrainCountMask(TileIndex tile)
 {
-	return v;
+	uint8 mask = 0;
+	if (IsLevelCrossingTile(tile)) SetBit(mask, LCTC_ON_CROSSING_BIT);
+	for (DiagDirection dir = DIAGDIR_BEGIN; dir < DIAGDIR_END; dir++) {
+		TileIndex neighbour = tile + TileOffsByDiagDir(dir);
+		if (IsLevelCrossingTile(neighbour) && GetCrossingRailAxis(neighbour) == DiagDirToAxis(dir)) SetBit(mask, dir);
+	}
+	return mask;
 }
 
+/**
+ * Add to the train vehicle counts of level crossings.
+ * @param tile Tile of the vehicle.
+ * @param mask Level crossings to change the counts of, see #GetLevelCrossingTrainCountMask.
+ * @param delta Number of vehicles to add, or remove when negative.
+ */
+static void ChangeLevelCrossingTrainCounts(TileIndex tile, uint8 mask, int delta)
+{
+	auto change = [delta](TileIndex crossing, bool on) {
+		LevelCrossingTrainCount &count = _level_crossing_train_counts[crossing];
+		uint16 &counter = on ? count.on : count.near;
+		assert(delta > 0 || counter >= -delta);
+		counter += delta;
+		if (count.on == 0 && count.near == 0) _level_crossing_train_counts.erase(crossing);
+	};
+
+	if (HasBit(mask, LCTC_ON_CROSSING_BIT)) change(tile, true);
+	for (DiagDirection dir = DIAGDIR_BEGIN; dir < DIAGDIR_END; dir++) {
+		if (HasBit(mask, dir)) change(tile + TileOffsByDiagDir(dir), false);
+	}
+}
+
+/**
+ * Move a train vehicle to the level crossing train counts of its current tile.
+ * Called whenever the vehicle is moved in the vehicle tile hash.
+ * @param v The train vehicle.
+ * @param remove Whether to only remove the vehicle from the counts.
+ */
+void UpdateLevelCrossingTrainCounts(Train *v, bool remove)
+{
+	if (v->crossing_counted) {
+		if (!remove && v->crossing_count_tile == v->tile) return;
+
+		ChangeLevelCrossingTrainCounts(v->crossing_count_tile, v->crossing_count_mask, -1);
+		v->crossing_counted = false;
+	}
+
+	if (remove) return;
+
+	v->crossing_count_tile = v->tile;
+	v->crossing_count_mask = GetLevelCrossingTrainCountMask(v->tile);
+	v->crossing_counted = true;
+	ChangeLevelCrossingTrainCounts(v->crossing_count_tile, v->crossing_count_mask, 1);
+}
+
+/**
+ * Recount the train vehicles on and next to a tile which has just become a level crossing.
+ * @param tile The new level crossing.
+ */
+void UpdateLevelCrossingTrainCountsAround(TileIndex tile)
+{
+	auto recount = [](Vehicle *v, void *) -> Vehicle * {
+		UpdateLevelCrossingTrainCounts(Train::From(v), true);
+		UpdateLevelCrossingTrainCounts(Train::From(v), false);
+		return nullptr;
+	};
+
+	FindVehicleOnPos(tile, VEH_TRAIN, nullptr, recount);
+	for (DiagDirection dir = DIAGDIR_BEGIN; dir < DIAGDIR_END; dir++) {
+		FindVehicleOnPos(tile + TileOffsByDiagDir(dir), VEH_TRAIN, nullptr, recount);
+	}
+}
+
+/** Forget all level crossing train counts, together with the vehicle tile hash. */
+void ResetLevelCrossingTrainCounts()
+{
+	for (Train *v : Train::Iterate()) v->crossing_counted = false;
+	_level_crossing_train_counts.clear();
+}
+
+/** Recount the train vehicles at all level crossings, after the map may have been changed without updating the counts. */
+void RebuildLevelCrossingTrainCounts()
+{
+	ResetLevelCrossingTrainCounts();
+	for (Train *v : Train::Iterate()) {
+		if (!v->IsVirtual()) UpdateLevelCrossingTrainCounts(v, false);
+	}
+}
+
+/**
+ * Check the train vehicle counts of all level crossings against a recount.
+ * @return True iff the counts of all level crossings are correct.
+ */
+bool ValidateLevelCrossingTrainCounts()
+{
+	std::unordered_map<TileIndex, LevelCrossingTrainCount> counts;
+	for (const Train *v : Train::Iterate()) {
+		if (v->IsVirtual()) continue;
+		uint8 mask = GetLevelCrossingTrainCountMask(v->tile);
+		if (HasBit(mask, LCTC_ON_CROSSING_BIT)) counts[v->tile].on++;
+		for (DiagDirection dir = DIAGDIR_BEGIN; dir < DIAGDIR_END; dir++) {
+			if (HasBit(mask, dir)) counts[v->tile + TileOffsByDiagDir(dir)].near++;
+		}
+	}
+
+	/* Counts of removed crossings are only dropped once the vehicles move on, so only check existing crossings. */
+	for (const auto &it : _level_crossing_train_counts) {
+		if (!IsLevelCrossingTile(it.first)) continue;
+		auto expected = counts.find(it.first);
+		if (expected == counts.end() || expected->second.on != it.second.on || expected->second.near != it.second.near) return false;
+	}
+	for (const auto &it : counts) {
+		if (_level_crossing_train_counts.find(it.first) == _level_crossing_train_counts.end()) return false;
+	}
+	return true;
+}
 
 /**
  * Checks if a train is approaching a rail-road crossing
@@ -1968,7 +2093,12 @@ static bool TrainApproachingCrossing(TileIndex tile)
 static inline bool CheckLevelCrossing(TileIndex tile)
 {
 	/* reserved || train on crossing || train approaching crossing */
-	return HasCrossingReservation(tile) || HasVehicleOnPos(tile, VEH_TRAIN, nullptr, &TrainOnTileEnum) || TrainApproachingCrossing(tile);
+	if (HasCrossingReservation(tile)) return true;
+
+	/* Only trains next to the crossing can approach it, so only look for them when there are any. */
+	auto it = _level_crossing_train_counts.find(tile);
+	if (it == _level_crossing_train_counts.end()) return false;
+	return it->second.on > 0 || (it->second.near > 0 && TrainApproachingCrossing(tile));
 }
 
 /**
@@ -44,6 +44,7 @@
 #include "sound_func.h"
 #include "effectvehicle_func.h"
 #include "effectvehicle_base.h"
+#include "disaster_vehicle.h"
 #include "vehiclelist.h"
 #include "bridge_map.h"
 #include "tunnel_map.h"
@@ -59,10 +60,12 @@
 #include "scope_info.h"
 #include "debug_settings.h"
 #include "3rdparty/cpp-btree/btree_set.h"
+#include "tick_arena.h"
 
 #include "table/strings.h"
 
 #include <algorithm>
+#include <unordered_map>
 
 #include "safeguards.h"
 
@@ -96,12 +99,15 @@ uint16 _returned_refit_capacity;      ///< Stores the capacity after a refit ope
 uint16 _returned_mail_refit_capacity; ///< Stores the mail capacity after a refit operation (Aircraft only).
 
 
-/** The pool with all our precious vehicles. */
-VehiclePool _vehicle_pool("Vehicle");
+/** The pool with all our precious vehicles, with slots large enough for any vehicle type. */
+VehiclePool _vehicle_pool("Vehicle", std::max({ sizeof(Train), sizeof(RoadVehicle), sizeof(Ship), sizeof(Aircraft), sizeof(EffectVehicle), sizeof(DisasterVehicle) }));
 INSTANTIATE_POOL_METHODS(Vehicle)
 
-static btree::btree_set<VehicleID> _vehicles_to_pay_repair;
-static btree::btree_set<VehicleID> _vehicles_to_sell;
+/** Set of vehicles which only lives during a tick. */
+typedef btree::btree_set<VehicleID, std::less<VehicleID>, TickAllocator<VehicleID>> TickVehicleIDSet;
+
+static TickVehicleIDSet _vehicles_to_pay_repair;
+static TickVehicleIDSet _vehicles_to_sell;
 
 std::unordered_multimap<VehicleID, PendingSpeedRestrictionChange> pending_speed_restriction_change_map;
 
@@ -471,6 +477,50 @@ const int HASH_RES = 0;
 
 static Vehicle *_vehicle_tile_hash[TOTAL_HASH_SIZE * 4];
 
+/**
+ * Road vehicles on each tile, by lane. Road vehicles are looked up by tile and direction
+ * very often, so they are kept by their exact tile instead of by a hash of it.
+ * Tiles without road vehicles have no entry.
+ */
+static std::unordered_map<TileIndex, RoadVehicleTileLanes> _road_vehicle_tile_lanes;
+
+/**
+ * Get the road vehicles on a tile, by lane.
+ * @param tile The tile.
+ * @return The lanes of the tile, or nullptr if there are no road vehicles on it.
+ */
+const RoadVehicleTileLanes *GetRoadVehicleTileLanes(TileIndex tile)
+{
+	auto iter = _road_vehicle_tile_lanes.find(tile);
+	return iter != _road_vehicle_tile_lanes.end() ? &iter->second : nullptr;
+}
+
+/**
+ * Helper function for FindVehicleOnPos/HasVehicleOnPos for road vehicles.
+ * @param tile The location on the map
+ * @param data Arbitrary data passed to \a proc.
+ * @param proc The proc that determines whether a vehicle will be "found".
+ * @param find_first Whether to return on the first found or iterate over
+ *                   all vehicles
+ * @return the best matching or first vehicle (depending on find_first).
+ */
+static Vehicle *RoadVehicleFromPos(TileIndex tile, void *data, VehicleFromPosProc *proc, bool find_first)
+{
+	const RoadVehicleTileLanes *tile_lanes = GetRoadVehicleTileLanes(tile);
+	if (tile_lanes == nullptr) return nullptr;
+
+	for (const RoadVehicleLane &lane : tile_lanes->lanes) {
+		for (RoadVehicle *v = lane.first; v != nullptr; v = v->lane_next) {
+			if (v->tile != tile) continue;
+
+			Vehicle *a = proc(v, data);
+			if (find_first && a != nullptr) return a;
+		}
+	}
+
+	return nullptr;
+}
+
 static Vehicle *VehicleFromTileHash(int xl, int yl, int xu, int yu, VehicleType type, void *data, VehicleFromPosProc *proc, bool find_first)
 {
 	for (int y = yl; ; y = (y + (1 << HASH_BITS)) & (HASH_MASK << HASH_BITS)) {
@@ -510,6 +560,21 @@ Vehicle *VehicleFromPosXY(int x, int y, VehicleType type, void *data, VehicleFro
 	int yl = GB((y - COLL_DIST) / TILE_SIZE, HASH_RES, HASH_BITS) << HASH_BITS;
 	int yu = GB((y + COLL_DIST) / TILE_SIZE, HASH_RES, HASH_BITS) << HASH_BITS;
 
+	if (type == VEH_ROAD) {
+		/* Scan the same tiles in the same order, but without the other tiles sharing their hash. */
+		const uint txl = max(x - COLL_DIST, 0) / TILE_SIZE;
+		const uint txu = min<uint>(max(x + COLL_DIST, 0) / TILE_SIZE, MapMaxX());
+		const uint tyl = max(y - COLL_DIST, 0) / TILE_SIZE;
+		const uint tyu = min<uint>(max(y + COLL_DIST, 0) / TILE_SIZE, MapMaxY());
+		for (uint ty = tyl; ty <= tyu; ty++) {
+			for (uint tx = txl; tx <= txu; tx++) {
+				Vehicle *a = RoadVehicleFromPos(TileXY(tx, ty), data, proc, find_first);
+				if (find_first && a != nullptr) return a;
+			}
+		}
+		return nullptr;
+	}
+
 	return VehicleFromTileHash(xl, yl, xu, yu, type, data, proc, find_first);
 }
 
@@ -525,6 +590,8 @@ Vehicle *VehicleFromPosXY(int x, int y, VehicleType type, void *data, VehicleFro
  */
 Vehicle *VehicleFromPos(TileIndex tile, VehicleType type, void *data, VehicleFromPosProc *proc, bool find_first)
 {
+	if (type == VEH_ROAD) return RoadVehicleFromPos(tile, data, proc, find_first);
+
 	int x = GB(TileX(tile), HASH_RES, HASH_BITS);
 	int y = GB(TileY(tile), HASH_RES, HASH_BITS) << HASH_BITS;
 
@@ -700,8 +767,102 @@ CommandCost EnsureNoTrainOnTrackBits(TileIndex tile, TrackBits track_bits)
 	return CommandCost();
 }
 
+/**
+ * Check whether a road vehicle is less far along its lane than another one.
+ * Vehicles equally far along are ordered by index.
+ * @param a The first road vehicle.
+ * @param b The second road vehicle, in the same lane.
+ * @return True if \a a comes before \a b in the lane.
+ */
+static inline bool IsRoadVehicleBehindInLane(const RoadVehicle *a, const RoadVehicle *b)
+{
+	int progress_a = GetRoadVehicleLaneProgress(a->x_pos, a->y_pos, b->lane_dir);
+	int progress_b = GetRoadVehicleLaneProgress(b->x_pos, b->y_pos, b->lane_dir);
+	return progress_a < progress_b || (progress_a == progress_b && a->index < b->index);
+}
+
+/**
+ * Remove a road vehicle from its lane.
+ * @param v The road vehicle.
+ */
+static void RemoveRoadVehicleFromLane(RoadVehicle *v)
+{
+	auto iter = _road_vehicle_tile_lanes.find(v->lane_tile);
+	assert(iter != _road_vehicle_tile_lanes.end());
+	RoadVehicleLane &lane = iter->second.lanes[v->lane_dir];
+
+	if (v->lane_prev != nullptr) {
+		v->lane_prev->lane_next = v->lane_next;
+	} else {
+		lane.first = v->lane_next;
+	}
+	if (v->lane_next != nullptr) v->lane_next->lane_prev = v->lane_prev;
+	v->in_lane = false;
+
+	lane.count--;
+	if (--iter->second.count == 0) _road_vehicle_tile_lanes.erase(iter);
+}
+
+/**
+ * Insert a road vehicle in the lane of its current tile and direction.
+ * @param v The road vehicle.
+ */
+static void InsertRoadVehicleInLane(RoadVehicle *v)
+{
+	assert(IsValidDirection(v->direction));
+	v->lane_tile = v->tile;
+	v->lane_dir = v->direction;
+	v->in_lane = true;
+
+	RoadVehicleTileLanes &tile_lanes = _road_vehicle_tile_lanes[v->tile];
+	RoadVehicleLane &lane = tile_lanes.lanes[v->direction];
+	RoadVehicle *prev = nullptr;
+	RoadVehicle *next = lane.first;
+	while (next != nullptr && IsRoadVehicleBehindInLane(next, v)) {
+		prev = next;
+		next = next->lane_next;
+	}
+
+	v->lane_prev = prev;
+	v->lane_next = next;
+	if (prev != nullptr) {
+		prev->lane_next = v;
+	} else {
+		lane.first = v;
+	}
+	if (next != nullptr) next->lane_prev = v;
+
+	lane.count++;
+	tile_lanes.count++;
+}
+
+/**
+ * Move a road vehicle to the lane of its current tile and direction, and keep
+ * the lane ordered when the vehicle has moved along it.
+ * @param v The road vehicle.
+ * @param remove Whether to only remove the vehicle from its lane.
+ */
+static void UpdateRoadVehicleLane(RoadVehicle *v, bool remove)
+{
+	if (v->in_lane) {
+		if (!remove && v->lane_tile == v->tile && v->lane_dir == v->direction) {
+			/* Vehicles only move a little at a time, so the order only needs fixing when they pass each other. */
+			if ((v->lane_next == nullptr || IsRoadVehicleBehindInLane(v, v->lane_next)) &&
+					(v->lane_prev == nullptr || IsRoadVehicleBehindInLane(v->lane_prev, v))) {
+				return;
+			}
+		}
+		RemoveRoadVehicleFromLane(v);
+	}
+
+	if (!remove) InsertRoadVehicleInLane(v);
+}
+
 void UpdateVehicleTileHash(Vehicle *v, bool remove)
 {
+	if (v->type == VEH_ROAD) UpdateRoadVehicleLane(RoadVehicle::From(v), remove || HasBit(v->subtype, GVSF_VIRTUAL));
+	if (v->type == VEH_TRAIN) UpdateLevelCrossingTrainCounts(Train::From(v), remove || HasBit(v->subtype, GVSF_VIRTUAL));
+
 	Vehicle **old_hash = v->hash_tile_current;
 	Vehicle **new_hash;
 
@@ -737,6 +898,17 @@ bool ValidateVehicleTileHash(const Vehicle *v)
 {
 	if ((v->type == VEH_TRAIN && Train::From(v)->IsVirtual()) || v->type >= VEH_COMPANY_END) return v->hash_tile_current == nullptr;
 
+	if (v->type == VEH_ROAD) {
+		const RoadVehicle *rv = RoadVehicle::From(v);
+		if (!rv->in_lane || rv->lane_tile != v->tile || rv->lane_dir != v->direction) return false;
+		if (rv->lane_next != nullptr && !IsRoadVehicleBehindInLane(rv, rv->lane_next)) return false;
+	}
+
+	if (v->type == VEH_TRAIN) {
+		const Train *t = Train::From(v);
+		if (!t->crossing_counted || t->crossing_count_tile != v->tile) return false;
+	}
+
 	int x = GB(TileX(v->tile), HASH_RES, HASH_BITS);
 	int y = GB(TileY(v->tile), HASH_RES, HASH_BITS) << HASH_BITS;
 	return v->hash_tile_current == &_vehicle_tile_hash[((x + y) & TOTAL_HASH_MASK) + (TOTAL_HASH_SIZE * v->type)];
@@ -773,8 +945,11 @@ static void UpdateVehicleViewportHash(Vehicle *v, int x, int y)
 void ResetVehicleHash()
 {
 	for (Vehicle *v : Vehicle::Iterate()) { v->hash_tile_current = nullptr; }
+	for (RoadVehicle *v : RoadVehicle::Iterate()) { v->in_lane = false; }
 	memset(_vehicle_viewport_hash, 0, sizeof(_vehicle_viewport_hash));
 	memset(_vehicle_tile_hash, 0, sizeof(_vehicle_tile_hash));
+	_road_vehicle_tile_lanes.clear();
+	ResetLevelCrossingTrainCounts();
 }
 
 void ResetVehicleColourMap()
@@ -786,12 +961,12 @@ void ResetVehicleColourMap()
  * List of vehicles that should check for autoreplace this tick.
  * Mapping of vehicle -> leave depot immediately after autoreplace.
  */
-static btree::btree_map<VehicleID, bool> _vehicles_to_autoreplace;
+static btree::btree_map<VehicleID, bool, std::less<VehicleID>, TickAllocator<std::pair<const VehicleID, bool>>> _vehicles_to_autoreplace;
 
 /**
  * List of vehicles that are issued for template replacement this tick.
  */
-static btree::btree_set<VehicleID> _vehicles_to_templatereplace;
+static TickVehicleIDSet _vehicles_to_templatereplace;
 
 void InitializeVehicles()
 {
@@ -1493,7 +1668,12 @@ void CallVehicleTicks()
 		v->breakdowns_since_last_service = 0;
 	}
 	repair_cur_company.Restore();
+
+	/* Release the lists' memory to the tick arena. */
+	_vehicles_to_autoreplace.clear();
+	_vehicles_to_templatereplace.clear();
 	_vehicles_to_pay_repair.clear();
+	_vehicles_to_sell.clear();
 }
 
 /**
@@ -24,6 +24,7 @@
 #include "../core/math_func.hpp"
 #include "../framerate_type.h"
 #include "../thread.h"
+#include "../spritecache.h"
 #include "allegro_v.h"
 #include <allegro.h>
 #include <algorithm>
@@ -518,7 +519,7 @@ void VideoDriver_Allegro::MainLoop()
 			CheckPaletteAnim();
 			DrawSurfaceToScreen();
 		} else {
-			CSleep(1);
+			if (!ProcessSpritePrefetchQueue(1000)) CSleep(1);
 			NetworkDrawChatMessage();
 			DrawMouseCursor();
 			DrawSurfaceToScreen();
@@ -36,6 +36,7 @@
 #include "../../texteff.hpp"
 #include "../../window_func.h"
 #include "../../thread.h"
+#include "../../spritecache.h"
 
 #import <sys/time.h> /* gettimeofday */
 
@@ -710,7 +711,7 @@ void QZ_GameLoop()
 #ifdef _DEBUG
 			uint32 st0 = GetTick();
 #endif
-			CSleep(1);
+			if (!ProcessSpritePrefetchQueue(1000)) CSleep(1);
 #ifdef _DEBUG
 			st += GetTick() - st0;
 #endif
@@ -22,6 +22,7 @@
 #include "../fileio_func.h"
 #include "../framerate_type.h"
 #include "../scope.h"
+#include "../spritecache.h"
 #include "sdl2_v.h"
 #include <SDL.h>
 #include <mutex>
@@ -1090,10 +1091,12 @@ void VideoDriver_SDL::MainLoop()
 			UpdateWindows();
 			_local_palette = _cur_palette;
 		} else {
-			/* Release the thread while sleeping */
-			if (_draw_mutex != nullptr) draw_lock.unlock();
-			CSleep(1);
-			if (_draw_mutex != nullptr) draw_lock.lock();
+			/* Load sprites for areas about to be scrolled into view, otherwise release the thread while sleeping */
+			if (!ProcessSpritePrefetchQueue(1000)) {
+				if (_draw_mutex != nullptr) draw_lock.unlock();
+				CSleep(1);
+				if (_draw_mutex != nullptr) draw_lock.lock();
+			}
 
 			NetworkDrawChatMessage();
 			DrawMouseCursor();
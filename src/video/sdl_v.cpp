@@ -21,6 +21,7 @@
 #include "../core/math_func.hpp"
 #include "../fileio_func.h"
 #include "../framerate_type.h"
+#include "../spritecache.h"
 #include "sdl_v.h"
 #include <SDL.h>
 #include <mutex>
@@ -758,10 +759,12 @@ void VideoDriver_SDL::MainLoop()
 			UpdateWindows();
 			_local_palette = _cur_palette;
 		} else {
-			/* Release the thread while sleeping */
-			if (_draw_mutex != nullptr) draw_lock.unlock();
-			CSleep(1);
-			if (_draw_mutex != nullptr) draw_lock.lock();
+			/* Load sprites for areas about to be scrolled into view, otherwise release the thread while sleeping */
+			if (!ProcessSpritePrefetchQueue(1000)) {
+				if (_draw_mutex != nullptr) draw_lock.unlock();
+				CSleep(1);
+				if (_draw_mutex != nullptr) draw_lock.lock();
+			}
 
 			NetworkDrawChatMessage();
 			DrawMouseCursor();
@@ -22,6 +22,7 @@
 #include "../window_gui.h"
 #include "../window_func.h"
 #include "../framerate_type.h"
+#include "../spritecache.h"
 #include "win32_v.h"
 #include <windows.h>
 #include <imm.h>
@@ -1277,10 +1278,12 @@ void VideoDriver_Win32::MainLoop()
 			/* Flush GDI buffer to ensure we don't conflict with the drawing thread. */
 			GdiFlush();
 
-			/* Release the thread while sleeping */
-			if (_draw_threaded) draw_lock.unlock();
-			Sleep(1);
-			if (_draw_threaded) draw_lock.lock();
+			/* Load sprites for areas about to be scrolled into view, otherwise release the thread while sleeping */
+			if (!ProcessSpritePrefetchQueue(1000)) {
+				if (_draw_threaded) draw_lock.unlock();
+				Sleep(1);
+				if (_draw_threaded) draw_lock.lock();
+			}
 
 			NetworkDrawChatMessage();
 			DrawMouseCursor();
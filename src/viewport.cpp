@@ -106,8 +106,17 @@
 #include "core/container_func.hpp"
 #include "tunnelbridge_map.h"
 #include "video/video_driver.hpp"
+#include "spritecache.h"
+#include "newgrf_station.h"
+#include "newgrf_airporttiles.h"
+#include "newgrf_object.h"
+#include "newgrf_house.h"
+#include "object_map.h"
+#include "industry_map.h"
+#include "worker_thread.h"
 
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <math.h>
 #include <algorithm>
@@ -158,6 +167,41 @@ struct ChildScreenSpriteToDraw {
 	bool relative;
 };
 
+/** Kind of a viewport drawing call recorded by the tile draw cache. */
+enum TileDrawOpType : byte {
+	TDOT_GROUND_SPRITE, ///< #DrawGroundSpriteAt
+	TDOT_OFFSET_GROUND, ///< #OffsetGroundSprite
+	TDOT_SORTABLE,      ///< #AddSortableSpriteToDraw
+	TDOT_CHILD_SCREEN,  ///< #AddChildSpriteScreen
+	TDOT_START_COMBINE, ///< #StartSpriteCombine
+	TDOT_END_COMBINE,   ///< #EndSpriteCombine
+};
+
+/**
+ * Viewport drawing call made by the draw proc of a tile, as recorded by the tile draw cache.
+ * The calls are recorded instead of the sprites they add, as the latter depend on the clipping to the drawn area.
+ */
+struct TileDrawOp {
+	TileDrawOpType type;
+	bool transparent;
+	bool scale;
+	bool relative;
+	SpriteID image;
+	PaletteID pal;
+	const SubSprite *sub;
+	int32 x;
+	int32 y;
+	int32 z;
+	int32 w;
+	int32 h;
+	int32 dz;
+	int32 bb_offset_x;
+	int32 bb_offset_y;
+	int32 bb_offset_z;
+	int32 extra_offs_x;
+	int32 extra_offs_y;
+};
+
 /**
  * Mode of "sprite combining"
  * @see StartSpriteCombine
@@ -172,6 +216,7 @@ typedef std::vector<TileSpriteToDraw> TileSpriteToDrawVector;
 typedef std::vector<StringSpriteToDraw> StringSpriteToDrawVector;
 typedef std::vector<ParentSpriteToDraw> ParentSpriteToDrawVector;
 typedef std::vector<ChildScreenSpriteToDraw> ChildScreenSpriteToDrawVector;
+typedef std::vector<TileDrawOp> TileDrawOpVector;
 
 typedef std::vector<std::pair<int, OrderType> > RankOrderTypeList;
 typedef std::map<TileIndex, RankOrderTypeList> RouteStepsMap;
@@ -244,6 +289,9 @@ struct ViewportDrawer {
 	btree::btree_map<TileIndex, TileIndex, BridgeSetYComparator> bridge_to_map_y;
 
 	int *last_child;
+	bool prefetch_only;                              ///< Only queue the sprites for prefetching into the sprite cache, do not collect anything to draw.
+	SpritePrefetchQueue prefetch_queue;              ///< Queue to add the sprites to if #prefetch_only is set.
+	TileDrawOpVector *tile_draw_record;              ///< If not nullptr, the drawing calls of the current tile are recorded here for the tile draw cache.
 
 	SpriteCombineMode combine_sprites;               ///< Current mode of "sprite combining". @see StartSpriteCombine
 	uint combine_psd_index;
@@ -261,6 +309,7 @@ struct ViewportDrawer {
 static void MarkViewportDirty(ViewPort * const vp, int left, int top, int right, int bottom);
 static void MarkRouteStepDirty(RouteStepsMap::const_iterator cit);
 static void MarkRouteStepDirty(const TileIndex tile, uint order_nr);
+static void ViewportPrefetchScrollMargin(ViewPort *vp, int dx, int dy);
 
 static DrawPixelInfo _dpi_for_text;
 static ViewportDrawer _vd;
@@ -640,6 +689,8 @@ static void SetViewportPosition(Window *w, int x, int y, bool force_update_overl
 	_vp_move_offs.x = old_left;
 	_vp_move_offs.y = old_top;
 
+	ViewportPrefetchScrollMargin(vp, -old_left, -old_top);
+
 	left = vp->left;
 	top = vp->top;
 	width = vp->width;
@@ -769,6 +820,27 @@ void HandleZoomMessage(Window *w, const ViewPort *vp, byte widget_zoom_in, byte
 	w->SetWidgetDirty(widget_zoom_out);
 }
 
+/**
+ * Record a drawing call of the current tile for the tile draw cache.
+ * @param type Kind of the call.
+ * @param image The image to draw, if any.
+ * @param pal The provided palette, if any.
+ * @param sub Only draw a part of the sprite, if any.
+ * @return The recorded call, to fill in the remaining parameters.
+ */
+static TileDrawOp &RecordTileDrawOp(TileDrawOpType type, SpriteID image = 0, PaletteID pal = PAL_NONE, const SubSprite *sub = nullptr)
+{
+	/*C++17: TileDrawOp &op = */ _vd.tile_draw_record->emplace_back();
+	TileDrawOp &op = _vd.tile_draw_record->back();
+	op.type = type;
+	op.image = image;
+	op.pal = pal;
+	op.sub = sub;
+	return op;
+}
+
+static void AddChildSpriteScreenToDraw(SpriteID image, PaletteID pal, int x, int y, bool transparent, const SubSprite *sub, bool scale, bool relative = true);
+
 /**
  * Schedules a tile sprite for drawing.
  *
@@ -785,6 +857,11 @@ static void AddTileSpriteToDraw(SpriteID image, PaletteID pal, int32 x, int32 y,
 {
 	assert((image & SPRITE_MASK) < MAX_SPRITES);
 
+	if (unlikely(_vd.prefetch_only)) {
+		PrefetchSprite(image & SPRITE_MASK, _vd.prefetch_queue);
+		return;
+	}
+
 	/*C++17: TileSpriteToDraw &ts = */ _vd.tile_sprites_to_draw.emplace_back();
 	TileSpriteToDraw &ts = _vd.tile_sprites_to_draw.back();
 	ts.image = image;
@@ -817,7 +894,7 @@ static void AddChildSpriteToFoundation(SpriteID image, PaletteID pal, const SubS
 	int *old_child = _vd.last_child;
 	_vd.last_child = _vd.last_foundation_child[foundation_part];
 
-	AddChildSpriteScreen(image, pal, offs.x + extra_offs_x, offs.y + extra_offs_y, false, sub, false);
+	AddChildSpriteScreenToDraw(image, pal, offs.x + extra_offs_x, offs.y + extra_offs_y, false, sub, false);
 
 	/* Switch back to last ChildSprite list */
 	_vd.last_child = old_child;
@@ -838,6 +915,15 @@ static void AddChildSpriteToFoundation(SpriteID image, PaletteID pal, const SubS
  */
 void DrawGroundSpriteAt(SpriteID image, PaletteID pal, int32 x, int32 y, int z, const SubSprite *sub, int extra_offs_x, int extra_offs_y)
 {
+	if (unlikely(_vd.tile_draw_record != nullptr)) {
+		TileDrawOp &op = RecordTileDrawOp(TDOT_GROUND_SPRITE, image, pal, sub);
+		op.x = x;
+		op.y = y;
+		op.z = z;
+		op.extra_offs_x = extra_offs_x;
+		op.extra_offs_y = extra_offs_y;
+	}
+
 	/* Switch to first foundation part, if no foundation was drawn */
 	if (_vd.foundation_part == FOUNDATION_PART_NONE) _vd.foundation_part = FOUNDATION_PART_NORMAL;
 
@@ -873,6 +959,12 @@ void DrawGroundSprite(SpriteID image, PaletteID pal, const SubSprite *sub, int e
  */
 void OffsetGroundSprite(int x, int y)
 {
+	if (unlikely(_vd.tile_draw_record != nullptr)) {
+		TileDrawOp &op = RecordTileDrawOp(TDOT_OFFSET_GROUND);
+		op.x = x;
+		op.y = y;
+	}
+
 	/* Switch to next foundation part */
 	switch (_vd.foundation_part) {
 		case FOUNDATION_PART_NONE:
@@ -918,7 +1010,7 @@ static void AddCombinedSprite(SpriteID image, PaletteID pal, int x, int y, int z
 			bottom <= _vd.dpi.top)
 		return;
 
-	AddChildSpriteScreen(image, pal, pt.x, pt.y, false, sub, false, false);
+	AddChildSpriteScreenToDraw(image, pal, pt.x, pt.y, false, sub, false, false);
 	if (left < _vd.combine_left) _vd.combine_left = left;
 	if (right > _vd.combine_right) _vd.combine_right = right;
 	if (top < _vd.combine_top) _vd.combine_top = top;
@@ -956,12 +1048,32 @@ void AddSortableSpriteToDraw(SpriteID image, PaletteID pal, int x, int y, int w,
 
 	assert((image & SPRITE_MASK) < MAX_SPRITES);
 
+	if (unlikely(_vd.tile_draw_record != nullptr)) {
+		TileDrawOp &op = RecordTileDrawOp(TDOT_SORTABLE, image, pal, sub);
+		op.transparent = transparent;
+		op.x = x;
+		op.y = y;
+		op.z = z;
+		op.w = w;
+		op.h = h;
+		op.dz = dz;
+		op.bb_offset_x = bb_offset_x;
+		op.bb_offset_y = bb_offset_y;
+		op.bb_offset_z = bb_offset_z;
+	}
+
 	/* make the sprites transparent with the right palette */
 	if (transparent) {
 		SetBit(image, PALETTE_MODIFIER_TRANSPARENT);
 		pal = PALETTE_TO_TRANSPARENT;
 	}
 
+	if (unlikely(_vd.prefetch_only)) {
+		if (image != SPR_EMPTY_BOUNDING_BOX) PrefetchSprite(image & SPRITE_MASK, _vd.prefetch_queue);
+		_vd.last_child = nullptr;
+		return;
+	}
+
 	if (_vd.combine_sprites == SPRITE_COMBINE_ACTIVE) {
 		AddCombinedSprite(image, pal, x, y, z, sub);
 		return;
@@ -1065,6 +1177,7 @@ void AddSortableSpriteToDraw(SpriteID image, PaletteID pal, int x, int y, int w,
  */
 void StartSpriteCombine()
 {
+	if (unlikely(_vd.tile_draw_record != nullptr)) RecordTileDrawOp(TDOT_START_COMBINE);
 	assert(_vd.combine_sprites == SPRITE_COMBINE_NONE);
 	_vd.combine_sprites = SPRITE_COMBINE_PENDING;
 }
@@ -1075,6 +1188,7 @@ void StartSpriteCombine()
  */
 void EndSpriteCombine()
 {
+	if (unlikely(_vd.tile_draw_record != nullptr)) RecordTileDrawOp(TDOT_END_COMBINE);
 	assert(_vd.combine_sprites != SPRITE_COMBINE_NONE);
 	if (_vd.combine_sprites == SPRITE_COMBINE_ACTIVE) {
 		ParentSpriteToDraw &ps = _vd.parent_sprites_to_draw[_vd.combine_psd_index];
@@ -1131,12 +1245,18 @@ static bool IsInsideSelectedRectangle(int x, int y)
  * @param y sprite y-offset (screen coordinates), optionally relative to parent sprite.
  * @param transparent if true, switch the palette between the provided palette and the transparent palette,
  * @param sub Only draw a part of the sprite.
+ * @param scale Whether the offsets are in unscaled pixels.
  * @param relative Whether coordinates are relative.
  */
-void AddChildSpriteScreen(SpriteID image, PaletteID pal, int x, int y, bool transparent, const SubSprite *sub, bool scale, bool relative)
+static void AddChildSpriteScreenToDraw(SpriteID image, PaletteID pal, int x, int y, bool transparent, const SubSprite *sub, bool scale, bool relative)
 {
 	assert((image & SPRITE_MASK) < MAX_SPRITES);
 
+	if (unlikely(_vd.prefetch_only)) {
+		PrefetchSprite(image & SPRITE_MASK, _vd.prefetch_queue);
+		return;
+	}
+
 	/* If the ParentSprite was clipped by the viewport bounds, do not draw the ChildSprites either */
 	if (_vd.last_child == nullptr) return;
 
@@ -1166,6 +1286,32 @@ void AddChildSpriteScreen(SpriteID image, PaletteID pal, int x, int y, bool tran
 	_vd.last_child = &cs.next;
 }
 
+/**
+ * Add a child sprite to a parent sprite.
+ *
+ * @param image the image to draw.
+ * @param pal the provided palette.
+ * @param x sprite x-offset (screen coordinates), optionally relative to parent sprite.
+ * @param y sprite y-offset (screen coordinates), optionally relative to parent sprite.
+ * @param transparent if true, switch the palette between the provided palette and the transparent palette,
+ * @param sub Only draw a part of the sprite.
+ * @param scale Whether the offsets are in unscaled pixels.
+ * @param relative Whether coordinates are relative.
+ */
+void AddChildSpriteScreen(SpriteID image, PaletteID pal, int x, int y, bool transparent, const SubSprite *sub, bool scale, bool relative)
+{
+	if (unlikely(_vd.tile_draw_record != nullptr)) {
+		TileDrawOp &op = RecordTileDrawOp(TDOT_CHILD_SCREEN, image, pal, sub);
+		op.transparent = transparent;
+		op.scale = scale;
+		op.relative = relative;
+		op.x = x;
+		op.y = y;
+	}
+
+	AddChildSpriteScreenToDraw(image, pal, x, y, transparent, sub, scale, relative);
+}
+
 static void AddStringToDraw(int x, int y, StringID string, uint64 params_1, uint64 params_2, Colours colour, uint16 width)
 {
 	assert(width != 0);
@@ -1494,6 +1640,182 @@ static int GetViewportY(Point tile)
 	return (tile.y * (int)(TILE_PIXELS / 2) + tile.x * (int)(TILE_PIXELS / 2) - TilePixelHeightOutsideMap(tile.x, tile.y)) << ZOOM_LVL_SHIFT;
 }
 
+/** Recorded drawing calls of a tile. */
+struct TileDrawCacheEntry {
+	ZoomLevel zoom;       ///< Zoom level the calls were recorded at.
+	Tile m;               ///< Map array contents of the tile when the calls were recorded.
+	TileExtended me;      ///< Extended map array contents of the tile when the calls were recorded.
+	uint32 newgrf_epoch;  ///< #_tile_draw_cache_newgrf_epoch when the calls were recorded.
+	TileDrawOpVector ops; ///< The recorded calls.
+};
+
+static const size_t TILE_DRAW_CACHE_MAX_TILES = 1 << 17; ///< Number of tiles in the tile draw cache above which it is emptied.
+
+bool _tile_draw_cache_enabled = true; ///< Whether fully visible tiles are drawn via the tile draw cache.
+static std::unordered_map<TileIndex, TileDrawCacheEntry> _tile_draw_cache;
+static TileDrawOpVector _tile_draw_record_buffer;
+static uint32 _tile_draw_cache_version = 0; ///< Incremented on every invalidation of the tile draw cache.
+static uint32 _tile_draw_cache_newgrf_epoch = 0; ///< Incremented when the drawing of all tiles drawn by NewGRFs may have changed.
+
+/**
+ * Remove all tiles from the tile draw cache.
+ */
+void ClearTileDrawCache()
+{
+	_tile_draw_cache_version++;
+	_tile_draw_cache.clear();
+}
+
+/**
+ * Remove a tile from the tile draw cache, because it changed.
+ * Its neighbours are removed as well, as the drawing of a tile depends on them, e.g. for foundations, fences and catenary.
+ * @param tile The changed tile.
+ */
+void InvalidateTileDrawCache(TileIndex tile)
+{
+	_tile_draw_cache_version++;
+	if (_tile_draw_cache.empty()) return;
+
+	const uint x = TileX(tile);
+	const uint y = TileY(tile);
+	for (uint ty = y - 1; ty != y + 2; ty++) {
+		if (ty >= MapSizeY()) continue;
+		for (uint tx = x - 1; tx != x + 2; tx++) {
+			if (tx >= MapSizeX()) continue;
+			_tile_draw_cache.erase(TileXY(tx, ty));
+		}
+	}
+}
+
+/**
+ * Make the recorded drawing calls of all tiles drawn by NewGRFs stale.
+ * Called every day, as their sprites can depend on the date, or on state of their
+ * industry, town or station which changes without the tile being marked dirty.
+ */
+void InvalidateNewGRFTileDrawCache()
+{
+	_tile_draw_cache_newgrf_epoch++;
+}
+
+/**
+ * Replay the drawing calls of a tile recorded by the tile draw cache.
+ * @param ops The recorded calls.
+ */
+static void ReplayTileDrawOps(const TileDrawOpVector &ops)
+{
+	for (const TileDrawOp &op : ops) {
+		switch (op.type) {
+			case TDOT_GROUND_SPRITE:
+				DrawGroundSpriteAt(op.image, op.pal, op.x, op.y, op.z, op.sub, op.extra_offs_x, op.extra_offs_y);
+				break;
+
+			case TDOT_OFFSET_GROUND:
+				OffsetGroundSprite(op.x, op.y);
+				break;
+
+			case TDOT_SORTABLE:
+				AddSortableSpriteToDraw(op.image, op.pal, op.x, op.y, op.w, op.h, op.dz, op.z, op.transparent, op.bb_offset_x, op.bb_offset_y, op.bb_offset_z, op.sub);
+				break;
+
+			case TDOT_CHILD_SCREEN:
+				AddChildSpriteScreen(op.image, op.pal, op.x, op.y, op.transparent, op.sub, op.scale, op.relative);
+				break;
+
+			case TDOT_START_COMBINE:
+				StartSpriteCombine();
+				break;
+
+			case TDOT_END_COMBINE:
+				EndSpriteCombine();
+				break;
+
+			default: NOT_REACHED();
+		}
+	}
+}
+
+/**
+ * Check whether a tile is drawn by a NewGRF, and its drawing may depend on more than the tile itself.
+ * @param tile Tile to check.
+ * @param tile_type Type of the tile.
+ * @return Whether the tile is a NewGRF station, airport, industry, house or object tile.
+ */
+static bool IsTileDrawnByNewGRF(TileIndex tile, TileType tile_type)
+{
+	switch (tile_type) {
+		case MP_STATION:
+			if (HasStationTileRail(tile) && GetStationSpec(tile) != nullptr) return true;
+			if (IsAirport(tile) && AirportTileSpec::GetByTile(tile)->grf_prop.spritegroup[0] != nullptr) return true;
+			return false;
+
+		case MP_INDUSTRY:
+			return GetIndustryTileSpec(GetIndustryGfx(tile))->grf_prop.spritegroup[0] != nullptr;
+
+		case MP_HOUSE:
+			return HouseSpec::Get(GetHouseType(tile))->grf_prop.spritegroup[0] != nullptr;
+
+		case MP_OBJECT:
+			return GetObjectType(tile) >= NEW_OBJECT_OFFSET;
+
+		default:
+			return false;
+	}
+}
+
+/**
+ * Check whether the recorded drawing calls of a tile can be replayed.
+ * The map array contents of the tile are compared, so changes of random bits, animation frames and
+ * construction stages invalidate the recording even when the tile was not marked dirty.
+ * Tiles drawn by NewGRFs are additionally re-recorded every day, see #InvalidateNewGRFTileDrawCache.
+ * @param entry The recording.
+ * @param tile The tile.
+ * @param tile_type Type of the tile.
+ * @return Whether the recording is still valid.
+ */
+static bool IsTileDrawCacheEntryValid(const TileDrawCacheEntry &entry, TileIndex tile, TileType tile_type)
+{
+	if (entry.zoom != _vd.dpi.zoom) return false;
+	if (memcmp(&entry.m, &_m[tile], sizeof(Tile)) != 0 || memcmp(&entry.me, &_me[tile], sizeof(TileExtended)) != 0) return false;
+	return entry.newgrf_epoch == _tile_draw_cache_newgrf_epoch || !IsTileDrawnByNewGRF(tile, tile_type);
+}
+
+/**
+ * Draw a tile whose ground is visible and not at the edge of the drawn area.
+ * The drawing calls of its draw proc are replayed from the tile draw cache if they were recorded at the same zoom level,
+ * else the draw proc is run and its calls are recorded.
+ * The calls are recorded instead of their resulting sprites, so the cached calls can be reused when the drawn area changes.
+ * @param ti Tile to draw.
+ * @param tile_type Type of the tile.
+ * @param params Parameters for the draw proc.
+ */
+static void DrawTileViaCache(TileInfo *ti, TileType tile_type, DrawTileProcParams params)
+{
+	auto iter = _tile_draw_cache.find(ti->tile);
+	if (iter != _tile_draw_cache.end() && IsTileDrawCacheEntryValid(iter->second, ti->tile, tile_type)) {
+		ReplayTileDrawOps(iter->second.ops);
+		return;
+	}
+
+	const uint32 version = _tile_draw_cache_version;
+	_tile_draw_record_buffer.clear();
+	_vd.tile_draw_record = &_tile_draw_record_buffer;
+	_tile_type_procs[tile_type]->draw_tile_proc(ti, params);
+	_vd.tile_draw_record = nullptr;
+
+	/* Do not cache the calls if the tile was changed while drawing it. */
+	if (version != _tile_draw_cache_version) return;
+
+	if (iter == _tile_draw_cache.end()) {
+		if (_tile_draw_cache.size() >= TILE_DRAW_CACHE_MAX_TILES) _tile_draw_cache.clear();
+		iter = _tile_draw_cache.emplace(ti->tile, TileDrawCacheEntry()).first;
+	}
+	iter->second.zoom = _vd.dpi.zoom;
+	iter->second.m = _m[ti->tile];
+	iter->second.me = _me[ti->tile];
+	iter->second.newgrf_epoch = _tile_draw_cache_newgrf_epoch;
+	iter->second.ops = _tile_draw_record_buffer;
+}
+
 /**
  * Add the landscape to the viewport, i.e. all ground tiles and buildings.
  */
@@ -1605,7 +1927,11 @@ static void ViewportAddLandscape()
 				_vd.last_foundation_child[1] = nullptr;
 
 				bool no_ground_tiles = (column == left_column || column == right_column) || min_visible_height > 0;
-				_tile_type_procs[tile_type]->draw_tile_proc(&tile_info, { min_visible_height, no_ground_tiles });
+				if (_tile_draw_cache_enabled && !no_ground_tiles && tile_type != MP_VOID) {
+					DrawTileViaCache(&tile_info, tile_type, { min_visible_height, no_ground_tiles });
+				} else {
+					_tile_type_procs[tile_type]->draw_tile_proc(&tile_info, { min_visible_height, no_ground_tiles });
+				}
 				if (tile_info.tile != INVALID_TILE && min_visible_height <= 0) {
 					DrawTileSelection(&tile_info);
 					DrawTileZoning(&tile_info);
@@ -1792,6 +2118,9 @@ void ViewportSign::UpdatePosition(ZoomLevel maxzoom, int center, int top, String
 	}
 	this->width_small = VPSM_LEFT + Align(GetStringBoundingBox(buffer, FS_SMALL).width, 2) + VPSM_RIGHT;
 
+	/* Signs which keep their position are not inserted into the kd-tree again, so account for a wider text here. */
+	_viewport_sign_maxwidth = max<int>(_viewport_sign_maxwidth, this->width_normal);
+
 	this->MarkDirty(maxzoom);
 }
 
@@ -3155,6 +3484,103 @@ void ViewportDoDraw(ViewPort *vp, int left, int top, int right, int bottom)
 	_vd.child_screen_sprites_to_draw.clear();
 }
 
+/**
+ * Queue the sprites required to draw a region of a viewport for prefetching into the sprite cache, without drawing anything.
+ * @param zoom Zoom level to draw the region at.
+ * @param left Left edge of the region, in virtual coordinates.
+ * @param top Top edge of the region, in virtual coordinates.
+ * @param right Right edge of the region, in virtual coordinates.
+ * @param bottom Bottom edge of the region, in virtual coordinates.
+ * @param queue Queue to add the sprites to.
+ * @see ProcessSpritePrefetchQueue
+ */
+static void ViewportQueueSpritePrefetch(ZoomLevel zoom, int left, int top, int right, int bottom, SpritePrefetchQueue queue = SPQ_SCROLL)
+{
+	if (right <= left || bottom <= top) return;
+
+	DrawPixelInfo *old_dpi = _cur_dpi;
+	_cur_dpi = &_vd.dpi;
+
+	_vd.dpi.zoom = zoom;
+	int mask = ScaleByZoom(-1, zoom);
+
+	_vd.combine_sprites = SPRITE_COMBINE_NONE;
+
+	_vd.dpi.width = (right - left) & mask;
+	_vd.dpi.height = (bottom - top) & mask;
+	_vd.dpi.left = left & mask;
+	_vd.dpi.top = top & mask;
+	_vd.dpi.pitch = old_dpi->pitch;
+	_vd.dpi.dst_ptr = nullptr;
+	_vd.last_child = nullptr;
+
+	_vd.prefetch_only = true;
+	_vd.prefetch_queue = queue;
+	ViewportAddLandscape();
+	ViewportAddVehicles(&_vd.dpi);
+	_vd.prefetch_only = false;
+
+	_cur_dpi = old_dpi;
+}
+
+/**
+ * Queue the sprites of the area which is about to be scrolled into view for prefetching into the sprite cache.
+ * The prefetched band extends a fixed distance beyond the edge in the scroll direction. Only the slice which
+ * has newly entered that band by this scroll step is scanned, so each tile is scanned once while scrolling.
+ * @param vp Viewport which has just been scrolled.
+ * @param dx Horizontal scroll distance, in screen pixels.
+ * @param dy Vertical scroll distance, in screen pixels.
+ */
+static void ViewportPrefetchScrollMargin(ViewPort *vp, int dx, int dy)
+{
+	if (vp->zoom >= ZOOM_LVL_DRAW_MAP) return;
+
+	/* Look ahead a few frames worth of scrolling */
+	static const int PREFETCH_LOOKAHEAD = 256;
+
+	const int left = vp->virtual_left;
+	const int top = vp->virtual_top;
+	const int right = vp->virtual_left + vp->virtual_width;
+	const int bottom = vp->virtual_top + vp->virtual_height;
+	const int lookahead = ScaleByZoom(PREFETCH_LOOKAHEAD, vp->zoom);
+
+	/* Width of the newly entering slice, the whole band after a jump */
+	auto slice = [&](int d) -> int {
+		return ScaleByZoom(min(abs(d), PREFETCH_LOOKAHEAD), vp->zoom);
+	};
+
+	if (dx > 0) ViewportQueueSpritePrefetch(vp->zoom, right + lookahead - slice(dx), top, right + lookahead, bottom);
+	if (dx < 0) ViewportQueueSpritePrefetch(vp->zoom, left - lookahead, top, left - lookahead + slice(dx), bottom);
+	if (dy > 0) ViewportQueueSpritePrefetch(vp->zoom, left, bottom + lookahead - slice(dy), right, bottom + lookahead);
+	if (dy < 0) ViewportQueueSpritePrefetch(vp->zoom, left, top - lookahead, right, top - lookahead + slice(dy));
+}
+
+/**
+ * Queue the sprites of the area which comes into view when zooming out one more level for prefetching into the sprite cache.
+ * That is the ring around the current view, half its size wide on each side, drawn at the next zoom level.
+ * Prefetched sprites include all zoom levels, so the current view itself needs nothing extra.
+ * @param vp Viewport which has just been zoomed.
+ */
+void ViewportPrefetchAdjacentZoom(ViewPort *vp)
+{
+	ClearSpritePrefetchQueue(SPQ_ADJACENT_ZOOM);
+
+	const ZoomLevel zoom = (ZoomLevel)(vp->zoom + 1);
+	if (vp->zoom >= _settings_client.gui.zoom_max || zoom >= ZOOM_LVL_DRAW_MAP) return;
+
+	const int left = vp->virtual_left;
+	const int top = vp->virtual_top;
+	const int right = vp->virtual_left + vp->virtual_width;
+	const int bottom = vp->virtual_top + vp->virtual_height;
+	const int margin_x = vp->virtual_width / 2;
+	const int margin_y = vp->virtual_height / 2;
+
+	ViewportQueueSpritePrefetch(zoom, left - margin_x, top - margin_y, right + margin_x, top, SPQ_ADJACENT_ZOOM);
+	ViewportQueueSpritePrefetch(zoom, left - margin_x, bottom, right + margin_x, bottom + margin_y, SPQ_ADJACENT_ZOOM);
+	ViewportQueueSpritePrefetch(zoom, left - margin_x, top, left, bottom, SPQ_ADJACENT_ZOOM);
+	ViewportQueueSpritePrefetch(zoom, right, top, right + margin_x, bottom, SPQ_ADJACENT_ZOOM);
+}
+
 /**
  * Make sure we don't draw a too big area at a time.
  * If we do, the sprite sorter will run into major performance problems and the sprite memory may overflow.
@@ -3489,6 +3915,8 @@ void ConstrainAllViewportsZoom()
  */
 void MarkTileDirtyByTile(TileIndex tile, const ZoomLevel mark_dirty_if_zoomlevel_is_below, int bridge_level_offset, int tile_height_override)
 {
+	InvalidateTileDrawCache(tile);
+
 	Point pt = RemapCoords(TileX(tile) * TILE_SIZE, TileY(tile) * TILE_SIZE, tile_height_override * TILE_HEIGHT);
 	MarkAllViewportsDirty(
 			pt.x - 31  * ZOOM_LVL_BASE,
@@ -3501,6 +3929,8 @@ void MarkTileDirtyByTile(TileIndex tile, const ZoomLevel mark_dirty_if_zoomlevel
 
 void MarkTileGroundDirtyByTile(TileIndex tile, const ZoomLevel mark_dirty_if_zoomlevel_is_below)
 {
+	InvalidateTileDrawCache(tile);
+
 	int x = TileX(tile) * TILE_SIZE;
 	int y = TileY(tile) * TILE_SIZE;
 	Point top = RemapCoords(x, y, GetTileMaxPixelZ(tile));
@@ -3909,7 +4339,7 @@ void RebuildViewportKdtree()
 		if (sign->sign.kdtree_valid) items.push_back(ViewportSignKdtreeItem::MakeSign(sign->index));
 	}
 
-	_viewport_sign_kdtree.Build(items.begin(), items.end());
+	_viewport_sign_kdtree.Build(items.begin(), items.end(), &RunParallelTasks);
 }
 
 
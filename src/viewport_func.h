@@ -32,6 +32,7 @@ Point TranslateXYToTileCoord(const ViewPort *vp, int x, int y, bool clamp_to_map
 Point GetTileBelowCursor();
 void UpdateViewportPosition(Window *w);
 void UpdateViewportSizeZoom(ViewPort *vp);
+void ViewportPrefetchAdjacentZoom(ViewPort *vp);
 
 void MarkAllViewportsDirty(int left, int top, int right, int bottom, const ZoomLevel mark_dirty_if_zoomlevel_is_below = ZOOM_LVL_END);
 void MarkAllViewportMapsDirty(int left, int top, int right, int bottom);
@@ -109,6 +110,11 @@ static inline void MarkTileDirtyByTile(TileIndex tile, const ZoomLevel mark_dirt
 
 void MarkTileGroundDirtyByTile(TileIndex tile, const ZoomLevel mark_dirty_if_zoomlevel_is_below);
 
+extern bool _tile_draw_cache_enabled;
+void InvalidateTileDrawCache(TileIndex tile);
+void ClearTileDrawCache();
+void InvalidateNewGRFTileDrawCache();
+
 ViewportMapType ChangeRenderMode(const ViewPort *vp, bool down);
 
 Point GetViewportStationMiddle(const ViewPort *vp, const Station *st);
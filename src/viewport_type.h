@@ -117,6 +117,15 @@ struct TrackedViewportSign : ViewportSign {
 		this->ViewportSign::UpdatePosition(maxzoom, center, top, str, str_small);
 	}
 
+	/**
+	 * Check whether updating the position of the sign to the given coordinates changes its entry in the viewport sign kd-tree.
+	 * Renaming a sign keeps its center and top, so it does not need to be removed and inserted again.
+	 */
+	bool IsKdtreeEntryChanged(int center, int top) const
+	{
+		return !this->kdtree_valid || this->center != center || this->top != top;
+	}
+
 
 	TrackedViewportSign() : kdtree_valid{ false }
 	{
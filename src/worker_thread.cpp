@@ -0,0 +1,66 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file worker_thread.cpp Running independent tasks on short-lived worker threads. */
+
+#include "stdafx.h"
+#include "worker_thread.h"
+#include "thread.h"
+
+#include <atomic>
+
+#include "safeguards.h"
+
+/** Upper limit on the number of threads used by #RunParallelTasks. */
+static const uint MAX_WORKER_THREADS = 16;
+
+/**
+ * Get the number of threads which #RunParallelTasks will use at most, including the calling thread.
+ * @return Number of threads, at least 1.
+ */
+uint GetWorkerThreadCount()
+{
+#ifdef NO_THREADS
+	return 1;
+#else
+	static const uint count = Clamp<uint>(std::thread::hardware_concurrency(), 1, MAX_WORKER_THREADS);
+	return count;
+#endif
+}
+
+/**
+ * Run a number of independent tasks, using worker threads if available, and wait for them all to complete.
+ * The calling thread also runs tasks. If no worker threads can be started, all tasks are run on the calling thread.
+ * @param count Number of tasks.
+ * @param task Function called with each task number in [0, count), in no particular order or thread.
+ */
+void RunParallelTasks(uint count, const std::function<void(uint)> &task)
+{
+	const uint threads = min(GetWorkerThreadCount(), count);
+	if (threads <= 1) {
+		for (uint i = 0; i < count; i++) task(i);
+		return;
+	}
+
+	std::atomic<uint> next_task(0);
+	auto worker = [&]() {
+		for (uint i = next_task++; i < count; i = next_task++) {
+			task(i);
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (uint i = 1; i < threads; i++) {
+		std::thread t;
+		if (!StartNewThread(&t, "ottd:worker", [&worker]() { worker(); })) break;
+		workers.push_back(std::move(t));
+	}
+
+	worker();
+
+	for (std::thread &t : workers) t.join();
+}
@@ -0,0 +1,80 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file worker_thread.h Running independent tasks on short-lived worker threads. */
+
+#ifndef WORKER_THREAD_H
+#define WORKER_THREAD_H
+
+#include "core/math_func.hpp"
+#include <functional>
+#include <vector>
+
+uint GetWorkerThreadCount();
+void RunParallelTasks(uint count, const std::function<void(uint)> &task);
+
+/** Number of pool indices handled by each task of #ParallelPoolReduce. */
+static const size_t POOL_REDUCE_CHUNK_SIZE = 1024;
+
+/**
+ * Deterministic parallel map-reduce over all valid items of a pool.
+ *
+ * The pool index range is split into fixed size chunks, each chunk is reduced in index order
+ * into its own partial result, starting from \a identity, and the partial results are then
+ * combined in chunk order on the calling thread.
+ * The result therefore does not depend on the number of threads used, or their scheduling.
+ *
+ * @param identity Initial value of the result and of each partial result.
+ * @param map Function called as map(R &partial, T *item) for each item. It must not modify anything other than \a partial and \a item.
+ * @param combine Function called as combine(R &result, const R &partial) for each partial result, in order.
+ * @return The combined result.
+ * @tparam T Pool item type.
+ */
+template <typename T, typename R, typename Tmap, typename Tcombine>
+R ParallelPoolReduce(const R &identity, Tmap map, Tcombine combine)
+{
+	const size_t pool_size = T::GetPoolSize();
+	const uint chunks = (uint)CeilDiv(pool_size, POOL_REDUCE_CHUNK_SIZE);
+
+	std::vector<R> partials(chunks, identity);
+	RunParallelTasks(chunks, [&](uint chunk) {
+		R &partial = partials[chunk];
+		const size_t end = min<size_t>(pool_size, (chunk + 1) * POOL_REDUCE_CHUNK_SIZE);
+		for (size_t index = T::GetNextValidIndex(chunk * POOL_REDUCE_CHUNK_SIZE); index < end; index = T::GetNextValidIndex(index + 1)) {
+			if (T::IsValidID(index)) map(partial, T::Get(index));
+		}
+	});
+
+	R result = identity;
+	for (const R &partial : partials) combine(result, partial);
+	return result;
+}
+
+/**
+ * Call a function for all valid items of a pool, in parallel.
+ *
+ * The pool index range is split into the same fixed size chunks as used by #ParallelPoolReduce.
+ * Within a chunk the items are handled in index order, but the chunks are handled in no particular order or thread.
+ *
+ * @param func Function called as func(T *item) for each item. It must not modify anything other than \a item.
+ * @tparam T Pool item type.
+ */
+template <typename T, typename Tfunc>
+void ParallelPoolForEach(Tfunc func)
+{
+	const size_t pool_size = T::GetPoolSize();
+	const uint chunks = (uint)CeilDiv(pool_size, POOL_REDUCE_CHUNK_SIZE);
+
+	RunParallelTasks(chunks, [&](uint chunk) {
+		const size_t end = min<size_t>(pool_size, (chunk + 1) * POOL_REDUCE_CHUNK_SIZE);
+		for (size_t index = T::GetNextValidIndex(chunk * POOL_REDUCE_CHUNK_SIZE); index < end; index = T::GetNextValidIndex(index + 1)) {
+			if (T::IsValidID(index)) func(T::Get(index));
+		}
+	});
+}
+
+#endif /* WORKER_THREAD_H */